@@ -0,0 +1,67 @@
+// crc16_fcs.cpp - X.25 FCS-16, ported from Jacksum's FCS16.java
+
+#include "pch.h"
+#include "crc16_fcs.h"
+
+NAMESPACE_BEGIN(CryptoPP)
+
+// Slicing-by-8 tables for the reflected CRC: m_tab[0] is the RFC 1331
+// fcstab, m_tab[k][b] is the FCS of byte b followed by k zero bytes.
+struct FCS16Tables
+{
+	FCS16Tables()
+	{
+		for (unsigned int i=0; i<256; i++)
+		{
+			word16 c = word16(i);
+			for (unsigned int j=0; j<8; j++)
+				c = (c >> 1) ^ (c & 1 ? 0x8408 : 0);
+			m_tab[0][i] = c;
+		}
+		for (unsigned int k=1; k<8; k++)
+			for (unsigned int i=0; i<256; i++)
+				m_tab[k][i] = (m_tab[k-1][i] >> 8) ^ m_tab[0][m_tab[k-1][i] & 0xFF];
+	}
+
+	word16 m_tab[8][256];
+};
+
+static const FCS16Tables & GetFCS16Tables()
+{
+	static const FCS16Tables tables;
+	return tables;
+}
+
+FCS16::FCS16()
+{
+	Reset();
+}
+
+void FCS16::Update(const byte *s, unsigned int n)
+{
+	const word16 (*t)[256] = GetFCS16Tables().m_tab;
+	word16 crc = m_crc;
+
+	while (n >= 8)
+	{
+		crc = t[7][s[0] ^ GETBYTE(crc, 0)] ^ t[6][s[1] ^ GETBYTE(crc, 1)]
+			^ t[5][s[2]] ^ t[4][s[3]] ^ t[3][s[4]] ^ t[2][s[5]] ^ t[1][s[6]] ^ t[0][s[7]];
+		n -= 8;
+		s += 8;
+	}
+
+	while (n--)
+		crc = (crc >> 8) ^ t[0][(crc ^ *s++) & 0xFF];
+
+	m_crc = crc;
+}
+
+void FCS16::Final(byte *hash)
+{
+	word16 value = GetValue();
+	hash[0] = GETBYTE(value, 1);
+	hash[1] = GETBYTE(value, 0);
+	Reset();
+}
+
+NAMESPACE_END
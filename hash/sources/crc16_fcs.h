@@ -0,0 +1,30 @@
+#ifndef CRYPTOPP_CRC16_FCS_H
+#define CRYPTOPP_CRC16_FCS_H
+
+#include "cryptlib.h"
+
+NAMESPACE_BEGIN(CryptoPP)
+
+//! 16-bit frame check sequence of RFC 1331 / X.25: reflected CRC-16 with
+//! polynomial 0x1021, initial value 0xFFFF, inverted at the end.
+//! Final() writes the value big-endian, as Jacksum prints it.
+class FCS16 : public HashModule
+{
+public:
+	enum {DIGESTSIZE = 2};
+	FCS16();
+	void Update(const byte *input, unsigned int length);
+	void Final(byte *hash);
+	unsigned int DigestSize() const {return DIGESTSIZE;}
+
+	//! checksum of the data so far, without resetting (Jacksum's getValue())
+	word16 GetValue() const {return word16(~m_crc);}
+
+private:
+	void Reset() {m_crc = 0xFFFF;}
+	word16 m_crc;
+};
+
+NAMESPACE_END
+
+#endif
@@ -0,0 +1,146 @@
+// crc32_posix.cpp - POSIX cksum, ported from Jacksum's Cksum.java
+
+#include "pch.h"
+#include "crc32_posix.h"
+
+#if CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE
+#include "cpu.h"
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+NAMESPACE_BEGIN(CryptoPP)
+
+// Slicing-by-8 tables for the MSB-first CRC: m_tab[0] is the classic
+// byte table, m_tab[k][b] is the CRC of byte b followed by k zero bytes.
+struct CksumTables
+{
+	CksumTables()
+	{
+		for (unsigned int i=0; i<256; i++)
+		{
+			word32 c = word32(i) << 24;
+			for (unsigned int j=0; j<8; j++)
+				c = (c << 1) ^ (c & 0x80000000 ? 0x04C11DB7 : 0);
+			m_tab[0][i] = c;
+		}
+		for (unsigned int k=1; k<8; k++)
+			for (unsigned int i=0; i<256; i++)
+				m_tab[k][i] = (m_tab[k-1][i] << 8) ^ m_tab[0][m_tab[k-1][i] >> 24];
+	}
+
+	word32 m_tab[8][256];
+};
+
+static const CksumTables & GetCksumTables()
+{
+	static const CksumTables tables;
+	return tables;
+}
+
+#if CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE
+// Fold 16-byte lanes with carry-less multiplies.  Each lane is loaded
+// byte-reversed, so bit i of the register is the coefficient of x^i and
+// the lane needs no reflection.  A lane moved D bits forward is replaced
+// by hi*(x^(D+64) mod P) ^ lo*(x^D mod P); at the end the single remaining
+// lane is run through the byte table, which multiplies it by x^32 mod P.
+// length must be a multiple of 16 and at least 64.
+static word32 CksumFold_CLMUL(word32 crc, const byte *s, size_t length)
+{
+	const __m128i swap = _mm_set_epi8(0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15);
+	const __m128i k512 = _mm_set_epi64x(0x8833794c, 0xe6228b11);	// x^576, x^512
+	const __m128i k128 = _mm_set_epi64x(0xc5b9cd4c, 0xe8a45605);	// x^192, x^128
+
+#define LOAD(i) _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(s+16*(i))), swap)
+#define FOLD(x, k) _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11), _mm_clmulepi64_si128(x, k, 0x00))
+
+	// the running CRC is xored into the first 4 message bytes
+	__m128i x0 = _mm_xor_si128(LOAD(0), _mm_set_epi32(crc, 0, 0, 0));
+	__m128i x1 = LOAD(1), x2 = LOAD(2), x3 = LOAD(3);
+
+	for (s += 64, length -= 64; length >= 64; s += 64, length -= 64)
+	{
+		x0 = _mm_xor_si128(FOLD(x0, k512), LOAD(0));
+		x1 = _mm_xor_si128(FOLD(x1, k512), LOAD(1));
+		x2 = _mm_xor_si128(FOLD(x2, k512), LOAD(2));
+		x3 = _mm_xor_si128(FOLD(x3, k512), LOAD(3));
+	}
+
+	x1 = _mm_xor_si128(FOLD(x0, k128), x1);
+	x2 = _mm_xor_si128(FOLD(x1, k128), x2);
+	x3 = _mm_xor_si128(FOLD(x2, k128), x3);
+
+	for (; length >= 16; s += 16, length -= 16)
+		x3 = _mm_xor_si128(FOLD(x3, k128), LOAD(0));
+
+#undef LOAD
+#undef FOLD
+
+	byte lane[16];
+	_mm_storeu_si128((__m128i *)lane, _mm_shuffle_epi8(x3, swap));
+
+	const word32 *t = GetCksumTables().m_tab[0];
+	crc = 0;
+	for (unsigned int i=0; i<16; i++)
+		crc = (crc << 8) ^ t[(crc >> 24) ^ lane[i]];
+	return crc;
+}
+#endif
+
+CKSUM::CKSUM()
+{
+	Reset();
+}
+
+void CKSUM::Update(const byte *s, unsigned int n)
+{
+	const word32 (*t)[256] = GetCksumTables().m_tab;
+	word32 crc = m_crc;
+
+	m_length += n;
+
+#if CRYPTOPP_BOOL_AESNI_INTRINSICS_AVAILABLE
+	if (n >= 128 && HasCLMUL())
+	{
+		unsigned int folded = n & ~15U;
+		crc = CksumFold_CLMUL(crc, s, folded);
+		s += folded;
+		n -= folded;
+	}
+#endif
+
+	while (n >= 8)
+	{
+		word32 a = crc ^ GetWord<word32>(false, BIG_ENDIAN_ORDER, s);
+		word32 b = GetWord<word32>(false, BIG_ENDIAN_ORDER, s+4);
+		crc = t[7][a >> 24] ^ t[6][GETBYTE(a, 2)] ^ t[5][GETBYTE(a, 1)] ^ t[4][GETBYTE(a, 0)]
+			^ t[3][b >> 24] ^ t[2][GETBYTE(b, 2)] ^ t[1][GETBYTE(b, 1)] ^ t[0][GETBYTE(b, 0)];
+		n -= 8;
+		s += 8;
+	}
+
+	while (n--)
+		crc = (crc << 8) ^ t[0][(crc >> 24) ^ *s++];
+
+	m_crc = crc;
+}
+
+word32 CKSUM::GetValue() const
+{
+	const word32 *t = GetCksumTables().m_tab[0];
+	word32 crc = m_crc;
+
+	// include the length of the data in the checksum value
+	for (word64 length = m_length; length != 0; length >>= 8)
+		crc = (crc << 8) ^ t[(crc >> 24) ^ byte(length)];
+
+	return ~crc;
+}
+
+void CKSUM::Final(byte *hash)
+{
+	PutWord(false, BIG_ENDIAN_ORDER, hash, GetValue());
+	Reset();
+}
+
+NAMESPACE_END
@@ -0,0 +1,32 @@
+#ifndef CRYPTOPP_CRC32_POSIX_H
+#define CRYPTOPP_CRC32_POSIX_H
+
+#include "cryptlib.h"
+
+NAMESPACE_BEGIN(CryptoPP)
+
+//! POSIX 1003.2 cksum: non-reflected CRC-32 (polynomial 0x04C11DB7, zero
+//! initial value) over the data, then over the data length in bytes
+//! (least significant byte first, leading zero bytes dropped), inverted.
+//! Final() writes the value big-endian, as cksum prints it.
+class CKSUM : public HashModule
+{
+public:
+	enum {DIGESTSIZE = 4};
+	CKSUM();
+	void Update(const byte *input, unsigned int length);
+	void Final(byte *hash);
+	unsigned int DigestSize() const {return DIGESTSIZE;}
+
+	//! checksum of the data so far, without resetting (Jacksum's getValue())
+	word32 GetValue() const;
+
+private:
+	void Reset() {m_crc = 0; m_length = 0;}
+	word32 m_crc;
+	word64 m_length;
+};
+
+NAMESPACE_END
+
+#endif
@@ -0,0 +1,166 @@
+// ed2k.cpp - eD2k chunked MD4 file hash
+
+#include "pch.h"
+#include "ed2k.h"
+
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+NAMESPACE_BEGIN(CryptoPP)
+
+ED2K::ED2K(unsigned int threads, bool appendEmptyChunk)
+	: m_threads(threads ? threads : STDMAX(std::thread::hardware_concurrency(), 1U)),
+	  m_appendEmptyChunk(appendEmptyChunk)
+{
+}
+
+void ED2K::HashChunks(const byte *input, size_t length)
+{
+	size_t chunks = (length + CHUNKSIZE - 1) / CHUNKSIZE;
+
+	// an empty input, or a trailing empty chunk on an exact multiple
+	if (length % CHUNKSIZE == 0 && (m_appendEmptyChunk || length == 0))
+		chunks++;
+
+	m_chunkDigests.New(chunks * DIGESTSIZE);
+
+	// workers pull the next chunk index from a shared counter, so a worker
+	// that finishes early just takes more chunks.  The first exception a
+	// worker throws ends the others at their next chunk and is rethrown
+	// here once all of them have been joined.
+	std::atomic<size_t> next(0);
+	std::exception_ptr error;
+	std::mutex errorLock;
+	byte *out = m_chunkDigests;
+	auto worker = [&]() {
+		try
+		{
+			MD4 md4;
+			for (size_t i; (i = next++) < chunks; )
+			{
+				size_t offset = i * CHUNKSIZE;
+				md4.CalculateDigest(out + i*DIGESTSIZE, input + offset, STDMIN(size_t(CHUNKSIZE), length - offset));
+			}
+		}
+		catch (...)
+		{
+			next = chunks;
+			std::lock_guard<std::mutex> lock(errorLock);
+			if (!error)
+				error = std::current_exception();
+		}
+	};
+
+	struct JoinAll
+	{
+		std::vector<std::thread> &pool;
+		~JoinAll()
+		{
+			for (size_t i = 0; i < pool.size(); i++)
+				pool[i].join();
+		}
+	};
+
+	size_t workers = STDMIN(size_t(m_threads), chunks);
+	std::vector<std::thread> pool;
+	pool.reserve(workers);
+	{
+		JoinAll joinAll = {pool};
+		for (size_t i = 1; i < workers; i++)
+		{
+			try
+			{
+				pool.emplace_back(worker);
+			}
+			catch (const std::system_error &)
+			{
+				break;		// the calling thread takes the remaining chunks
+			}
+		}
+		worker();
+	}
+
+	if (error)
+		std::rethrow_exception(error);
+}
+
+void ED2K::CalculateDigest(byte *digest, const byte *input, size_t length)
+{
+	HashChunks(input, length);
+
+	if (ChunkCount() == 1)
+		memcpy(digest, m_chunkDigests, DIGESTSIZE);
+	else
+		MD4().CalculateDigest(digest, m_chunkDigests, m_chunkDigests.size());
+}
+
+void ED2K::CalculateFileDigest(byte *digest, const char *filename)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		throw OS_Error(Exception::IO_ERROR, "ED2K: error opening file " + std::string(filename), "open", errno);
+
+	struct stat st;
+	if (fstat(fd, &st) < 0)
+	{
+		int err = errno;
+		close(fd);
+		throw OS_Error(Exception::IO_ERROR, "ED2K: error reading file " + std::string(filename), "fstat", err);
+	}
+
+	// the whole file is mapped at once, so it has to fit in size_t
+	if ((unsigned long long)st.st_size > std::numeric_limits<size_t>::max())
+	{
+		close(fd);
+		throw Exception(Exception::IO_ERROR, "ED2K: file too large to map: " + std::string(filename));
+	}
+
+	size_t length = (size_t)st.st_size;
+	if (length == 0)
+	{
+		close(fd);
+		CalculateDigest(digest, NULL, 0);
+		return;
+	}
+
+	void *p = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	int err = errno;
+	close(fd);
+	if (p == MAP_FAILED)
+		throw OS_Error(Exception::IO_ERROR, "ED2K: error mapping file " + std::string(filename), "mmap", err);
+
+	madvise(p, length, MADV_SEQUENTIAL);
+	try
+	{
+		CalculateDigest(digest, (const byte *)p, length);
+	}
+	catch (...)
+	{
+		munmap(p, length);
+		throw;
+	}
+	munmap(p, length);
+}
+
+bool ED2K::VerifyChunk(size_t i, const byte *chunk, size_t length) const
+{
+	if (i >= ChunkCount())
+		throw InvalidArgument("ED2K: chunk index out of range");
+
+	byte digest[DIGESTSIZE];
+	MD4().CalculateDigest(digest, chunk, length);
+	return memcmp(digest, ChunkDigest(i), DIGESTSIZE) == 0;
+}
+
+NAMESPACE_END
@@ -0,0 +1,42 @@
+#ifndef CRYPTOPP_ED2K_H
+#define CRYPTOPP_ED2K_H
+
+#include "md4.h"
+#include "secblock.h"
+
+NAMESPACE_BEGIN(CryptoPP)
+
+//! eD2k file hash: MD4 over each 9728000-byte chunk, then MD4 over the
+//! concatenated chunk digests.  A file of a single chunk hashes to that
+//! chunk's digest.  Chunks are hashed on a pool of worker threads.
+class ED2K
+{
+public:
+	enum {CHUNKSIZE = 9728000, DIGESTSIZE = MD4::DIGESTSIZE};
+
+	//! threads == 0 uses one worker per hardware thread.
+	//! With appendEmptyChunk set (the eDonkey/eMule behaviour), a file whose
+	//! size is an exact multiple of CHUNKSIZE gets the MD4 of an empty
+	//! chunk appended to its chunk list; without it the list simply ends.
+	ED2K(unsigned int threads = 0, bool appendEmptyChunk = true);
+
+	void CalculateDigest(byte *digest, const byte *input, size_t length);
+	//! maps the file read-only and hashes it in place
+	void CalculateFileDigest(byte *digest, const char *filename);
+
+	//! digests of the chunks of the last input hashed, for partial verification
+	size_t ChunkCount() const {return m_chunkDigests.size() / DIGESTSIZE;}
+	const byte * ChunkDigest(size_t i) const {return m_chunkDigests + i*DIGESTSIZE;}
+	bool VerifyChunk(size_t i, const byte *chunk, size_t length) const;
+
+private:
+	void HashChunks(const byte *input, size_t length);
+
+	unsigned int m_threads;
+	bool m_appendEmptyChunk;
+	SecByteBlock m_chunkDigests;
+};
+
+NAMESPACE_END
+
+#endif
@@ -0,0 +1,609 @@
+
+/*
+ *  haval.hpp:  compile-time specialised HAVAL (V.1) for C++17.
+ *
+ *  The C library in haval.zip fixes PASS and FPTLEN with the preprocessor,
+ *  so a program gets exactly one HAVAL variant per build.  This header
+ *  turns the same round function into a template over both parameters:
+ *  every haval<PASS, FPTLEN> compiles to its own straight-line
+ *  compression function and output tailoring, and haval_create() maps a
+ *  name such as "haval-256-5" to the matching instantiation at run time.
+ *  Dispatch happens once per call, never per block.
+ *
+ *  Derived from haval.c by Yuliang Zheng and Lawrence Teo, Calyptix
+ *  Security Corporation; see haval.zip for the full copyright notice and
+ *  haval.cert for the certification data.
+ */
+
+#ifndef HAVAL_HPP
+#define HAVAL_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <memory>
+
+typedef uint32_t haval_word;                /* a HAVAL word = 32 bits */
+
+#define HAVAL_VERSION    1                   /* current version number */
+
+#define f_1(x6, x5, x4, x3, x2, x1, x0)              \
+           (((x1) & ((x0) ^ (x4))) ^ ((x2) & (x5)) ^ \
+            ((x3) & (x6)) ^ (x0))
+
+#define f_2(x6, x5, x4, x3, x2, x1, x0)                                 \
+           (((x2) & (((x1) & ~(x3)) ^ ((x4) & (x5)) ^ (x6) ^ (x0))) ^ \
+            ((x4) & ((x1) ^ (x5))) ^ ((x3) & (x5)) ^ (x0))
+
+#define f_3(x6, x5, x4, x3, x2, x1, x0)                \
+           (((x3) & (((x1) & (x2)) ^ (x6) ^ (x0))) ^ \
+            ((x1) & (x4)) ^ ((x2) & (x5)) ^ (x0))
+
+#define f_4(x6, x5, x4, x3, x2, x1, x0)                                         \
+           (((x4) & (((x5) & ~(x2)) ^ ((x3) & ~(x6)) ^ (x1) ^ (x6) ^ (x0))) ^ \
+            ((x3) & (((x1) & (x2)) ^ (x5) ^ (x6))) ^                          \
+            ((x2) & (x6)) ^ (x0))
+
+#define f_5(x6, x5, x4, x3, x2, x1, x0)                 \
+           (((x0) & (((x1) & (x2) & (x3)) ^ ~(x5))) ^   \
+            ((x1) & (x4)) ^ ((x2) & (x5)) ^ ((x3) & (x6)))
+
+#define rotate_right(x, n) (((x) >> (n)) | ((x) << (32-(n))))
+
+/*
+ * Permutations phi_{i,j}, i=3,4,5, j=1,...,i, one specialisation per
+ * number of passes (see haval.c for the table they are taken from).
+ */
+template <int PASS> struct haval_phi;
+
+template <> struct haval_phi<3>
+{
+  static haval_word f1 (haval_word x6, haval_word x5, haval_word x4, haval_word x3,
+                        haval_word x2, haval_word x1, haval_word x0)
+    { return f_1(x1, x0, x3, x5, x6, x2, x4); }
+  static haval_word f2 (haval_word x6, haval_word x5, haval_word x4, haval_word x3,
+                        haval_word x2, haval_word x1, haval_word x0)
+    { return f_2(x4, x2, x1, x0, x5, x3, x6); }
+  static haval_word f3 (haval_word x6, haval_word x5, haval_word x4, haval_word x3,
+                        haval_word x2, haval_word x1, haval_word x0)
+    { return f_3(x6, x1, x2, x3, x4, x5, x0); }
+};
+
+template <> struct haval_phi<4>
+{
+  static haval_word f1 (haval_word x6, haval_word x5, haval_word x4, haval_word x3,
+                        haval_word x2, haval_word x1, haval_word x0)
+    { return f_1(x2, x6, x1, x4, x5, x3, x0); }
+  static haval_word f2 (haval_word x6, haval_word x5, haval_word x4, haval_word x3,
+                        haval_word x2, haval_word x1, haval_word x0)
+    { return f_2(x3, x5, x2, x0, x1, x6, x4); }
+  static haval_word f3 (haval_word x6, haval_word x5, haval_word x4, haval_word x3,
+                        haval_word x2, haval_word x1, haval_word x0)
+    { return f_3(x1, x4, x3, x6, x0, x2, x5); }
+  static haval_word f4 (haval_word x6, haval_word x5, haval_word x4, haval_word x3,
+                        haval_word x2, haval_word x1, haval_word x0)
+    { return f_4(x6, x4, x0, x5, x2, x1, x3); }
+};
+
+template <> struct haval_phi<5>
+{
+  static haval_word f1 (haval_word x6, haval_word x5, haval_word x4, haval_word x3,
+                        haval_word x2, haval_word x1, haval_word x0)
+    { return f_1(x3, x4, x1, x0, x5, x2, x6); }
+  static haval_word f2 (haval_word x6, haval_word x5, haval_word x4, haval_word x3,
+                        haval_word x2, haval_word x1, haval_word x0)
+    { return f_2(x6, x2, x1, x0, x3, x4, x5); }
+  static haval_word f3 (haval_word x6, haval_word x5, haval_word x4, haval_word x3,
+                        haval_word x2, haval_word x1, haval_word x0)
+    { return f_3(x2, x6, x0, x4, x3, x1, x5); }
+  static haval_word f4 (haval_word x6, haval_word x5, haval_word x4, haval_word x3,
+                        haval_word x2, haval_word x1, haval_word x0)
+    { return f_4(x1, x5, x3, x2, x0, x4, x6); }
+  static haval_word f5 (haval_word x6, haval_word x5, haval_word x4, haval_word x3,
+                        haval_word x2, haval_word x1, haval_word x0)
+    { return f_5(x2, x5, x0, x6, x4, x3, x1); }
+};
+
+#define FF_1(x7, x6, x5, x4, x3, x2, x1, x0, w) {                        \
+      haval_word temp = phi::f1(x6, x5, x4, x3, x2, x1, x0);             \
+      (x7) = rotate_right(temp, 7) + rotate_right((x7), 11) + (w);       \
+      }
+
+#define FF_2(x7, x6, x5, x4, x3, x2, x1, x0, w, c) {                      \
+      haval_word temp = phi::f2(x6, x5, x4, x3, x2, x1, x0);              \
+      (x7) = rotate_right(temp, 7) + rotate_right((x7), 11) + (w) + (c);  \
+      }
+
+#define FF_3(x7, x6, x5, x4, x3, x2, x1, x0, w, c) {                      \
+      haval_word temp = phi::f3(x6, x5, x4, x3, x2, x1, x0);              \
+      (x7) = rotate_right(temp, 7) + rotate_right((x7), 11) + (w) + (c);  \
+      }
+
+#define FF_4(x7, x6, x5, x4, x3, x2, x1, x0, w, c) {                      \
+      haval_word temp = phi::f4(x6, x5, x4, x3, x2, x1, x0);              \
+      (x7) = rotate_right(temp, 7) + rotate_right((x7), 11) + (w) + (c);  \
+      }
+
+#define FF_5(x7, x6, x5, x4, x3, x2, x1, x0, w, c) {                      \
+      haval_word temp = phi::f5(x6, x5, x4, x3, x2, x1, x0);              \
+      (x7) = rotate_right(temp, 7) + rotate_right((x7), 11) + (w) + (c);  \
+      }
+
+/* run-time interface shared by all variants, used by haval_create() */
+class haval_hasher
+{
+public:
+  virtual ~haval_hasher () {}
+  virtual void start () = 0;                                 /* initialization */
+  virtual void hash (const unsigned char *, size_t) = 0;     /* updating routine */
+  virtual void end (unsigned char *) = 0;                    /* finalization */
+  virtual unsigned int fptlen () const = 0;                  /* in bits */
+};
+
+template <int PASS, int FPTLEN>
+class haval : public haval_hasher
+{
+  static_assert(PASS >= 3 && PASS <= 5, "HAVAL has 3, 4 or 5 passes");
+  static_assert(FPTLEN >= 128 && FPTLEN <= 256 && FPTLEN % 32 == 0,
+                "HAVAL fingerprints are 128, 160, 192, 224 or 256 bits");
+
+public:
+  haval () { start (); }
+  ~haval () { memset (remainder, 0, sizeof (remainder)); }
+
+  void start ();
+  void hash (const unsigned char *str, size_t str_len);
+  void end (unsigned char *final_fpt);
+  unsigned int fptlen () const { return FPTLEN; }
+
+  /* hash a 32-word block into a fingerprint */
+  static void hash_block (haval_word fpt[8], const haval_word w[32]);
+
+private:
+  static void hash_bytes (haval_word fpt[8], const unsigned char *str);
+  static void tailor (haval_word fpt[8]);
+
+  uint64_t      count;                   /* number of bits in a message */
+  haval_word    fingerprint[8];          /* current state of fingerprint */
+  unsigned char remainder[32*4];         /* unhashed chars (No.<128) */
+};
+
+template <int PASS, int FPTLEN>
+void haval<PASS, FPTLEN>::start ()
+{
+  count          = 0;                    /* clear count */
+  fingerprint[0] = 0x243F6A88L;          /* initial fingerprint */
+  fingerprint[1] = 0x85A308D3L;
+  fingerprint[2] = 0x13198A2EL;
+  fingerprint[3] = 0x03707344L;
+  fingerprint[4] = 0xA4093822L;
+  fingerprint[5] = 0x299F31D0L;
+  fingerprint[6] = 0x082EFA98L;
+  fingerprint[7] = 0xEC4E6C89L;
+}
+
+/* translate 128 characters into a block and hash it */
+template <int PASS, int FPTLEN>
+void haval<PASS, FPTLEN>::hash_bytes (haval_word fpt[8], const unsigned char *str)
+{
+  haval_word w[32];
+
+  for (int i = 0; i < 32; i++, str += 4) {
+    w[i] =  (haval_word)str[0]        |
+           ((haval_word)str[1] <<  8) |
+           ((haval_word)str[2] << 16) |
+           ((haval_word)str[3] << 24);
+  }
+  hash_block (fpt, w);
+}
+
+template <int PASS, int FPTLEN>
+void haval<PASS, FPTLEN>::hash (const unsigned char *str, size_t str_len)
+{
+  size_t rmd_len = (size_t)((count >> 3) & 0x7F),
+         i = 0;
+
+  count += (uint64_t)str_len << 3;
+
+  /* hash as many blocks as possible */
+  if (rmd_len + str_len >= 128) {
+    if (rmd_len) {
+      i = 128 - rmd_len;
+      memcpy (remainder + rmd_len, str, i);
+      hash_bytes (fingerprint, remainder);
+      rmd_len = 0;
+    }
+    for (; i + 127 < str_len; i += 128)
+      hash_bytes (fingerprint, str + i);
+  }
+
+  /* save the remaining input chars */
+  memcpy (remainder + rmd_len, str + i, str_len - i);
+}
+
+template <int PASS, int FPTLEN>
+void haval<PASS, FPTLEN>::end (unsigned char *final_fpt)
+{
+  static const unsigned char padding[128] = { 0x01 };
+  unsigned char tail[10];
+  size_t        rmd_len, pad_len;
+
+  /*
+   * save the version number, the number of passes, the fingerprint
+   * length and the number of bits in the unpadded message.
+   */
+  tail[0] = (unsigned char)(((FPTLEN  & 0x3) << 6) |
+                            ((PASS    & 0x7) << 3) |
+                             (HAVAL_VERSION & 0x7));
+  tail[1] = (unsigned char)((FPTLEN >> 2) & 0xFF);
+  for (int i = 0; i < 8; i++)
+    tail[2 + i] = (unsigned char)(count >> (8 * i));
+
+  /* pad out to 118 mod 128 */
+  rmd_len = (size_t)((count >> 3) & 0x7f);
+  pad_len = (rmd_len < 118) ? (118 - rmd_len) : (246 - rmd_len);
+  hash (padding, pad_len);
+
+  /*
+   * append the version number, the number of passes,
+   * the fingerprint length and the number of bits
+   */
+  hash (tail, 10);
+
+  /* tailor the last output */
+  tailor (fingerprint);
+
+  /* translate and save the final fingerprint */
+  for (int i = 0; i < FPTLEN >> 5; i++) {
+    final_fpt[4*i    ] = (unsigned char)( fingerprint[i]        & 0xFF);
+    final_fpt[4*i + 1] = (unsigned char)((fingerprint[i] >>  8) & 0xFF);
+    final_fpt[4*i + 2] = (unsigned char)((fingerprint[i] >> 16) & 0xFF);
+    final_fpt[4*i + 3] = (unsigned char)((fingerprint[i] >> 24) & 0xFF);
+  }
+
+  /* clear the state information, then get ready for the next message */
+  memset (remainder, 0, sizeof (remainder));
+  start ();
+}
+
+/* hash a 32-word block */
+template <int PASS, int FPTLEN>
+void haval<PASS, FPTLEN>::hash_block (haval_word fpt[8], const haval_word w[32])
+{
+  typedef haval_phi<PASS> phi;
+  haval_word t0 = fpt[0], t1 = fpt[1], t2 = fpt[2], t3 = fpt[3],
+             t4 = fpt[4], t5 = fpt[5], t6 = fpt[6], t7 = fpt[7];
+
+  /* Pass 1 */
+  FF_1(t7, t6, t5, t4, t3, t2, t1, t0, w[ 0]);
+  FF_1(t6, t5, t4, t3, t2, t1, t0, t7, w[ 1]);
+  FF_1(t5, t4, t3, t2, t1, t0, t7, t6, w[ 2]);
+  FF_1(t4, t3, t2, t1, t0, t7, t6, t5, w[ 3]);
+  FF_1(t3, t2, t1, t0, t7, t6, t5, t4, w[ 4]);
+  FF_1(t2, t1, t0, t7, t6, t5, t4, t3, w[ 5]);
+  FF_1(t1, t0, t7, t6, t5, t4, t3, t2, w[ 6]);
+  FF_1(t0, t7, t6, t5, t4, t3, t2, t1, w[ 7]);
+
+  FF_1(t7, t6, t5, t4, t3, t2, t1, t0, w[ 8]);
+  FF_1(t6, t5, t4, t3, t2, t1, t0, t7, w[ 9]);
+  FF_1(t5, t4, t3, t2, t1, t0, t7, t6, w[10]);
+  FF_1(t4, t3, t2, t1, t0, t7, t6, t5, w[11]);
+  FF_1(t3, t2, t1, t0, t7, t6, t5, t4, w[12]);
+  FF_1(t2, t1, t0, t7, t6, t5, t4, t3, w[13]);
+  FF_1(t1, t0, t7, t6, t5, t4, t3, t2, w[14]);
+  FF_1(t0, t7, t6, t5, t4, t3, t2, t1, w[15]);
+
+  FF_1(t7, t6, t5, t4, t3, t2, t1, t0, w[16]);
+  FF_1(t6, t5, t4, t3, t2, t1, t0, t7, w[17]);
+  FF_1(t5, t4, t3, t2, t1, t0, t7, t6, w[18]);
+  FF_1(t4, t3, t2, t1, t0, t7, t6, t5, w[19]);
+  FF_1(t3, t2, t1, t0, t7, t6, t5, t4, w[20]);
+  FF_1(t2, t1, t0, t7, t6, t5, t4, t3, w[21]);
+  FF_1(t1, t0, t7, t6, t5, t4, t3, t2, w[22]);
+  FF_1(t0, t7, t6, t5, t4, t3, t2, t1, w[23]);
+
+  FF_1(t7, t6, t5, t4, t3, t2, t1, t0, w[24]);
+  FF_1(t6, t5, t4, t3, t2, t1, t0, t7, w[25]);
+  FF_1(t5, t4, t3, t2, t1, t0, t7, t6, w[26]);
+  FF_1(t4, t3, t2, t1, t0, t7, t6, t5, w[27]);
+  FF_1(t3, t2, t1, t0, t7, t6, t5, t4, w[28]);
+  FF_1(t2, t1, t0, t7, t6, t5, t4, t3, w[29]);
+  FF_1(t1, t0, t7, t6, t5, t4, t3, t2, w[30]);
+  FF_1(t0, t7, t6, t5, t4, t3, t2, t1, w[31]);
+
+  /* Pass 2 */
+  FF_2(t7, t6, t5, t4, t3, t2, t1, t0, w[ 5], 0x452821E6L);
+  FF_2(t6, t5, t4, t3, t2, t1, t0, t7, w[14], 0x38D01377L);
+  FF_2(t5, t4, t3, t2, t1, t0, t7, t6, w[26], 0xBE5466CFL);
+  FF_2(t4, t3, t2, t1, t0, t7, t6, t5, w[18], 0x34E90C6CL);
+  FF_2(t3, t2, t1, t0, t7, t6, t5, t4, w[11], 0xC0AC29B7L);
+  FF_2(t2, t1, t0, t7, t6, t5, t4, t3, w[28], 0xC97C50DDL);
+  FF_2(t1, t0, t7, t6, t5, t4, t3, t2, w[ 7], 0x3F84D5B5L);
+  FF_2(t0, t7, t6, t5, t4, t3, t2, t1, w[16], 0xB5470917L);
+
+  FF_2(t7, t6, t5, t4, t3, t2, t1, t0, w[ 0], 0x9216D5D9L);
+  FF_2(t6, t5, t4, t3, t2, t1, t0, t7, w[23], 0x8979FB1BL);
+  FF_2(t5, t4, t3, t2, t1, t0, t7, t6, w[20], 0xD1310BA6L);
+  FF_2(t4, t3, t2, t1, t0, t7, t6, t5, w[22], 0x98DFB5ACL);
+  FF_2(t3, t2, t1, t0, t7, t6, t5, t4, w[ 1], 0x2FFD72DBL);
+  FF_2(t2, t1, t0, t7, t6, t5, t4, t3, w[10], 0xD01ADFB7L);
+  FF_2(t1, t0, t7, t6, t5, t4, t3, t2, w[ 4], 0xB8E1AFEDL);
+  FF_2(t0, t7, t6, t5, t4, t3, t2, t1, w[ 8], 0x6A267E96L);
+
+  FF_2(t7, t6, t5, t4, t3, t2, t1, t0, w[30], 0xBA7C9045L);
+  FF_2(t6, t5, t4, t3, t2, t1, t0, t7, w[ 3], 0xF12C7F99L);
+  FF_2(t5, t4, t3, t2, t1, t0, t7, t6, w[21], 0x24A19947L);
+  FF_2(t4, t3, t2, t1, t0, t7, t6, t5, w[ 9], 0xB3916CF7L);
+  FF_2(t3, t2, t1, t0, t7, t6, t5, t4, w[17], 0x0801F2E2L);
+  FF_2(t2, t1, t0, t7, t6, t5, t4, t3, w[24], 0x858EFC16L);
+  FF_2(t1, t0, t7, t6, t5, t4, t3, t2, w[29], 0x636920D8L);
+  FF_2(t0, t7, t6, t5, t4, t3, t2, t1, w[ 6], 0x71574E69L);
+
+  FF_2(t7, t6, t5, t4, t3, t2, t1, t0, w[19], 0xA458FEA3L);
+  FF_2(t6, t5, t4, t3, t2, t1, t0, t7, w[12], 0xF4933D7EL);
+  FF_2(t5, t4, t3, t2, t1, t0, t7, t6, w[15], 0x0D95748FL);
+  FF_2(t4, t3, t2, t1, t0, t7, t6, t5, w[13], 0x728EB658L);
+  FF_2(t3, t2, t1, t0, t7, t6, t5, t4, w[ 2], 0x718BCD58L);
+  FF_2(t2, t1, t0, t7, t6, t5, t4, t3, w[25], 0x82154AEEL);
+  FF_2(t1, t0, t7, t6, t5, t4, t3, t2, w[31], 0x7B54A41DL);
+  FF_2(t0, t7, t6, t5, t4, t3, t2, t1, w[27], 0xC25A59B5L);
+
+  /* Pass 3 */
+  FF_3(t7, t6, t5, t4, t3, t2, t1, t0, w[19], 0x9C30D539L);
+  FF_3(t6, t5, t4, t3, t2, t1, t0, t7, w[ 9], 0x2AF26013L);
+  FF_3(t5, t4, t3, t2, t1, t0, t7, t6, w[ 4], 0xC5D1B023L);
+  FF_3(t4, t3, t2, t1, t0, t7, t6, t5, w[20], 0x286085F0L);
+  FF_3(t3, t2, t1, t0, t7, t6, t5, t4, w[28], 0xCA417918L);
+  FF_3(t2, t1, t0, t7, t6, t5, t4, t3, w[17], 0xB8DB38EFL);
+  FF_3(t1, t0, t7, t6, t5, t4, t3, t2, w[ 8], 0x8E79DCB0L);
+  FF_3(t0, t7, t6, t5, t4, t3, t2, t1, w[22], 0x603A180EL);
+
+  FF_3(t7, t6, t5, t4, t3, t2, t1, t0, w[29], 0x6C9E0E8BL);
+  FF_3(t6, t5, t4, t3, t2, t1, t0, t7, w[14], 0xB01E8A3EL);
+  FF_3(t5, t4, t3, t2, t1, t0, t7, t6, w[25], 0xD71577C1L);
+  FF_3(t4, t3, t2, t1, t0, t7, t6, t5, w[12], 0xBD314B27L);
+  FF_3(t3, t2, t1, t0, t7, t6, t5, t4, w[24], 0x78AF2FDAL);
+  FF_3(t2, t1, t0, t7, t6, t5, t4, t3, w[30], 0x55605C60L);
+  FF_3(t1, t0, t7, t6, t5, t4, t3, t2, w[16], 0xE65525F3L);
+  FF_3(t0, t7, t6, t5, t4, t3, t2, t1, w[26], 0xAA55AB94L);
+
+  FF_3(t7, t6, t5, t4, t3, t2, t1, t0, w[31], 0x57489862L);
+  FF_3(t6, t5, t4, t3, t2, t1, t0, t7, w[15], 0x63E81440L);
+  FF_3(t5, t4, t3, t2, t1, t0, t7, t6, w[ 7], 0x55CA396AL);
+  FF_3(t4, t3, t2, t1, t0, t7, t6, t5, w[ 3], 0x2AAB10B6L);
+  FF_3(t3, t2, t1, t0, t7, t6, t5, t4, w[ 1], 0xB4CC5C34L);
+  FF_3(t2, t1, t0, t7, t6, t5, t4, t3, w[ 0], 0x1141E8CEL);
+  FF_3(t1, t0, t7, t6, t5, t4, t3, t2, w[18], 0xA15486AFL);
+  FF_3(t0, t7, t6, t5, t4, t3, t2, t1, w[27], 0x7C72E993L);
+
+  FF_3(t7, t6, t5, t4, t3, t2, t1, t0, w[13], 0xB3EE1411L);
+  FF_3(t6, t5, t4, t3, t2, t1, t0, t7, w[ 6], 0x636FBC2AL);
+  FF_3(t5, t4, t3, t2, t1, t0, t7, t6, w[21], 0x2BA9C55DL);
+  FF_3(t4, t3, t2, t1, t0, t7, t6, t5, w[10], 0x741831F6L);
+  FF_3(t3, t2, t1, t0, t7, t6, t5, t4, w[23], 0xCE5C3E16L);
+  FF_3(t2, t1, t0, t7, t6, t5, t4, t3, w[11], 0x9B87931EL);
+  FF_3(t1, t0, t7, t6, t5, t4, t3, t2, w[ 5], 0xAFD6BA33L);
+  FF_3(t0, t7, t6, t5, t4, t3, t2, t1, w[ 2], 0x6C24CF5CL);
+
+  if constexpr (PASS >= 4) {
+    /* Pass 4. executed only when PASS =4 or 5 */
+    FF_4(t7, t6, t5, t4, t3, t2, t1, t0, w[24], 0x7A325381L);
+    FF_4(t6, t5, t4, t3, t2, t1, t0, t7, w[ 4], 0x28958677L);
+    FF_4(t5, t4, t3, t2, t1, t0, t7, t6, w[ 0], 0x3B8F4898L);
+    FF_4(t4, t3, t2, t1, t0, t7, t6, t5, w[14], 0x6B4BB9AFL);
+    FF_4(t3, t2, t1, t0, t7, t6, t5, t4, w[ 2], 0xC4BFE81BL);
+    FF_4(t2, t1, t0, t7, t6, t5, t4, t3, w[ 7], 0x66282193L);
+    FF_4(t1, t0, t7, t6, t5, t4, t3, t2, w[28], 0x61D809CCL);
+    FF_4(t0, t7, t6, t5, t4, t3, t2, t1, w[23], 0xFB21A991L);
+
+    FF_4(t7, t6, t5, t4, t3, t2, t1, t0, w[26], 0x487CAC60L);
+    FF_4(t6, t5, t4, t3, t2, t1, t0, t7, w[ 6], 0x5DEC8032L);
+    FF_4(t5, t4, t3, t2, t1, t0, t7, t6, w[30], 0xEF845D5DL);
+    FF_4(t4, t3, t2, t1, t0, t7, t6, t5, w[20], 0xE98575B1L);
+    FF_4(t3, t2, t1, t0, t7, t6, t5, t4, w[18], 0xDC262302L);
+    FF_4(t2, t1, t0, t7, t6, t5, t4, t3, w[25], 0xEB651B88L);
+    FF_4(t1, t0, t7, t6, t5, t4, t3, t2, w[19], 0x23893E81L);
+    FF_4(t0, t7, t6, t5, t4, t3, t2, t1, w[ 3], 0xD396ACC5L);
+
+    FF_4(t7, t6, t5, t4, t3, t2, t1, t0, w[22], 0x0F6D6FF3L);
+    FF_4(t6, t5, t4, t3, t2, t1, t0, t7, w[11], 0x83F44239L);
+    FF_4(t5, t4, t3, t2, t1, t0, t7, t6, w[31], 0x2E0B4482L);
+    FF_4(t4, t3, t2, t1, t0, t7, t6, t5, w[21], 0xA4842004L);
+    FF_4(t3, t2, t1, t0, t7, t6, t5, t4, w[ 8], 0x69C8F04AL);
+    FF_4(t2, t1, t0, t7, t6, t5, t4, t3, w[27], 0x9E1F9B5EL);
+    FF_4(t1, t0, t7, t6, t5, t4, t3, t2, w[12], 0x21C66842L);
+    FF_4(t0, t7, t6, t5, t4, t3, t2, t1, w[ 9], 0xF6E96C9AL);
+
+    FF_4(t7, t6, t5, t4, t3, t2, t1, t0, w[ 1], 0x670C9C61L);
+    FF_4(t6, t5, t4, t3, t2, t1, t0, t7, w[29], 0xABD388F0L);
+    FF_4(t5, t4, t3, t2, t1, t0, t7, t6, w[ 5], 0x6A51A0D2L);
+    FF_4(t4, t3, t2, t1, t0, t7, t6, t5, w[15], 0xD8542F68L);
+    FF_4(t3, t2, t1, t0, t7, t6, t5, t4, w[17], 0x960FA728L);
+    FF_4(t2, t1, t0, t7, t6, t5, t4, t3, w[10], 0xAB5133A3L);
+    FF_4(t1, t0, t7, t6, t5, t4, t3, t2, w[16], 0x6EEF0B6CL);
+    FF_4(t0, t7, t6, t5, t4, t3, t2, t1, w[13], 0x137A3BE4L);
+  }
+
+  if constexpr (PASS == 5) {
+    /* Pass 5. executed only when PASS = 5 */
+    FF_5(t7, t6, t5, t4, t3, t2, t1, t0, w[27], 0xBA3BF050L);
+    FF_5(t6, t5, t4, t3, t2, t1, t0, t7, w[ 3], 0x7EFB2A98L);
+    FF_5(t5, t4, t3, t2, t1, t0, t7, t6, w[21], 0xA1F1651DL);
+    FF_5(t4, t3, t2, t1, t0, t7, t6, t5, w[26], 0x39AF0176L);
+    FF_5(t3, t2, t1, t0, t7, t6, t5, t4, w[17], 0x66CA593EL);
+    FF_5(t2, t1, t0, t7, t6, t5, t4, t3, w[11], 0x82430E88L);
+    FF_5(t1, t0, t7, t6, t5, t4, t3, t2, w[20], 0x8CEE8619L);
+    FF_5(t0, t7, t6, t5, t4, t3, t2, t1, w[29], 0x456F9FB4L);
+
+    FF_5(t7, t6, t5, t4, t3, t2, t1, t0, w[19], 0x7D84A5C3L);
+    FF_5(t6, t5, t4, t3, t2, t1, t0, t7, w[ 0], 0x3B8B5EBEL);
+    FF_5(t5, t4, t3, t2, t1, t0, t7, t6, w[12], 0xE06F75D8L);
+    FF_5(t4, t3, t2, t1, t0, t7, t6, t5, w[ 7], 0x85C12073L);
+    FF_5(t3, t2, t1, t0, t7, t6, t5, t4, w[13], 0x401A449FL);
+    FF_5(t2, t1, t0, t7, t6, t5, t4, t3, w[ 8], 0x56C16AA6L);
+    FF_5(t1, t0, t7, t6, t5, t4, t3, t2, w[31], 0x4ED3AA62L);
+    FF_5(t0, t7, t6, t5, t4, t3, t2, t1, w[10], 0x363F7706L);
+
+    FF_5(t7, t6, t5, t4, t3, t2, t1, t0, w[ 5], 0x1BFEDF72L);
+    FF_5(t6, t5, t4, t3, t2, t1, t0, t7, w[ 9], 0x429B023DL);
+    FF_5(t5, t4, t3, t2, t1, t0, t7, t6, w[14], 0x37D0D724L);
+    FF_5(t4, t3, t2, t1, t0, t7, t6, t5, w[30], 0xD00A1248L);
+    FF_5(t3, t2, t1, t0, t7, t6, t5, t4, w[18], 0xDB0FEAD3L);
+    FF_5(t2, t1, t0, t7, t6, t5, t4, t3, w[ 6], 0x49F1C09BL);
+    FF_5(t1, t0, t7, t6, t5, t4, t3, t2, w[28], 0x075372C9L);
+    FF_5(t0, t7, t6, t5, t4, t3, t2, t1, w[24], 0x80991B7BL);
+
+    FF_5(t7, t6, t5, t4, t3, t2, t1, t0, w[ 2], 0x25D479D8L);
+    FF_5(t6, t5, t4, t3, t2, t1, t0, t7, w[23], 0xF6E8DEF7L);
+    FF_5(t5, t4, t3, t2, t1, t0, t7, t6, w[16], 0xE3FE501AL);
+    FF_5(t4, t3, t2, t1, t0, t7, t6, t5, w[22], 0xB6794C3BL);
+    FF_5(t3, t2, t1, t0, t7, t6, t5, t4, w[ 4], 0x976CE0BDL);
+    FF_5(t2, t1, t0, t7, t6, t5, t4, t3, w[ 1], 0x04C006BAL);
+    FF_5(t1, t0, t7, t6, t5, t4, t3, t2, w[25], 0xC1A94FB6L);
+    FF_5(t0, t7, t6, t5, t4, t3, t2, t1, w[15], 0x409F60C4L);
+  }
+
+
+  fpt[0] += t0;
+  fpt[1] += t1;
+  fpt[2] += t2;
+  fpt[3] += t3;
+  fpt[4] += t4;
+  fpt[5] += t5;
+  fpt[6] += t6;
+  fpt[7] += t7;
+}
+
+/* tailor the last output; 256-bit fingerprints are used as they are */
+template <int PASS, int FPTLEN>
+void haval<PASS, FPTLEN>::tailor (haval_word fpt[8])
+{
+  haval_word temp;
+
+  if constexpr (FPTLEN == 128) {
+    temp = (fpt[7] & 0x000000FFL) |
+           (fpt[6] & 0xFF000000L) |
+           (fpt[5] & 0x00FF0000L) |
+           (fpt[4] & 0x0000FF00L);
+    fpt[0] += rotate_right(temp,  8);
+
+    temp = (fpt[7] & 0x0000FF00L) |
+           (fpt[6] & 0x000000FFL) |
+           (fpt[5] & 0xFF000000L) |
+           (fpt[4] & 0x00FF0000L);
+    fpt[1] += rotate_right(temp, 16);
+
+    temp  = (fpt[7] & 0x00FF0000L) |
+            (fpt[6] & 0x0000FF00L) |
+            (fpt[5] & 0x000000FFL) |
+            (fpt[4] & 0xFF000000L);
+    fpt[2] += rotate_right(temp, 24);
+
+    temp = (fpt[7] & 0xFF000000L) |
+           (fpt[6] & 0x00FF0000L) |
+           (fpt[5] & 0x0000FF00L) |
+           (fpt[4] & 0x000000FFL);
+    fpt[3] += temp;
+
+  } else if constexpr (FPTLEN == 160) {
+    temp = (fpt[7] &  (haval_word)0x3F) |
+           (fpt[6] & ((haval_word)0x7F << 25)) |
+           (fpt[5] & ((haval_word)0x3F << 19));
+    fpt[0] += rotate_right(temp, 19);
+
+    temp = (fpt[7] & ((haval_word)0x3F <<  6)) |
+           (fpt[6] &  (haval_word)0x3F) |
+           (fpt[5] & ((haval_word)0x7F << 25));
+    fpt[1] += rotate_right(temp, 25);
+
+    temp = (fpt[7] & ((haval_word)0x7F << 12)) |
+           (fpt[6] & ((haval_word)0x3F <<  6)) |
+           (fpt[5] &  (haval_word)0x3F);
+    fpt[2] += temp;
+
+    temp = (fpt[7] & ((haval_word)0x3F << 19)) |
+           (fpt[6] & ((haval_word)0x7F << 12)) |
+           (fpt[5] & ((haval_word)0x3F <<  6));
+    fpt[3] += temp >> 6;
+
+    temp = (fpt[7] & ((haval_word)0x7F << 25)) |
+           (fpt[6] & ((haval_word)0x3F << 19)) |
+           (fpt[5] & ((haval_word)0x7F << 12));
+    fpt[4] += temp >> 12;
+
+  } else if constexpr (FPTLEN == 192) {
+    temp = (fpt[7] &  (haval_word)0x1F) |
+           (fpt[6] & ((haval_word)0x3F << 26));
+    fpt[0] += rotate_right(temp, 26);
+
+    temp = (fpt[7] & ((haval_word)0x1F <<  5)) |
+           (fpt[6] &  (haval_word)0x1F);
+    fpt[1] += temp;
+
+    temp = (fpt[7] & ((haval_word)0x3F << 10)) |
+           (fpt[6] & ((haval_word)0x1F <<  5));
+    fpt[2] += temp >> 5;
+
+    temp = (fpt[7] & ((haval_word)0x1F << 16)) |
+           (fpt[6] & ((haval_word)0x3F << 10));
+    fpt[3] += temp >> 10;
+
+    temp = (fpt[7] & ((haval_word)0x1F << 21)) |
+           (fpt[6] & ((haval_word)0x1F << 16));
+    fpt[4] += temp >> 16;
+
+    temp = (fpt[7] & ((haval_word)0x3F << 26)) |
+           (fpt[6] & ((haval_word)0x1F << 21));
+    fpt[5] += temp >> 21;
+
+  } else if constexpr (FPTLEN == 224) {
+    fpt[0] += (fpt[7] >> 27) & 0x1F;
+    fpt[1] += (fpt[7] >> 22) & 0x1F;
+    fpt[2] += (fpt[7] >> 18) & 0x0F;
+    fpt[3] += (fpt[7] >> 13) & 0x1F;
+    fpt[4] += (fpt[7] >>  9) & 0x0F;
+    fpt[5] += (fpt[7] >>  4) & 0x1F;
+    fpt[6] +=  fpt[7]        & 0x0F;
+  }
+}
+
+#undef FF_1
+#undef FF_2
+#undef FF_3
+#undef FF_4
+#undef FF_5
+#undef f_1
+#undef f_2
+#undef f_3
+#undef f_4
+#undef f_5
+#undef rotate_right
+
+/*
+ * map "haval-<FPTLEN>-<PASS>", e.g. "haval-256-5", to a hasher of that
+ * variant; returns an empty pointer for unknown names.
+ */
+inline std::unique_ptr<haval_hasher> haval_create (const char *name)
+{
+  struct variant {
+    const char   *name;
+    haval_hasher *(*create) ();
+  };
+#define HAVAL_VARIANT(fptlen, pass) \
+  { "haval-" #fptlen "-" #pass, [] () -> haval_hasher * { return new haval<pass, fptlen>; } }
+  static const variant variants[] = {
+    HAVAL_VARIANT(128, 3), HAVAL_VARIANT(128, 4), HAVAL_VARIANT(128, 5),
+    HAVAL_VARIANT(160, 3), HAVAL_VARIANT(160, 4), HAVAL_VARIANT(160, 5),
+    HAVAL_VARIANT(192, 3), HAVAL_VARIANT(192, 4), HAVAL_VARIANT(192, 5),
+    HAVAL_VARIANT(224, 3), HAVAL_VARIANT(224, 4), HAVAL_VARIANT(224, 5),
+    HAVAL_VARIANT(256, 3), HAVAL_VARIANT(256, 4), HAVAL_VARIANT(256, 5)
+  };
+#undef HAVAL_VARIANT
+
+  for (const variant &v : variants)
+    if (strcmp (name, v.name) == 0)
+      return std::unique_ptr<haval_hasher> (v.create ());
+  return std::unique_ptr<haval_hasher> ();
+}
+
+#endif /* HAVAL_HPP */
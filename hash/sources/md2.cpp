@@ -49,6 +49,25 @@ SKIP Source Code License Statement:
 
 NAMESPACE_BEGIN(CryptoPP)
 
+static const byte permutation[256] = {
+	 41, 46, 67,201,162,216,124,  1, 61, 54, 84,161,236,240,  6, 19,
+	 98,167,  5,243,192,199,115,140,152,147, 43,217,188, 76,130,202,
+	 30,155, 87, 60,253,212,224, 22,103, 66,111, 24,138, 23,229, 18,
+	190, 78,196,214,218,158,222, 73,160,251,245,142,187, 47,238,122,
+	169,104,121,145, 21,178,  7, 63,148,194, 16,137, 11, 34, 95, 33,
+	128,127, 93,154, 90,144, 50, 39, 53, 62,204,231,191,247,151,  3,
+	255, 25, 48,179, 72,165,181,209,215, 94,146, 42,172, 86,170,198,
+	 79,184, 56,210,150,164,125,182,118,252,107,226,156,116,  4,241,
+	 69,157,112, 89,100,113,135, 32,134, 91,207,101,230, 45,168,  2,
+	 27, 96, 37,173,174,176,185,246, 28, 70, 97,105, 52, 64,126, 15,
+	 85, 71,163, 35,221, 81,175, 58,195, 92,249,206,186,197,234, 38,
+	 44, 83, 13,110,133, 40,132,  9,211,223,205,244, 65,129, 77, 82,
+	106,220, 55,200,108,193,171,250, 36,225,123,  8, 12,189,177, 74,
+	120,136,149,139,227, 99,232,109,233,203,213,254, 59,  0, 29, 57,
+	242,239,183, 14,102, 88,208,228,166,119,114,248,235,117, 75, 10,
+	 49, 68, 80,180,143,237, 31, 26,219,153,141, 51,159, 17,131, 20
+};
+
 MD2::MD2()
 	: buf(64)
 {
@@ -100,25 +119,6 @@ void MD2::Final(byte *hash)
 
 void MD2::Transform()
 {
-	static const byte permutation[256] = {
-		 41, 46, 67,201,162,216,124,  1, 61, 54, 84,161,236,240,  6, 19,
-		 98,167,  5,243,192,199,115,140,152,147, 43,217,188, 76,130,202,
-		 30,155, 87, 60,253,212,224, 22,103, 66,111, 24,138, 23,229, 18,
-		190, 78,196,214,218,158,222, 73,160,251,245,142,187, 47,238,122,
-		169,104,121,145, 21,178,  7, 63,148,194, 16,137, 11, 34, 95, 33,
-		128,127, 93,154, 90,144, 50, 39, 53, 62,204,231,191,247,151,  3,
-		255, 25, 48,179, 72,165,181,209,215, 94,146, 42,172, 86,170,198,
-		 79,184, 56,210,150,164,125,182,118,252,107,226,156,116,  4,241,
-		 69,157,112, 89,100,113,135, 32,134, 91,207,101,230, 45,168,  2,
-		 27, 96, 37,173,174,176,185,246, 28, 70, 97,105, 52, 64,126, 15,
-		 85, 71,163, 35,221, 81,175, 58,195, 92,249,206,186,197,234, 38,
-		 44, 83, 13,110,133, 40,132,  9,211,223,205,244, 65,129, 77, 82,
-		106,220, 55,200,108,193,171,250, 36,225,123,  8, 12,189,177, 74,
-		120,136,149,139,227, 99,232,109,233,203,213,254, 59,  0, 29, 57,
-		242,239,183, 14,102, 88,208,228,166,119,114,248,235,117, 75, 10,
-		 49, 68, 80,180,143,237, 31, 26,219,153,141, 51,159, 17,131, 20
-	};
-
 	// Fill in the temp buf
 	unsigned int i;
 	for (i = 0; i < 16; i++)
@@ -139,4 +139,127 @@ void MD2::Transform()
 	}
 }
 
+// Working set of one lane of the multi-message path.  X holds the state,
+// the current block and the scratch copy exactly like buf does, followed by
+// the checksum, and is aligned so every lane sits in its own 64-byte line.
+struct alignas(64) MD2Lane
+{
+	byte X[48];
+	byte C[16];
+};
+
+// Same as MD2::Transform(), but on N lanes at once.  The lookup chains of
+// the lanes are independent, so interleaving them lets the loads of one
+// lane issue while another is still waiting on its previous lookup.
+template <unsigned int N>
+static void MD2TransformLanes(MD2Lane *lane)
+{
+	byte t[N];
+	unsigned int i, j, l;
+
+	for (l = 0; l < N; l++)
+		for (i = 0; i < 16; i++)
+			lane[l].X[i+32] = lane[l].X[i+16] ^ lane[l].X[i];
+
+	for (l = 0; l < N; l++)
+		t[l] = lane[l].C[15];
+	for (i = 0; i < 16; i++)
+		for (l = 0; l < N; l++)
+			t[l] = lane[l].C[i] ^= permutation[lane[l].X[16+i] ^ t[l]];
+
+	for (l = 0; l < N; l++)
+		t[l] = 0;
+	for (i = 0; i < 18; i++)
+	{
+		for (j = 0; j < 48; j++)
+			for (l = 0; l < N; l++)
+				t[l] = lane[l].X[j] ^= permutation[t[l]];
+		for (l = 0; l < N; l++)
+			t[l] += i;
+	}
+}
+
+// Feed the messages through N lanes.  A lane that finishes its message
+// (data blocks, padding block, checksum block) writes its digest and picks
+// up the next pending message, so lanes stay busy even when the lengths
+// differ.  Idle lanes keep churning on stale data, which is never read.
+template <unsigned int N>
+static void MD2HashLanes(byte *digests, const byte *const *inputs, const unsigned int *lengths, unsigned int count)
+{
+	MD2Lane lane[N];
+	unsigned int msg[N], step[N], next = 0, busy = 0, l;
+
+	memset(lane, 0, sizeof(lane));
+	for (l = 0; l < N; l++)
+	{
+		msg[l] = next < count ? next++ : count;
+		step[l] = 0;
+		busy += msg[l] < count;
+	}
+
+	while (busy)
+	{
+		for (l = 0; l < N; l++)
+		{
+			if (msg[l] == count)
+				continue;
+
+			const byte *input = inputs[msg[l]];
+			unsigned int blocks = lengths[msg[l]] / 16;
+			byte *block = lane[l].X + 16;
+
+			if (step[l] < blocks)
+				memcpy(block, input+16*step[l], 16);
+			else if (step[l] == blocks)
+			{
+				unsigned int len = lengths[msg[l]] % 16;
+				memcpy(block, input+16*step[l], len);
+				memset(block+len, 16-len, 16-len);
+			}
+			else
+				memcpy(block, lane[l].C, 16);
+		}
+
+		MD2TransformLanes<N>(lane);
+
+		for (l = 0; l < N; l++)
+		{
+			if (msg[l] == count || step[l]++ <= lengths[msg[l]] / 16)
+				continue;
+
+			memcpy(digests+16*msg[l], lane[l].X, 16);
+			memset(&lane[l], 0, sizeof(MD2Lane));
+			step[l] = 0;
+			if (next < count)
+				msg[l] = next++;
+			else
+			{
+				msg[l] = count;
+				busy--;
+			}
+		}
+	}
+
+	memset(lane, 0, sizeof(lane));
+}
+
+// Hash count independent messages, writing 16*count bytes to digests.
+void MD2::CalculateDigests(byte *digests, const byte *const *inputs, const unsigned int *lengths, unsigned int count)
+{
+	// a lane costs a full transform per step whether it is busy or not,
+	// so the lane count never exceeds the number of messages
+	if (count >= 8)
+		MD2HashLanes<8>(digests, inputs, lengths, count);
+	else if (count >= 4)
+		MD2HashLanes<4>(digests, inputs, lengths, count);
+	else if (count >= 2)
+		MD2HashLanes<2>(digests, inputs, lengths, count);
+	else if (count == 1)
+	{
+		MD2 md2;
+		md2.Update(inputs[0], lengths[0]);
+		md2.Final(digests);
+	}
+}
+
 NAMESPACE_END
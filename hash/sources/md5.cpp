@@ -15,11 +15,15 @@ MD5::MD5()
 void MD5::Init()
 {
 	countLo = countHi = 0;
+	InitState(digest);
+}
 
-	digest[0] = 0x67452301L;
-	digest[1] = 0xefcdab89L;
-	digest[2] = 0x98badcfeL;
-	digest[3] = 0x10325476L;
+void MD5::InitState(word32 *state)
+{
+	state[0] = 0x67452301L;
+	state[1] = 0xefcdab89L;
+	state[2] = 0x98badcfeL;
+	state[3] = 0x10325476L;
 }
 
 void MD5::HashBlock(const word32 *input)
@@ -47,6 +51,40 @@ void MD5::Final (byte *hash)
 	Init();		// reinit for next use
 }
 
+// One-shot digest for messages of at most 2*DATASIZE-9 bytes: the padded
+// final block(s) are laid out directly on the stack and hashed with one or
+// two Transforms, bypassing the Update()/PadLastBlock()/Final() copies.
+void MD5::CalculateDigest(byte *hash, const byte *input, unsigned int length)
+{
+	// the short path must not drop data already buffered by Update()
+	if (length > 2*DATASIZE-9 || countLo || countHi)
+	{
+		IteratedHash<word32>::CalculateDigest(hash, input, length);
+		return;
+	}
+
+	FixedSizeSecBlock<word32, 32> block;
+	FixedSizeSecBlock<word32, 4> state;
+	unsigned int blocks = length < 56 ? 1 : 2;
+	byte *b = (byte *)(word32 *)block;
+
+	memcpy(b, input, length);
+	b[length] = 0x80;
+	memset(b+length+1, 0, 64*blocks-8-(length+1));
+	CorrectEndianess(block, block, 64*blocks-8);
+
+	block[16*blocks-2] = length << 3;
+	block[16*blocks-1] = 0;
+
+	InitState(state);
+	Transform(state, block);
+	if (blocks == 2)
+		Transform(state, block+16);
+
+	CorrectEndianess(state, state, DIGESTSIZE);
+	memcpy(hash, state, DIGESTSIZE);
+}
+
 void MD5::Transform (word32 *digest, const word32 *X)
 {
 // #define	F(x,y,z)	((x & y)  |  (~x & z))
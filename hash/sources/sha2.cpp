@@ -9,6 +9,42 @@
 
 NAMESPACE_BEGIN(CryptoPP)
 
+// Lay out the padded final block(s) of a message of at most 2*64-9 bytes
+// directly in big-endian word order.  Returns the number of 64-byte blocks
+// that need to be transformed.
+static unsigned int PadShortMessage(word32 *block, const byte *input, size_t length)
+{
+	unsigned int blocks = length < 56 ? 1 : 2;
+	byte *b = (byte *)block;
+
+	memcpy(b, input, length);
+	b[length] = 0x80;
+	memset(b+length+1, 0, 64*blocks-8-(length+1));
+	ConditionalByteReverse(BIG_ENDIAN_ORDER, block, block, 64*blocks-8);
+
+	block[16*blocks-2] = 0;
+	block[16*blocks-1] = word32(length << 3);
+	return blocks;
+}
+
+// One-shot digest for short messages: skips the buffered Update()/Final()
+// path and writes the state straight out after one or two Transforms.
+template <class T>
+static void CalculateShortDigest(byte *digest, const byte *input, size_t length)
+{
+	FixedSizeSecBlock<word32, 32> block;
+	FixedSizeSecBlock<word32, 8> state;
+	unsigned int blocks = PadShortMessage(block, input, length);
+
+	T::InitState(state);
+	T::Transform(state, block);
+	if (blocks == 2)
+		T::Transform(state, block+16);
+
+	for (unsigned int i=0; i<T::DIGESTSIZE/4; i++)
+		PutWord(false, BIG_ENDIAN_ORDER, digest+4*i, state[i]);
+}
+
 // start of Steve Reid's code
 
 #define blk0(i) (W[i] = data[i])
@@ -78,6 +114,15 @@ void SHA::Transform(word32 *state, const word32 *data)
 	memset(W, 0, sizeof(W));
 }
 
+void SHA::CalculateDigest(byte *digest, const byte *input, size_t length)
+{
+	// the short path must not drop data already buffered by Update()
+	if (length > 2*BLOCKSIZE-9 || m_countLo || m_countHi)
+		HashTransformation::CalculateDigest(digest, input, length);
+	else
+		CalculateShortDigest<SHA>(digest, input, length);
+}
+
 #endif	// #ifndef CRYPTOPP_IMPORTS
 
 // end of Steve Reid's code
@@ -147,6 +192,14 @@ void SHA256::Transform(word32 *state, const word32 *data)
 	memset(T, 0, sizeof(T));
 }
 
+void SHA256::CalculateDigest(byte *digest, const byte *input, size_t length)
+{
+	if (length > 2*BLOCKSIZE-9 || m_countLo || m_countHi)
+		HashTransformation::CalculateDigest(digest, input, length);
+	else
+		CalculateShortDigest<SHA256>(digest, input, length);
+}
+
 const word32 SHA256::K[64] = {
 	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
 	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
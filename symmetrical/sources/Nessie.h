@@ -0,0 +1,73 @@
+/************************************************************************************/
+/* Nessie.h
+ *
+ * Project    : Nessie Proposal: NOEKEON
+ *
+ * Description: NESSIE portable C conventions and the interface of noekeon.c
+ */
+/************************************************************************************/
+
+#ifndef NESSIE_H
+#define NESSIE_H
+
+#include <limits.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Portable integer types: u8 and u32 hold at least 8 and 32 bits */
+typedef unsigned char u8;
+#define ONE8 0xffU
+#if UINT_MAX >= 4294967295UL
+typedef unsigned int u32;
+#define ONE32 0xffffffffU
+#else
+typedef unsigned long u32;
+#define ONE32 0xffffffffUL
+#endif
+
+#define T8(x)  ((x) & ONE8)
+#define T32(x) ((x) & ONE32)
+
+#define ROTL32(v, n) (T32((v) << (n)) | ((v) >> (32 - (n))))
+
+#define U8TO32_BIG(c)  (((u32)T8(*(c)) << 24) | ((u32)T8(*((c) + 1)) << 16) | \
+                        ((u32)T8(*((c) + 2)) << 8) | ((u32)T8(*((c) + 3))))
+#define U32TO8_BIG(c, v) do { u32 x = (v); u8 *d = (c); \
+                          d[0] = T8(x >> 24); d[1] = T8(x >> 16); \
+                          d[2] = T8(x >> 8); d[3] = T8(x); } while (0)
+
+/* Block cipher parameters, in bits */
+#define NESSIE_KEYSIZE   128
+#define NESSIE_BLOCKSIZE 128
+
+/* Working keys, both set by NESSIEkeysetup: k for encryption and kd = Theta(0,k)
+ * for decryption
+ */
+struct NESSIEstruct {
+  u32 k[4];
+  u32 kd[4];
+};
+
+void NESSIEkeysetup(const unsigned char * const key,
+                    struct NESSIEstruct * const structpointer);
+void NESSIEencrypt(const struct NESSIEstruct * const structpointer,
+                   const unsigned char * const plaintext,
+                   unsigned char * const ciphertext);
+void NESSIEdecrypt(const struct NESSIEstruct * const structpointer,
+                   const unsigned char * const ciphertext,
+                   unsigned char * const plaintext);
+
+/* n consecutive 16-byte blocks; in may be the same as out */
+void NESSIEencryptblocks(const struct NESSIEstruct * const structpointer,
+                         const unsigned char *in, unsigned char *out, size_t n);
+void NESSIEdecryptblocks(const struct NESSIEstruct * const structpointer,
+                         const unsigned char *in, unsigned char *out, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NESSIE_H */
@@ -0,0 +1,372 @@
+/*
+ *  bcrypt.hpp:  bcrypt password hashes on the EksBlowfish core in
+ *  blowfish.c, and a worker pool for hashing and checking them.
+ *
+ *  Hashes are the 60-character strings of OpenBSD's bcrypt,
+ *
+ *    $2b$10$<22 characters of salt><31 characters of hash>
+ *
+ *  "$2a$" and "$2y$" are accepted as the same algorithm.  Passwords are
+ *  NUL-terminated and only their first 72 bytes count.
+ *
+ *  The pool.  A login server checks many passwords at one cost, and the
+ *  time of one check is fixed by the cost.  What it can change is how
+ *  long a check waits behind others when logins arrive in bursts.
+ *  bcrypt_pool keeps one worker per hardware thread and a queue of
+ *  requests.  A worker that finds a request alone runs it alone, at
+ *  full single-hash speed.  A worker that finds a backlog takes up to
+ *  BLOWFISH_BCRYPT_LANES waiting requests of the same cost and runs
+ *  them in lock step (see blowfish_bcrypt), which finishes them sooner
+ *  than one after the other.  The backlog drains faster, and the tail
+ *  latency falls with it.
+ */
+
+#ifndef BCRYPT_HPP
+#define BCRYPT_HPP
+
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "blowfish.h"
+#include "block_cipher.hpp"
+
+/* "$2b$" cost "$" salt, and salt followed by the hash */
+#define BCRYPT_SETTING_LEN 29
+#define BCRYPT_HASH_LEN    60
+
+#define BCRYPT_MIN_COST    4
+#define BCRYPT_MAX_COST    31
+
+/* bytes of password that count */
+#define BCRYPT_MAX_KEY     72
+
+static const char bcrypt_alphabet[] =
+  "./ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+
+/* bcrypt's radix-64: big-endian bit order, no padding */
+inline void bcrypt_encode64 (const unsigned char *in, size_t len, char *out)
+{
+  for (size_t i = 0; i < len; i += 3)
+    {
+      unsigned long v = (unsigned long) in[i] << 16;
+      if (i + 1 < len)
+        v |= (unsigned long) in[i + 1] << 8;
+      if (i + 2 < len)
+        v |= in[i + 2];
+      *out++ = bcrypt_alphabet[v >> 18 & 63];
+      *out++ = bcrypt_alphabet[v >> 12 & 63];
+      if (i + 1 < len)
+        *out++ = bcrypt_alphabet[v >> 6 & 63];
+      if (i + 2 < len)
+        *out++ = bcrypt_alphabet[v & 63];
+    }
+}
+
+/* len bytes from the (4 * len + 2) / 3 characters at in */
+inline bool bcrypt_decode64 (const char *in, size_t len, unsigned char *out)
+{
+  unsigned long v = 0;
+  int bits = 0;
+  for (size_t n = 0; n < len; in++)
+    {
+      const char *p = *in ? strchr (bcrypt_alphabet, *in) : NULL;
+      if (!p)
+        return false;
+      v = v << 6 | (unsigned long) (p - bcrypt_alphabet);
+      bits += 6;
+      if (bits >= 8)
+        {
+          bits -= 8;
+          out[n++] = (unsigned char) (v >> bits);
+        }
+    }
+  return true;
+}
+
+/* one hash to compute: a parsed setting and the password as EksBlowfish key */
+struct bcrypt_params
+{
+  char          minor;          /* 'a', 'b' or 'y', kept in the output */
+  unsigned      cost;
+  unsigned char salt[16];
+  unsigned char key[BCRYPT_MAX_KEY];
+  unsigned      keylen;
+
+  ~bcrypt_params () { block_cipher_wipe (key, sizeof (key)); }
+};
+
+/* parse "$2b$cc$" and 22 salt characters; anything after them is ignored */
+inline bool bcrypt_parse (const char *setting, bcrypt_params &p)
+{
+  if (strlen (setting) < BCRYPT_SETTING_LEN || setting[0] != '$'
+      || setting[1] != '2' || !strchr ("aby", setting[2]) || setting[3] != '$'
+      || setting[4] < '0' || setting[4] > '9'
+      || setting[5] < '0' || setting[5] > '9' || setting[6] != '$')
+    return false;
+  p.minor = setting[2];
+  p.cost = (unsigned) (setting[4] - '0') * 10 + (unsigned) (setting[5] - '0');
+  if (p.cost < BCRYPT_MIN_COST || p.cost > BCRYPT_MAX_COST)
+    return false;
+  return bcrypt_decode64 (setting + 7, 16, p.salt);
+}
+
+/* the password and its NUL, cut to 72 bytes */
+inline void bcrypt_set_password (bcrypt_params &p, const char *password)
+{
+  size_t len = strlen (password);
+  p.keylen = (unsigned) std::min (len + 1, (size_t) BCRYPT_MAX_KEY);
+  memcpy (p.key, password, p.keylen);
+}
+
+/* "$2b$cc$salt" for a cost and 16 random bytes, NUL-terminated */
+inline bool bcrypt_setting (unsigned cost, const unsigned char salt[16],
+                            char out[BCRYPT_SETTING_LEN + 1])
+{
+  if (cost < BCRYPT_MIN_COST || cost > BCRYPT_MAX_COST)
+    return false;
+  memcpy (out, "$2b$", 4);
+  out[4] = (char) ('0' + cost / 10);
+  out[5] = (char) ('0' + cost % 10);
+  out[6] = '$';
+  bcrypt_encode64 (salt, 16, out + 7);
+  out[BCRYPT_SETTING_LEN] = 0;
+  return true;
+}
+
+/* the hash string for p and its raw EksBlowfish output */
+inline void bcrypt_format (const bcrypt_params &p, const unsigned char raw[24],
+                           char out[BCRYPT_HASH_LEN + 1])
+{
+  bcrypt_setting (p.cost, p.salt, out);
+  out[2] = p.minor;
+  bcrypt_encode64 (raw, 23, out + BCRYPT_SETTING_LEN);
+  out[BCRYPT_HASH_LEN] = 0;
+}
+
+/* n <= BLOWFISH_BCRYPT_LANES requests of one cost, computed together */
+inline void bcrypt_run (const bcrypt_params *const p[], int n,
+                        char out[][BCRYPT_HASH_LEN + 1])
+{
+  const byte *key[BLOWFISH_BCRYPT_LANES] = {}, *salt[BLOWFISH_BCRYPT_LANES] = {};
+  unsigned keylen[BLOWFISH_BCRYPT_LANES] = {};
+  unsigned char raw[BLOWFISH_BCRYPT_LANES][24];
+  byte *rawp[BLOWFISH_BCRYPT_LANES] = {};
+
+  for (int k = 0; k < n; k++)
+    {
+      key[k] = p[k]->key;
+      keylen[k] = p[k]->keylen;
+      salt[k] = p[k]->salt;
+      rawp[k] = raw[k];
+    }
+  blowfish_bcrypt (n, p[0]->cost, key, keylen, salt, rawp);
+  for (int k = 0; k < n; k++)
+    bcrypt_format (*p[k], raw[k], out[k]);
+}
+
+/* compare without an early exit, so timing shows nothing of the hash */
+inline bool bcrypt_equal (const char *a, const char *b, size_t len)
+{
+  unsigned char d = 0;
+  for (size_t i = 0; i < len; i++)
+    d |= (unsigned char) (a[i] ^ b[i]);
+  return d == 0;
+}
+
+/* hash password under setting (a setting or a whole hash) */
+inline bool bcrypt_hashpw (const char *password, const char *setting,
+                           char out[BCRYPT_HASH_LEN + 1])
+{
+  bcrypt_params p;
+  if (!bcrypt_parse (setting, p))
+    return false;
+  bcrypt_set_password (p, password);
+  const bcrypt_params *pp = &p;
+  char h[1][BCRYPT_HASH_LEN + 1];
+  bcrypt_run (&pp, 1, h);
+  memcpy (out, h[0], sizeof (h[0]));
+  return true;
+}
+
+inline bool bcrypt_checkpw (const char *password, const char *hash)
+{
+  char h[BCRYPT_HASH_LEN + 1];
+  bool ok = strlen (hash) == BCRYPT_HASH_LEN
+            && bcrypt_hashpw (password, hash, h)
+            && bcrypt_equal (h, hash, BCRYPT_HASH_LEN);
+  block_cipher_wipe (h, sizeof (h));
+  return ok;
+}
+
+class bcrypt_pool
+{
+public:
+  /* threads == 0 uses one worker per hardware thread */
+  explicit bcrypt_pool (unsigned int threads = 0);
+  ~bcrypt_pool ();
+
+  bcrypt_pool (const bcrypt_pool &) = delete;
+  bcrypt_pool &operator= (const bcrypt_pool &) = delete;
+
+  /* the hash string, or "" for a setting that is not bcrypt */
+  std::future<std::string> hashpw (const char *password, const char *setting);
+
+  std::future<bool> checkpw (const char *password, const char *hash);
+
+private:
+  struct job
+  {
+    bcrypt_params             p;
+    bool                      check;
+    char                      expect[BCRYPT_HASH_LEN + 1];
+    std::promise<std::string> hash;
+    std::promise<bool>        ok;
+  };
+
+  void submit (std::unique_ptr<job> j);
+  static void run (std::unique_ptr<job> *batch, int n);
+  void work ();
+
+  std::mutex                        m;
+  std::condition_variable           cv;
+  std::deque<std::unique_ptr<job>>  queue;
+  bool                              stopping;
+  std::vector<std::thread>          pool;
+};
+
+inline bcrypt_pool::bcrypt_pool (unsigned int threads)
+  : stopping (false)
+{
+  if (!threads)
+    threads = std::max (std::thread::hardware_concurrency (), 1u);
+  pool.reserve (threads);
+  for (unsigned int t = 0; t < threads; t++)
+    {
+      try
+        {
+          pool.emplace_back (&bcrypt_pool::work, this);
+        }
+      catch (const std::system_error &)
+        {
+          break;                     /* with no workers, callers run jobs */
+        }
+    }
+}
+
+/* finishes every queued request before returning */
+inline bcrypt_pool::~bcrypt_pool ()
+{
+  {
+    std::lock_guard<std::mutex> lock (m);
+    stopping = true;
+  }
+  cv.notify_all ();
+  for (auto &t : pool)
+    t.join ();
+}
+
+inline std::future<std::string> bcrypt_pool::hashpw (const char *password,
+                                                     const char *setting)
+{
+  std::unique_ptr<job> j (new job);
+  std::future<std::string> f = j->hash.get_future ();
+  if (!bcrypt_parse (setting, j->p))
+    {
+      j->hash.set_value (std::string ());
+      return f;
+    }
+  bcrypt_set_password (j->p, password);
+  j->check = false;
+  submit (std::move (j));
+  return f;
+}
+
+inline std::future<bool> bcrypt_pool::checkpw (const char *password,
+                                               const char *hash)
+{
+  std::unique_ptr<job> j (new job);
+  std::future<bool> f = j->ok.get_future ();
+  if (strlen (hash) != BCRYPT_HASH_LEN || !bcrypt_parse (hash, j->p))
+    {
+      j->ok.set_value (false);
+      return f;
+    }
+  bcrypt_set_password (j->p, password);
+  j->check = true;
+  memcpy (j->expect, hash, sizeof (j->expect));
+  submit (std::move (j));
+  return f;
+}
+
+inline void bcrypt_pool::submit (std::unique_ptr<job> j)
+{
+  if (pool.empty ())
+    {
+      run (&j, 1);
+      return;
+    }
+  {
+    std::lock_guard<std::mutex> lock (m);
+    queue.push_back (std::move (j));
+  }
+  cv.notify_one ();
+}
+
+inline void bcrypt_pool::run (std::unique_ptr<job> *batch, int n)
+{
+  const bcrypt_params *p[BLOWFISH_BCRYPT_LANES] = {};
+  char out[BLOWFISH_BCRYPT_LANES][BCRYPT_HASH_LEN + 1];
+
+  for (int k = 0; k < n; k++)
+    p[k] = &batch[k]->p;
+  bcrypt_run (p, n, out);
+  for (int k = 0; k < n; k++)
+    {
+      job &j = *batch[k];
+      if (j.check)
+        j.ok.set_value (bcrypt_equal (out[k], j.expect, BCRYPT_HASH_LEN));
+      else
+        j.hash.set_value (std::string (out[k], BCRYPT_HASH_LEN));
+    }
+  block_cipher_wipe (out, sizeof (out));
+}
+
+inline void bcrypt_pool::work ()
+{
+  for (;;)
+    {
+      std::unique_ptr<job> batch[BLOWFISH_BCRYPT_LANES];
+      int n = 0;
+      {
+        std::unique_lock<std::mutex> lock (m);
+        cv.wait (lock, [this] { return stopping || !queue.empty (); });
+        if (queue.empty ())
+          return;
+        batch[n++] = std::move (queue.front ());
+        queue.pop_front ();
+
+        /* the oldest waiting requests at the same cost join it */
+        for (auto i = queue.begin ();
+             i != queue.end () && n < BLOWFISH_BCRYPT_LANES; )
+          if ((*i)->p.cost == batch[0]->p.cost)
+            {
+              batch[n++] = std::move (*i);
+              i = queue.erase (i);
+            }
+          else
+            ++i;
+      }
+      run (batch, n);
+    }
+}
+
+#endif /* BCRYPT_HPP */
@@ -0,0 +1,466 @@
+/*
+ *  block_cipher.hpp:  one C++17 interface over the block ciphers in this
+ *  directory.
+ *
+ *  The C sources each arrived with their own calling convention: the AES
+ *  candidates take u4byte words and a context, the gcrypt modules hand
+ *  out per-block function pointers through *_get_info(), GOST works on
+ *  word32 pairs with the key passed on every call.  BlockCipher<Impl>
+ *  puts a single face on all of them: compile-time block and key size
+ *  traits, a per-object key schedule, and encrypt_blocks/decrypt_blocks
+ *  that map to one direct call into the cipher's own multi-block loop.
+ *  A mode layer therefore pays one call per buffer, not one indirect
+ *  call per block.
+ *
+ *  An Impl is a stateless struct supplying
+ *
+ *    typedef ... context;                      the expanded key
+ *    static constexpr size_t BLOCKSIZE, MIN_KEYLENGTH, MAX_KEYLENGTH,
+ *                            KEYLENGTH_MULTIPLE;   in bytes
+ *    static const char *name ();
+ *    static bool set_key (context &, const unsigned char *key, size_t len);
+ *    static void encrypt_blocks (const context &, const unsigned char *in,
+ *                                unsigned char *out, size_t nblocks);
+ *    static void decrypt_blocks (...same...);
+ *
+ *  and may add
+ *
+ *    static constexpr size_t PREFERRED_BLOCKS;  blocks per call at which
+ *                                               its widest path kicks in
+ *
+ *  Buffers are plain bytes with no alignment requirement, and in may be
+ *  the same as out.  The adapters below are only defined for the cipher
+ *  headers that were included before this one, so a program links just
+ *  the modules it uses.
+ */
+
+#ifndef BLOCK_CIPHER_HPP
+#define BLOCK_CIPHER_HPP
+
+#include <stddef.h>
+#include <string.h>
+
+/* clear key material in a way the optimiser may not drop */
+inline void block_cipher_wipe (void *p, size_t n)
+{
+#if defined(__GNUC__)
+  memset (p, 0, n);
+  __asm__ __volatile__ ("" : : "r" (p) : "memory");
+#else
+  volatile unsigned char *v = static_cast<volatile unsigned char *> (p);
+  while (n--)
+    *v++ = 0;
+#endif
+}
+
+/* T::PREFERRED_BLOCKS where T declares it, otherwise 0 */
+template <class T, class = void>
+struct block_cipher_preferred_blocks
+{
+  static constexpr size_t value = 0;
+};
+
+template <class T>
+struct block_cipher_preferred_blocks<T, decltype ((void) T::PREFERRED_BLOCKS)>
+{
+  static constexpr size_t value = T::PREFERRED_BLOCKS;
+};
+
+template <class Impl>
+class BlockCipher
+{
+public:
+  typedef Impl                    impl_type;
+  typedef typename Impl::context  context_type;
+
+  static constexpr size_t BLOCKSIZE          = Impl::BLOCKSIZE;
+  static constexpr size_t MIN_KEYLENGTH      = Impl::MIN_KEYLENGTH;
+  static constexpr size_t MAX_KEYLENGTH      = Impl::MAX_KEYLENGTH;
+  static constexpr size_t KEYLENGTH_MULTIPLE = Impl::KEYLENGTH_MULTIPLE;
+  static constexpr size_t PREFERRED_BLOCKS
+    = block_cipher_preferred_blocks<Impl>::value;
+
+  static_assert(BLOCKSIZE == 8 || BLOCKSIZE == 16,
+                "only 64- and 128-bit block ciphers are supported");
+  static_assert(MIN_KEYLENGTH <= MAX_KEYLENGTH && KEYLENGTH_MULTIPLE > 0,
+                "inconsistent key length traits");
+
+  static constexpr bool valid_key_length (size_t len)
+  {
+    return len >= MIN_KEYLENGTH && len <= MAX_KEYLENGTH
+           && (len - MIN_KEYLENGTH) % KEYLENGTH_MULTIPLE == 0;
+  }
+
+  static const char *name () { return Impl::name (); }
+
+  BlockCipher () : ctx () {}
+  BlockCipher (const BlockCipher &) = default;
+  BlockCipher &operator= (const BlockCipher &) = default;
+  ~BlockCipher () { clear (); }
+
+  /* false for a length outside the traits or a key the cipher rejects */
+  bool set_key (const unsigned char *key, size_t len)
+  {
+    return valid_key_length (len) && Impl::set_key (ctx, key, len);
+  }
+
+  void encrypt_blocks (const unsigned char *in, unsigned char *out,
+                       size_t nblocks) const
+  {
+    Impl::encrypt_blocks (ctx, in, out, nblocks);
+  }
+
+  void decrypt_blocks (const unsigned char *in, unsigned char *out,
+                       size_t nblocks) const
+  {
+    Impl::decrypt_blocks (ctx, in, out, nblocks);
+  }
+
+  void encrypt_block (const unsigned char *in, unsigned char *out) const
+  {
+    Impl::encrypt_blocks (ctx, in, out, 1);
+  }
+
+  void decrypt_block (const unsigned char *in, unsigned char *out) const
+  {
+    Impl::decrypt_blocks (ctx, in, out, 1);
+  }
+
+  const context_type &context () const { return ctx; }
+
+  /* install a schedule made earlier by set_key (see key_cache.hpp) */
+  void set_context (const context_type &c) { ctx = c; }
+
+  void clear () { block_cipher_wipe (&ctx, sizeof (ctx)); }
+
+private:
+  context_type ctx;
+};
+
+/*
+ * The AES candidates (Gladman's implementations): 128-bit blocks, keys of
+ * 128, 192 or 256 bits passed as u4byte words in the submission's byte
+ * order.
+ */
+#define GLADMAN_BLOCK_CIPHER(impl, prefix)                                  \
+struct impl                                                                 \
+{                                                                           \
+  typedef prefix##_ctx context;                                             \
+  static constexpr size_t BLOCKSIZE = 16;                                   \
+  static constexpr size_t MIN_KEYLENGTH = 16;                               \
+  static constexpr size_t MAX_KEYLENGTH = 32;                               \
+  static constexpr size_t KEYLENGTH_MULTIPLE = 8;                           \
+  static const char *name () { return prefix##_cipher_name ()[0]; }         \
+  static bool set_key (context &ctx, const unsigned char *key, size_t len)  \
+  {                                                                         \
+    u4byte k[8];                                                            \
+    memcpy (k, key, len);                                                   \
+    prefix##_set_key (&ctx, k, (u4byte) (8 * len));                         \
+    block_cipher_wipe (k, sizeof (k));                                      \
+    return true;                                                            \
+  }                                                                         \
+  static void encrypt_blocks (const context &ctx, const unsigned char *in,  \
+                              unsigned char *out, size_t nblocks)           \
+  {                                                                         \
+    prefix##_encrypt_blocks (&ctx, in, out, nblocks);                       \
+  }                                                                         \
+  static void decrypt_blocks (const context &ctx, const unsigned char *in,  \
+                              unsigned char *out, size_t nblocks)           \
+  {                                                                         \
+    prefix##_decrypt_blocks (&ctx, in, out, nblocks);                       \
+  }                                                                         \
+}
+
+#ifdef _SERPENT_H
+GLADMAN_BLOCK_CIPHER (serpent_cipher, serpent);
+#endif
+#ifdef _RC6_H
+GLADMAN_BLOCK_CIPHER (rc6_cipher, rc6);
+#endif
+#ifdef _MARS_H
+GLADMAN_BLOCK_CIPHER (mars_cipher, mars);
+#endif
+#ifdef _TWOFISH_H
+GLADMAN_BLOCK_CIPHER (twofish_cipher, twofish);
+#endif
+#ifdef _MAGENTA_H
+GLADMAN_BLOCK_CIPHER (magenta_cipher, magenta);
+#endif
+#ifdef _DFC_H
+GLADMAN_BLOCK_CIPHER (dfc_cipher, dfc);
+#endif
+#ifdef _E2_H
+GLADMAN_BLOCK_CIPHER (e2_cipher, e2);
+#endif
+#ifdef _HPC_H
+GLADMAN_BLOCK_CIPHER (hpc_cipher, hpc);
+#endif
+#ifdef _CAST6_H
+GLADMAN_BLOCK_CIPHER (cast6_cipher, cast6);
+#endif
+#ifdef _SAFERP_H
+GLADMAN_BLOCK_CIPHER (saferp_cipher, saferp);
+#endif
+
+/*
+ * The gcrypt modules.  Their entry points predate const, but none of
+ * them writes to the context while encrypting.
+ */
+#ifdef G10_BLOWFISH_H
+struct blowfish_cipher
+{
+  typedef BLOWFISH_context context;
+  static constexpr size_t BLOCKSIZE = BLOWFISH_BLOCKSIZE;
+  static constexpr size_t MIN_KEYLENGTH = 4;
+  static constexpr size_t MAX_KEYLENGTH = 56;
+  static constexpr size_t KEYLENGTH_MULTIPLE = 1;
+  static const char *name () { return "BLOWFISH"; }
+  static bool set_key (context &ctx, const unsigned char *key, size_t len)
+  {
+    return blowfish_setkey (&ctx, key, (unsigned) len) == 0;
+  }
+  static void encrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    blowfish_encrypt_blocks (const_cast<context *> (&ctx), out, in, nblocks);
+  }
+  static void decrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    blowfish_decrypt_blocks (const_cast<context *> (&ctx), out, in, nblocks);
+  }
+};
+#endif
+
+#ifdef G10_CAST5_H
+struct cast5_cipher
+{
+  typedef CAST5_context context;
+  static constexpr size_t BLOCKSIZE = CAST5_BLOCKSIZE;
+  static constexpr size_t MIN_KEYLENGTH = 16;
+  static constexpr size_t MAX_KEYLENGTH = 16;
+  static constexpr size_t KEYLENGTH_MULTIPLE = 1;
+  static const char *name () { return "CAST5"; }
+  static bool set_key (context &ctx, const unsigned char *key, size_t len)
+  {
+    return _gcry_cast5_setkey (&ctx, key, (unsigned) len) == 0;
+  }
+  static void encrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    _gcry_cast5_encrypt_blocks (const_cast<context *> (&ctx), out, in,
+                                nblocks);
+  }
+  static void decrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    _gcry_cast5_decrypt_blocks (const_cast<context *> (&ctx), out, in,
+                                nblocks);
+  }
+};
+#endif
+
+#ifdef G10_DES_H
+struct tripledes_cipher
+{
+  typedef struct _tripledes_ctx context;
+  static constexpr size_t BLOCKSIZE = 8;
+  static constexpr size_t MIN_KEYLENGTH = 24;
+  static constexpr size_t MAX_KEYLENGTH = 24;
+  static constexpr size_t KEYLENGTH_MULTIPLE = 1;
+  static constexpr size_t PREFERRED_BLOCKS = 512;  /* widest bitsliced slice */
+  static const char *name () { return "3DES"; }
+  static bool set_key (context &ctx, const unsigned char *key, size_t len)
+  {
+    return tripledes_setkey (&ctx, key, (unsigned) len) == 0;
+  }
+  static void encrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    tripledes_encrypt_blocks (const_cast<context *> (&ctx), out, in, nblocks);
+  }
+  static void decrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    tripledes_decrypt_blocks (const_cast<context *> (&ctx), out, in, nblocks);
+  }
+};
+#endif
+
+/*
+ * GOST 28147-89 under one S-box parameter set from gost.h; gost_cipher
+ * keeps the illustrative S-boxes of gost.c.  The 256-bit key is read as
+ * eight little-endian words, as the standard specifies.
+ */
+#ifdef GOST_H
+template <int SBOX>
+struct gost_sbox_cipher
+{
+  typedef gost_ctx context;
+  static constexpr size_t BLOCKSIZE = 8;
+  static constexpr size_t MIN_KEYLENGTH = 32;
+  static constexpr size_t MAX_KEYLENGTH = 32;
+  static constexpr size_t KEYLENGTH_MULTIPLE = 1;
+  static const char *name ()
+  {
+    static const char *const names[GOST_SBOX_COUNT] = {
+      "GOST", "GOST-TEST", "GOST-CRYPTOPRO-A", "GOST-CRYPTOPRO-B",
+      "GOST-CRYPTOPRO-C", "GOST-CRYPTOPRO-D", "GOST-TC26-Z" };
+    return names[SBOX];
+  }
+  static bool set_key (context &ctx, const unsigned char *key, size_t)
+  {
+    return gost_setkey (&ctx, key, SBOX) == 0;
+  }
+  static void encrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    gost_encrypt_blocks (&ctx, in, out, nblocks);
+  }
+  static void decrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    gost_decrypt_blocks (&ctx, in, out, nblocks);
+  }
+};
+
+typedef gost_sbox_cipher<GOST_SBOX_DES> gost_cipher;
+typedef gost_sbox_cipher<GOST_SBOX_CRYPTOPRO_A> gost_cryptopro_a_cipher;
+typedef gost_sbox_cipher<GOST_SBOX_TC26_Z> gost_tc26_z_cipher;
+#endif
+
+#ifdef CAMELLIA_H
+struct camellia_cipher
+{
+  typedef Camellia_Ctx context;
+  static constexpr size_t BLOCKSIZE = 16;
+  static constexpr size_t MIN_KEYLENGTH = 16;
+  static constexpr size_t MAX_KEYLENGTH = 32;
+  static constexpr size_t KEYLENGTH_MULTIPLE = 8;
+  static const char *name () { return "CAMELLIA"; }
+  static bool set_key (context &ctx, const unsigned char *key, size_t len)
+  {
+    return Camellia_Ekeygen (&ctx, (int) (8 * len), key) == 0;
+  }
+  static void encrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    Camellia_EncryptBlocks (&ctx, in, out, nblocks);
+  }
+  static void decrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    Camellia_DecryptBlocks (&ctx, in, out, nblocks);
+  }
+};
+#endif
+
+#ifdef SKIPJACK_H
+struct skipjack_cipher
+{
+  typedef skipjack_ctx context;
+  static constexpr size_t BLOCKSIZE = 8;
+  static constexpr size_t MIN_KEYLENGTH = 10;
+  static constexpr size_t MAX_KEYLENGTH = 10;
+  static constexpr size_t KEYLENGTH_MULTIPLE = 1;
+  static const char *name () { return "SKIPJACK"; }
+  static bool set_key (context &ctx, const unsigned char *key, size_t)
+  {
+    skipjack_setkey (&ctx, key);
+    return true;
+  }
+  static void encrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    skipjack_encrypt_blocks (&ctx, in, out, nblocks);
+  }
+  static void decrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    skipjack_decrypt_blocks (&ctx, in, out, nblocks);
+  }
+};
+#endif
+
+#ifdef IDEA_H
+struct idea_cipher
+{
+  typedef IdeaCtx context;
+  static constexpr size_t BLOCKSIZE = 8;
+  static constexpr size_t MIN_KEYLENGTH = 16;
+  static constexpr size_t MAX_KEYLENGTH = 16;
+  static constexpr size_t KEYLENGTH_MULTIPLE = 1;
+  static const char *name () { return "IDEA"; }
+  static bool set_key (context &ctx, const unsigned char *key, size_t)
+  {
+    IdeaSetKey (&ctx, key);
+    return true;
+  }
+  static void encrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    IdeaEncryptBlocks (&ctx, in, out, nblocks);
+  }
+  static void decrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    IdeaDecryptBlocks (&ctx, in, out, nblocks);
+  }
+};
+#endif
+
+#ifdef MISTY1_H
+struct misty1_cipher
+{
+  typedef misty1_ctx context;
+  static constexpr size_t BLOCKSIZE = 8;
+  static constexpr size_t MIN_KEYLENGTH = 16;
+  static constexpr size_t MAX_KEYLENGTH = 16;
+  static constexpr size_t KEYLENGTH_MULTIPLE = 1;
+  static const char *name () { return "MISTY1"; }
+  static bool set_key (context &ctx, const unsigned char *key, size_t)
+  {
+    misty1_setkey (&ctx, key);
+    return true;
+  }
+  static void encrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    misty1_encrypt_blocks (&ctx, in, out, nblocks);
+  }
+  static void decrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    misty1_decrypt_blocks (&ctx, in, out, nblocks);
+  }
+};
+#endif
+
+#ifdef NESSIE_H
+struct noekeon_cipher
+{
+  typedef struct NESSIEstruct context;
+  static constexpr size_t BLOCKSIZE = 16;
+  static constexpr size_t MIN_KEYLENGTH = 16;
+  static constexpr size_t MAX_KEYLENGTH = 16;
+  static constexpr size_t KEYLENGTH_MULTIPLE = 1;
+  static const char *name () { return "NOEKEON"; }
+  static bool set_key (context &ctx, const unsigned char *key, size_t)
+  {
+    NESSIEkeysetup (key, &ctx);
+    return true;
+  }
+  static void encrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    NESSIEencryptblocks (&ctx, in, out, nblocks);
+  }
+  static void decrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    NESSIEdecryptblocks (&ctx, in, out, nblocks);
+  }
+};
+#endif
+
+#endif /* BLOCK_CIPHER_HPP */
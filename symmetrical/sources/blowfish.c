@@ -35,6 +35,7 @@
 #include <string.h>
 #include <assert.h>
 #include "types.h"
+#include "util.h"
 #include "errors.h"
 #include "blowfish.h"
 #include "dynload.h"
@@ -43,17 +44,6 @@
 
 #define CIPHER_ALGO_BLOWFISH	 4  /* blowfish 128 bit key */
 
-#define BLOWFISH_BLOCKSIZE 8
-#define BLOWFISH_ROUNDS 16
-
-typedef struct {
-    u32 s0[256];
-    u32 s1[256];
-    u32 s2[256];
-    u32 s3[256];
-    u32 p[BLOWFISH_ROUNDS+2];
-} BLOWFISH_context;
-
 static int  bf_setkey( BLOWFISH_context *c, byte *key, unsigned keylen );
 static void encrypt_block( BLOWFISH_context *bc, byte *outbuf, byte *inbuf );
 static void decrypt_block( BLOWFISH_context *bc, byte *outbuf, byte *inbuf );
@@ -251,31 +241,14 @@ static const u32 ps[BLOWFISH_ROUNDS+2] = {
 static inline u32
 function_F( BLOWFISH_context *bc, u32 x )
 {
-    u16 a, b, c, d;
-
-  #ifdef BIG_ENDIAN_HOST
-    a = ((byte*)&x)[0];
-    b = ((byte*)&x)[1];
-    c = ((byte*)&x)[2];
-    d = ((byte*)&x)[3];
-  #else
-    a = ((byte*)&x)[3];
-    b = ((byte*)&x)[2];
-    c = ((byte*)&x)[1];
-    d = ((byte*)&x)[0];
-  #endif
-
-    return ((bc->s0[a] + bc->s1[b]) ^ bc->s2[c] ) + bc->s3[d];
+    return ((bc->s0[x >> 24] + bc->s1[(x >> 16) & 0xff])
+	    ^ bc->s2[(x >> 8) & 0xff]) + bc->s3[x & 0xff];
 }
 #endif
 
-#ifdef BIG_ENDIAN_HOST
-  #define F(x) ((( s0[((byte*)&x)[0]] + s1[((byte*)&x)[1]])	 \
-		   ^ s2[((byte*)&x)[2]]) + s3[((byte*)&x)[3]] )
-#else
-  #define F(x) ((( s0[((byte*)&x)[3]] + s1[((byte*)&x)[2]])	 \
-		   ^ s2[((byte*)&x)[1]]) + s3[((byte*)&x)[0]] )
-#endif
+/* the bytes of x, most significant first, index s0..s3 */
+#define F(x) ((( s0[(x) >> 24] + s1[((x) >> 16) & 0xff])	 \
+		^ s2[((x) >> 8) & 0xff]) + s3[(x) & 0xff] )
 #define R(l,r,i)  do { l ^= p[i]; r ^= F(l); } while(0)
 
 
@@ -450,6 +423,118 @@ decrypt_block( BLOWFISH_context *bc, byte *outbuf, byte *inbuf )
 }
 
 
+/****************
+ * Interleaved ECB of up to BF_MAX_LANES blocks.  Each round of a single
+ * block is a chain of four S-box loads whose addresses depend on the
+ * round before, which leaves most of an out-of-order core idle; here the
+ * same round of N independent blocks is issued together so that their
+ * loads overlap.  The bytes of a word are taken with shifts, so the lane
+ * halves can stay in registers on either byte order.  P is the P-array
+ * in the order it is applied: bc->p to encrypt, reversed to decrypt.
+ */
+
+#ifdef __GNUC__
+  #define BF_INLINE static inline __attribute__((always_inline))
+#else
+  #define BF_INLINE static inline
+#endif
+
+#define BF_MAX_LANES 8
+
+/* op(k) for the lanes k < n; n is a constant in every caller, so the
+ * untaken tests fold away and each lane keeps its own registers */
+#define BF_LANES(op)  do { op(0);					 \
+			   if( n > 1 ) op(1);				 \
+			   if( n > 2 ) op(2);				 \
+			   if( n > 3 ) op(3);				 \
+			   if( n > 4 ) op(4);				 \
+			   if( n > 5 ) op(5);				 \
+			   if( n > 6 ) op(6);				 \
+			   if( n > 7 ) op(7);				 \
+		      } while(0)
+
+#define BF_GET(k)   do { const byte *q = inbuf + BLOWFISH_BLOCKSIZE*(k);    \
+			 l[k] = (u32)q[0] << 24 | q[1] << 16 | q[2] << 8 | q[3]; \
+			 r[k] = (u32)q[4] << 24 | q[5] << 16 | q[6] << 8 | q[7]; \
+		    } while(0)
+#define BF_RND_L(k) R( l[k], r[k], i )
+#define BF_RND_R(k) R( r[k], l[k], i+1 )
+#define BF_PUT(k)   do { byte *q = outbuf + BLOWFISH_BLOCKSIZE*(k);	    \
+			 u32 x = r[k] ^ p[BLOWFISH_ROUNDS+1];		    \
+			 u32 y = l[k] ^ p[BLOWFISH_ROUNDS];		    \
+			 q[0] = x >> 24; q[1] = x >> 16; q[2] = x >> 8; q[3] = x; \
+			 q[4] = y >> 24; q[5] = y >> 16; q[6] = y >> 8; q[7] = y; \
+		    } while(0)
+
+#define F(x) ((( s0[(x) >> 24] + s1[((x) >> 16) & 0xff])	 \
+		^ s2[((x) >> 8) & 0xff]) + s3[(x) & 0xff] )
+#define R(l,r,i)  do { l ^= p[i]; r ^= F(l); } while(0)
+
+BF_INLINE void
+crypt_lanes( BLOWFISH_context *bc, const u32 *p, const int n,
+	     byte *outbuf, const byte *inbuf )
+{
+    const u32 *s0 = bc->s0, *s1 = bc->s1, *s2 = bc->s2, *s3 = bc->s3;
+    u32 l[BF_MAX_LANES], r[BF_MAX_LANES];
+    int i;
+
+    BF_LANES( BF_GET );
+    for( i=0; i < BLOWFISH_ROUNDS; i += 2 ) {
+	BF_LANES( BF_RND_L );
+	BF_LANES( BF_RND_R );
+    }
+    BF_LANES( BF_PUT );
+}
+
+#undef F
+#undef R
+
+static void
+crypt_blocks( BLOWFISH_context *bc, const u32 *p, byte *outbuf,
+	      const byte *inbuf, size_t nblocks )
+{
+    for( ; nblocks >= 8; nblocks -= 8, outbuf += 8*BLOWFISH_BLOCKSIZE,
+				       inbuf += 8*BLOWFISH_BLOCKSIZE )
+	crypt_lanes( bc, p, 8, outbuf, inbuf );
+    if( nblocks >= 4 ) {
+	crypt_lanes( bc, p, 4, outbuf, inbuf );
+	nblocks -= 4;
+	outbuf += 4*BLOWFISH_BLOCKSIZE;
+	inbuf  += 4*BLOWFISH_BLOCKSIZE;
+    }
+    for( ; nblocks; nblocks--, outbuf += BLOWFISH_BLOCKSIZE,
+			       inbuf += BLOWFISH_BLOCKSIZE )
+	crypt_lanes( bc, p, 1, outbuf, inbuf );
+}
+
+
+/****************
+ * Encrypt or decrypt NBLOCKS consecutive blocks in one call.  This is
+ * what callers linking this module directly should use instead of the
+ * per-block function pointers handed out by blowfish_get_info().
+ * OUTBUF may be the same as INBUF.
+ */
+void
+blowfish_encrypt_blocks( BLOWFISH_context *bc, byte *outbuf,
+			 const byte *inbuf, size_t nblocks )
+{
+    crypt_blocks( bc, bc->p, outbuf, inbuf, nblocks );
+}
+
+void
+blowfish_decrypt_blocks( BLOWFISH_context *bc, byte *outbuf,
+			 const byte *inbuf, size_t nblocks )
+{
+    u32 p[BLOWFISH_ROUNDS+2];
+    int i;
+
+    for( i=0; i < BLOWFISH_ROUNDS+2; i++ )
+	p[i] = bc->p[BLOWFISH_ROUNDS+1-i];
+    crypt_blocks( bc, p, outbuf, inbuf, nblocks );
+    wipememory( p, sizeof p );
+}
+
+
 static const char*
 selftest(void)
 {
@@ -564,6 +649,204 @@ bf_setkey( BLOWFISH_context *c, byte *key, unsigned keylen )
 }
 
 
+int
+blowfish_setkey( BLOWFISH_context *c, const byte *key, unsigned keylen )
+{
+    return bf_setkey( c, (byte*)key, keylen );
+}
+
+
+/****************
+ * EksBlowfish, the key schedule of bcrypt:
+ *   Niels Provos, David Mazieres: A Future-Adaptable Password Scheme.
+ *   USENIX 1999.
+ *
+ * Each of the 2^cost rounds re-keys all 4168 bytes of P-array and S-boxes
+ * with 521 encryptions, every one of which depends on the one before and
+ * on the tables it just wrote.  A single setup therefore leaves the core
+ * waiting on one chain of S-box loads.  The setups of several passwords
+ * are independent, so up to BLOWFISH_BCRYPT_LANES of them are run in lock
+ * step, one round of every lane at a time; their tables together still
+ * fit in the L1 cache.
+ */
+
+/* the P-array / key stream word i, as bf_setkey builds it */
+static u32
+eks_stream_word( const byte *key, unsigned keylen, int i )
+{
+    unsigned j = (unsigned)(4*i) % keylen;
+
+    return (u32)key[j] << 24 | (u32)key[(j+1)%keylen] << 16
+	 | (u32)key[(j+2)%keylen] << 8 | key[(j+3)%keylen];
+}
+
+#define EKS_F(c,x)  ((((c)->s0[(x) >> 24] + (c)->s1[((x) >> 16) & 0xff]) \
+		      ^ (c)->s2[((x) >> 8) & 0xff]) + (c)->s3[(x) & 0xff])
+
+/* OP(k) for each lane k < n; with n constant the tests fold away and
+ * each lane's halves stay in registers */
+#define EKS_LANES(op)  do { op(0);					    \
+			    if( n > 1 ) op(1);				    \
+			    if( n > 2 ) op(2);				    \
+			    if( n > 3 ) op(3);				    \
+		       } while(0)
+
+#define EKS_RND_L(k)   do { l[k] ^= c[k].p[i];   r[k] ^= EKS_F( c+k, l[k] ); \
+		       } while(0)
+#define EKS_RND_R(k)   do { r[k] ^= c[k].p[i+1]; l[k] ^= EKS_F( c+k, r[k] ); \
+		       } while(0)
+#define EKS_OUT(k)     do { u32 _t = l[k] ^ c[k].p[BLOWFISH_ROUNDS];	    \
+			    l[k] = r[k] ^ c[k].p[BLOWFISH_ROUNDS+1];	    \
+			    r[k] = _t; } while(0)
+#define EKS_SALT(k)    do { l[k] ^= salt[k][s]; r[k] ^= salt[k][s+1]; } while(0)
+#define EKS_STORE(k)   do { d[k][j] = l[k]; d[k][j+1] = r[k]; } while(0)
+
+/****************
+ * ExpandKey(state, salt, key) for N lanes: XOR each lane's key stream
+ * KW into its P-array, then re-encrypt the P-array and S-boxes in order.
+ * SALT, if not NULL, holds four words per lane mixed into the data
+ * before each encryption.
+ */
+BF_INLINE void
+eks_expand( BLOWFISH_context *c, const int n, u32 (*kw)[BLOWFISH_ROUNDS+2],
+	    u32 (*salt)[4] )
+{
+    u32 l[BLOWFISH_BCRYPT_LANES], r[BLOWFISH_BCRYPT_LANES];
+    u32 *d[BLOWFISH_BCRYPT_LANES];
+    int i, j, k, t, len, s = 0;
+
+    for( k=0; k < n; k++ ) {
+	for( i=0; i < BLOWFISH_ROUNDS+2; i++ )
+	    c[k].p[i] ^= kw[k][i];
+	l[k] = r[k] = 0;
+    }
+    for( t=0; t < 5; t++ ) {
+	len = t ? 256 : BLOWFISH_ROUNDS+2;
+	for( k=0; k < n; k++ )
+	    d[k] = t == 0 ? c[k].p  : t == 1 ? c[k].s0 :
+		   t == 2 ? c[k].s1 : t == 3 ? c[k].s2 : c[k].s3;
+	for( j=0; j < len; j += 2 ) {
+	    if( salt ) {
+		EKS_LANES( EKS_SALT );
+		s ^= 2;
+	    }
+	    for( i=0; i < BLOWFISH_ROUNDS; i += 2 ) {
+		EKS_LANES( EKS_RND_L );
+		EKS_LANES( EKS_RND_R );
+	    }
+	    EKS_LANES( EKS_OUT );
+	    EKS_LANES( EKS_STORE );
+	}
+    }
+}
+
+/* the unsalted expansion of the cost loop, compiled for each lane count */
+typedef void (*eks_expand_fn)( BLOWFISH_context *c,
+			       u32 (*kw)[BLOWFISH_ROUNDS+2] );
+
+static void
+eks_expand1( BLOWFISH_context *c, u32 (*kw)[BLOWFISH_ROUNDS+2] )
+{
+    eks_expand( c, 1, kw, NULL );
+}
+
+static void
+eks_expand2( BLOWFISH_context *c, u32 (*kw)[BLOWFISH_ROUNDS+2] )
+{
+    eks_expand( c, 2, kw, NULL );
+}
+
+static void
+eks_expand3( BLOWFISH_context *c, u32 (*kw)[BLOWFISH_ROUNDS+2] )
+{
+    eks_expand( c, 3, kw, NULL );
+}
+
+static void
+eks_expand4( BLOWFISH_context *c, u32 (*kw)[BLOWFISH_ROUNDS+2] )
+{
+    eks_expand( c, 4, kw, NULL );
+}
+
+static const eks_expand_fn eks_expand_lanes[BLOWFISH_BCRYPT_LANES] = {
+    eks_expand1, eks_expand2, eks_expand3, eks_expand4
+};
+
+#undef EKS_F
+#undef EKS_LANES
+#undef EKS_RND_L
+#undef EKS_RND_R
+#undef EKS_OUT
+#undef EKS_SALT
+#undef EKS_STORE
+
+/****************
+ * Raw bcrypt: the 24 byte result of EksBlowfish with cost COST (0..31)
+ * encrypting "OrpheanBeholderScryDoubt" 64 times, for N passwords
+ * (1..BLOWFISH_BCRYPT_LANES) computed together.  KEY[k] is KEYLEN[k]
+ * (1..72) bytes, SALT[k] is 16 bytes and OUT[k] receives 24 bytes.
+ * The "$2b$" string form is in bcrypt.hpp.
+ */
+void
+blowfish_bcrypt( int n, unsigned cost, const byte *const key[],
+		 const unsigned keylen[], const byte *const salt[],
+		 byte *const out[] )
+{
+    static const byte magic[24] = "OrpheanBeholderScryDoubt";
+    BLOWFISH_context c[BLOWFISH_BCRYPT_LANES];
+    u32 kw[BLOWFISH_BCRYPT_LANES][BLOWFISH_ROUNDS+2];
+    u32 sw[BLOWFISH_BCRYPT_LANES][BLOWFISH_ROUNDS+2];
+    u32 salt4[BLOWFISH_BCRYPT_LANES][4];
+    u32 data[6];
+    eks_expand_fn expand;
+    unsigned long round;
+    int i, k;
+
+    if( n < 1 || n > BLOWFISH_BCRYPT_LANES )
+	return;
+
+    for( k=0; k < n; k++ ) {
+	memcpy( c[k].p, ps, sizeof c[k].p );
+	memcpy( c[k].s0, ks0, sizeof c[k].s0 );
+	memcpy( c[k].s1, ks1, sizeof c[k].s1 );
+	memcpy( c[k].s2, ks2, sizeof c[k].s2 );
+	memcpy( c[k].s3, ks3, sizeof c[k].s3 );
+	for( i=0; i < BLOWFISH_ROUNDS+2; i++ ) {
+	    kw[k][i] = eks_stream_word( key[k], keylen[k], i );
+	    sw[k][i] = eks_stream_word( salt[k], 16, i );
+	}
+	for( i=0; i < 4; i++ )
+	    salt4[k][i] = sw[k][i];
+    }
+
+    eks_expand( c, n, kw, salt4 );
+    expand = eks_expand_lanes[n-1];
+    for( round = 1ul << cost; round; round-- ) {
+	expand( c, kw );
+	expand( c, sw );
+    }
+
+    for( k=0; k < n; k++ ) {
+	for( i=0; i < 6; i++ )
+	    data[i] = eks_stream_word( magic, 24, i );
+	for( round=0; round < 64; round++ )
+	    for( i=0; i < 6; i += 2 )
+		encrypt( c+k, data+i, data+i+1 );
+	for( i=0; i < 6; i++ ) {
+	    out[k][4*i]   = data[i] >> 24;
+	    out[k][4*i+1] = data[i] >> 16;
+	    out[k][4*i+2] = data[i] >> 8;
+	    out[k][4*i+3] = data[i];
+	}
+    }
+
+    wipememory( c, sizeof c );
+    wipememory( kw, sizeof kw );
+    wipememory( sw, sizeof sw );
+    wipememory( data, sizeof data );
+}
+
+
 /****************
  * Return some information about the algorithm.  We need algo here to
  * distinguish different flavors of the algorithm.
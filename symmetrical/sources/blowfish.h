@@ -0,0 +1,67 @@
+/* blowfish.h
+ *	Copyright (C) 1998 Free Software Foundation, Inc.
+ *
+ * This file is part of GnuPG.
+ *
+ * GnuPG is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GnuPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+#ifndef G10_BLOWFISH_H
+#define G10_BLOWFISH_H
+
+#include <stddef.h>
+#include "types.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#define BLOWFISH_BLOCKSIZE 8
+#define BLOWFISH_ROUNDS 16
+
+typedef struct {
+    u32 s0[256];
+    u32 s1[256];
+    u32 s2[256];
+    u32 s3[256];
+    u32 p[BLOWFISH_ROUNDS+2];
+} BLOWFISH_context;
+
+const char *
+blowfish_get_info( int algo, size_t *keylen,
+		   size_t *blocksize, size_t *contextsize,
+		   int	(**setkeyf)( void *c, byte *key, unsigned keylen ),
+		   void (**encryptf)( void *c, byte *outbuf, byte *inbuf ),
+		   void (**decryptf)( void *c, byte *outbuf, byte *inbuf )
+		 );
+
+/* Direct entry points for callers linking this module without the
+ * get_info indirection; see blowfish.c. */
+int  blowfish_setkey( BLOWFISH_context *c, const byte *key, unsigned keylen );
+void blowfish_encrypt_blocks( BLOWFISH_context *bc, byte *outbuf,
+			      const byte *inbuf, size_t nblocks );
+void blowfish_decrypt_blocks( BLOWFISH_context *bc, byte *outbuf,
+			      const byte *inbuf, size_t nblocks );
+
+/* EksBlowfish/bcrypt; see blowfish.c and, for the string form, bcrypt.hpp */
+#define BLOWFISH_BCRYPT_LANES 4	/* blowfish.c unrolls up to four */
+void blowfish_bcrypt( int n, unsigned cost, const byte *const key[],
+		      const unsigned keylen[], const byte *const salt[],
+		      byte *const out[] );
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /*G10_BLOWFISH_H*/
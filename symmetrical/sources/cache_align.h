@@ -0,0 +1,22 @@
+
+/* Alignment for the key schedule contexts of the AES candidate     */
+/* ciphers. Placing CACHE_ALIGN on the first member of a context    */
+/* starts it on a cache line, so two contexts used on different     */
+/* processors never share a line. Define CACHE_ALIGN before this    */
+/* header is included to override it (as an empty macro to turn    */
+/* alignment off).                                                  */
+
+#ifndef _CACHE_ALIGN_H
+#define _CACHE_ALIGN_H
+
+#ifndef CACHE_ALIGN
+#  if defined(_MSC_VER)
+#    define CACHE_ALIGN __declspec(align(64))
+#  elif defined(__GNUC__)
+#    define CACHE_ALIGN __attribute__((aligned(64)))
+#  else
+#    define CACHE_ALIGN
+#  endif
+#endif
+
+#endif
@@ -8,326 +8,722 @@
  *						 *
  *************************************************/
 
-#include <stdio.h>
-
-typedef unsigned char Byte;
-typedef unsigned long Word;
-
-void Camellia_Ekeygen( const int, const Byte *, Byte * );
-void Camellia_Encrypt( const int, const Byte *, const Byte *, Byte * );
-void Camellia_Decrypt( const int, const Byte *, const Byte *, Byte * );
-void Camellia_Feistel( const Byte *, const Byte *, Byte * );
-void Camellia_FLlayer( Byte *, const Byte *, const Byte * );
-
-void ByteWord( const Byte *, Word * );
-void WordByte( const Word *, Byte * );
-void XorBlock( const Byte *, const Byte *, Byte * );
-void SwapHalf( Byte * );
-void RotBlock( const Word *, const int, Word * );
-
-const Byte SIGMA[48] = {
-0xa0,0x9e,0x66,0x7f,0x3b,0xcc,0x90,0x8b,
-0xb6,0x7a,0xe8,0x58,0x4c,0xaa,0x73,0xb2,
-0xc6,0xef,0x37,0x2f,0xe9,0x4f,0x82,0xbe,
-0x54,0xff,0x53,0xa5,0xf1,0xd3,0x6f,0x1c,
-0x10,0xe5,0x27,0xfa,0xde,0x68,0x2d,0x1d,
-0xb0,0x56,0x88,0xc2,0xb3,0xe6,0xc1,0xfd};
-
-const int KSFT1[26] = {
+/*
+ * Word-oriented version.  The state and the subkeys are kept as
+ * big-endian 32-bit words from key setup to output, and each round
+ * looks up four 32-bit tables that combine one S-box with its column
+ * of the P-function.  Runs of 16 blocks go through a byte-sliced path
+ * that evaluates the S-boxes with the AES-NI SubBytes instruction
+ * (see below); define CAMELLIA_NO_AESNI to leave it out.
+ */
+
+#include "camellia.h"
+
+#if !defined(CAMELLIA_NO_AESNI) && (defined(__GNUC__) || defined(__clang__)) \
+	&& (defined(__x86_64__) || defined(__i386__))
+#define CAMELLIA_AESNI
+#include <immintrin.h>
+#endif
+
+static const Word SIGMA[12] = {
+	0xa09e667f, 0x3bcc908b, 0xb67ae858, 0x4caa73b2,
+	0xc6ef372f, 0xe94f82be, 0x54ff53a5, 0xf1d36f1c,
+	0x10e527fa, 0xde682d1d, 0xb05688c2, 0xb3e6c1fd };
+
+static const int KSFT1[26] = {
 0,64,0,64,15,79,15,79,30,94,45,109,45,124,60,124,77,13,
 94,30,94,30,111,47,111,47 };
-const int KIDX1[26] = {
+static const int KIDX1[26] = {
 0,0,4,4,0,0,4,4,4,4,0,0,4,0,4,4,0,0,0,0,4,4,0,0,4,4 };
-const int KSFT2[34] = {
+static const int KSFT2[34] = {
 0,64,0,64,15,79,15,79,30,94,30,94,45,109,45,109,60,124,
 60,124,60,124,77,13,77,13,94,30,94,30,111,47,111,47 };
-const int KIDX2[34] = {
+static const int KIDX2[34] = {
 0,0,12,12,8,8,4,4,8,8,12,12,0,0,4,4,0,0,8,8,12,12,
 0,0,4,4,8,8,4,4,0,0,12,12 };
 
-const Byte SBOX[256] = {
-112,130, 44,236,179, 39,192,229,228,133, 87, 53,234, 12,174, 65,
- 35,239,107,147, 69, 25,165, 33,237, 14, 79, 78, 29,101,146,189,
-134,184,175,143,124,235, 31,206, 62, 48,220, 95, 94,197, 11, 26,
-166,225, 57,202,213, 71, 93, 61,217,  1, 90,214, 81, 86,108, 77,
-139, 13,154,102,251,204,176, 45,116, 18, 43, 32,240,177,132,153,
-223, 76,203,194, 52,126,118,  5,109,183,169, 49,209, 23,  4,215,
- 20, 88, 58, 97,222, 27, 17, 28, 50, 15,156, 22, 83, 24,242, 34,
-254, 68,207,178,195,181,122,145, 36,  8,232,168, 96,252,105, 80,
-170,208,160,125,161,137, 98,151, 84, 91, 30,149,224,255,100,210,
- 16,196,  0, 72,163,247,117,219,138,  3,230,218,  9, 63,221,148,
-135, 92,131,  2,205, 74,144, 51,115,103,246,243,157,127,191,226,
- 82,155,216, 38,200, 55,198, 59,129,150,111, 75, 19,190, 99, 46,
-233,121,167,140,159,110,188,142, 41,245,249,182, 47,253,180, 89,
-120,152,  6,106,231, 70,113,186,212, 37,171, 66,136,162,141,250,
-114,  7,185, 85,248,238,172, 10, 54, 73, 42,104, 60, 56,241,164,
- 64, 40,211,123,187,201, 67,193, 21,227,173,244,119,199,128,158};
-
-#define SBOX1(n) SBOX[(n)]
-#define SBOX2(n) (Byte)((SBOX[(n)]>>7^SBOX[(n)]<<1)&0xff)
-#define SBOX3(n) (Byte)((SBOX[(n)]>>1^SBOX[(n)]<<7)&0xff)
-#define SBOX4(n) SBOX[((n)<<1^(n)>>7)&0xff]
-
-void main( void )
+/*
+ * SPxxxx[x] is S-box s(x) placed in the bytes of the P-function output
+ * it reaches, e.g. SP1110[x] = s1(x) * 0x01010100.  The four boxes are
+ * s1 = SBOX, s2 = s1 rotated left 1, s3 = s1 rotated left 7 and
+ * s4(x) = s1(x rotated left 1).
+ */
+static const Word SP1110[256] = {
+	0x70707000, 0x82828200, 0x2c2c2c00, 0xececec00,
+	0xb3b3b300, 0x27272700, 0xc0c0c000, 0xe5e5e500,
+	0xe4e4e400, 0x85858500, 0x57575700, 0x35353500,
+	0xeaeaea00, 0x0c0c0c00, 0xaeaeae00, 0x41414100,
+	0x23232300, 0xefefef00, 0x6b6b6b00, 0x93939300,
+	0x45454500, 0x19191900, 0xa5a5a500, 0x21212100,
+	0xededed00, 0x0e0e0e00, 0x4f4f4f00, 0x4e4e4e00,
+	0x1d1d1d00, 0x65656500, 0x92929200, 0xbdbdbd00,
+	0x86868600, 0xb8b8b800, 0xafafaf00, 0x8f8f8f00,
+	0x7c7c7c00, 0xebebeb00, 0x1f1f1f00, 0xcecece00,
+	0x3e3e3e00, 0x30303000, 0xdcdcdc00, 0x5f5f5f00,
+	0x5e5e5e00, 0xc5c5c500, 0x0b0b0b00, 0x1a1a1a00,
+	0xa6a6a600, 0xe1e1e100, 0x39393900, 0xcacaca00,
+	0xd5d5d500, 0x47474700, 0x5d5d5d00, 0x3d3d3d00,
+	0xd9d9d900, 0x01010100, 0x5a5a5a00, 0xd6d6d600,
+	0x51515100, 0x56565600, 0x6c6c6c00, 0x4d4d4d00,
+	0x8b8b8b00, 0x0d0d0d00, 0x9a9a9a00, 0x66666600,
+	0xfbfbfb00, 0xcccccc00, 0xb0b0b000, 0x2d2d2d00,
+	0x74747400, 0x12121200, 0x2b2b2b00, 0x20202000,
+	0xf0f0f000, 0xb1b1b100, 0x84848400, 0x99999900,
+	0xdfdfdf00, 0x4c4c4c00, 0xcbcbcb00, 0xc2c2c200,
+	0x34343400, 0x7e7e7e00, 0x76767600, 0x05050500,
+	0x6d6d6d00, 0xb7b7b700, 0xa9a9a900, 0x31313100,
+	0xd1d1d100, 0x17171700, 0x04040400, 0xd7d7d700,
+	0x14141400, 0x58585800, 0x3a3a3a00, 0x61616100,
+	0xdedede00, 0x1b1b1b00, 0x11111100, 0x1c1c1c00,
+	0x32323200, 0x0f0f0f00, 0x9c9c9c00, 0x16161600,
+	0x53535300, 0x18181800, 0xf2f2f200, 0x22222200,
+	0xfefefe00, 0x44444400, 0xcfcfcf00, 0xb2b2b200,
+	0xc3c3c300, 0xb5b5b500, 0x7a7a7a00, 0x91919100,
+	0x24242400, 0x08080800, 0xe8e8e800, 0xa8a8a800,
+	0x60606000, 0xfcfcfc00, 0x69696900, 0x50505000,
+	0xaaaaaa00, 0xd0d0d000, 0xa0a0a000, 0x7d7d7d00,
+	0xa1a1a100, 0x89898900, 0x62626200, 0x97979700,
+	0x54545400, 0x5b5b5b00, 0x1e1e1e00, 0x95959500,
+	0xe0e0e000, 0xffffff00, 0x64646400, 0xd2d2d200,
+	0x10101000, 0xc4c4c400, 0x00000000, 0x48484800,
+	0xa3a3a300, 0xf7f7f700, 0x75757500, 0xdbdbdb00,
+	0x8a8a8a00, 0x03030300, 0xe6e6e600, 0xdadada00,
+	0x09090900, 0x3f3f3f00, 0xdddddd00, 0x94949400,
+	0x87878700, 0x5c5c5c00, 0x83838300, 0x02020200,
+	0xcdcdcd00, 0x4a4a4a00, 0x90909000, 0x33333300,
+	0x73737300, 0x67676700, 0xf6f6f600, 0xf3f3f300,
+	0x9d9d9d00, 0x7f7f7f00, 0xbfbfbf00, 0xe2e2e200,
+	0x52525200, 0x9b9b9b00, 0xd8d8d800, 0x26262600,
+	0xc8c8c800, 0x37373700, 0xc6c6c600, 0x3b3b3b00,
+	0x81818100, 0x96969600, 0x6f6f6f00, 0x4b4b4b00,
+	0x13131300, 0xbebebe00, 0x63636300, 0x2e2e2e00,
+	0xe9e9e900, 0x79797900, 0xa7a7a700, 0x8c8c8c00,
+	0x9f9f9f00, 0x6e6e6e00, 0xbcbcbc00, 0x8e8e8e00,
+	0x29292900, 0xf5f5f500, 0xf9f9f900, 0xb6b6b600,
+	0x2f2f2f00, 0xfdfdfd00, 0xb4b4b400, 0x59595900,
+	0x78787800, 0x98989800, 0x06060600, 0x6a6a6a00,
+	0xe7e7e700, 0x46464600, 0x71717100, 0xbababa00,
+	0xd4d4d400, 0x25252500, 0xababab00, 0x42424200,
+	0x88888800, 0xa2a2a200, 0x8d8d8d00, 0xfafafa00,
+	0x72727200, 0x07070700, 0xb9b9b900, 0x55555500,
+	0xf8f8f800, 0xeeeeee00, 0xacacac00, 0x0a0a0a00,
+	0x36363600, 0x49494900, 0x2a2a2a00, 0x68686800,
+	0x3c3c3c00, 0x38383800, 0xf1f1f100, 0xa4a4a400,
+	0x40404000, 0x28282800, 0xd3d3d300, 0x7b7b7b00,
+	0xbbbbbb00, 0xc9c9c900, 0x43434300, 0xc1c1c100,
+	0x15151500, 0xe3e3e300, 0xadadad00, 0xf4f4f400,
+	0x77777700, 0xc7c7c700, 0x80808000, 0x9e9e9e00 };
+
+static const Word SP0222[256] = {
+	0x00e0e0e0, 0x00050505, 0x00585858, 0x00d9d9d9,
+	0x00676767, 0x004e4e4e, 0x00818181, 0x00cbcbcb,
+	0x00c9c9c9, 0x000b0b0b, 0x00aeaeae, 0x006a6a6a,
+	0x00d5d5d5, 0x00181818, 0x005d5d5d, 0x00828282,
+	0x00464646, 0x00dfdfdf, 0x00d6d6d6, 0x00272727,
+	0x008a8a8a, 0x00323232, 0x004b4b4b, 0x00424242,
+	0x00dbdbdb, 0x001c1c1c, 0x009e9e9e, 0x009c9c9c,
+	0x003a3a3a, 0x00cacaca, 0x00252525, 0x007b7b7b,
+	0x000d0d0d, 0x00717171, 0x005f5f5f, 0x001f1f1f,
+	0x00f8f8f8, 0x00d7d7d7, 0x003e3e3e, 0x009d9d9d,
+	0x007c7c7c, 0x00606060, 0x00b9b9b9, 0x00bebebe,
+	0x00bcbcbc, 0x008b8b8b, 0x00161616, 0x00343434,
+	0x004d4d4d, 0x00c3c3c3, 0x00727272, 0x00959595,
+	0x00ababab, 0x008e8e8e, 0x00bababa, 0x007a7a7a,
+	0x00b3b3b3, 0x00020202, 0x00b4b4b4, 0x00adadad,
+	0x00a2a2a2, 0x00acacac, 0x00d8d8d8, 0x009a9a9a,
+	0x00171717, 0x001a1a1a, 0x00353535, 0x00cccccc,
+	0x00f7f7f7, 0x00999999, 0x00616161, 0x005a5a5a,
+	0x00e8e8e8, 0x00242424, 0x00565656, 0x00404040,
+	0x00e1e1e1, 0x00636363, 0x00090909, 0x00333333,
+	0x00bfbfbf, 0x00989898, 0x00979797, 0x00858585,
+	0x00686868, 0x00fcfcfc, 0x00ececec, 0x000a0a0a,
+	0x00dadada, 0x006f6f6f, 0x00535353, 0x00626262,
+	0x00a3a3a3, 0x002e2e2e, 0x00080808, 0x00afafaf,
+	0x00282828, 0x00b0b0b0, 0x00747474, 0x00c2c2c2,
+	0x00bdbdbd, 0x00363636, 0x00222222, 0x00383838,
+	0x00646464, 0x001e1e1e, 0x00393939, 0x002c2c2c,
+	0x00a6a6a6, 0x00303030, 0x00e5e5e5, 0x00444444,
+	0x00fdfdfd, 0x00888888, 0x009f9f9f, 0x00656565,
+	0x00878787, 0x006b6b6b, 0x00f4f4f4, 0x00232323,
+	0x00484848, 0x00101010, 0x00d1d1d1, 0x00515151,
+	0x00c0c0c0, 0x00f9f9f9, 0x00d2d2d2, 0x00a0a0a0,
+	0x00555555, 0x00a1a1a1, 0x00414141, 0x00fafafa,
+	0x00434343, 0x00131313, 0x00c4c4c4, 0x002f2f2f,
+	0x00a8a8a8, 0x00b6b6b6, 0x003c3c3c, 0x002b2b2b,
+	0x00c1c1c1, 0x00ffffff, 0x00c8c8c8, 0x00a5a5a5,
+	0x00202020, 0x00898989, 0x00000000, 0x00909090,
+	0x00474747, 0x00efefef, 0x00eaeaea, 0x00b7b7b7,
+	0x00151515, 0x00060606, 0x00cdcdcd, 0x00b5b5b5,
+	0x00121212, 0x007e7e7e, 0x00bbbbbb, 0x00292929,
+	0x000f0f0f, 0x00b8b8b8, 0x00070707, 0x00040404,
+	0x009b9b9b, 0x00949494, 0x00212121, 0x00666666,
+	0x00e6e6e6, 0x00cecece, 0x00ededed, 0x00e7e7e7,
+	0x003b3b3b, 0x00fefefe, 0x007f7f7f, 0x00c5c5c5,
+	0x00a4a4a4, 0x00373737, 0x00b1b1b1, 0x004c4c4c,
+	0x00919191, 0x006e6e6e, 0x008d8d8d, 0x00767676,
+	0x00030303, 0x002d2d2d, 0x00dedede, 0x00969696,
+	0x00262626, 0x007d7d7d, 0x00c6c6c6, 0x005c5c5c,
+	0x00d3d3d3, 0x00f2f2f2, 0x004f4f4f, 0x00191919,
+	0x003f3f3f, 0x00dcdcdc, 0x00797979, 0x001d1d1d,
+	0x00525252, 0x00ebebeb, 0x00f3f3f3, 0x006d6d6d,
+	0x005e5e5e, 0x00fbfbfb, 0x00696969, 0x00b2b2b2,
+	0x00f0f0f0, 0x00313131, 0x000c0c0c, 0x00d4d4d4,
+	0x00cfcfcf, 0x008c8c8c, 0x00e2e2e2, 0x00757575,
+	0x00a9a9a9, 0x004a4a4a, 0x00575757, 0x00848484,
+	0x00111111, 0x00454545, 0x001b1b1b, 0x00f5f5f5,
+	0x00e4e4e4, 0x000e0e0e, 0x00737373, 0x00aaaaaa,
+	0x00f1f1f1, 0x00dddddd, 0x00595959, 0x00141414,
+	0x006c6c6c, 0x00929292, 0x00545454, 0x00d0d0d0,
+	0x00787878, 0x00707070, 0x00e3e3e3, 0x00494949,
+	0x00808080, 0x00505050, 0x00a7a7a7, 0x00f6f6f6,
+	0x00777777, 0x00939393, 0x00868686, 0x00838383,
+	0x002a2a2a, 0x00c7c7c7, 0x005b5b5b, 0x00e9e9e9,
+	0x00eeeeee, 0x008f8f8f, 0x00010101, 0x003d3d3d };
+
+static const Word SP3033[256] = {
+	0x38003838, 0x41004141, 0x16001616, 0x76007676,
+	0xd900d9d9, 0x93009393, 0x60006060, 0xf200f2f2,
+	0x72007272, 0xc200c2c2, 0xab00abab, 0x9a009a9a,
+	0x75007575, 0x06000606, 0x57005757, 0xa000a0a0,
+	0x91009191, 0xf700f7f7, 0xb500b5b5, 0xc900c9c9,
+	0xa200a2a2, 0x8c008c8c, 0xd200d2d2, 0x90009090,
+	0xf600f6f6, 0x07000707, 0xa700a7a7, 0x27002727,
+	0x8e008e8e, 0xb200b2b2, 0x49004949, 0xde00dede,
+	0x43004343, 0x5c005c5c, 0xd700d7d7, 0xc700c7c7,
+	0x3e003e3e, 0xf500f5f5, 0x8f008f8f, 0x67006767,
+	0x1f001f1f, 0x18001818, 0x6e006e6e, 0xaf00afaf,
+	0x2f002f2f, 0xe200e2e2, 0x85008585, 0x0d000d0d,
+	0x53005353, 0xf000f0f0, 0x9c009c9c, 0x65006565,
+	0xea00eaea, 0xa300a3a3, 0xae00aeae, 0x9e009e9e,
+	0xec00ecec, 0x80008080, 0x2d002d2d, 0x6b006b6b,
+	0xa800a8a8, 0x2b002b2b, 0x36003636, 0xa600a6a6,
+	0xc500c5c5, 0x86008686, 0x4d004d4d, 0x33003333,
+	0xfd00fdfd, 0x66006666, 0x58005858, 0x96009696,
+	0x3a003a3a, 0x09000909, 0x95009595, 0x10001010,
+	0x78007878, 0xd800d8d8, 0x42004242, 0xcc00cccc,
+	0xef00efef, 0x26002626, 0xe500e5e5, 0x61006161,
+	0x1a001a1a, 0x3f003f3f, 0x3b003b3b, 0x82008282,
+	0xb600b6b6, 0xdb00dbdb, 0xd400d4d4, 0x98009898,
+	0xe800e8e8, 0x8b008b8b, 0x02000202, 0xeb00ebeb,
+	0x0a000a0a, 0x2c002c2c, 0x1d001d1d, 0xb000b0b0,
+	0x6f006f6f, 0x8d008d8d, 0x88008888, 0x0e000e0e,
+	0x19001919, 0x87008787, 0x4e004e4e, 0x0b000b0b,
+	0xa900a9a9, 0x0c000c0c, 0x79007979, 0x11001111,
+	0x7f007f7f, 0x22002222, 0xe700e7e7, 0x59005959,
+	0xe100e1e1, 0xda00dada, 0x3d003d3d, 0xc800c8c8,
+	0x12001212, 0x04000404, 0x74007474, 0x54005454,
+	0x30003030, 0x7e007e7e, 0xb400b4b4, 0x28002828,
+	0x55005555, 0x68006868, 0x50005050, 0xbe00bebe,
+	0xd000d0d0, 0xc400c4c4, 0x31003131, 0xcb00cbcb,
+	0x2a002a2a, 0xad00adad, 0x0f000f0f, 0xca00caca,
+	0x70007070, 0xff00ffff, 0x32003232, 0x69006969,
+	0x08000808, 0x62006262, 0x00000000, 0x24002424,
+	0xd100d1d1, 0xfb00fbfb, 0xba00baba, 0xed00eded,
+	0x45004545, 0x81008181, 0x73007373, 0x6d006d6d,
+	0x84008484, 0x9f009f9f, 0xee00eeee, 0x4a004a4a,
+	0xc300c3c3, 0x2e002e2e, 0xc100c1c1, 0x01000101,
+	0xe600e6e6, 0x25002525, 0x48004848, 0x99009999,
+	0xb900b9b9, 0xb300b3b3, 0x7b007b7b, 0xf900f9f9,
+	0xce00cece, 0xbf00bfbf, 0xdf00dfdf, 0x71007171,
+	0x29002929, 0xcd00cdcd, 0x6c006c6c, 0x13001313,
+	0x64006464, 0x9b009b9b, 0x63006363, 0x9d009d9d,
+	0xc000c0c0, 0x4b004b4b, 0xb700b7b7, 0xa500a5a5,
+	0x89008989, 0x5f005f5f, 0xb100b1b1, 0x17001717,
+	0xf400f4f4, 0xbc00bcbc, 0xd300d3d3, 0x46004646,
+	0xcf00cfcf, 0x37003737, 0x5e005e5e, 0x47004747,
+	0x94009494, 0xfa00fafa, 0xfc00fcfc, 0x5b005b5b,
+	0x97009797, 0xfe00fefe, 0x5a005a5a, 0xac00acac,
+	0x3c003c3c, 0x4c004c4c, 0x03000303, 0x35003535,
+	0xf300f3f3, 0x23002323, 0xb800b8b8, 0x5d005d5d,
+	0x6a006a6a, 0x92009292, 0xd500d5d5, 0x21002121,
+	0x44004444, 0x51005151, 0xc600c6c6, 0x7d007d7d,
+	0x39003939, 0x83008383, 0xdc00dcdc, 0xaa00aaaa,
+	0x7c007c7c, 0x77007777, 0x56005656, 0x05000505,
+	0x1b001b1b, 0xa400a4a4, 0x15001515, 0x34003434,
+	0x1e001e1e, 0x1c001c1c, 0xf800f8f8, 0x52005252,
+	0x20002020, 0x14001414, 0xe900e9e9, 0xbd00bdbd,
+	0xdd00dddd, 0xe400e4e4, 0xa100a1a1, 0xe000e0e0,
+	0x8a008a8a, 0xf100f1f1, 0xd600d6d6, 0x7a007a7a,
+	0xbb00bbbb, 0xe300e3e3, 0x40004040, 0x4f004f4f };
+
+static const Word SP4404[256] = {
+	0x70700070, 0x2c2c002c, 0xb3b300b3, 0xc0c000c0,
+	0xe4e400e4, 0x57570057, 0xeaea00ea, 0xaeae00ae,
+	0x23230023, 0x6b6b006b, 0x45450045, 0xa5a500a5,
+	0xeded00ed, 0x4f4f004f, 0x1d1d001d, 0x92920092,
+	0x86860086, 0xafaf00af, 0x7c7c007c, 0x1f1f001f,
+	0x3e3e003e, 0xdcdc00dc, 0x5e5e005e, 0x0b0b000b,
+	0xa6a600a6, 0x39390039, 0xd5d500d5, 0x5d5d005d,
+	0xd9d900d9, 0x5a5a005a, 0x51510051, 0x6c6c006c,
+	0x8b8b008b, 0x9a9a009a, 0xfbfb00fb, 0xb0b000b0,
+	0x74740074, 0x2b2b002b, 0xf0f000f0, 0x84840084,
+	0xdfdf00df, 0xcbcb00cb, 0x34340034, 0x76760076,
+	0x6d6d006d, 0xa9a900a9, 0xd1d100d1, 0x04040004,
+	0x14140014, 0x3a3a003a, 0xdede00de, 0x11110011,
+	0x32320032, 0x9c9c009c, 0x53530053, 0xf2f200f2,
+	0xfefe00fe, 0xcfcf00cf, 0xc3c300c3, 0x7a7a007a,
+	0x24240024, 0xe8e800e8, 0x60600060, 0x69690069,
+	0xaaaa00aa, 0xa0a000a0, 0xa1a100a1, 0x62620062,
+	0x54540054, 0x1e1e001e, 0xe0e000e0, 0x64640064,
+	0x10100010, 0x00000000, 0xa3a300a3, 0x75750075,
+	0x8a8a008a, 0xe6e600e6, 0x09090009, 0xdddd00dd,
+	0x87870087, 0x83830083, 0xcdcd00cd, 0x90900090,
+	0x73730073, 0xf6f600f6, 0x9d9d009d, 0xbfbf00bf,
+	0x52520052, 0xd8d800d8, 0xc8c800c8, 0xc6c600c6,
+	0x81810081, 0x6f6f006f, 0x13130013, 0x63630063,
+	0xe9e900e9, 0xa7a700a7, 0x9f9f009f, 0xbcbc00bc,
+	0x29290029, 0xf9f900f9, 0x2f2f002f, 0xb4b400b4,
+	0x78780078, 0x06060006, 0xe7e700e7, 0x71710071,
+	0xd4d400d4, 0xabab00ab, 0x88880088, 0x8d8d008d,
+	0x72720072, 0xb9b900b9, 0xf8f800f8, 0xacac00ac,
+	0x36360036, 0x2a2a002a, 0x3c3c003c, 0xf1f100f1,
+	0x40400040, 0xd3d300d3, 0xbbbb00bb, 0x43430043,
+	0x15150015, 0xadad00ad, 0x77770077, 0x80800080,
+	0x82820082, 0xecec00ec, 0x27270027, 0xe5e500e5,
+	0x85850085, 0x35350035, 0x0c0c000c, 0x41410041,
+	0xefef00ef, 0x93930093, 0x19190019, 0x21210021,
+	0x0e0e000e, 0x4e4e004e, 0x65650065, 0xbdbd00bd,
+	0xb8b800b8, 0x8f8f008f, 0xebeb00eb, 0xcece00ce,
+	0x30300030, 0x5f5f005f, 0xc5c500c5, 0x1a1a001a,
+	0xe1e100e1, 0xcaca00ca, 0x47470047, 0x3d3d003d,
+	0x01010001, 0xd6d600d6, 0x56560056, 0x4d4d004d,
+	0x0d0d000d, 0x66660066, 0xcccc00cc, 0x2d2d002d,
+	0x12120012, 0x20200020, 0xb1b100b1, 0x99990099,
+	0x4c4c004c, 0xc2c200c2, 0x7e7e007e, 0x05050005,
+	0xb7b700b7, 0x31310031, 0x17170017, 0xd7d700d7,
+	0x58580058, 0x61610061, 0x1b1b001b, 0x1c1c001c,
+	0x0f0f000f, 0x16160016, 0x18180018, 0x22220022,
+	0x44440044, 0xb2b200b2, 0xb5b500b5, 0x91910091,
+	0x08080008, 0xa8a800a8, 0xfcfc00fc, 0x50500050,
+	0xd0d000d0, 0x7d7d007d, 0x89890089, 0x97970097,
+	0x5b5b005b, 0x95950095, 0xffff00ff, 0xd2d200d2,
+	0xc4c400c4, 0x48480048, 0xf7f700f7, 0xdbdb00db,
+	0x03030003, 0xdada00da, 0x3f3f003f, 0x94940094,
+	0x5c5c005c, 0x02020002, 0x4a4a004a, 0x33330033,
+	0x67670067, 0xf3f300f3, 0x7f7f007f, 0xe2e200e2,
+	0x9b9b009b, 0x26260026, 0x37370037, 0x3b3b003b,
+	0x96960096, 0x4b4b004b, 0xbebe00be, 0x2e2e002e,
+	0x79790079, 0x8c8c008c, 0x6e6e006e, 0x8e8e008e,
+	0xf5f500f5, 0xb6b600b6, 0xfdfd00fd, 0x59590059,
+	0x98980098, 0x6a6a006a, 0x46460046, 0xbaba00ba,
+	0x25250025, 0x42420042, 0xa2a200a2, 0xfafa00fa,
+	0x07070007, 0x55550055, 0xeeee00ee, 0x0a0a000a,
+	0x49490049, 0x68680068, 0x38380038, 0xa4a400a4,
+	0x28280028, 0x7b7b007b, 0xc9c900c9, 0xc1c100c1,
+	0xe3e300e3, 0xf4f400f4, 0xc7c700c7, 0x9e9e009e };
+
+#define ROTL(x,n) ((Word)((x)<<(n) | (x)>>(32-(n))))
+#define ROTR(x,n) ((Word)((x)>>(n) | (x)<<(32-(n))))
+
+#define GETW(b) ((Word)(b)[0]<<24 | (Word)(b)[1]<<16 | (Word)(b)[2]<<8 | (Word)(b)[3])
+#define PUTW(b,w) ( (b)[0] = (Byte)((w)>>24), (b)[1] = (Byte)((w)>>16), \
+		    (b)[2] = (Byte)((w)>>8), (b)[3] = (Byte)(w) )
+
+/* (s2,s3) ^= F( (s0,s1), k ) */
+#define FEISTEL(s0,s1,s2,s3,k) do{ \
+	Word t0,t1,t2,t3; \
+	t0  = (s0)^(k)[0]; \
+	t1  = (s1)^(k)[1]; \
+	t3  = SP4404[t0&0xff] ^ SP3033[t0>>8&0xff] \
+	    ^ SP0222[t0>>16&0xff] ^ SP1110[t0>>24]; \
+	t2  = SP1110[t1&0xff] ^ SP4404[t1>>8&0xff] \
+	    ^ SP3033[t1>>16&0xff] ^ SP0222[t1>>24]; \
+	t2 ^= t3; \
+	(s2) ^= t2; \
+	(s3) ^= t2 ^ ROTR(t3,8); \
+}while(0)
+
+/* FL on (s0,s1) with kl, FL^-1 on (s2,s3) with kr */
+#define FLLAYER(s0,s1,s2,s3,kl,kr) do{ \
+	(s1) ^= ROTL((s0)&(kl)[0],1); \
+	(s0) ^= (s1)|(kl)[1]; \
+	(s2) ^= (s3)|(kr)[1]; \
+	(s3) ^= ROTL((s2)&(kr)[0],1); \
+}while(0)
+
+/* the left 64 bits of the 128-bit block x rotated left by n */
+static void RotBlock( const Word *x, const int n, Word *y )
 {
-	const int keysize = 128; /* must be 128, 192 or 256 */
-
-	const Byte ptext[16] = {
-		0x01,0x23,0x45,0x67,0x89,0xab,0xcd,0xef,
-		0xfe,0xdc,0xba,0x98,0x76,0x54,0x32,0x10 };
-	const Byte key[32] = {
-		0x01,0x23,0x45,0x67,0x89,0xab,0xcd,0xef,
-		0xfe,0xdc,0xba,0x98,0x76,0x54,0x32,0x10,
-		0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,
-		0x88,0x99,0xaa,0xbb,0xcc,0xdd,0xee,0xff };
-
-	Byte ctext[16],rtext[16],ekey[272];
-	int  i;
-
-	printf( "Plaintext  " );
-	for( i=0; i<16; i++ ) printf( "%02x ", ptext[i] );
-	printf( "\n%dbit Key ", keysize );
-	for( i=0; i<keysize/8; i++ ) printf( "%02x ", key[i] );
-	printf( "\n" );
-
-	Camellia_Ekeygen( keysize, key, ekey );
-
-	Camellia_Encrypt( keysize, ptext, ekey, ctext );
-
-	printf( "Ciphertext " );
-	for( i=0; i<16; i++ ) printf( "%02x ", ctext[i] );
-	printf( "\n" );
-
-	Camellia_Decrypt( keysize, ctext, ekey, rtext );
-
-	printf( "Plaintext  " );
-	for( i=0; i<16; i++ ) printf( "%02x ", rtext[i] );
-	printf( "\n" );
+	int r;
+	if( (r = (n & 31)) != 0 ){
+		y[0] = x[((n>>5)+0)&3]<<r^x[((n>>5)+1)&3]>>(32-r);
+		y[1] = x[((n>>5)+1)&3]<<r^x[((n>>5)+2)&3]>>(32-r);
+	}
+	else{
+		y[0] = x[((n>>5)+0)&3];
+		y[1] = x[((n>>5)+1)&3];
+	}
 }
 
-void Camellia_Ekeygen( const int n, const Byte *k, Byte *e )
+int Camellia_Ekeygen( Camellia_Ctx *ctx, const int n, const Byte *k )
 {
-	Byte t[64];
-	Word u[20];
+	Word u[16],s0,s1,s2,s3;
 	int  i;
 
+	if( n != 128 && n != 192 && n != 256 ) return -1;
+
+	for( i=0; i<4; i++ ) u[i] = GETW(k+4*i);
 	if( n == 128 ){
-		for( i=0 ; i<16; i++ ) t[i] = k[i];
-		for( i=16; i<32; i++ ) t[i] = 0;
+		u[8] = u[9] = u[10] = u[11] = 0;
 	}
 	else if( n == 192 ){
-		for( i=0 ; i<24; i++ ) t[i] = k[i];
-		for( i=24; i<32; i++ ) t[i] = k[i-8]^0xff;
+		u[8] = GETW(k+16); u[9] = GETW(k+20);
+		u[10] = ~u[8]; u[11] = ~u[9];
 	}
-	else if( n == 256 ){
-		for( i=0 ; i<32; i++ ) t[i] = k[i];
+	else{
+		for( i=0; i<4; i++ ) u[8+i] = GETW(k+16+4*i);
 	}
 
-	XorBlock( t+0, t+16, t+32 );
-
-	Camellia_Feistel( t+32, SIGMA+0, t+40 );
-	Camellia_Feistel( t+40, SIGMA+8, t+32 );
-
-	XorBlock( t+32, t+0, t+32 );
-
-	Camellia_Feistel( t+32, SIGMA+16, t+40 );
-	Camellia_Feistel( t+40, SIGMA+24, t+32 );
-
-	ByteWord( t+0,  u+0 );
-	ByteWord( t+32, u+4 );
+	/* KA */
+	s0 = u[0]^u[8]; s1 = u[1]^u[9]; s2 = u[2]^u[10]; s3 = u[3]^u[11];
+	FEISTEL( s0,s1,s2,s3, SIGMA+0 );
+	FEISTEL( s2,s3,s0,s1, SIGMA+2 );
+	s0 ^= u[0]; s1 ^= u[1]; s2 ^= u[2]; s3 ^= u[3];
+	FEISTEL( s0,s1,s2,s3, SIGMA+4 );
+	FEISTEL( s2,s3,s0,s1, SIGMA+6 );
+	u[4] = s0; u[5] = s1; u[6] = s2; u[7] = s3;
 
 	if( n == 128 ){
-		for( i=0; i<26; i+=2 ){
-			RotBlock( u+KIDX1[i+0], KSFT1[i+0], u+16 );
-			RotBlock( u+KIDX1[i+1], KSFT1[i+1], u+18 );
-			WordByte( u+16, e+i*8 );
-		}
+		ctx->grand = 3;
+		for( i=0; i<26; i++ ) RotBlock( u+KIDX1[i], KSFT1[i], ctx->k+2*i );
 	}
 	else{
-		XorBlock( t+32, t+16, t+48 );
-
-		Camellia_Feistel( t+48, SIGMA+32, t+56 );
-		Camellia_Feistel( t+56, SIGMA+40, t+48 );
-
-		ByteWord( t+16, u+8  );
-		ByteWord( t+48, u+12 );
-
-		for( i=0; i<34; i+=2 ){
-			RotBlock( u+KIDX2[i+0], KSFT2[i+0], u+16 );
-			RotBlock( u+KIDX2[i+1], KSFT2[i+1], u+18 );
-			WordByte( u+16, e+(i<<3) );
-		}
+		/* KB */
+		s0 ^= u[8]; s1 ^= u[9]; s2 ^= u[10]; s3 ^= u[11];
+		FEISTEL( s0,s1,s2,s3, SIGMA+8 );
+		FEISTEL( s2,s3,s0,s1, SIGMA+10 );
+		u[12] = s0; u[13] = s1; u[14] = s2; u[15] = s3;
+
+		ctx->grand = 4;
+		for( i=0; i<34; i++ ) RotBlock( u+KIDX2[i], KSFT2[i], ctx->k+2*i );
 	}
+	return 0;
 }
 
-void Camellia_Encrypt( const int n, const Byte *p, const Byte *e, Byte *c )
+void Camellia_Encrypt( const Camellia_Ctx *ctx, const Byte *p, Byte *c )
 {
-	int i;
-
-	XorBlock( p, e+0, c );
-
-	for( i=0; i<3; i++ ){
-		Camellia_Feistel( c+0, e+16+(i<<4), c+8 );
-		Camellia_Feistel( c+8, e+24+(i<<4), c+0 );
+	const Word *k = ctx->k;
+	Word s0,s1,s2,s3;
+	int  g;
+
+	s0 = GETW(p+0)^k[0];
+	s1 = GETW(p+4)^k[1];
+	s2 = GETW(p+8)^k[2];
+	s3 = GETW(p+12)^k[3];
+
+	for( g=0, k+=4; ; g++, k+=4 ){
+		FEISTEL( s0,s1,s2,s3, k+0 );
+		FEISTEL( s2,s3,s0,s1, k+2 );
+		FEISTEL( s0,s1,s2,s3, k+4 );
+		FEISTEL( s2,s3,s0,s1, k+6 );
+		FEISTEL( s0,s1,s2,s3, k+8 );
+		FEISTEL( s2,s3,s0,s1, k+10 );
+		k += 12;
+		if( g == ctx->grand-1 ) break;
+		FLLAYER( s0,s1,s2,s3, k+0, k+2 );
 	}
 
-	Camellia_FLlayer( c, e+64, e+72 );
-
-	for( i=0; i<3; i++ ){
-		Camellia_Feistel( c+0, e+80+(i<<4), c+8 );
-		Camellia_Feistel( c+8, e+88+(i<<4), c+0 );
-	}
-
-	Camellia_FLlayer( c, e+128, e+136 );
+	s2 ^= k[0]; s3 ^= k[1]; s0 ^= k[2]; s1 ^= k[3];
+	PUTW(c+0,s2); PUTW(c+4,s3); PUTW(c+8,s0); PUTW(c+12,s1);
+}
 
-	for( i=0; i<3; i++ ){
-		Camellia_Feistel( c+0, e+144+(i<<4), c+8 );
-		Camellia_Feistel( c+8, e+152+(i<<4), c+0 );
+void Camellia_Decrypt( const Camellia_Ctx *ctx, const Byte *c, Byte *p )
+{
+	const Word *k = ctx->k + 16*ctx->grand;
+	Word s0,s1,s2,s3;
+	int  g;
+
+	s0 = GETW(c+0)^k[0];
+	s1 = GETW(c+4)^k[1];
+	s2 = GETW(c+8)^k[2];
+	s3 = GETW(c+12)^k[3];
+
+	for( g=0; ; g++ ){
+		k -= 12;
+		FEISTEL( s0,s1,s2,s3, k+10 );
+		FEISTEL( s2,s3,s0,s1, k+8 );
+		FEISTEL( s0,s1,s2,s3, k+6 );
+		FEISTEL( s2,s3,s0,s1, k+4 );
+		FEISTEL( s0,s1,s2,s3, k+2 );
+		FEISTEL( s2,s3,s0,s1, k+0 );
+		if( g == ctx->grand-1 ) break;
+		k -= 4;
+		FLLAYER( s0,s1,s2,s3, k+2, k+0 );
 	}
 
-	if( n == 128 ){
-		SwapHalf( c );
-		XorBlock( c, e+192, c );
-	}
-	else{
-		Camellia_FLlayer( c, e+192, e+200 );
+	k = ctx->k;
+	s2 ^= k[0]; s3 ^= k[1]; s0 ^= k[2]; s1 ^= k[3];
+	PUTW(p+0,s2); PUTW(p+4,s3); PUTW(p+8,s0); PUTW(p+12,s1);
+}
 
-		for( i=0; i<3; i++ ){
-			Camellia_Feistel( c+0, e+208+(i<<4), c+8 );
-			Camellia_Feistel( c+8, e+216+(i<<4), c+0 );
-		}
+#ifdef CAMELLIA_AESNI
+
+/*
+ * The Camellia S-box is the AES S-box between two affine maps over
+ * GF(2)^8 (both are inversion in GF(2^8) under a change of basis):
+ *
+ *	s1(x) = post( AES_S( pre(x) ) )
+ *
+ * An affine map of a byte is the XOR of a map of its low nibble and a
+ * map of its high nibble, so pre and post are two PSHUFB lookups each.
+ * s2 and s3 only rotate the output and s4 the input, which folds into
+ * the tables.  AESENCLAST with a zero round key is ShiftRows then
+ * SubBytes, so undoing ShiftRows first leaves SubBytes on all 16 bytes.
+ *
+ * Sixteen blocks are transposed so that register j holds byte j of every
+ * block; each S-box then runs once per round per state byte, 16 blocks
+ * at a time, with no table lookups that depend on data.
+ */
+
+#define AESNI __attribute__((target("aes,ssse3")))
+
+static const Byte AFFINE[11][16] = {
+	{ 0x45, 0xe8, 0x40, 0xed, 0x2e, 0x83, 0x2b, 0x86, 0x4b, 0xe6, 0x4e, 0xe3, 0x20, 0x8d, 0x25, 0x88 },	/* pre_lo_s1 */
+	{ 0x00, 0x51, 0xf1, 0xa0, 0x8a, 0xdb, 0x7b, 0x2a, 0x09, 0x58, 0xf8, 0xa9, 0x83, 0xd2, 0x72, 0x23 },	/* pre_hi_s1 */
+	{ 0x45, 0x40, 0x2e, 0x2b, 0x4b, 0x4e, 0x20, 0x25, 0x14, 0x11, 0x7f, 0x7a, 0x1a, 0x1f, 0x71, 0x74 },	/* pre_lo_s4 */
+	{ 0x00, 0xf1, 0x8a, 0x7b, 0x09, 0xf8, 0x83, 0x72, 0xad, 0x5c, 0x27, 0xd6, 0xa4, 0x55, 0x2e, 0xdf },	/* pre_hi_s4 */
+	{ 0x3c, 0xcc, 0xcf, 0x3f, 0x32, 0xc2, 0xc1, 0x31, 0xdc, 0x2c, 0x2f, 0xdf, 0xd2, 0x22, 0x21, 0xd1 },	/* post_lo_s1 */
+	{ 0x00, 0xf9, 0x86, 0x7f, 0xd7, 0x2e, 0x51, 0xa8, 0xa4, 0x5d, 0x22, 0xdb, 0x73, 0x8a, 0xf5, 0x0c },	/* post_hi_s1 */
+	{ 0x78, 0x99, 0x9f, 0x7e, 0x64, 0x85, 0x83, 0x62, 0xb9, 0x58, 0x5e, 0xbf, 0xa5, 0x44, 0x42, 0xa3 },	/* post_lo_s2 */
+	{ 0x00, 0xf3, 0x0d, 0xfe, 0xaf, 0x5c, 0xa2, 0x51, 0x49, 0xba, 0x44, 0xb7, 0xe6, 0x15, 0xeb, 0x18 },	/* post_hi_s2 */
+	{ 0x1e, 0x66, 0xe7, 0x9f, 0x19, 0x61, 0xe0, 0x98, 0x6e, 0x16, 0x97, 0xef, 0x69, 0x11, 0x90, 0xe8 },	/* post_lo_s3 */
+	{ 0x00, 0xfc, 0x43, 0xbf, 0xeb, 0x17, 0xa8, 0x54, 0x52, 0xae, 0x11, 0xed, 0xb9, 0x45, 0xfa, 0x06 },	/* post_hi_s3 */
+	{ 0x00, 0x0d, 0x0a, 0x07, 0x04, 0x01, 0x0e, 0x0b, 0x08, 0x05, 0x02, 0x0f, 0x0c, 0x09, 0x06, 0x03 },	/* inv_shift_rows */
+};
+
+enum { PRE_S1 = 0, PRE_S4 = 2, POST_S1 = 4, POST_S2 = 6, POST_S3 = 8,
+       INV_SHIFT_ROWS = 10 };
+
+#define LOADT(i) _mm_loadu_si128( (const __m128i *)AFFINE[i] )
+
+/* t[lo] and t[hi] looked up by the low and high nibbles of x */
+static inline AESNI __m128i Nibbles( __m128i x, __m128i lo, __m128i hi )
+{
+	const __m128i m = _mm_set1_epi8( 0x0f );
+	return _mm_xor_si128( _mm_shuffle_epi8( lo, _mm_and_si128( x, m ) ),
+	    _mm_shuffle_epi8( hi, _mm_and_si128( _mm_srli_epi16( x, 4 ), m ) ) );
+}
 
-		SwapHalf( c );
-		XorBlock( c, e+256, c );
-	}
+static inline AESNI __m128i SBox( __m128i x, int pre, int post )
+{
+	x = Nibbles( x, LOADT(pre), LOADT(pre+1) );
+	x = _mm_shuffle_epi8( x, LOADT(INV_SHIFT_ROWS) );
+	x = _mm_aesenclast_si128( x, _mm_setzero_si128() );
+	return Nibbles( x, LOADT(post), LOADT(post+1) );
 }
 
-void Camellia_Decrypt( const int n, const Byte *c, const Byte *e, Byte *p )
+/* every subkey byte in all 16 lanes, four registers per subkey word */
+static AESNI void Expand16( const Camellia_Ctx *ctx, __m128i *kb )
 {
 	int i;
+	for( i=0; i<4*(16*ctx->grand+4); i++ )
+		kb[i] = _mm_set1_epi8( (char)(ctx->k[i>>2] >> (24-8*(i&3))) );
+}
 
-	if( n == 128 ){
-		XorBlock( c, e+192, p );
-	}
-	else{
-		XorBlock( c, e+256, p );
-
-		for( i=2; i>=0; i-- ){
-			Camellia_Feistel( p+0, e+216+(i<<4), p+8 );
-			Camellia_Feistel( p+8, e+208+(i<<4), p+0 );
-		}
+/* y ^= F( x, k ) for byte-sliced halves x[0..7], y[0..7] */
+static AESNI void Feistel16( const __m128i *x, __m128i *y, const __m128i *k )
+{
+	__m128i t0,t1,t2,t3,t4,t5,t6,t7;
+
+	t0 = SBox( _mm_xor_si128( x[0], k[0] ), PRE_S1, POST_S1 );
+	t1 = SBox( _mm_xor_si128( x[1], k[1] ), PRE_S1, POST_S2 );
+	t2 = SBox( _mm_xor_si128( x[2], k[2] ), PRE_S1, POST_S3 );
+	t3 = SBox( _mm_xor_si128( x[3], k[3] ), PRE_S4, POST_S1 );
+	t4 = SBox( _mm_xor_si128( x[4], k[4] ), PRE_S1, POST_S2 );
+	t5 = SBox( _mm_xor_si128( x[5], k[5] ), PRE_S1, POST_S3 );
+	t6 = SBox( _mm_xor_si128( x[6], k[6] ), PRE_S4, POST_S1 );
+	t7 = SBox( _mm_xor_si128( x[7], k[7] ), PRE_S1, POST_S1 );
+
+#define X3(a,b,c) _mm_xor_si128( _mm_xor_si128( a, b ), c )
+	y[0] = X3( y[0], X3( t0,t2,t3 ), X3( t5,t6,t7 ) );
+	y[1] = X3( y[1], X3( t0,t1,t3 ), X3( t4,t6,t7 ) );
+	y[2] = X3( y[2], X3( t0,t1,t2 ), X3( t4,t5,t7 ) );
+	y[3] = X3( y[3], X3( t1,t2,t3 ), X3( t4,t5,t6 ) );
+	y[4] = X3( y[4], X3( t0,t1,t5 ), _mm_xor_si128( t6,t7 ) );
+	y[5] = X3( y[5], X3( t1,t2,t4 ), _mm_xor_si128( t6,t7 ) );
+	y[6] = X3( y[6], X3( t2,t3,t4 ), _mm_xor_si128( t5,t7 ) );
+	y[7] = X3( y[7], X3( t0,t3,t4 ), _mm_xor_si128( t5,t6 ) );
+#undef X3
+}
 
-		Camellia_FLlayer( p, e+200, e+192 );
-	}
+/* the 32-bit word in byte-sliced w[0..3] rotated left by one bit */
+static inline AESNI void Rotl1( __m128i *w )
+{
+	const __m128i one = _mm_set1_epi8( 1 );
+	__m128i w0 = w[0];
+	int i;
+	for( i=0; i<4; i++ )
+		w[i] = _mm_or_si128( _mm_add_epi8( w[i], w[i] ),
+		    _mm_and_si128( _mm_srli_epi16( i<3 ? w[i+1] : w0, 7 ), one ) );
+}
 
-	for( i=2; i>=0; i-- ){
-		Camellia_Feistel( p+0, e+152+(i<<4), p+8 );
-		Camellia_Feistel( p+8, e+144+(i<<4), p+0 );
-	}
+static AESNI void FLlayer16( __m128i *x, const __m128i *kl, const __m128i *kr )
+{
+	__m128i t[4];
+	int i;
 
-	Camellia_FLlayer( p, e+136, e+128 );
+	for( i=0; i<4; i++ ) t[i] = _mm_and_si128( x[i], kl[i] );
+	Rotl1( t );
+	for( i=0; i<4; i++ ) x[4+i] = _mm_xor_si128( x[4+i], t[i] );
+	for( i=0; i<4; i++ )
+		x[i] = _mm_xor_si128( x[i], _mm_or_si128( x[4+i], kl[4+i] ) );
+
+	for( i=0; i<4; i++ )
+		x[8+i] = _mm_xor_si128( x[8+i], _mm_or_si128( x[12+i], kr[4+i] ) );
+	for( i=0; i<4; i++ ) t[i] = _mm_and_si128( x[8+i], kr[i] );
+	Rotl1( t );
+	for( i=0; i<4; i++ ) x[12+i] = _mm_xor_si128( x[12+i], t[i] );
+}
 
-	for( i=2; i>=0; i-- ){
-		Camellia_Feistel( p+0, e+88+(i<<4), p+8 );
-		Camellia_Feistel( p+8, e+80+(i<<4), p+0 );
-	}
+/*
+ * Four rounds of byte interleaving send byte c of block r to register
+ * rev(c), lane rev(r), where rev reverses 4 bits; the same network
+ * applied again puts every byte back.
+ */
+static const int REV4[16] = { 0,8,4,12,2,10,6,14,1,9,5,13,3,11,7,15 };
 
-	Camellia_FLlayer( p, e+72, e+64 );
+static AESNI void Shuffle16( __m128i *x )
+{
+	__m128i t[16];
+	int i,r;
 
-	for( i=2; i>=0; i-- ){
-		Camellia_Feistel( p+0, e+24+(i<<4), p+8 );
-		Camellia_Feistel( p+8, e+16+(i<<4), p+0 );
+	for( r=0; r<4; r++ ){
+		for( i=0; i<8; i++ ){
+			t[i]   = _mm_unpacklo_epi8( x[2*i], x[2*i+1] );
+			t[i+8] = _mm_unpackhi_epi8( x[2*i], x[2*i+1] );
+		}
+		for( i=0; i<16; i++ ) x[i] = t[i];
 	}
-
-	SwapHalf( p );
-	XorBlock( p, e+0, p );
 }
 
-void Camellia_Feistel( const Byte *x, const Byte *k, Byte *y )
+static AESNI void Load16( const Byte *in, __m128i *x )
 {
-	Byte t[8];
-
-	t[0] = SBOX1(x[0]^k[0]);
-	t[1] = SBOX2(x[1]^k[1]);
-	t[2] = SBOX3(x[2]^k[2]);
-	t[3] = SBOX4(x[3]^k[3]);
-	t[4] = SBOX2(x[4]^k[4]);
-	t[5] = SBOX3(x[5]^k[5]);
-	t[6] = SBOX4(x[6]^k[6]);
-	t[7] = SBOX1(x[7]^k[7]);
-
-	y[0] ^= t[0]^t[2]^t[3]^t[5]^t[6]^t[7];
-	y[1] ^= t[0]^t[1]^t[3]^t[4]^t[6]^t[7];
-	y[2] ^= t[0]^t[1]^t[2]^t[4]^t[5]^t[7];
-	y[3] ^= t[1]^t[2]^t[3]^t[4]^t[5]^t[6];
-	y[4] ^= t[0]^t[1]^t[5]^t[6]^t[7];
-	y[5] ^= t[1]^t[2]^t[4]^t[6]^t[7];
-	y[6] ^= t[2]^t[3]^t[4]^t[5]^t[7];
-	y[7] ^= t[0]^t[3]^t[4]^t[5]^t[6];
+	__m128i t[16];
+	int i;
+
+	for( i=0; i<16; i++ ) t[i] = _mm_loadu_si128( (const __m128i *)(in+16*i) );
+	Shuffle16( t );
+	for( i=0; i<16; i++ ) x[i] = t[REV4[i]];
 }
 
-void Camellia_FLlayer( Byte *x, const Byte *kl, const Byte *kr )
+static AESNI void Store16( __m128i *x, Byte *out )
 {
-	Word t[4],u[4],v[4];
-
-	ByteWord( x, t );
-	ByteWord( kl, u );
-	ByteWord( kr, v );
+	__m128i t[16];
+	int i;
 
-	t[1] ^= (t[0]&u[0])<<1^(t[0]&u[0])>>31;
-	t[0] ^= t[1]|u[1];
-	t[2] ^= t[3]|v[1];
-	t[3] ^= (t[2]&v[0])<<1^(t[2]&v[0])>>31;
+	for( i=0; i<16; i++ ) t[REV4[i]] = x[i];
+	Shuffle16( t );
+	for( i=0; i<16; i++ ) _mm_storeu_si128( (__m128i *)(out+16*i), t[i] );
+}
 
-	WordByte( t, x );
+static AESNI void Whiten16( __m128i *x, const __m128i *k )
+{
+	int i;
+	for( i=0; i<16; i++ ) x[i] = _mm_xor_si128( x[i], k[i] );
 }
 
-void ByteWord( const Byte *x, Word *y )
+/* output whitening, with the halves swapped back */
+static AESNI void Finish16( __m128i *x, const __m128i *k, Byte *out )
 {
+	__m128i y[16];
 	int i;
-	for( i=0; i<4; i++ ){
-		y[i] = ((Word)x[(i<<2)+0]<<24) + ((Word)x[(i<<2)+1]<<16)
-		     + ((Word)x[(i<<2)+2]<<8 ) + ((Word)x[(i<<2)+3]<<0 );
+
+	for( i=0; i<8; i++ ){
+		y[i]   = _mm_xor_si128( x[8+i], k[i] );
+		y[8+i] = _mm_xor_si128( x[i], k[8+i] );
 	}
+	Store16( y, out );
 }
 
-void WordByte( const Word *x, Byte *y )
+/* kb is the schedule from Expand16; subkey word w starts at kb[4*w] */
+static AESNI void Encrypt16( int grand, const __m128i *kb, const Byte *in, Byte *out )
 {
-	int i;
-	for( i=0; i<4; i++ ){
-		y[(i<<2)+0] = (Byte)(x[i]>>24&0xff);
-		y[(i<<2)+1] = (Byte)(x[i]>>16&0xff);
-		y[(i<<2)+2] = (Byte)(x[i]>> 8&0xff);
-		y[(i<<2)+3] = (Byte)(x[i]>> 0&0xff);
+	const __m128i *k = kb;
+	__m128i x[16];
+	int g;
+
+	Load16( in, x );
+	Whiten16( x, k );
+
+	for( g=0, k+=16; ; g++, k+=16 ){
+		Feistel16( x+0, x+8, k+0 );
+		Feistel16( x+8, x+0, k+8 );
+		Feistel16( x+0, x+8, k+16 );
+		Feistel16( x+8, x+0, k+24 );
+		Feistel16( x+0, x+8, k+32 );
+		Feistel16( x+8, x+0, k+40 );
+		k += 48;
+		if( g == grand-1 ) break;
+		FLlayer16( x, k+0, k+8 );
 	}
+
+	Finish16( x, k, out );
 }
 
-void RotBlock( const Word *x, const int n, Word *y )
+static AESNI void Decrypt16( int grand, const __m128i *kb, const Byte *in, Byte *out )
 {
-	int r;
-	if( r = (n & 31) ){
-		y[0] = x[((n>>5)+0)&3]<<r^x[((n>>5)+1)&3]>>(32-r);
-		y[1] = x[((n>>5)+1)&3]<<r^x[((n>>5)+2)&3]>>(32-r);
+	const __m128i *k = kb + 64*grand;
+	__m128i x[16];
+	int g;
+
+	Load16( in, x );
+	Whiten16( x, k );
+
+	for( g=0; ; g++ ){
+		k -= 48;
+		Feistel16( x+0, x+8, k+40 );
+		Feistel16( x+8, x+0, k+32 );
+		Feistel16( x+0, x+8, k+24 );
+		Feistel16( x+8, x+0, k+16 );
+		Feistel16( x+0, x+8, k+8 );
+		Feistel16( x+8, x+0, k+0 );
+		if( g == grand-1 ) break;
+		k -= 16;
+		FLlayer16( x, k+8, k+0 );
 	}
-	else{
-		y[0] = x[((n>>5)+0)&3];
-		y[1] = x[((n>>5)+1)&3];
+
+	Finish16( x, kb, out );
+}
+
+/* as many whole runs of 16 blocks as n holds; returns the blocks done */
+static AESNI size_t Blocks16( const Camellia_Ctx *ctx, const Byte *in,
+	Byte *out, size_t n, int decrypt )
+{
+	__m128i kb[272];
+	size_t  d;
+
+	Expand16( ctx, kb );
+	for( d=0; n-d >= 16; d += 16 ){
+		if( decrypt ) Decrypt16( ctx->grand, kb, in+16*d, out+16*d );
+		else          Encrypt16( ctx->grand, kb, in+16*d, out+16*d );
 	}
+	return d;
 }
 
-void SwapHalf( Byte *x )
+#define HAVE_AESNI ( __builtin_cpu_supports( "aes" ) && __builtin_cpu_supports( "ssse3" ) )
+
+#endif /* CAMELLIA_AESNI */
+
+void Camellia_EncryptBlocks( const Camellia_Ctx *ctx, const Byte *in,
+	Byte *out, size_t n )
 {
-	Byte t;
-	int  i;
-	for( i=0; i<8; i++ ){
-		t = x[i];
-		x[i] = x[8+i];
-		x[8+i] = t;
+#ifdef CAMELLIA_AESNI
+	if( n >= 16 && HAVE_AESNI ){
+		size_t d = Blocks16( ctx, in, out, n, 0 );
+		n -= d; in += 16*d; out += 16*d;
 	}
+#endif
+	for( ; n; n--, in += 16, out += 16 ) Camellia_Encrypt( ctx, in, out );
 }
 
-void XorBlock( const Byte *x, const Byte *y, Byte *z )
+void Camellia_DecryptBlocks( const Camellia_Ctx *ctx, const Byte *in,
+	Byte *out, size_t n )
 {
-	int i;
-	for( i=0; i<16; i++ ) z[i] = x[i] ^ y[i];
+#ifdef CAMELLIA_AESNI
+	if( n >= 16 && HAVE_AESNI ){
+		size_t d = Blocks16( ctx, in, out, n, 1 );
+		n -= d; in += 16*d; out += 16*d;
+	}
+#endif
+	for( ; n; n--, in += 16, out += 16 ) Camellia_Decrypt( ctx, in, out );
 }
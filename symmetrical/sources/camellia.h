@@ -0,0 +1,49 @@
+/*************************************************
+ *						 *
+ *	Camellia Block Encryption Algorithm	 *
+ *	  in ANSI-C Language : Camellia.h	 *
+ *						 *
+ *************************************************/
+
+#ifndef CAMELLIA_H
+#define CAMELLIA_H
+
+#include <limits.h>
+#include <stddef.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+typedef unsigned char Byte;
+
+/* A 32-bit data type */
+#if ULONG_MAX > 0xffffffffUL	/* LP64: long is 64 bits */
+typedef unsigned int Word;
+#else
+typedef unsigned long Word;
+#endif
+
+/* expanded key: subkeys as big-endian words, in encryption order */
+typedef struct {
+	Word k[68];
+	int  grand;	/* 3 for 128-bit keys, 4 for 192/256 */
+} Camellia_Ctx;
+
+/* keysize in bits: 128, 192 or 256; returns nonzero for any other */
+int  Camellia_Ekeygen( Camellia_Ctx *, const int keysize, const Byte *key );
+
+void Camellia_Encrypt( const Camellia_Ctx *, const Byte *p, Byte *c );
+void Camellia_Decrypt( const Camellia_Ctx *, const Byte *c, Byte *p );
+
+/* n consecutive 16-byte blocks; in may be the same as out */
+void Camellia_EncryptBlocks( const Camellia_Ctx *, const Byte *in,
+	Byte *out, size_t n );
+void Camellia_DecryptBlocks( const Camellia_Ctx *, const Byte *in,
+	Byte *out, size_t n );
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* CAMELLIA_H */
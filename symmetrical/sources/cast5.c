@@ -49,13 +49,6 @@
 #define FNCCAST_SETKEY(f)  (int(*)(void*, byte*, unsigned))(f)
 #define FNCCAST_CRYPT(f)   (void(*)(void*, byte*, byte*))(f)
 
-#define CAST5_BLOCKSIZE 8
-
-typedef struct {
-    u32  Km[16];
-    byte Kr[16];
-} CAST5_context;
-
 static int  cast_setkey( CAST5_context *c, byte *key, unsigned keylen );
 static void encrypt_block( CAST5_context *bc, byte *outbuf, byte *inbuf );
 static void decrypt_block( CAST5_context *bc, byte *outbuf, byte *inbuf );
@@ -478,6 +471,160 @@ decrypt_block( CAST5_context *c, byte *outbuf, byte *inbuf )
     burn_stack (20+4*sizeof(void*));
 }
 
+
+/****************
+ * Interleaved ECB of up to CAST_MAX_LANES blocks.  A round of one block
+ * is a chain of four S-box loads that all wait on the round before; the
+ * same round of N independent blocks is issued together here so that
+ * their loads overlap.  Instead of the L/R swap of the single block code
+ * the rounds alternate between the two halves of each lane, which keeps
+ * every half in place.
+ */
+
+#ifdef __GNUC__
+  #define CAST_INLINE static inline __attribute__((always_inline))
+#else
+  #define CAST_INLINE static inline
+#endif
+
+#define CAST_MAX_LANES 8
+
+/* op(k) for the lanes k < n; n is a constant in every caller */
+#define CAST_LANES(op)	do { op(0);					 \
+			     if( n > 1 ) op(1);				 \
+			     if( n > 2 ) op(2);				 \
+			     if( n > 3 ) op(3);				 \
+			     if( n > 4 ) op(4);				 \
+			     if( n > 5 ) op(5);				 \
+			     if( n > 6 ) op(6);				 \
+			     if( n > 7 ) op(7);				 \
+			} while(0)
+#define CAST_ROUND(op,j)  do { const int i = (j); CAST_LANES(op); } while(0)
+
+#define CAST_L1(k)  (l[k] ^= F1(r[k], Km[i], Kr[i]))
+#define CAST_L2(k)  (l[k] ^= F2(r[k], Km[i], Kr[i]))
+#define CAST_L3(k)  (l[k] ^= F3(r[k], Km[i], Kr[i]))
+#define CAST_R1(k)  (r[k] ^= F1(l[k], Km[i], Kr[i]))
+#define CAST_R2(k)  (r[k] ^= F2(l[k], Km[i], Kr[i]))
+#define CAST_R3(k)  (r[k] ^= F3(l[k], Km[i], Kr[i]))
+
+#define CAST_GET(k) do { const byte *q = inbuf + CAST5_BLOCKSIZE*(k);	    \
+			 l[k] = (u32)q[0] << 24 | q[1] << 16 | q[2] << 8 | q[3]; \
+			 r[k] = (u32)q[4] << 24 | q[5] << 16 | q[6] << 8 | q[7]; \
+		    } while(0)
+/* after an even number of rounds r holds R16 and l holds L16 */
+#define CAST_PUT(k) do { byte *q = outbuf + CAST5_BLOCKSIZE*(k);	    \
+			 q[0] = r[k] >> 24; q[1] = r[k] >> 16;		    \
+			 q[2] = r[k] >>  8; q[3] = r[k];			    \
+			 q[4] = l[k] >> 24; q[5] = l[k] >> 16;		    \
+			 q[6] = l[k] >>  8; q[7] = l[k];			    \
+		    } while(0)
+
+CAST_INLINE void
+encrypt_lanes( CAST5_context *c, const int n, byte *outbuf,
+	       const byte *inbuf )
+{
+    u32 l[CAST_MAX_LANES], r[CAST_MAX_LANES];
+    u32 I;   /* used by the Fx macros */
+    const u32 *Km = c->Km;
+    const byte *Kr = c->Kr;
+
+    CAST_LANES( CAST_GET );
+    CAST_ROUND( CAST_L1,  0 );
+    CAST_ROUND( CAST_R2,  1 );
+    CAST_ROUND( CAST_L3,  2 );
+    CAST_ROUND( CAST_R1,  3 );
+    CAST_ROUND( CAST_L2,  4 );
+    CAST_ROUND( CAST_R3,  5 );
+    CAST_ROUND( CAST_L1,  6 );
+    CAST_ROUND( CAST_R2,  7 );
+    CAST_ROUND( CAST_L3,  8 );
+    CAST_ROUND( CAST_R1,  9 );
+    CAST_ROUND( CAST_L2, 10 );
+    CAST_ROUND( CAST_R3, 11 );
+    CAST_ROUND( CAST_L1, 12 );
+    CAST_ROUND( CAST_R2, 13 );
+    CAST_ROUND( CAST_L3, 14 );
+    CAST_ROUND( CAST_R1, 15 );
+    CAST_LANES( CAST_PUT );
+}
+
+CAST_INLINE void
+decrypt_lanes( CAST5_context *c, const int n, byte *outbuf,
+	       const byte *inbuf )
+{
+    u32 l[CAST_MAX_LANES], r[CAST_MAX_LANES];
+    u32 I;
+    const u32 *Km = c->Km;
+    const byte *Kr = c->Kr;
+
+    CAST_LANES( CAST_GET );
+    CAST_ROUND( CAST_L1, 15 );
+    CAST_ROUND( CAST_R3, 14 );
+    CAST_ROUND( CAST_L2, 13 );
+    CAST_ROUND( CAST_R1, 12 );
+    CAST_ROUND( CAST_L3, 11 );
+    CAST_ROUND( CAST_R2, 10 );
+    CAST_ROUND( CAST_L1,  9 );
+    CAST_ROUND( CAST_R3,  8 );
+    CAST_ROUND( CAST_L2,  7 );
+    CAST_ROUND( CAST_R1,  6 );
+    CAST_ROUND( CAST_L3,  5 );
+    CAST_ROUND( CAST_R2,  4 );
+    CAST_ROUND( CAST_L1,  3 );
+    CAST_ROUND( CAST_R3,  2 );
+    CAST_ROUND( CAST_L2,  1 );
+    CAST_ROUND( CAST_R1,  0 );
+    CAST_LANES( CAST_PUT );
+}
+
+
+/****************
+ * Encrypt or decrypt NBLOCKS consecutive blocks in one call, burning
+ * the stack once at the end rather than after every block as the
+ * function pointers handed out by _gcry_cast5_get_info() do.  Runs of
+ * eight and four blocks go through the interleaved code above.  OUTBUF
+ * may be the same as INBUF.
+ */
+void
+_gcry_cast5_encrypt_blocks( CAST5_context *c, byte *outbuf,
+			    const byte *inbuf, size_t nblocks )
+{
+    for( ; nblocks >= 8; nblocks -= 8, outbuf += 8*CAST5_BLOCKSIZE,
+				       inbuf += 8*CAST5_BLOCKSIZE )
+	encrypt_lanes( c, 8, outbuf, inbuf );
+    if( nblocks >= 4 ) {
+	encrypt_lanes( c, 4, outbuf, inbuf );
+	nblocks -= 4;
+	outbuf += 4*CAST5_BLOCKSIZE;
+	inbuf  += 4*CAST5_BLOCKSIZE;
+    }
+    for( ; nblocks; nblocks--, outbuf += CAST5_BLOCKSIZE,
+			       inbuf += CAST5_BLOCKSIZE )
+	do_encrypt_block( c, outbuf, (byte*)inbuf );
+    burn_stack (2*CAST_MAX_LANES*sizeof(u32)+20+4*sizeof(void*));
+}
+
+void
+_gcry_cast5_decrypt_blocks( CAST5_context *c, byte *outbuf,
+			    const byte *inbuf, size_t nblocks )
+{
+    for( ; nblocks >= 8; nblocks -= 8, outbuf += 8*CAST5_BLOCKSIZE,
+				       inbuf += 8*CAST5_BLOCKSIZE )
+	decrypt_lanes( c, 8, outbuf, inbuf );
+    if( nblocks >= 4 ) {
+	decrypt_lanes( c, 4, outbuf, inbuf );
+	nblocks -= 4;
+	outbuf += 4*CAST5_BLOCKSIZE;
+	inbuf  += 4*CAST5_BLOCKSIZE;
+    }
+    for( ; nblocks; nblocks--, outbuf += CAST5_BLOCKSIZE,
+			       inbuf += CAST5_BLOCKSIZE )
+	do_decrypt_block( c, outbuf, (byte*)inbuf );
+    burn_stack (2*CAST_MAX_LANES*sizeof(u32)+20+4*sizeof(void*));
+}
+
+
 static const char*
 selftest(void)
 {
@@ -623,6 +770,12 @@ cast_setkey( CAST5_context *c, byte *key, unsigned keylen )
     return rc;
 }
 
+int
+_gcry_cast5_setkey( CAST5_context *c, const byte *key, unsigned keylen )
+{
+    return cast_setkey( c, (byte*)key, keylen );
+}
+
 /****************
  * Return some information about the algorithm.  We need algo here to
  * distinguish different flavors of the algorithm.
@@ -0,0 +1,57 @@
+/* cast5.h
+ *	Copyright (C) 1998, 2001 Free Software Foundation, Inc.
+ *
+ * This file is part of Libgcrypt.
+ *
+ * Libgcrypt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Libgcrypt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+#ifndef G10_CAST5_H
+#define G10_CAST5_H
+
+#include <stddef.h>
+#include "types.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#define CAST5_BLOCKSIZE 8
+
+typedef struct {
+    u32  Km[16];
+    byte Kr[16];
+} CAST5_context;
+
+const char *
+_gcry_cast5_get_info( int algo, size_t *keylen,
+		   size_t *blocksize, size_t *contextsize,
+		   int	(**setkeyf)( void *c, byte *key, unsigned keylen ),
+		   void (**encryptf)( void *c, byte *outbuf, byte *inbuf ),
+		   void (**decryptf)( void *c, byte *outbuf, byte *inbuf )
+		 );
+
+/* Direct entry points for callers linking this module without the
+ * get_info indirection; see cast5.c. */
+int  _gcry_cast5_setkey( CAST5_context *c, const byte *key, unsigned keylen );
+void _gcry_cast5_encrypt_blocks( CAST5_context *c, byte *outbuf,
+				 const byte *inbuf, size_t nblocks );
+void _gcry_cast5_decrypt_blocks( CAST5_context *c, byte *outbuf,
+				 const byte *inbuf, size_t nblocks );
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /*G10_CAST5_H*/
@@ -62,16 +62,17 @@ Mean:          674 cycles =    38.0 mbits/sec
 #  undef BYTE_SWAP 
 #endif 
  
-#include "../std_defs.h" 
+#include <string.h> 
+#include "cast6.h" 
  
 static char *alg_name[] = { "cast256", "cast.c", "cast-256" }; 
  
-char **cipher_name() 
+char **cast6_cipher_name(void) 
 { 
     return alg_name; 
 } 
      
-u4byte s_box[4][256] =  
+static u4byte s_box[4][256] =  
 { { 
     0x30fb40d4, 0x9fa0ff0b, 0x6beccd2f, 0x3f258c7a, 0x1e213f2f, 0x9C004dd3,  
     0x6003e540, 0xcf9fc949, 0xbfd4af27, 0x88bbbdb5, 0xe2034090, 0x98d09675, 
@@ -300,12 +301,11 @@ u4byte s_box[4][256] =
     f1(k[0],k[1],tr[6],tm[6]);  \ 
     f2(k[7],k[0],tr[7],tm[7]) 
  
-u4byte  l_key[96]; 
- 
 /* initialise the key schedule from the user supplied key   */ 
  
-u4byte *set_key(const u4byte in_key[], const u4byte key_len) 
-{   u4byte  i, j, t, u, cm, cr, lk[8], tm[8], tr[8]; 
+u4byte *cast6_set_key(cast6_ctx *ctx, const u4byte in_key[], const u4byte key_len) 
+{   u4byte *l_key = ctx->l_key; 
+    u4byte  i, j, t, u, cm, cr, lk[8], tm[8], tr[8]; 
  
     for(i = 0; i < key_len / 32; ++i) 
  
@@ -346,8 +346,9 @@ u4byte *set_key(const u4byte in_key[], const u4byte key_len)
  
 /* encrypt a block of text  */ 
  
-void encrypt(const u4byte in_blk[4], u4byte out_blk[]) 
-{   u4byte  t, u, blk[4]; 
+void cast6_encrypt(const cast6_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]) 
+{   const u4byte *l_key = ctx->l_key; 
+    u4byte  t, u, blk[4]; 
  
     blk[0] = io_swap(in_blk[0]); blk[1] = io_swap(in_blk[1]); 
     blk[2] = io_swap(in_blk[2]); blk[3] = io_swap(in_blk[3]); 
@@ -365,8 +366,9 @@ void encrypt(const u4byte in_blk[4], u4byte out_blk[])
  
 /* decrypt a block of text  */ 
  
-void decrypt(const u4byte in_blk[4], u4byte out_blk[4]) 
-{   u4byte  t, u, blk[4]; 
+void cast6_decrypt(const cast6_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]) 
+{   const u4byte *l_key = ctx->l_key; 
+    u4byte  t, u, blk[4]; 
  
     blk[0] = io_swap(in_blk[0]); blk[1] = io_swap(in_blk[1]); 
     blk[2] = io_swap(in_blk[2]); blk[3] = io_swap(in_blk[3]); 
@@ -381,3 +383,28 @@ void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
     out_blk[0] = io_swap(blk[0]); out_blk[1] = io_swap(blk[1]); 
     out_blk[2] = io_swap(blk[2]); out_blk[3] = io_swap(blk[3]); 
 }; 
+ 
+/* encrypt n_blk consecutive blocks of text held in byte buffers that */ 
+/* need not be word aligned; in_blk may be the same as out_blk        */ 
+ 
+void cast6_encrypt_blocks(const cast6_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk) 
+{   u4byte  b_in[4], b_out[4]; 
+ 
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16) 
+    { 
+        memcpy(b_in, in_blk, 16); cast6_encrypt(ctx, b_in, b_out); 
+        memcpy(out_blk, b_out, 16); 
+    } 
+}; 
+ 
+/* decrypt n_blk consecutive blocks of text                          */ 
+ 
+void cast6_decrypt_blocks(const cast6_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk) 
+{   u4byte  b_in[4], b_out[4]; 
+ 
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16) 
+    { 
+        memcpy(b_in, in_blk, 16); cast6_decrypt(ctx, b_in, b_out); 
+        memcpy(out_blk, b_out, 16); 
+    } 
+}; 
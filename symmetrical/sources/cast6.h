@@ -0,0 +1,32 @@
+
+/* CAST-256 with the key schedule held in a caller supplied         */
+/* context (see cast6.c). A context may be shared by any number     */
+/* of threads once its key has been set.                            */
+
+#ifndef _CAST6_H
+#define _CAST6_H
+
+#include "../std_defs.h"
+#include <stddef.h>
+#include "cache_align.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{   CACHE_ALIGN u4byte  l_key[96];  /* storage for the key schedule */
+} cast6_ctx;
+
+char    **cast6_cipher_name(void);
+u4byte  *cast6_set_key(cast6_ctx *ctx, const u4byte in_key[], const u4byte key_len);
+void    cast6_encrypt(const cast6_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    cast6_decrypt(const cast6_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    cast6_encrypt_blocks(const cast6_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+void    cast6_decrypt_blocks(const cast6_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,450 @@
+/*
+ *  cipher_modes.hpp:  ECB, CBC, CFB, OFB and CTR over any BlockCipher<Impl>
+ *  with a 64- or 128-bit block (see block_cipher.hpp).
+ *
+ *  Wherever the mode lets blocks be computed independently -- ECB, CBC
+ *  decryption, CFB decryption and CTR -- the data is handed to the
+ *  cipher's encrypt_blocks/decrypt_blocks a stride at a time, so the
+ *  cipher sees runs of blocks rather than one block per call.  CBC and
+ *  CFB encryption and OFB are inherently serial and go block by block.
+ *
+ *  All modes work in place (in == out) on the caller's buffers.  The
+ *  only scratch space is a fixed stride on the stack; nothing is
+ *  allocated.  The chaining value or counter lives in the mode object,
+ *  so a message can be fed in successive calls:
+ *
+ *    - cfb_mode, ofb_mode and ctr_mode take chunks of any length and
+ *      carry a partly used keystream block over to the next call;
+ *    - ecb_mode and cbc_mode take whole blocks only and return false,
+ *      processing nothing, for a length that is not a multiple of the
+ *      block size.  Padding is left to the caller.
+ *
+ *  A mode object refers to its cipher and does not own it; the cipher
+ *  must outlive it, and may be shared by any number of mode objects.
+ */
+
+#ifndef CIPHER_MODES_HPP
+#define CIPHER_MODES_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "block_cipher.hpp"
+
+/*
+ * Bytes handed to the cipher per call on the batched paths, raised to
+ * the cipher's PREFERRED_BLOCKS where it declares more (bitsliced 3DES
+ * only reaches its AVX2 and AVX-512 kernels at 256 and 512 blocks).
+ */
+#define CIPHER_MODE_STRIDE_BYTES 512
+
+/*
+ * A cipher block held as 64-bit words, so that chaining values stay in
+ * registers and XORs are done a word at a time.  Loads and stores go
+ * through memcpy and may be unaligned.
+ */
+template <size_t B>
+struct mode_block
+{
+  static_assert(B == 8 || B == 16, "64- or 128-bit blocks only");
+
+  uint64_t w[B / 8];
+
+  void load (const unsigned char *p) { memcpy (w, p, B); }
+  void store (unsigned char *p) const { memcpy (p, w, B); }
+
+  void operator^= (const mode_block &o)
+  {
+    for (size_t i = 0; i < B / 8; i++)
+      w[i] ^= o.w[i];
+  }
+};
+
+/* out = a ^ b for n bytes; out may be a or b */
+inline void mode_xor (unsigned char *out, const unsigned char *a,
+                      const unsigned char *b, size_t n)
+{
+  for (; n >= 8; n -= 8, out += 8, a += 8, b += 8)
+    {
+      uint64_t x, y;
+      memcpy (&x, a, 8);
+      memcpy (&y, b, 8);
+      x ^= y;
+      memcpy (out, &x, 8);
+    }
+  while (n--)
+    *out++ = *a++ ^ *b++;
+}
+
+template <class Cipher>
+class mode_base
+{
+public:
+  static constexpr size_t BLOCKSIZE = Cipher::BLOCKSIZE;
+  static constexpr size_t STRIDE
+    = CIPHER_MODE_STRIDE_BYTES / BLOCKSIZE
+        > block_cipher_preferred_blocks<Cipher>::value
+      ? CIPHER_MODE_STRIDE_BYTES / BLOCKSIZE
+      : block_cipher_preferred_blocks<Cipher>::value;
+
+  const Cipher &cipher () const { return *c; }
+
+protected:
+  typedef mode_block<BLOCKSIZE> block;
+
+  explicit mode_base (const Cipher &cipher) : c (&cipher) {}
+
+  const Cipher *c;
+};
+
+/*
+ * Electronic codebook: the whole buffer goes to the cipher in one call.
+ */
+template <class Cipher>
+class ecb_mode : public mode_base<Cipher>
+{
+  typedef mode_base<Cipher> base;
+  using base::c;
+
+public:
+  explicit ecb_mode (const Cipher &cipher) : base (cipher) {}
+
+  bool encrypt (const unsigned char *in, unsigned char *out, size_t len)
+  {
+    if (len % base::BLOCKSIZE)
+      return false;
+    c->encrypt_blocks (in, out, len / base::BLOCKSIZE);
+    return true;
+  }
+
+  bool decrypt (const unsigned char *in, unsigned char *out, size_t len)
+  {
+    if (len % base::BLOCKSIZE)
+      return false;
+    c->decrypt_blocks (in, out, len / base::BLOCKSIZE);
+    return true;
+  }
+};
+
+/*
+ * Cipher block chaining.  Encryption is serial; decryption deciphers a
+ * stride at once and then undoes the chaining, reading each ciphertext
+ * block before its plaintext overwrites it.
+ */
+template <class Cipher>
+class cbc_mode : public mode_base<Cipher>
+{
+  typedef mode_base<Cipher> base;
+  typedef typename base::block block;
+  using base::c;
+  static constexpr size_t B = base::BLOCKSIZE;
+
+public:
+  cbc_mode (const Cipher &cipher, const unsigned char *iv)
+    : base (cipher) { set_iv (iv); }
+  ~cbc_mode () { block_cipher_wipe (&chain, sizeof (chain)); }
+
+  void set_iv (const unsigned char *iv) { chain.load (iv); }
+  void get_iv (unsigned char *iv) const { chain.store (iv); }
+
+  bool encrypt (const unsigned char *in, unsigned char *out, size_t len)
+  {
+    if (len % B)
+      return false;
+    block x = chain;
+    for (; len; len -= B, in += B, out += B)
+      {
+        block p;
+        p.load (in);
+        x ^= p;
+        x.store (out);
+        c->encrypt_block (out, out);
+        x.load (out);
+      }
+    chain = x;
+    return true;
+  }
+
+  bool decrypt (const unsigned char *in, unsigned char *out, size_t len)
+  {
+    if (len % B)
+      return false;
+    unsigned char buf[base::STRIDE * B];
+    block prev = chain;
+    for (size_t n; len; len -= n * B, in += n * B, out += n * B)
+      {
+        n = len / B < base::STRIDE ? len / B : base::STRIDE;
+        c->decrypt_blocks (in, buf, n);
+        for (size_t i = 0; i < n; i++)
+          {
+            block x, ct;
+            ct.load (in + i * B);
+            x.load (buf + i * B);
+            x ^= prev;
+            x.store (out + i * B);
+            prev = ct;
+          }
+      }
+    chain = prev;
+    block_cipher_wipe (buf, sizeof (buf));
+    return true;
+  }
+
+private:
+  block chain;          /* IV, then the last ciphertext block */
+};
+
+/*
+ * Full-block cipher feedback.  reg holds the last ciphertext block, or
+ * while a block is partly used, the keystream with the ciphertext bytes
+ * produced so far written over it; pos counts those bytes.  Decryption
+ * enciphers a stride of previous ciphertext blocks at once.
+ */
+template <class Cipher>
+class cfb_mode : public mode_base<Cipher>
+{
+  typedef mode_base<Cipher> base;
+  using base::c;
+  static constexpr size_t B = base::BLOCKSIZE;
+
+public:
+  cfb_mode (const Cipher &cipher, const unsigned char *iv)
+    : base (cipher) { set_iv (iv); }
+  ~cfb_mode () { block_cipher_wipe (reg, sizeof (reg)); }
+
+  void set_iv (const unsigned char *iv) { memcpy (reg, iv, B); pos = 0; }
+
+  void encrypt (const unsigned char *in, unsigned char *out, size_t len)
+  {
+    for (; pos && len; len--)
+      {
+        reg[pos] = *out++ = *in++ ^ reg[pos];
+        pos = (pos + 1) % B;
+      }
+    for (; len >= B; len -= B, in += B, out += B)
+      {
+        c->encrypt_block (reg, reg);
+        mode_xor (reg, reg, in, B);
+        memcpy (out, reg, B);
+      }
+    if (len)
+      {
+        c->encrypt_block (reg, reg);
+        for (; pos < len; pos++)
+          reg[pos] = *out++ = *in++ ^ reg[pos];
+      }
+  }
+
+  void decrypt (const unsigned char *in, unsigned char *out, size_t len)
+  {
+    for (; pos && len; len--)
+      {
+        unsigned char t = *in++;
+        *out++ = reg[pos] ^ t;
+        reg[pos] = t;
+        pos = (pos + 1) % B;
+      }
+    if (len >= B)
+      {
+        unsigned char buf[base::STRIDE * B];
+        for (size_t n; len >= B; len -= n * B, in += n * B, out += n * B)
+          {
+            n = len / B < base::STRIDE ? len / B : base::STRIDE;
+            memcpy (buf, reg, B);
+            memcpy (buf + B, in, (n - 1) * B);
+            memcpy (reg, in + (n - 1) * B, B);
+            c->encrypt_blocks (buf, buf, n);
+            mode_xor (out, in, buf, n * B);
+          }
+        block_cipher_wipe (buf, sizeof (buf));
+      }
+    if (len)
+      {
+        c->encrypt_block (reg, reg);
+        for (; pos < len; pos++)
+          {
+            unsigned char t = *in++;
+            *out++ = reg[pos] ^ t;
+            reg[pos] = t;
+          }
+      }
+  }
+
+private:
+  unsigned char reg[B];
+  size_t        pos;
+};
+
+/*
+ * Output feedback.  Each keystream block is the encryption of the last,
+ * so there is nothing to batch; encryption and decryption coincide.
+ */
+template <class Cipher>
+class ofb_mode : public mode_base<Cipher>
+{
+  typedef mode_base<Cipher> base;
+  using base::c;
+  static constexpr size_t B = base::BLOCKSIZE;
+
+public:
+  ofb_mode (const Cipher &cipher, const unsigned char *iv)
+    : base (cipher) { set_iv (iv); }
+  ~ofb_mode () { block_cipher_wipe (reg, sizeof (reg)); }
+
+  void set_iv (const unsigned char *iv) { memcpy (reg, iv, B); pos = 0; }
+
+  void process (const unsigned char *in, unsigned char *out, size_t len)
+  {
+    for (; pos && len; len--)
+      {
+        *out++ = *in++ ^ reg[pos];
+        pos = (pos + 1) % B;
+      }
+    for (; len >= B; len -= B, in += B, out += B)
+      {
+        c->encrypt_block (reg, reg);
+        mode_xor (out, in, reg, B);
+      }
+    if (len)
+      {
+        c->encrypt_block (reg, reg);
+        mode_xor (out, in, reg, len);
+        pos = len;
+      }
+  }
+
+  void encrypt (const unsigned char *in, unsigned char *out, size_t len)
+  {
+    process (in, out, len);
+  }
+
+  void decrypt (const unsigned char *in, unsigned char *out, size_t len)
+  {
+    process (in, out, len);
+  }
+
+private:
+  unsigned char reg[B];
+  size_t        pos;
+};
+
+/*
+ * Counter mode.  The counter is the whole block, read as a big-endian
+ * integer and incremented modulo 2^(8*BLOCKSIZE) per block; it is kept
+ * as native 64-bit words and only written out as counter blocks, a
+ * stride at a time, for the cipher to encrypt.  seek() moves to any
+ * block of the keystream, which is what lets independent workers split
+ * one message.
+ */
+template <class Cipher>
+class ctr_mode : public mode_base<Cipher>
+{
+  typedef mode_base<Cipher> base;
+  using base::c;
+  static constexpr size_t B = base::BLOCKSIZE;
+  static constexpr size_t W = B / 8;
+
+public:
+  ctr_mode (const Cipher &cipher, const unsigned char *iv)
+    : base (cipher) { set_iv (iv); }
+  ~ctr_mode ()
+  {
+    block_cipher_wipe (ks, sizeof (ks));
+    block_cipher_wipe (ctr, sizeof (ctr));
+  }
+
+  void set_iv (const unsigned char *iv)
+  {
+    for (size_t i = 0; i < W; i++)
+      ctr[i] = get_be64 (iv + 8 * i);
+    pos = 0;
+  }
+
+  /* the counter block for the next unused keystream block */
+  void get_iv (unsigned char *iv) const { put_counter (iv); }
+
+  /* advance the counter by nblocks, discarding any partial block */
+  void seek (uint64_t nblocks)
+  {
+    pos = 0;
+    add (nblocks);
+  }
+
+  void process (const unsigned char *in, unsigned char *out, size_t len)
+  {
+    for (; pos && len; len--)
+      {
+        *out++ = *in++ ^ ks[pos];
+        pos = (pos + 1) % B;
+      }
+    if (len >= B)
+      {
+        unsigned char buf[base::STRIDE * B];
+        for (size_t n; len >= B; len -= n * B, in += n * B, out += n * B)
+          {
+            n = len / B < base::STRIDE ? len / B : base::STRIDE;
+            for (size_t i = 0; i < n; i++)
+              {
+                put_counter (buf + i * B);
+                add (1);
+              }
+            c->encrypt_blocks (buf, buf, n);
+            mode_xor (out, in, buf, n * B);
+          }
+        block_cipher_wipe (buf, sizeof (buf));
+      }
+    if (len)
+      {
+        put_counter (ks);
+        add (1);
+        c->encrypt_block (ks, ks);
+        mode_xor (out, in, ks, len);
+        pos = len;
+      }
+  }
+
+  void encrypt (const unsigned char *in, unsigned char *out, size_t len)
+  {
+    process (in, out, len);
+  }
+
+  void decrypt (const unsigned char *in, unsigned char *out, size_t len)
+  {
+    process (in, out, len);
+  }
+
+private:
+  static uint64_t get_be64 (const unsigned char *p)
+  {
+    uint64_t x = 0;
+    for (int i = 0; i < 8; i++)
+      x = x << 8 | p[i];
+    return x;
+  }
+
+  static void put_be64 (unsigned char *p, uint64_t x)
+  {
+    for (int i = 7; i >= 0; i--, x >>= 8)
+      p[i] = (unsigned char) x;
+  }
+
+  void put_counter (unsigned char *p) const
+  {
+    for (size_t i = 0; i < W; i++)
+      put_be64 (p + 8 * i, ctr[i]);
+  }
+
+  void add (uint64_t n)
+  {
+    uint64_t lo = ctr[W - 1] + n;
+    if (W == 2 && lo < n)
+      ctr[0]++;
+    ctr[W - 1] = lo;
+  }
+
+  uint64_t      ctr[W];         /* ctr[0] is the most significant word */
+  unsigned char ks[B];          /* keystream of a partly used block */
+  size_t        pos;
+};
+
+#endif /* CIPHER_MODES_HPP */
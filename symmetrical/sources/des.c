@@ -147,29 +147,6 @@
 #define FNCCAST_CRYPT(f)   ((void(*)(void*, byte*, byte*))(f))
 
 
-/*
- * Encryption/Decryption context of DES
- */
-typedef struct _des_ctx
-  {
-    int mode;
-    u32 encrypt_subkeys[32];
-    u32 decrypt_subkeys[32];
-  }
-des_ctx[1];
-
-/*
- * Encryption/Decryption context of Triple-DES
- */
-typedef struct _tripledes_ctx
-  {
-    int mode;
-    u32 encrypt_subkeys[96];
-    u32 decrypt_subkeys[96];
-  }
-tripledes_ctx[1];
-
-
 static void des_key_schedule (const byte *, u32 *, int);
 static int des_setkey (struct _des_ctx *, const byte *);
 static int des_ecb_crypt (struct _des_ctx *, const byte *, byte *, int);
@@ -601,14 +578,15 @@ tripledes_set3keys (struct _tripledes_ctx *ctx,
   if (!ctx || !key1 || !key2 || !key3)
     return -1;
 
+  /* Decryption runs the stages in reverse: D(key3), E(key2), D(key1). */
   des_key_schedule (key1, ctx->encrypt_subkeys, 0);
-  des_key_schedule (key1, ctx->decrypt_subkeys, 1);
+  des_key_schedule (key3, ctx->decrypt_subkeys, 1);
 
   des_key_schedule (key2, &(ctx->encrypt_subkeys[32]), 1);
   des_key_schedule (key2, &(ctx->decrypt_subkeys[32]), 0);
 
   des_key_schedule (key3, &(ctx->encrypt_subkeys[64]), 0);
-  des_key_schedule (key3, &(ctx->decrypt_subkeys[64]), 1);
+  des_key_schedule (key1, &(ctx->decrypt_subkeys[64]), 1);
 
   return 0;
 }
@@ -666,6 +644,715 @@ tripledes_ecb_crypt (struct _tripledes_ctx *ctx, const byte * from, byte * to, i
 }
 
 
+
+/*
+ * Triple-DES on up to four independent blocks at once.  The 48 rounds of
+ * one block are a single chain of SP-table lookups; issuing the same
+ * round of two to four blocks back to back lets their lookups overlap.
+ * As in tripledes_ecb_crypt(), IP and FP are applied once per block and
+ * the E-D-E stages meet without them.
+ */
+
+#ifdef __GNUC__
+#define DES_INLINE static inline __attribute__ ((always_inline))
+#else
+#define DES_INLINE static inline
+#endif
+
+/* op(k) for the lanes k < n; n is a constant in every caller */
+#define DES_LANES(op)							\
+  do {									\
+    op (0);								\
+    if (n > 1) op (1);							\
+    if (n > 2) op (2);							\
+    if (n > 3) op (3);							\
+  } while (0)
+
+/* to ^= f(from), as DES_ROUND() but with the subkey pair sk[0..1] */
+#define DES_LANE_F(from, to, sk)					\
+  do {									\
+    u32 w_ = ((from << 1) | (from >> 31)) ^ (sk)[0];			\
+    to ^= sbox8[w_ & 0x3f] ^ sbox6[(w_ >> 8) & 0x3f]			\
+	^ sbox4[(w_ >> 16) & 0x3f] ^ sbox2[(w_ >> 24) & 0x3f];		\
+    w_ = ((from >> 3) | (from << 29)) ^ (sk)[1];			\
+    to ^= sbox7[w_ & 0x3f] ^ sbox5[(w_ >> 8) & 0x3f]			\
+	^ sbox3[(w_ >> 16) & 0x3f] ^ sbox1[(w_ >> 24) & 0x3f];		\
+  } while (0)
+
+#define DES_LANE_IP(k)	do { u32 t_; INITIAL_PERMUTATION (l[k], t_, r[k]) } while (0)
+#define DES_LANE_FP(k)	do { u32 t_; FINAL_PERMUTATION (r[k], t_, l[k]) } while (0)
+#define DES_LANE_L0(k)	DES_LANE_F (r[k], l[k], keys)
+#define DES_LANE_R2(k)	DES_LANE_F (l[k], r[k], keys + 2)
+#define DES_LANE_R0(k)	DES_LANE_F (l[k], r[k], keys)
+#define DES_LANE_L2(k)	DES_LANE_F (r[k], l[k], keys + 2)
+
+#define DES_LANE_GET(k) do { const byte *p_ = in + 8 * (k);		\
+			     READ_64BIT_DATA (p_, l[k], r[k]) } while (0)
+#define DES_LANE_PUT(k) do { byte *p_ = out + 8 * (k);			\
+			     WRITE_64BIT_DATA (p_, r[k], l[k]) } while (0)
+
+/*
+ * n blocks from 'in' to 'out' with the 96 subkeys 'keys'; the halves
+ * alternate exactly as in tripledes_ecb_crypt().
+ */
+DES_INLINE void
+tripledes_lanes (const u32 * keys, const int n, byte * out, const byte * in)
+{
+  u32 l[4], r[4];
+  int j;
+
+  DES_LANES (DES_LANE_GET);
+  DES_LANES (DES_LANE_IP);
+
+  for (j = 0; j < 8; j++, keys += 4)
+    {
+      DES_LANES (DES_LANE_L0);
+      DES_LANES (DES_LANE_R2);
+    }
+  for (j = 0; j < 8; j++, keys += 4)
+    {
+      DES_LANES (DES_LANE_R0);
+      DES_LANES (DES_LANE_L2);
+    }
+  for (j = 0; j < 8; j++, keys += 4)
+    {
+      DES_LANES (DES_LANE_L0);
+      DES_LANES (DES_LANE_R2);
+    }
+
+  DES_LANES (DES_LANE_FP);
+  DES_LANES (DES_LANE_PUT);
+}
+
+/*
+ * Electronic Codebook Mode Triple-DES of 'nblocks' blocks with the table
+ * code, four blocks at a time, then two, then one.
+ */
+static void
+tripledes_ecb_lanes (const u32 * keys, byte * out, const byte * in,
+		     size_t nblocks)
+{
+  for (; nblocks >= 4; nblocks -= 4, in += 32, out += 32)
+    tripledes_lanes (keys, 4, out, in);
+  if (nblocks >= 2)
+    {
+      tripledes_lanes (keys, 2, out, in);
+      nblocks -= 2;
+      in += 16;
+      out += 16;
+    }
+  if (nblocks)
+    tripledes_lanes (keys, 1, out, in);
+}
+
+
+
+/*
+ * Bitsliced Triple-DES
+ * ====================
+ *
+ * For long runs of blocks under one key tripledes_encrypt_blocks() and
+ * tripledes_decrypt_blocks() use a bitsliced engine instead of the SP
+ * tables: bit i of 64, 256 or 512 blocks is gathered into one word (a
+ * u64, or an AVX2 or AVX-512 vector of them) and each round becomes a
+ * fixed sequence of Boolean operations on such words.  IP, E, P and FP
+ * only renumber the words and cost nothing; the S-boxes are the gate
+ * circuits below, about 73 AND/OR/XOR/ANDNOT/NOT gates each on average.
+ * The round keys are read from the ordinary subkeys of the context, so
+ * the key setup is unchanged.
+ *
+ * Define DES_NO_BITSLICE to use the table code only, or DES_NO_SIMD to
+ * keep the bitsliced engine on plain 64-bit words.  The vector code uses
+ * GCC/Clang vector extensions in target("avx2") and target("avx512f")
+ * functions chosen at run time, so no special compiler flags are needed.
+ */
+
+#if defined(HAVE_U64_TYPEDEF) && !defined(DES_NO_BITSLICE)
+#define DES_BITSLICE
+#endif
+
+#if defined(DES_BITSLICE) && !defined(DES_NO_SIMD) \
+    && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define DES_BS_SIMD
+#endif
+
+#ifdef DES_BITSLICE
+
+/*
+ * FIPS 46 initial and final permutations; bit 1 is the most significant
+ * bit of the first byte.
+ */
+static const byte des_bs_ip[64] =
+{
+  58, 50, 42, 34, 26, 18, 10, 2, 60, 52, 44, 36, 28, 20, 12, 4,
+  62, 54, 46, 38, 30, 22, 14, 6, 64, 56, 48, 40, 32, 24, 16, 8,
+  57, 49, 41, 33, 25, 17,  9, 1, 59, 51, 43, 35, 27, 19, 11, 3,
+  61, 53, 45, 37, 29, 21, 13, 5, 63, 55, 47, 39, 31, 23, 15, 7
+};
+
+static const byte des_bs_fp[64] =
+{
+  40, 8, 48, 16, 56, 24, 64, 32, 39, 7, 47, 15, 55, 23, 63, 31,
+  38, 6, 46, 14, 54, 22, 62, 30, 37, 5, 45, 13, 53, 21, 61, 29,
+  36, 4, 44, 12, 52, 20, 60, 28, 35, 3, 43, 11, 51, 19, 59, 27,
+  34, 2, 42, 10, 50, 18, 58, 26, 33, 1, 41,  9, 49, 17, 57, 25
+};
+
+
+/*
+ * Gate circuits for S1..S8.  a1..a6 are the six input bits in FIPS 46
+ * order (a1 and a6 select the row); the four output bits, most
+ * significant first, are XORed into o1..o4.  They were found by Shannon
+ * and Davio decomposition over all input orders and checked against the
+ * S-box tables for all 64 inputs.  bs_word is the type of one bit slice.
+ */
+#define DES_BS_S1(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4)		\
+  do {									\
+    bs_word x1 = (a1), x2 = (a2), x3 = (a3),				\
+	    x4 = (a4), x5 = (a5), x6 = (a6);				\
+    bs_word t0 = x6 ^ x5, t1 = ~x2, t2 = t1 & ~x3, t3 = t0 ^ t2,	\
+	    t4 = x6 & x2, t5 = x5 & ~t4, t6 = ~t5, t7 = t6 ^ t1, t8 = t7 & x3, \
+	    t9 = t6 ^ t8, t10 = t9 & x1, t11 = t3 ^ t10, t12 = x6 & x5,	\
+	    t13 = t1 ^ t12, t14 = t0 & ~x3, t15 = t13 ^ t14, t16 = t1 & ~x5, \
+	    t17 = ~x6, t18 = t4 & ~x5, t19 = t17 ^ t18, t20 = t19 & ~x3, \
+	    t21 = t16 ^ t20, t22 = t21 & x1, t23 = t15 ^ t22, t24 = t11 ^ t23, \
+	    t25 = t24 & x4, t26 = t11 ^ t25, t27 = x6 ^ x2, t28 = x5 & ~t27, \
+	    t29 = ~t28, t30 = t17 | x2, t31 = t30 ^ x5, t32 = t31 & x3,	\
+	    t33 = t29 ^ t32, t34 = x6 | x2, t35 = t17 & x2, t36 = t35 & x5, \
+	    t37 = t36 & ~x3, t38 = t34 ^ t37, t39 = t38 & x1, t40 = t33 ^ t39, \
+	    t41 = t30 ^ t16, t42 = x6 & ~x5, t43 = t42 & x3, t44 = t41 ^ t43, \
+	    t45 = ~t35, t46 = t45 ^ t12, t47 = t46 & x3, t48 = t5 ^ t47, \
+	    t49 = t48 & x1, t50 = t44 ^ t49, t51 = t50 & ~x4, t52 = t40 ^ t51, \
+	    t53 = t41 & ~x3, t54 = t1 ^ t53, t55 = t35 & ~x5, t56 = t55 & ~x3, \
+	    t57 = t29 ^ t56, t58 = t57 & x1, t59 = t54 ^ t58, t60 = t29 ^ t43, \
+	    t61 = t55 ^ t47, t62 = t61 & ~x1, t63 = t60 ^ t62, t64 = t63 & x4, \
+	    t65 = t59 ^ t64, t66 = t4 | x5, t67 = t66 & x3, t68 = t13 ^ t67, \
+	    t69 = ~t30, t70 = t69 & ~x5, t71 = t70 & ~x3, t72 = t30 ^ t71, \
+	    t73 = t72 & x1, t74 = t68 ^ t73, t75 = ~t31, t76 = t75 ^ t13, \
+	    t77 = t76 & x3, t78 = t75 ^ t77, t79 = t27 ^ t16, t80 = t79 ^ t77, \
+	    t81 = t80 & ~x1, t82 = t78 ^ t81, t83 = t82 & ~x4, t84 = t74 ^ t83; \
+    (o1) ^= t26; (o2) ^= t52; (o3) ^= t65; (o4) ^= t84;			\
+  } while (0)
+
+
+#define DES_BS_S2(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4)		\
+  do {									\
+    bs_word x1 = (a1), x2 = (a2), x3 = (a3),				\
+	    x4 = (a4), x5 = (a5), x6 = (a6);				\
+    bs_word t0 = ~x3, t1 = x6 & ~t0, t2 = ~t1, t3 = t2 ^ x5,		\
+	    t4 = t3 ^ x4, t5 = t0 & ~x6, t6 = t1 & x5, t7 = t5 ^ t6,	\
+	    t8 = t7 & x1, t9 = t4 ^ t8, t10 = ~t5, t11 = ~x5, t12 = t11 & x4, \
+	    t13 = t10 ^ t12, t14 = x6 & x5, t15 = t14 | x4, t16 = t13 ^ t15, \
+	    t17 = t16 & x1, t18 = t13 ^ t17, t19 = t18 & ~x2, t20 = t9 ^ t19, \
+	    t21 = x6 & ~x3, t22 = ~t21, t23 = t22 ^ x5, t24 = t21 | x5,	\
+	    t25 = t23 ^ t24, t26 = t25 & x4, t27 = t23 ^ t26, t28 = t27 ^ x1, \
+	    t29 = ~x6, t30 = t29 & x4, t31 = t0 ^ t30, t32 = t5 & x5,	\
+	    t33 = t29 & x5, t34 = t33 & ~x4, t35 = t32 ^ t34, t36 = t35 & x1, \
+	    t37 = t31 ^ t36, t38 = t37 & x2, t39 = t28 ^ t38, t40 = x3 ^ t33, \
+	    t41 = t40 ^ t12, t42 = t2 ^ t33, t43 = t0 & ~x5, t44 = t2 ^ t43, \
+	    t45 = t44 & ~x4, t46 = t42 ^ t45, t47 = t46 & ~x1,		\
+	    t48 = t41 ^ t47, t49 = x6 & ~x5, t50 = t49 & ~x4, t51 = t22 ^ t50, \
+	    t52 = t0 ^ t49, t53 = t52 & ~x4, t54 = t32 ^ t53, t55 = t54 & x1, \
+	    t56 = t51 ^ t55, t57 = t56 & x2, t58 = t48 ^ t57, t59 = t7 ^ t12, \
+	    t60 = t29 ^ t43, t61 = t49 & x4, t62 = t60 ^ t61, t63 = t62 & x1, \
+	    t64 = t59 ^ t63, t65 = x6 ^ t32, t66 = t65 ^ t34, t67 = ~t24, \
+	    t68 = x6 & ~x4, t69 = t67 ^ t68, t70 = t69 & x1, t71 = t66 ^ t70, \
+	    t72 = t71 & ~x2, t73 = t64 ^ t72;				\
+    (o1) ^= t20; (o2) ^= t39; (o3) ^= t58; (o4) ^= t73;			\
+  } while (0)
+
+
+#define DES_BS_S3(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4)		\
+  do {									\
+    bs_word x1 = (a1), x2 = (a2), x3 = (a3),				\
+	    x4 = (a4), x5 = (a5), x6 = (a6);				\
+    bs_word t0 = ~x6, t1 = t0 ^ x5, t2 = t1 ^ x4, t3 = t0 | x4,		\
+	    t4 = t0 & x5, t5 = x4 & ~t4, t6 = ~t5, t7 = t6 & ~x2,	\
+	    t8 = t3 ^ t7, t9 = t8 & ~x1, t10 = t2 ^ t9, t11 = t4 | x2,	\
+	    t12 = x6 & x5, t13 = t12 & ~x4, t14 = ~x4, t15 = t14 & ~x2,	\
+	    t16 = t13 ^ t15, t17 = t16 & ~x1, t18 = t11 ^ t17, t19 = t18 & x3, \
+	    t20 = t10 ^ t19, t21 = x6 | x5, t22 = t21 & x4, t23 = t1 ^ t22, \
+	    t24 = x4 & ~t0, t25 = ~t24, t26 = t25 & x2, t27 = t23 ^ t26, \
+	    t28 = t27 ^ x1, t29 = ~x5, t30 = ~t21, t31 = t30 ^ x4,	\
+	    t32 = t31 & x2, t33 = t29 ^ t32, t34 = t12 & x4, t35 = t34 ^ t32, \
+	    t36 = t35 & x1, t37 = t33 ^ t36, t38 = t37 & ~x3, t39 = t28 ^ t38, \
+	    t40 = ~t2, t41 = t22 & x2, t42 = t40 ^ t41, t43 = t21 ^ t34, \
+	    t44 = t43 & ~x2, t45 = t6 ^ t44, t46 = t45 & ~x1, t47 = t42 ^ t46, \
+	    t48 = t21 | x4, t49 = t0 & ~x4, t50 = t49 & x2, t51 = t48 ^ t50, \
+	    t52 = t29 & x4, t53 = x6 ^ t52, t54 = t0 & x2, t55 = t53 ^ t54, \
+	    t56 = t51 ^ t55, t57 = t56 & x1, t58 = t51 ^ t57, t59 = t58 & ~x3, \
+	    t60 = t47 ^ t59, t61 = t53 ^ x2, t62 = t1 | x4, t63 = t30 & x2, \
+	    t64 = t62 ^ t63, t65 = t64 & x1, t66 = t61 ^ t65, t67 = t1 ^ t24, \
+	    t68 = t67 & x2, t69 = t29 ^ t68, t70 = t69 & x1, t71 = x5 ^ t70, \
+	    t72 = t71 & x3, t73 = t66 ^ t72;				\
+    (o1) ^= t20; (o2) ^= t39; (o3) ^= t60; (o4) ^= t73;			\
+  } while (0)
+
+
+#define DES_BS_S4(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4)		\
+  do {									\
+    bs_word x1 = (a1), x2 = (a2), x3 = (a3),				\
+	    x4 = (a4), x5 = (a5), x6 = (a6);				\
+    bs_word t0 = ~x5, t1 = t0 | x3, t2 = t1 & ~x1, t3 = x3 ^ t2,	\
+	    t4 = x5 & ~x4, t5 = t3 ^ t4, t6 = t0 ^ t2, t7 = x5 ^ x3,	\
+	    t8 = t7 | x1, t9 = t8 & x4, t10 = t6 ^ t9, t11 = t5 ^ t10,	\
+	    t12 = t11 & x2, t13 = t5 ^ t12, t14 = t0 & x3, t15 = ~t14,	\
+	    t16 = t15 & ~x1, t17 = x3 ^ t16, t18 = t14 ^ t17, t19 = t18 & x4, \
+	    t20 = t14 ^ t19, t21 = t1 | x1, t22 = t7 & x4, t23 = t21 ^ t22, \
+	    t24 = t23 & ~x2, t25 = t20 ^ t24, t26 = t25 & ~x6,		\
+	    t27 = t13 ^ t26, t28 = ~t25, t29 = t28 & x6, t30 = t13 ^ t29, \
+	    t31 = ~t18, t32 = t0 & x4, t33 = t31 ^ t32, t34 = t8 ^ x3,	\
+	    t35 = t34 & x4, t36 = t8 ^ t35, t37 = t36 & x2, t38 = t33 ^ t37, \
+	    t39 = t3 & ~x4, t40 = t1 ^ t39, t41 = t14 & ~x1, t42 = t1 ^ t41, \
+	    t43 = t42 ^ t22, t44 = t43 & ~x2, t45 = t40 ^ t44,		\
+	    t46 = t45 & ~x6, t47 = t38 ^ t46, t48 = ~t38, t49 = ~t45,	\
+	    t50 = t49 & x6, t51 = t48 ^ t50;				\
+    (o1) ^= t27; (o2) ^= t30; (o3) ^= t47; (o4) ^= t51;			\
+  } while (0)
+
+
+#define DES_BS_S5(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4)		\
+  do {									\
+    bs_word x1 = (a1), x2 = (a2), x3 = (a3),				\
+	    x4 = (a4), x5 = (a5), x6 = (a6);				\
+    bs_word t0 = x2 ^ x5, t1 = ~x5, t2 = t1 & x6, t3 = t0 ^ t2,		\
+	    t4 = ~x2, t5 = t4 | x5, t6 = t5 & x6, t7 = t6 & x3, t8 = t3 ^ t7, \
+	    t9 = t1 ^ t6, t10 = x6 & ~t0, t11 = ~t10, t12 = t11 & ~x3,	\
+	    t13 = t9 ^ t12, t14 = t13 & x1, t15 = t8 ^ t14, t16 = t0 & x6, \
+	    t17 = t5 ^ t16, t18 = t1 & ~x6, t19 = t18 & ~x3, t20 = t17 ^ t19, \
+	    t21 = ~t5, t22 = t21 | x6, t23 = t0 & x3, t24 = t22 ^ t23,	\
+	    t25 = t24 & x1, t26 = t20 ^ t25, t27 = t26 & x4, t28 = t15 ^ t27, \
+	    t29 = ~t0, t30 = t29 ^ x6, t31 = t30 ^ x3, t32 = t1 | x3,	\
+	    t33 = t32 & x1, t34 = t31 ^ t33, t35 = t10 & x3, t36 = t4 ^ t35, \
+	    t37 = t29 | x6, t38 = t3 & x3, t39 = t37 ^ t38, t40 = t36 ^ t39, \
+	    t41 = t40 & x1, t42 = t36 ^ t41, t43 = t42 & ~x4, t44 = t34 ^ t43, \
+	    t45 = t5 & ~x3, t46 = t29 ^ t45, t47 = x2 | x5, t48 = t47 | x6, \
+	    t49 = t47 & x6, t50 = t49 & x3, t51 = t48 ^ t50, t52 = t51 & ~x1, \
+	    t53 = t46 ^ t52, t54 = ~t47, t55 = t54 & x6, t56 = t29 & ~x6, \
+	    t57 = t56 & ~x3, t58 = t55 ^ t57, t59 = t58 & ~x1,		\
+	    t60 = t22 ^ t59, t61 = t60 & ~x4, t62 = t53 ^ t61, t63 = x2 & x5, \
+	    t64 = t63 ^ t18, t65 = t64 & ~x3, t66 = t9 ^ t65, t67 = t22 | x3, \
+	    t68 = t67 & x1, t69 = t66 ^ t68, t70 = t5 | x6, t71 = x2 & ~x3, \
+	    t72 = t70 ^ t71, t73 = t54 ^ t38, t74 = t73 & ~x1,		\
+	    t75 = t72 ^ t74, t76 = t75 & x4, t77 = t69 ^ t76;		\
+    (o1) ^= t28; (o2) ^= t44; (o3) ^= t62; (o4) ^= t77;			\
+  } while (0)
+
+
+#define DES_BS_S6(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4)		\
+  do {									\
+    bs_word x1 = (a1), x2 = (a2), x3 = (a3),				\
+	    x4 = (a4), x5 = (a5), x6 = (a6);				\
+    bs_word t0 = x4 ^ x1, t1 = t0 ^ x6, t2 = x4 & ~x1, t3 = t2 & x6,	\
+	    t4 = x3 & ~t3, t5 = ~t4, t6 = t5 & x2, t7 = t1 ^ t6, t8 = ~t0, \
+	    t9 = x4 & x1, t10 = t8 ^ t9, t11 = t10 & x6, t12 = t8 ^ t11, \
+	    t13 = t0 | x6, t14 = t13 & x3, t15 = t12 ^ t14, t16 = t9 & x6, \
+	    t17 = x1 & x6, t18 = t17 & x3, t19 = t16 ^ t18, t20 = t19 & x2, \
+	    t21 = t15 ^ t20, t22 = t21 & ~x5, t23 = t7 ^ t22, t24 = ~t9, \
+	    t25 = t24 & x6, t26 = ~t10, t27 = t26 & ~x3, t28 = t25 ^ t27, \
+	    t29 = x4 & ~x6, t30 = t24 ^ t29, t31 = t16 & x3, t32 = t30 ^ t31, \
+	    t33 = t32 & x2, t34 = t28 ^ t33, t35 = ~t3, t36 = t10 & x3,	\
+	    t37 = t35 ^ t36, t38 = t2 ^ t29, t39 = x1 & ~x6, t40 = t39 & x3, \
+	    t41 = t38 ^ t40, t42 = t41 & ~x2, t43 = t37 ^ t42,		\
+	    t44 = t43 & ~x5, t45 = t34 ^ t44, t46 = t39 & ~x3, t47 = t1 ^ t46, \
+	    t48 = x1 | x3, t49 = t48 & x2, t50 = t47 ^ t49, t51 = ~t12,	\
+	    t52 = t51 ^ x3, t53 = t26 ^ t25, t54 = t53 ^ t40, t55 = t54 & x2, \
+	    t56 = t52 ^ t55, t57 = t50 ^ t56, t58 = t57 & x5, t59 = t50 ^ t58, \
+	    t60 = t10 ^ t16, t61 = t0 & ~x6, t62 = t61 & x3, t63 = t60 ^ t62, \
+	    t64 = x1 ^ t61, t65 = t64 | x3, t66 = t65 & ~x2, t67 = t63 ^ t66, \
+	    t68 = t26 ^ t3, t69 = t68 & ~x3, t70 = t8 ^ t69, t71 = t3 & x2, \
+	    t72 = t70 ^ t71, t73 = t72 & ~x5, t74 = t67 ^ t73;		\
+    (o1) ^= t23; (o2) ^= t45; (o3) ^= t59; (o4) ^= t74;			\
+  } while (0)
+
+
+#define DES_BS_S7(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4)		\
+  do {									\
+    bs_word x1 = (a1), x2 = (a2), x3 = (a3),				\
+	    x4 = (a4), x5 = (a5), x6 = (a6);				\
+    bs_word t0 = ~x1, t1 = t0 & x3, t2 = t1 ^ x5, t3 = t0 | x3,		\
+	    t4 = x5 & ~t3, t5 = ~t4, t6 = t5 & ~x2, t7 = t2 ^ t6,	\
+	    t8 = t1 & x5, t9 = t3 ^ t8, t10 = t9 & ~x6, t11 = t7 ^ t10,	\
+	    t12 = x1 & ~x5, t13 = t12 | x2, t14 = x1 | x3, t15 = t14 & x5, \
+	    t16 = t1 & x2, t17 = t15 ^ t16, t18 = t17 & ~x6, t19 = t13 ^ t18, \
+	    t20 = t19 & ~x4, t21 = t11 ^ t20, t22 = t0 ^ x3, t23 = t22 & ~x2, \
+	    t24 = t2 ^ t23, t25 = x1 ^ t3, t26 = t25 & x2, t27 = x1 ^ t26, \
+	    t28 = t27 & x6, t29 = t24 ^ t28, t30 = t0 ^ t3, t31 = t30 & x5, \
+	    t32 = t0 ^ t31, t33 = t32 ^ t26, t34 = x3 & x5, t35 = x1 | x5, \
+	    t36 = t35 & x2, t37 = t34 ^ t36, t38 = t37 & x6, t39 = t33 ^ t38, \
+	    t40 = t39 & x4, t41 = t29 ^ t40, t42 = ~t3, t43 = t42 ^ x2,	\
+	    t44 = t0 & x5, t45 = t14 ^ t44, t46 = t30 & ~x5, t47 = t46 & ~x2, \
+	    t48 = t45 ^ t47, t49 = t48 & ~x6, t50 = t43 ^ t49, t51 = ~x5, \
+	    t52 = t51 ^ t36, t53 = t2 & ~x2, t54 = t8 ^ t53, t55 = t54 & x6, \
+	    t56 = t52 ^ t55, t57 = t56 & x4, t58 = t50 ^ t57, t59 = t0 ^ x5, \
+	    t60 = ~x3, t61 = t60 & ~x2, t62 = t59 ^ t61, t63 = t3 ^ t12, \
+	    t64 = x2 & ~t63, t65 = ~t64, t66 = t65 & x6, t67 = t62 ^ t66, \
+	    t68 = x3 | x5, t69 = t42 & ~x5, t70 = t59 & x2, t71 = t69 ^ t70, \
+	    t72 = t71 & x6, t73 = t68 ^ t72, t74 = t73 & x4, t75 = t67 ^ t74; \
+    (o1) ^= t21; (o2) ^= t41; (o3) ^= t58; (o4) ^= t75;			\
+  } while (0)
+
+
+#define DES_BS_S8(a1, a2, a3, a4, a5, a6, o1, o2, o3, o4)		\
+  do {									\
+    bs_word x1 = (a1), x2 = (a2), x3 = (a3),				\
+	    x4 = (a4), x5 = (a5), x6 = (a6);				\
+    bs_word t0 = x1 ^ x5, t1 = t0 ^ x3, t2 = ~x1, t3 = t2 | x5,		\
+	    t4 = t3 & ~x4, t5 = t1 ^ t4, t6 = x3 & ~t3, t7 = ~t6,	\
+	    t8 = x1 | x5, t9 = t8 & x4, t10 = t7 ^ t9, t11 = t10 & ~x2,	\
+	    t12 = t5 ^ t11, t13 = t2 & ~x3, t14 = t8 ^ t13, t15 = t14 & ~x4, \
+	    t16 = t1 ^ t15, t17 = x1 & x5, t18 = t17 & ~x3, t19 = t0 & ~x4, \
+	    t20 = t18 ^ t19, t21 = t16 ^ t20, t22 = t21 & x2, t23 = t16 ^ t22, \
+	    t24 = t23 & ~x6, t25 = t12 ^ t24, t26 = x3 & ~x5, t27 = ~t26, \
+	    t28 = t27 ^ t9, t29 = ~t8, t30 = t29 & x4, t31 = t14 ^ t30,	\
+	    t32 = t31 & ~x2, t33 = t28 ^ t32, t34 = ~t18, t35 = x1 & x4, \
+	    t36 = t34 ^ t35, t37 = x1 & x3, t38 = t37 & x4, t39 = t38 & ~x2, \
+	    t40 = t36 ^ t39, t41 = t40 & ~x6, t42 = t33 ^ t41, t43 = t8 ^ t2, \
+	    t44 = t43 & x3, t45 = t8 ^ t44, t46 = t45 ^ t9, t47 = t34 & x2, \
+	    t48 = t46 ^ t47, t49 = t17 ^ x1, t50 = t49 & x4, t51 = t17 ^ t50, \
+	    t52 = t43 ^ x3, t53 = t52 & ~x4, t54 = t18 ^ t53, t55 = t54 & x2, \
+	    t56 = t51 ^ t55, t57 = t56 & x6, t58 = t48 ^ t57, t59 = ~t12, \
+	    t60 = t26 & ~x4, t61 = t1 ^ t60, t62 = ~x3, t63 = t14 ^ t62, \
+	    t64 = t63 & x4, t65 = t14 ^ t64, t66 = t65 & ~x2, t67 = t61 ^ t66, \
+	    t68 = t59 ^ t67, t69 = t68 & x6, t70 = t59 ^ t69;		\
+    (o1) ^= t25; (o2) ^= t42; (o3) ^= t58; (o4) ^= t70;			\
+  } while (0)
+
+/*
+ * One DES round, t ^= f(f, k): f and t are the 32 slices of the two
+ * halves, bit 1 first, and k the 48 key masks of the round.  E selects
+ * the S-box inputs and P the slices their outputs go to.
+ */
+#define DES_BS_ROUND(f, t, k)						\
+  DES_BS_S1 ((f)[31] ^ (k)[0], (f)[0] ^ (k)[1], (f)[1] ^ (k)[2],	\
+	     (f)[2] ^ (k)[3], (f)[3] ^ (k)[4], (f)[4] ^ (k)[5],		\
+	     (t)[8], (t)[16], (t)[22], (t)[30]);			\
+  DES_BS_S2 ((f)[3] ^ (k)[6], (f)[4] ^ (k)[7], (f)[5] ^ (k)[8],		\
+	     (f)[6] ^ (k)[9], (f)[7] ^ (k)[10], (f)[8] ^ (k)[11],	\
+	     (t)[12], (t)[27], (t)[1], (t)[17]);			\
+  DES_BS_S3 ((f)[7] ^ (k)[12], (f)[8] ^ (k)[13], (f)[9] ^ (k)[14],	\
+	     (f)[10] ^ (k)[15], (f)[11] ^ (k)[16], (f)[12] ^ (k)[17],	\
+	     (t)[23], (t)[15], (t)[29], (t)[5]);			\
+  DES_BS_S4 ((f)[11] ^ (k)[18], (f)[12] ^ (k)[19], (f)[13] ^ (k)[20],	\
+	     (f)[14] ^ (k)[21], (f)[15] ^ (k)[22], (f)[16] ^ (k)[23],	\
+	     (t)[25], (t)[19], (t)[9], (t)[0]);				\
+  DES_BS_S5 ((f)[15] ^ (k)[24], (f)[16] ^ (k)[25], (f)[17] ^ (k)[26],	\
+	     (f)[18] ^ (k)[27], (f)[19] ^ (k)[28], (f)[20] ^ (k)[29],	\
+	     (t)[7], (t)[13], (t)[24], (t)[2]);				\
+  DES_BS_S6 ((f)[19] ^ (k)[30], (f)[20] ^ (k)[31], (f)[21] ^ (k)[32],	\
+	     (f)[22] ^ (k)[33], (f)[23] ^ (k)[34], (f)[24] ^ (k)[35],	\
+	     (t)[3], (t)[28], (t)[10], (t)[18]);			\
+  DES_BS_S7 ((f)[23] ^ (k)[36], (f)[24] ^ (k)[37], (f)[25] ^ (k)[38],	\
+	     (f)[26] ^ (k)[39], (f)[27] ^ (k)[40], (f)[28] ^ (k)[41],	\
+	     (t)[31], (t)[11], (t)[21], (t)[6]);			\
+  DES_BS_S8 ((f)[27] ^ (k)[42], (f)[28] ^ (k)[43], (f)[29] ^ (k)[44],	\
+	     (f)[30] ^ (k)[45], (f)[31] ^ (k)[46], (f)[0] ^ (k)[47],	\
+	     (t)[4], (t)[26], (t)[14], (t)[20])
+
+
+/*
+ * Sixteen rounds on the halves a and b, the first one changing a, in the
+ * alternation des_ecb_crypt() uses.
+ */
+#define DES_BS_16(a, b, k)						\
+  for (j = 0; j < 16; j += 2)						\
+    {									\
+      DES_BS_ROUND (b, a, (k) + 48 * j);				\
+      DES_BS_ROUND (a, b, (k) + 48 * (j + 1));				\
+    }
+
+
+/*
+ * Transpose a 64x64 bit matrix held in x[0..63]: bit i of x[p] trades
+ * places with bit p of x[i], in each 64-bit lane on its own.  It is its
+ * own inverse.
+ */
+#define DES_BS_TRANSPOSE(x)						\
+  for (j = 32, m = 0xffffffff; j; j >>= 1, m ^= m << j)			\
+    for (k = 0; k < 64; k = ((k | j) + 1) & ~j)				\
+      {									\
+	tt = ((x[k] >> j) ^ x[k | j]) & m;				\
+	x[k] ^= tt << j;						\
+	x[k | j] ^= tt;							\
+      }
+
+
+/*
+ * Triple-DES on the words w[], 64 blocks per 64-bit lane as des_bs_get()
+ * lays them out, with the 48 x 48 key masks km.  After the transpose
+ * x[64 - b] is the slice of data bit b.  The three stages continue on
+ * the same halves without a swap between them, as in tripledes_ecb_crypt(),
+ * so each starts on the half the previous one finished on.
+ */
+#define DES_BS_CRYPT(w, km)						\
+  do {									\
+    bs_word x[64], l[32], r[32], *a = l, *b = r, *tp, tt;		\
+    u64 m;								\
+    int i, j, k, s;							\
+									\
+    memcpy (x, w, sizeof x);						\
+    DES_BS_TRANSPOSE (x);						\
+    for (i = 0; i < 32; i++)						\
+      {									\
+	l[i] = x[64 - des_bs_ip[i]];					\
+	r[i] = x[64 - des_bs_ip[32 + i]];				\
+      }									\
+									\
+    for (s = 0; s < 3; s++, tp = a, a = b, b = tp)			\
+      DES_BS_16 (a, b, (km) + 16 * 48 * s);				\
+									\
+    for (i = 0; i < 64; i++)						\
+      x[63 - i] = des_bs_fp[i] <= 32 ? r[des_bs_fp[i] - 1]		\
+				    : l[des_bs_fp[i] - 33];		\
+    DES_BS_TRANSPOSE (x);						\
+    memcpy (w, x, sizeof x);						\
+  } while (0)
+
+
+/*
+ * The key bits of 'rounds' rounds as masks of all zeros or all ones,
+ * 48 per round in the order of E.  The subkey pairs hold the six bits
+ * of each S-box where DES_ROUND() extracts its table index.
+ */
+static void
+des_bs_keys (const u32 * subkey, int rounds, u64 * km)
+{
+  static const byte shift[8] = { 24, 24, 16, 16, 8, 8, 0, 0 };
+  int r, s, j;
+
+  for (r = 0; r < rounds; r++, subkey += 2)
+    for (s = 0; s < 8; s++)
+      for (j = 0; j < 6; j++)
+	*km++ = -(u64) ((subkey[~s & 1] >> (shift[s] + 5 - j)) & 1);
+}
+
+
+/*
+ * Gather 64 * lanes blocks into w[]: w[i * lanes + q] is block
+ * q * 64 + i as a big-endian word, so that w can be copied straight
+ * into a vector of 'lanes' u64s per slice.  des_bs_put() undoes it.
+ */
+static void
+des_bs_get (const byte * in, u64 * w, int lanes)
+{
+  int i, q;
+
+  for (q = 0; q < lanes; q++)
+    for (i = 0; i < 64; i++, in += 8)
+      w[i * lanes + q] = (u64) in[0] << 56 | (u64) in[1] << 48
+	| (u64) in[2] << 40 | (u64) in[3] << 32 | (u64) in[4] << 24
+	| (u64) in[5] << 16 | (u64) in[6] << 8 | in[7];
+}
+
+static void
+des_bs_put (byte * out, const u64 * w, int lanes)
+{
+  int i, q, b;
+
+  for (q = 0; q < lanes; q++)
+    for (i = 0; i < 64; i++, out += 8)
+      for (b = 0; b < 8; b++)
+	out[b] = w[i * lanes + q] >> (56 - 8 * b);
+}
+
+
+#define bs_word u64
+
+static void
+des_bs_crypt64 (u64 * w, const u64 * km)
+{
+  DES_BS_CRYPT (w, km);
+}
+
+#undef bs_word
+
+#ifdef DES_BS_SIMD
+
+typedef u64 des_bs_v4 __attribute__ ((vector_size (32)));
+typedef u64 des_bs_v8 __attribute__ ((vector_size (64)));
+
+#define bs_word des_bs_v4
+
+__attribute__ ((target ("avx2")))
+static void
+des_bs_crypt256 (u64 * w, const u64 * km)
+{
+  DES_BS_CRYPT (w, km);
+}
+
+#undef bs_word
+#define bs_word des_bs_v8
+
+__attribute__ ((target ("avx512f")))
+static void
+des_bs_crypt512 (u64 * w, const u64 * km)
+{
+  DES_BS_CRYPT (w, km);
+}
+
+#undef bs_word
+
+#endif /*DES_BS_SIMD*/
+
+
+/*
+ * Triple-DES on as many leading blocks as fill whole slices, 512 at a
+ * time with AVX-512, 256 with AVX2, otherwise 64; 'subkeys' are the 96
+ * encryption or decryption subkeys of a context.  Returns the number of
+ * blocks done, a multiple of 64; the rest is left to the table code.
+ */
+static size_t
+tripledes_bs_crypt (const u32 * subkeys, byte * outbuf,
+		    const byte * inbuf, size_t nblocks)
+{
+  u64 km[48 * 48];
+  u64 w[64 * 8];
+  size_t done = 0;
+
+  if (nblocks < 64)
+    return 0;
+
+  des_bs_keys (subkeys, 48, km);
+
+#ifdef DES_BS_SIMD
+  if (nblocks >= 512 && __builtin_cpu_supports ("avx512f"))
+    for (; nblocks - done >= 512; done += 512)
+      {
+	des_bs_get (inbuf + 8 * done, w, 8);
+	des_bs_crypt512 (w, km);
+	des_bs_put (outbuf + 8 * done, w, 8);
+      }
+
+  if (nblocks - done >= 256 && __builtin_cpu_supports ("avx2"))
+    for (; nblocks - done >= 256; done += 256)
+      {
+	des_bs_get (inbuf + 8 * done, w, 4);
+	des_bs_crypt256 (w, km);
+	des_bs_put (outbuf + 8 * done, w, 4);
+      }
+#endif
+
+  for (; nblocks - done >= 64; done += 64)
+    {
+      des_bs_get (inbuf + 8 * done, w, 1);
+      des_bs_crypt64 (w, km);
+      des_bs_put (outbuf + 8 * done, w, 1);
+    }
+
+  wipememory (km, sizeof km);
+  wipememory (w, sizeof w);
+  return done;
+}
+
+#endif /*DES_BITSLICE*/
+
+
+
+/*
+ * Electronic Codebook Mode Triple-DES encryption/decryption of 'nblocks'
+ * consecutive 64bit blocks with a single call.  'outbuf' may be the same
+ * as 'inbuf'.
+ */
+void
+tripledes_encrypt_blocks (struct _tripledes_ctx *ctx, byte * outbuf,
+			  const byte * inbuf, size_t nblocks)
+{
+#ifdef DES_BITSLICE
+  size_t done = tripledes_bs_crypt (ctx->encrypt_subkeys, outbuf, inbuf,
+				    nblocks);
+
+  nblocks -= done;
+  inbuf += 8 * done;
+  outbuf += 8 * done;
+#endif
+  tripledes_ecb_lanes (ctx->encrypt_subkeys, outbuf, inbuf, nblocks);
+}
+
+void
+tripledes_decrypt_blocks (struct _tripledes_ctx *ctx, byte * outbuf,
+			  const byte * inbuf, size_t nblocks)
+{
+#ifdef DES_BITSLICE
+  size_t done = tripledes_bs_crypt (ctx->decrypt_subkeys, outbuf, inbuf,
+				    nblocks);
+
+  nblocks -= done;
+  inbuf += 8 * done;
+  outbuf += 8 * done;
+#endif
+  tripledes_ecb_lanes (ctx->decrypt_subkeys, outbuf, inbuf, nblocks);
+}
+
+
+/*
+ * Blocks handed to tripledes_encrypt_blocks()/tripledes_decrypt_blocks()
+ * per call by the CBC and CTR code below; one slice of the widest
+ * bitsliced path.
+ */
+#define DES_CHUNK 512
+
+/*
+ * Cipher Block Chaining Mode Triple-DES decryption of 'nblocks' blocks.
+ * Unlike encryption, all blocks can be deciphered independently, so
+ * whole chunks go through the batched ECB code before the chaining is
+ * undone.  'iv' is updated to the last ciphertext block, ready for the
+ * next call.  'outbuf' may be the same as 'inbuf'.
+ */
+void
+tripledes_cbc_decrypt (struct _tripledes_ctx *ctx, byte * iv, byte * outbuf,
+		       const byte * inbuf, size_t nblocks)
+{
+  byte buf[8 * DES_CHUNK], next[8];
+  size_t n, i;
+  int j;
+
+  for (; nblocks; nblocks -= n)
+    {
+      n = nblocks < DES_CHUNK ? nblocks : DES_CHUNK;
+      tripledes_decrypt_blocks (ctx, buf, inbuf, n);
+      for (i = 0; i < n; i++, inbuf += 8, outbuf += 8)
+	{
+	  memcpy (next, inbuf, 8);
+	  for (j = 0; j < 8; j++)
+	    outbuf[j] = buf[8 * i + j] ^ iv[j];
+	  memcpy (iv, next, 8);
+	}
+    }
+  wipememory (buf, sizeof buf);
+}
+
+/*
+ * Counter Mode Triple-DES of 'nblocks' blocks: the key stream is the
+ * encryption of the 64bit big-endian counter block 'ctr', incremented
+ * once per block and left at the next unused value.  Encryption and
+ * decryption are the same.  'outbuf' may be the same as 'inbuf'.
+ */
+void
+tripledes_ctr_crypt (struct _tripledes_ctx *ctx, byte * ctr, byte * outbuf,
+		     const byte * inbuf, size_t nblocks)
+{
+  byte buf[8 * DES_CHUNK];
+  size_t n, i;
+  int j;
+
+  for (; nblocks; nblocks -= n)
+    {
+      n = nblocks < DES_CHUNK ? nblocks : DES_CHUNK;
+      for (i = 0; i < n; i++)
+	{
+	  memcpy (buf + 8 * i, ctr, 8);
+	  for (j = 7; j >= 0 && !++ctr[j]; j--)
+	    ;
+	}
+      tripledes_encrypt_blocks (ctx, buf, buf, n);
+      for (i = 0; i < 8 * n; i++)
+	*outbuf++ = *inbuf++ ^ buf[i];
+    }
+  wipememory (buf, sizeof buf);
+}
+
+
 /*
  * Check whether the 8 byte key is weak.
  */
@@ -780,6 +1467,12 @@ do_tripledes_decrypt( struct _tripledes_ctx *ctx, byte *outbuf, byte *inbuf )
     tripledes_ecb_decrypt ( ctx, inbuf, outbuf );
 }
 
+int
+tripledes_setkey ( struct _tripledes_ctx *ctx, const byte *key, unsigned keylen )
+{
+    return do_tripledes_setkey ( ctx, (byte*)key, keylen );
+}
+
 
 /****************
  * Return some information about the algorithm.  We need algo here to
@@ -0,0 +1,79 @@
+/* des.h
+ *	Copyright (C) 1998 Free Software Foundation, Inc.
+ *
+ * This file is part of GNUPG.
+ *
+ * GNUPG is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * GNUPG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA
+ */
+#ifndef G10_DES_H
+#define G10_DES_H
+
+#include <stddef.h>
+#include "types.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Encryption/Decryption context of DES
+ */
+typedef struct _des_ctx
+  {
+    int mode;
+    u32 encrypt_subkeys[32];
+    u32 decrypt_subkeys[32];
+  }
+des_ctx[1];
+
+/*
+ * Encryption/Decryption context of Triple-DES
+ */
+typedef struct _tripledes_ctx
+  {
+    int mode;
+    u32 encrypt_subkeys[96];
+    u32 decrypt_subkeys[96];
+  }
+tripledes_ctx[1];
+
+const char *
+des_get_info( int algo, size_t *keylen,
+		   size_t *blocksize, size_t *contextsize,
+		   int	(**setkeyf)( void *c, byte *key, unsigned keylen ),
+		   void (**encryptf)( void *c, byte *outbuf, byte *inbuf ),
+		   void (**decryptf)( void *c, byte *outbuf, byte *inbuf )
+		 );
+
+/*
+ * Direct Triple-DES entry points for callers linking this module
+ * without the get_info indirection; see des.c.
+ */
+int tripledes_setkey (struct _tripledes_ctx *ctx, const byte * key,
+		      unsigned keylen);
+void tripledes_encrypt_blocks (struct _tripledes_ctx *ctx, byte * outbuf,
+			       const byte * inbuf, size_t nblocks);
+void tripledes_decrypt_blocks (struct _tripledes_ctx *ctx, byte * outbuf,
+			       const byte * inbuf, size_t nblocks);
+void tripledes_cbc_decrypt (struct _tripledes_ctx *ctx, byte * iv,
+			    byte * outbuf, const byte * inbuf, size_t nblocks);
+void tripledes_ctr_crypt (struct _tripledes_ctx *ctx, byte * ctr,
+			  byte * outbuf, const byte * inbuf, size_t nblocks);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /*G10_DES_H*/
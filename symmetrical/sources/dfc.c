@@ -99,11 +99,12 @@ Mean:         1749 cycles =    14.6 mbits/sec
 
 #define BYTE_SWAP
 
-#include "../std_defs.h"
+#include <string.h>
+#include "dfc.h"
 
 static char *alg_name[] = { "dfc", "dfc2.c" };
 
-char **cipher_name()
+char **dfc_cipher_name(void)
 {
     return alg_name;
 };
@@ -112,7 +113,7 @@ char **cipher_name()
 /* format with 32 bit words at lower array positions    */
 /* being more significant in multi-word values          */
 
-u4byte rt64[64] = 
+static u4byte rt64[64] = 
 {
     0xb7e15162, 0x8aed2a6a, 0xbf715880, 0x9cf4f3c7, 
     0x62e7160f, 0x38b4da56, 0xa784d904, 0x5190cfef, 
@@ -135,38 +136,36 @@ u4byte rt64[64] =
     0x78d56ced, 0x94640d6e, 0xf0d3d37b, 0xe67008e1, 
 };
 
-u4byte  kc = 0xeb64749a;
+static u4byte  kc = 0xeb64749a;
 
-u4byte  kd2[2] = 
+static u4byte  kd2[2] = 
 {
     0x86d1bf27, 0x5b9b241d  
 };
 
-u4byte  ka2[6] = 
+static u4byte  ka2[6] = 
 {
     0xb7e15162, 0x8aed2a6a, 
     0xbf715880, 0x9cf4f3c7, 
     0x62e7160f, 0x38b4da56, 
 };
 
-u4byte  kb2[6] =
+static u4byte  kb2[6] =
 {
     0xa784d904, 0x5190cfef, 
     0x324e7738, 0x926cfbe5, 
     0xf4bf8d8d, 0x8c31d763,
 };
 
-u4byte  ks8[8] = 
+static u4byte  ks8[8] = 
 {   0xda06c80a, 0xbb1185eb, 0x4f7c7b57, 0x57f59584, 
     0x90cfd47d, 0x7c19bb42, 0x158d9554, 0xf7b46bce,
 };
 
-u4byte l_key[32];
-
 #define lo(x)   ((x) & 0x0000ffff)
 #define hi(x)   ((x) >> 16)
 
-void mult_64(u4byte r[4], const u4byte x[2], const u4byte y[2])
+static void mult_64(u4byte r[4], const u4byte x[2], const u4byte y[2])
 {   u4byte  x0, x1, x2, x3, y0, y1, y2, y3, t0, t1, t2, t3, c;
 
     x0 = lo(x[1]); x1 = hi(x[1]); x2 = lo(x[0]); x3 = hi(x[0]);
@@ -195,7 +194,7 @@ void mult_64(u4byte r[4], const u4byte x[2], const u4byte y[2])
     r[3] = c + x3 * y3;
 };
 
-void add_64(u4byte r[4], const u4byte hi, const u4byte lo)
+static void add_64(u4byte r[4], const u4byte hi, const u4byte lo)
 {
     if((r[0] += lo) < lo)
         if(!++r[1])
@@ -207,7 +206,7 @@ void add_64(u4byte r[4], const u4byte hi, const u4byte lo)
             ++r[3];
 };
 
-void mult_13(u4byte r[3])
+static void mult_13(u4byte r[3])
 {   u4byte  c, d;
 
     c = 13 * lo(r[0]);
@@ -233,7 +232,7 @@ void mult_13(u4byte r[3])
 /* have to invert the order of the 32 bit words in the 64 bit   */
 /* blocks being processed.                                      */ 
 
-void r_fun(u4byte outp[2], const u4byte inp[2], const u4byte key[4])
+static void r_fun(u4byte outp[2], const u4byte inp[2], const u4byte key[4])
 {   u4byte acc[5], b, t;
 
     mult_64(acc, inp, key);  add_64(acc, key[2], key[3]);
@@ -278,8 +277,9 @@ void r_fun(u4byte outp[2], const u4byte inp[2], const u4byte key[4])
     outp[0] ^= b; outp[1] ^= t; 
 };
 
-u4byte *set_key(const u4byte in_key[], const u4byte key_len)
-{   u4byte  i, lk[32], rk[4];
+u4byte *dfc_set_key(dfc_ctx *ctx, const u4byte in_key[], const u4byte key_len)
+{   u4byte *l_key = ctx->l_key;
+    u4byte  i, lk[32], rk[4];
 
     for(i = 0; i < key_len / 32; ++i)
 
@@ -347,8 +347,9 @@ u4byte *set_key(const u4byte in_key[], const u4byte key_len)
     return l_key;
 };
 
-void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{   u4byte  blk[4];
+void dfc_encrypt(const dfc_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{   const u4byte *l_key = ctx->l_key;
+    u4byte  blk[4];
 
     /* the input/output format is big endian -  */
     /* any reversals needed are performed when  */
@@ -372,8 +373,9 @@ void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
     out_blk[2] = io_swap(blk[0]); out_blk[3] = io_swap(blk[1]);
 };
 
-void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{   u4byte  blk[4];
+void dfc_decrypt(const dfc_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{   const u4byte *l_key = ctx->l_key;
+    u4byte  blk[4];
 
     /* the input/output format is big endian -  */
     /* any reversals needed are performed when  */
@@ -396,3 +398,28 @@ void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
     out_blk[0] = io_swap(blk[2]); out_blk[1] = io_swap(blk[3]);
     out_blk[2] = io_swap(blk[0]); out_blk[3] = io_swap(blk[1]);   
 };
+
+/* encrypt n_blk consecutive blocks of text held in byte buffers that */
+/* need not be word aligned; in_blk may be the same as out_blk        */
+
+void dfc_encrypt_blocks(const dfc_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{   u4byte  b_in[4], b_out[4];
+
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+    {
+        memcpy(b_in, in_blk, 16); dfc_encrypt(ctx, b_in, b_out);
+        memcpy(out_blk, b_out, 16);
+    }
+};
+
+/* decrypt n_blk consecutive blocks of text                          */
+
+void dfc_decrypt_blocks(const dfc_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{   u4byte  b_in[4], b_out[4];
+
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+    {
+        memcpy(b_in, in_blk, 16); dfc_decrypt(ctx, b_in, b_out);
+        memcpy(out_blk, b_out, 16);
+    }
+};
@@ -0,0 +1,32 @@
+
+/* DFC with the key schedule held in a caller supplied              */
+/* context (see dfc.c). A context may be shared by any number       */
+/* of threads once its key has been set.                            */
+
+#ifndef _DFC_H
+#define _DFC_H
+
+#include "../std_defs.h"
+#include <stddef.h>
+#include "cache_align.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{   CACHE_ALIGN u4byte  l_key[32];  /* storage for the key schedule */
+} dfc_ctx;
+
+char    **dfc_cipher_name(void);
+u4byte  *dfc_set_key(dfc_ctx *ctx, const u4byte in_key[], const u4byte key_len);
+void    dfc_encrypt(const dfc_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    dfc_decrypt(const dfc_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    dfc_encrypt_blocks(const dfc_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+void    dfc_decrypt_blocks(const dfc_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
@@ -37,11 +37,12 @@ Mean:          725 cycles =    35.3 mbits/sec
 
 #define BYTE_SWAP
 
-#include "../std_defs.h"
+#include <string.h>
+#include "e2.h"
 
 static char *alg_name[] = { "e2", "e25.c" };
 
-char **cipher_name()
+char **e2_cipher_name(void)
 {
     return alg_name;
 };
@@ -74,7 +75,7 @@ u1byte  s_box[] =
 };
 */
 
-u4byte l_box1[] = 
+static u4byte l_box1[] = 
 {
  0x000000e1, 0x00000042, 0x0000003e, 0x00000081, 0x0000004e, 0x00000017,
  0x0000009e, 0x000000fd, 0x000000b4, 0x0000003f, 0x0000002c, 0x000000da,
@@ -121,7 +122,7 @@ u4byte l_box1[] =
  0x00000036, 0x00000052, 0x0000004a, 0x0000002a
 };
 
-u4byte l_box2[] = 
+static u4byte l_box2[] = 
 {
  0x0000e100, 0x00004200, 0x00003e00, 0x00008100, 0x00004e00, 0x00001700,
  0x00009e00, 0x0000fd00, 0x0000b400, 0x00003f00, 0x00002c00, 0x0000da00,
@@ -168,7 +169,7 @@ u4byte l_box2[] =
  0x00003600, 0x00005200, 0x00004a00, 0x00002a00
 };
 
-u4byte l_box4[] = 
+static u4byte l_box4[] = 
 {
  0x00e10000, 0x00420000, 0x003e0000, 0x00810000, 0x004e0000, 0x00170000,
  0x009e0000, 0x00fd0000, 0x00b40000, 0x003f0000, 0x002c0000, 0x00da0000,
@@ -215,7 +216,7 @@ u4byte l_box4[] =
  0x00360000, 0x00520000, 0x004a0000, 0x002a0000
 };
 
-u4byte l_box8[] = 
+static u4byte l_box8[] = 
 {
  0xe1000000, 0x42000000, 0x3e000000, 0x81000000, 0x4e000000, 0x17000000,
  0x9e000000, 0xfd000000, 0xb4000000, 0x3f000000, 0x2c000000, 0xda000000,
@@ -346,9 +347,7 @@ typedef union
     byte_adr(d, 2) = byte_adr(u, 1);    \
     byte_adr(d, 3) = byte_adr(v, 0)
 
-u4byte  l_key[72];
-
-u4byte  mod_inv(u4byte x)
+static u4byte  mod_inv(u4byte x)
 {   u4byte  y1, y2, a, b, q;
 
     y1 = ~((-x) / x); y2 = 1;
@@ -375,7 +374,7 @@ u4byte  mod_inv(u4byte x)
     }
 };
 
-void g_fun(u4byte y[8], u4byte l[8], u4byte v[2])
+static void g_fun(u4byte y[8], u4byte l[8], u4byte v[2])
 {   u4byte  p,q;
 
     sp_fun(y[0], y[1]); sp_fun(v[0], v[1]); 
@@ -391,8 +390,9 @@ void g_fun(u4byte y[8], u4byte l[8], u4byte v[2])
     l[6] = v[0] ^= y[6]; l[7] = v[1] ^= y[7];
 };
 
-u4byte *set_key(const u4byte in_key[], const u4byte key_len)
-{   u4byte  lk[8], v[2], lout[8];
+u4byte *e2_set_key(e2_ctx *ctx, const u4byte in_key[], const u4byte key_len)
+{   u4byte *l_key = ctx->l_key;
+    u4byte  lk[8], v[2], lout[8];
     un8byte *lp = (un8byte*)lout;
     u1byte  *bp = (u1byte*)l_key;
     u4byte  i, j, k;
@@ -436,11 +436,12 @@ u4byte *set_key(const u4byte in_key[], const u4byte key_len)
     }
 
 
-    return (u4byte*)&l_key;
+    return l_key;
 };
 
-void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{   u4byte      a,b,c,d,p,q,r,s,u,v;
+void e2_encrypt(const e2_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{   const u4byte *l_key = ctx->l_key;
+    u4byte      a,b,c,d,p,q,r,s,u,v;
 
     p = io_swap(in_blk[0]); q = io_swap(in_blk[1]); 
     r = io_swap(in_blk[2]); s = io_swap(in_blk[3]);
@@ -477,8 +478,9 @@ void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
     out_blk[2] = io_swap(r); out_blk[3] = io_swap(s);
 };
 
-void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{   u4byte      a,b,c,d,p,q,r,s,u,v;
+void e2_decrypt(const e2_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{   const u4byte *l_key = ctx->l_key;
+    u4byte      a,b,c,d,p,q,r,s,u,v;
 
     p = io_swap(in_blk[0]); q = io_swap(in_blk[1]); 
     r = io_swap(in_blk[2]); s = io_swap(in_blk[3]);
@@ -514,3 +516,28 @@ void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
     out_blk[0] = io_swap(p); out_blk[1] = io_swap(q); 
     out_blk[2] = io_swap(r); out_blk[3] = io_swap(s);
 };
+
+/* encrypt n_blk consecutive blocks of text held in byte buffers that */
+/* need not be word aligned; in_blk may be the same as out_blk        */
+
+void e2_encrypt_blocks(const e2_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{   u4byte  b_in[4], b_out[4];
+
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+    {
+        memcpy(b_in, in_blk, 16); e2_encrypt(ctx, b_in, b_out);
+        memcpy(out_blk, b_out, 16);
+    }
+};
+
+/* decrypt n_blk consecutive blocks of text                          */
+
+void e2_decrypt_blocks(const e2_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{   u4byte  b_in[4], b_out[4];
+
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+    {
+        memcpy(b_in, in_blk, 16); e2_decrypt(ctx, b_in, b_out);
+        memcpy(out_blk, b_out, 16);
+    }
+};
@@ -0,0 +1,32 @@
+
+/* E2 with the key schedule held in a caller supplied               */
+/* context (see e2.c). A context may be shared by any number        */
+/* of threads once its key has been set.                            */
+
+#ifndef _E2_H
+#define _E2_H
+
+#include "../std_defs.h"
+#include <stddef.h>
+#include "cache_align.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{   CACHE_ALIGN u4byte  l_key[72];  /* storage for the key schedule */
+} e2_ctx;
+
+char    **e2_cipher_name(void);
+u4byte  *e2_set_key(e2_ctx *ctx, const u4byte in_key[], const u4byte key_len);
+void    e2_encrypt(const e2_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    e2_decrypt(const e2_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    e2_encrypt_blocks(const e2_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+void    e2_decrypt_blocks(const e2_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
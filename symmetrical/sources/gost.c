@@ -32,12 +32,7 @@
  */
 
 
-/* A 32-bit data type */
-#ifdef __alpha  /* Any other 64-bit machines? */
-typedef unsigned int word32;
-#else
-typedef unsigned long word32;
-#endif
+#include "gost.h"
 
 /*
  * The standard does not specify the contents of the 8 4 bit->4 bit
@@ -71,34 +66,53 @@ static unsigned char const k2[16] = {
 static unsigned char const k1[16] = {
 	13,  2,  8,  4,  6, 15, 11,  1, 10,  9,  3, 14,  5,  0, 12,  7 };
 
-/* Byte-at-a-time substitution boxes */
-static unsigned char k87[256];
-static unsigned char k65[256];
-static unsigned char k43[256];
-static unsigned char k21[256];
+/* The same boxes as rows, k1 (the low nibble of f's input) first */
+static unsigned char const *const sbox_des[8] = {
+	k1, k2, k3, k4, k5, k6, k7, k8 };
 
 /*
- * Build byte-at-a-time subtitution tables.
- * This must be called once for global setup.
+ * Byte-at-a-time substitution tables.  kbox[i][b] is the result of
+ * substituting b as byte i of the input, shifted into place and
+ * already rotated left 11 bits, as the DES implementations store their
+ * combined S/P tables.  The four bytes land in disjoint bits, so the
+ * whole of f() is four lookups and three XORs.
+ */
+static word32 kbox[4][256];
+
+#define ROL11(x) ((x)<<11 | (x)>>(32-11))
+
+static void
+gost_expand(word32 t[4][256], unsigned char const *const k[8])
+{
+	word32 x;
+	int i, j;
+
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < 256; j++) {
+			x = (word32)(k[2*i+1][j >> 4] << 4 | k[2*i][j & 15]);
+			x <<= 8*i;
+			t[i][j] = ROL11(x);
+		}
+	}
+}
+
+/*
+ * Build the substitution tables for the functions below.
+ * This must be called once for global setup.  The gost_ctx
+ * functions further down carry their own tables and do not need it.
  */
 void
 kboxinit(void)
 {
-	int i;
-	for (i = 0; i < 256; i++) {
-		k87[i] = k8[i >> 4] << 4 | k7[i & 15];
-		k65[i] = k6[i >> 4] << 4 | k5[i & 15];
-		k43[i] = k4[i >> 4] << 4 | k3[i & 15];
-		k21[i] = k2[i >> 4] << 4 | k1[i & 15];
-	}
+	gost_expand(kbox, sbox_des);
 }
 
+#define GOST_F(t, x) ((t)[0][(x) & 255] ^ (t)[1][(x)>>8 & 255] ^ \
+		      (t)[2][(x)>>16 & 255] ^ (t)[3][(x)>>24])
+
 /*
  * Do the substitution and rotation that are the core of the operation,
  * like the expansion, substitution and permutation of the DES.
- * It would be possible to perform DES-like optimisations and store
- * the table entries as 32-bit words, already rotated, but the
- * efficiency gain is questionable.
  *
  * This should be inlined for maximum speed
  */
@@ -108,21 +122,7 @@ __inline__
 static word32
 f(word32 x)
 {
-	/* Do substitutions */
-#if 0
-	/* This is annoyingly slow */
-	x = k8[x>>28 & 15] << 28 | k7[x>>24 & 15] << 24 |
-	    k6[x>>20 & 15] << 20 | k5[x>>16 & 15] << 16 |
-	    k4[x>>12 & 15] << 12 | k3[x>> 8 & 15] <<  8 |
-	    k2[x>> 4 & 15] <<  4 | k1[x     & 15];
-#else
-	/* This is faster */
-	x = k87[x>>24 & 255] << 24 | k65[x>>16 & 255] << 16 |
-	    k43[x>> 8 & 255] <<  8 | k21[x & 255];
-#endif
-
-	/* Rotate left 11 bits */
-	return x<<11 | x>>(32-11);
+	return GOST_F(kbox, x);
 }
 
 /*
@@ -236,6 +236,54 @@ gostdecrypt(word32 const in[2], word32 out[2], word32 const key[8])
 	out[1] = n1;
 }
 
+/*
+ * Electronic codebook over len consecutive 8-byte blocks, for callers
+ * that hold their data as bytes.  Each block is read as two words in
+ * the standard's little-endian order, so the buffers need not be
+ * aligned and the result does not depend on the host's byte order.
+ * in may be the same as out.
+ */
+#define GETW(p) ((word32)(p)[0] | (word32)(p)[1] << 8 | \
+		 (word32)(p)[2] << 16 | (word32)(p)[3] << 24)
+#define PUTW(p, x) ((p)[0] = (unsigned char)(x), \
+		    (p)[1] = (unsigned char)((x) >> 8), \
+		    (p)[2] = (unsigned char)((x) >> 16), \
+		    (p)[3] = (unsigned char)((x) >> 24))
+
+void
+gostcrypt_blocks(unsigned char const *in, unsigned char *out, size_t len,
+	word32 const key[8])
+{
+	word32 t[2];
+
+	while (len--) {
+		t[0] = GETW(in);
+		t[1] = GETW(in+4);
+		gostcrypt(t, t, key);
+		PUTW(out, t[0]);
+		PUTW(out+4, t[1]);
+		in += 8;
+		out += 8;
+	}
+}
+
+void
+gostdecrypt_blocks(unsigned char const *in, unsigned char *out, size_t len,
+	word32 const key[8])
+{
+	word32 t[2];
+
+	while (len--) {
+		t[0] = GETW(in);
+		t[1] = GETW(in+4);
+		gostdecrypt(t, t, key);
+		PUTW(out, t[0]);
+		PUTW(out+4, t[1]);
+		in += 8;
+		out += 8;
+	}
+}
+
 /*
  * The GOST "Output feedback" standard.  It seems closer morally
  * to the counter feedback mode some people have proposed for DES.
@@ -367,6 +415,364 @@ gostmac(word32 const *in, int len, word32 out[2], word32 const key[8])
 	out[1] = n2;
 }
 
+/*
+ * Keyed contexts.
+ *
+ * The functions above share one global set of S-boxes.  A gost_ctx
+ * carries its own expanded tables, so keys under different parameter
+ * sets can be in use at once, and its own subkey sequences for both
+ * directions, so one round loop serves both.
+ *
+ * The parameter sets are those of RFC 4357 and RFC 7836, stored the
+ * way k1..k8 are above: row i is box k(i+1), applied to bits 4i..4i+3.
+ */
+static unsigned char const sbox_param[GOST_SBOX_COUNT-1][8][16] = {
+	{	/* GOST_SBOX_TEST */
+		{  4,  2, 15,  5,  9,  1,  0,  8, 14,  3, 11, 12, 13,  7, 10,  6 },
+		{ 12,  9, 15, 14,  8,  1,  3, 10,  2,  7,  4, 13,  6,  0, 11,  5 },
+		{ 13,  8, 14, 12,  7,  3,  9, 10,  1,  5,  2,  4,  6, 15,  0, 11 },
+		{ 14,  9, 11,  2,  5, 15,  7,  1,  0, 13, 12,  6, 10,  4,  3,  8 },
+		{  3, 14,  5,  9,  6,  8,  0, 13, 10, 11,  7, 12,  2,  1, 15,  4 },
+		{  8, 15,  6, 11,  1,  9, 12,  5, 13,  3,  7, 10,  0, 14,  2,  4 },
+		{  9, 11, 12,  0,  3,  6,  7,  5,  4,  8, 14, 15,  1, 10,  2, 13 },
+		{ 12,  6,  5,  2, 11,  0,  9, 13,  3, 14,  7, 10, 15,  4,  1,  8 }
+	},
+	{	/* GOST_SBOX_CRYPTOPRO_A */
+		{  9,  6,  3,  2,  8, 11,  1,  7, 10,  4, 14, 15, 12,  0, 13,  5 },
+		{  3,  7, 14,  9,  8, 10, 15,  0,  5,  2,  6, 12, 11,  4, 13,  1 },
+		{ 14,  4,  6,  2, 11,  3, 13,  8, 12, 15,  5, 10,  0,  7,  1,  9 },
+		{ 14,  7, 10, 12, 13,  1,  3,  9,  0,  2, 11,  4, 15,  8,  5,  6 },
+		{ 11,  5,  1,  9,  8, 13, 15,  0, 14,  4,  2,  3, 12,  7, 10,  6 },
+		{  3, 10, 13, 12,  1,  2,  0, 11,  7,  5,  9,  4,  8, 15, 14,  6 },
+		{  1, 13,  2,  9,  7, 10,  6,  0,  8, 12,  4,  5, 15,  3, 11, 14 },
+		{ 11, 10, 15,  5,  0, 12, 14,  8,  6,  2,  3,  9,  1,  7, 13,  4 }
+	},
+	{	/* GOST_SBOX_CRYPTOPRO_B */
+		{  8,  4, 11,  1,  3,  5,  0,  9,  2, 14, 10, 12, 13,  6,  7, 15 },
+		{  0,  1,  2, 10,  4, 13,  5, 12,  9,  7,  3, 15, 11,  8,  6, 14 },
+		{ 14, 12,  0, 10,  9,  2, 13, 11,  7,  5,  8, 15,  3,  6,  1,  4 },
+		{  7,  5,  0, 13, 11,  6,  1,  2,  3, 10, 12, 15,  4, 14,  9,  8 },
+		{  2,  7, 12, 15,  9,  5, 10, 11,  1,  4,  0, 13,  6,  8, 14,  3 },
+		{  8,  3,  2,  6,  4, 13, 14, 11, 12,  1,  7, 15, 10,  0,  9,  5 },
+		{  5,  2, 10, 11,  9,  1, 12,  3,  7,  4, 13,  0,  6, 15,  8, 14 },
+		{  0,  4, 11, 14,  8,  3,  7,  1, 10,  2,  9,  6, 15, 13,  5, 12 }
+	},
+	{	/* GOST_SBOX_CRYPTOPRO_C */
+		{  1, 11, 12,  2,  9, 13,  0, 15,  4,  5,  8, 14, 10,  7,  6,  3 },
+		{  0,  1,  7, 13, 11,  4,  5,  2,  8, 14, 15, 12,  9, 10,  6,  3 },
+		{  8,  2,  5,  0,  4,  9, 15, 10,  3,  7, 12, 13,  6, 14,  1, 11 },
+		{  3,  6,  0,  1,  5, 13, 10,  8, 11,  2,  9,  7, 14, 15, 12,  4 },
+		{  8, 13, 11,  0,  4,  5,  1,  2,  9,  3, 12, 14,  6, 15, 10,  7 },
+		{ 12,  9, 11,  1,  8, 14,  2,  4,  7,  3,  6,  5, 10,  0, 15, 13 },
+		{ 10,  9,  6,  8, 13, 14,  2,  0, 15,  3,  5, 11,  4,  1, 12,  7 },
+		{  7,  4,  0,  5, 10,  2, 15, 14, 12,  6,  1, 11, 13,  9,  3,  8 }
+	},
+	{	/* GOST_SBOX_CRYPTOPRO_D */
+		{ 15, 12,  2, 10,  6,  4,  5,  0,  7,  9, 14, 13,  1, 11,  8,  3 },
+		{ 11,  6,  3,  4, 12, 15, 14,  2,  7, 13,  8,  0,  5, 10,  9,  1 },
+		{  1, 12, 11,  0, 15, 14,  6,  5, 10, 13,  4,  8,  9,  3,  7,  2 },
+		{  1,  5, 14, 12, 10,  7,  0, 13,  6,  2, 11,  4,  9,  3, 15,  8 },
+		{  0, 12,  8,  9, 13,  2, 10, 11,  7,  3,  6,  5,  4, 14, 15,  1 },
+		{  8,  0, 15,  3,  2,  5, 14, 11,  1, 10,  4,  7, 12,  9, 13,  6 },
+		{  3,  0,  6, 15,  1, 14,  9,  2, 13,  8, 12,  4, 11, 10,  5,  7 },
+		{  1, 10,  6,  8, 15, 11,  0,  4, 12,  3,  5,  9,  7, 13,  2, 14 }
+	},
+	{	/* GOST_SBOX_TC26_Z */
+		{ 12,  4,  6,  2, 10,  5, 11,  9, 14,  8, 13,  7,  0,  3, 15,  1 },
+		{  6,  8,  2,  3,  9, 10,  5, 12,  1, 14,  4,  7, 11, 13,  0, 15 },
+		{ 11,  3,  5,  8,  2, 15, 10, 13, 14,  1,  7,  4, 12,  9,  6,  0 },
+		{ 12,  8,  2,  1, 13,  4, 15,  6,  7,  0, 10,  5,  3, 14,  9, 11 },
+		{  7, 15,  5, 10,  8,  1,  6, 13,  0,  9,  3, 14, 11,  4,  2, 12 },
+		{  5, 13, 15,  6,  9,  2, 12, 10, 11,  7,  8,  1,  4,  3, 14,  0 },
+		{  8, 14,  2,  5,  6,  9,  1, 12, 15,  4, 11,  0, 13, 10,  3,  7 },
+		{  1,  7, 14, 13,  0,  5,  8,  3,  4, 15, 10,  6,  9, 12, 11,  2 }
+	},
+};
+
+int
+gost_setkey(gost_ctx *ctx, unsigned char const key[32], int sbox)
+{
+	unsigned char const *k[8];
+	int i;
+
+	if (sbox < 0 || sbox >= GOST_SBOX_COUNT)
+		return -1;
+	for (i = 0; i < 8; i++)
+		k[i] = sbox == GOST_SBOX_DES ? sbox_des[i] : sbox_param[sbox-1][i];
+	gost_expand(ctx->sbox, k);
+
+	/* Three times forward, once backward; decryption is the reverse */
+	for (i = 0; i < 8; i++) {
+		ctx->ek[i] = ctx->ek[i+8] = ctx->ek[i+16] = ctx->ek[31-i] =
+			GETW(key + 4*i);
+	}
+	for (i = 0; i < 32; i++)
+		ctx->dk[i] = ctx->ek[31-i];
+	return 0;
+}
+
+/*
+ * Up to four independent blocks go through the rounds together.  A
+ * round is a chain of four dependent loads; interleaving lets the
+ * table lookups of one block overlap those of the others.  n is a
+ * constant at every call, so the lane tests fold away.
+ */
+#if defined(__GNUC__)
+#define GOST_INLINE static __inline__ __attribute__((always_inline))
+#else
+#define GOST_INLINE static
+#endif
+
+#define GOST_MAX_LANES 4
+
+#define GOST_LANES(op) do {					\
+		op(0);						\
+		if (n > 1) op(1);				\
+		if (n > 2) op(2);				\
+		if (n > 3) op(3);				\
+	} while (0)
+
+#define GOST_RND_A(j) (t = n1[j] + k[i], n2[j] ^= GOST_F(s, t))
+#define GOST_RND_B(j) (t = n2[j] + k[i+1], n1[j] ^= GOST_F(s, t))
+
+/* 32 rounds on n lanes; as in gostcrypt(), the result is (n2, n1) */
+GOST_INLINE void
+gost_lanes(word32 const s[4][256], word32 const k[32], int const n,
+	word32 *n1, word32 *n2)
+{
+	word32 t;
+	int i;
+
+	for (i = 0; i < 32; i += 2) {
+		GOST_LANES(GOST_RND_A);
+		GOST_LANES(GOST_RND_B);
+	}
+}
+
+GOST_INLINE void
+gost_ecb_lanes(gost_ctx const *ctx, word32 const k[32],
+	unsigned char const *in, unsigned char *out, int const n)
+{
+	word32 n1[GOST_MAX_LANES], n2[GOST_MAX_LANES];
+	int j;
+
+	for (j = 0; j < n; j++) {
+		n1[j] = GETW(in + 8*j);
+		n2[j] = GETW(in + 8*j + 4);
+	}
+	gost_lanes(ctx->sbox, k, n, n1, n2);
+	for (j = 0; j < n; j++) {
+		PUTW(out + 8*j, n2[j]);
+		PUTW(out + 8*j + 4, n1[j]);
+	}
+}
+
+static void
+gost_ecb(gost_ctx const *ctx, word32 const k[32],
+	unsigned char const *in, unsigned char *out, size_t len)
+{
+	for (; len >= 4; len -= 4, in += 32, out += 32)
+		gost_ecb_lanes(ctx, k, in, out, 4);
+	if (len >= 2) {
+		gost_ecb_lanes(ctx, k, in, out, 2);
+		len -= 2, in += 16, out += 16;
+	}
+	if (len)
+		gost_ecb_lanes(ctx, k, in, out, 1);
+}
+
+/* len is in 8-byte blocks; in may be the same as out */
+void
+gost_encrypt_blocks(gost_ctx const *ctx, unsigned char const *in,
+	unsigned char *out, size_t len)
+{
+	gost_ecb(ctx, ctx->ek, in, out, len);
+}
+
+void
+gost_decrypt_blocks(gost_ctx const *ctx, unsigned char const *in,
+	unsigned char *out, size_t len)
+{
+	gost_ecb(ctx, ctx->dk, in, out, len);
+}
+
+/*
+ * Gamma with feedback (CFB-64).  Encryption is a chain and goes one
+ * block at a time; decryption knows every feedback block up front and
+ * runs four at a time.  iv is updated in place.
+ */
+void
+gost_cfb_encrypt(gost_ctx const *ctx, unsigned char iv[8],
+	unsigned char const *in, unsigned char *out, size_t len)
+{
+	word32 n1 = GETW(iv), n2 = GETW(iv + 4);
+	word32 y1, y2;
+
+	while (len--) {
+		gost_lanes(ctx->sbox, ctx->ek, 1, &n1, &n2);
+		y1 = GETW(in) ^ n2;
+		y2 = GETW(in + 4) ^ n1;
+		PUTW(out, y1);
+		PUTW(out + 4, y2);
+		n1 = y1;
+		n2 = y2;
+		in += 8;
+		out += 8;
+	}
+	PUTW(iv, n1);
+	PUTW(iv + 4, n2);
+}
+
+GOST_INLINE void
+gost_cfb_dec_lanes(gost_ctx const *ctx, unsigned char iv[8],
+	unsigned char const *in, unsigned char *out, int const n)
+{
+	word32 n1[GOST_MAX_LANES], n2[GOST_MAX_LANES];
+	word32 y[2*GOST_MAX_LANES];
+	int j;
+
+	/* Read all of the ciphertext first: out may be in */
+	for (j = 0; j < 2*n; j++)
+		y[j] = GETW(in + 4*j);
+	n1[0] = GETW(iv);
+	n2[0] = GETW(iv + 4);
+	for (j = 1; j < n; j++) {
+		n1[j] = y[2*j-2];
+		n2[j] = y[2*j-1];
+	}
+	gost_lanes(ctx->sbox, ctx->ek, n, n1, n2);
+	for (j = 0; j < n; j++) {
+		PUTW(out + 8*j, y[2*j] ^ n2[j]);
+		PUTW(out + 8*j + 4, y[2*j+1] ^ n1[j]);
+	}
+	PUTW(iv, y[2*n-2]);
+	PUTW(iv + 4, y[2*n-1]);
+}
+
+void
+gost_cfb_decrypt(gost_ctx const *ctx, unsigned char iv[8],
+	unsigned char const *in, unsigned char *out, size_t len)
+{
+	for (; len >= 4; len -= 4, in += 32, out += 32)
+		gost_cfb_dec_lanes(ctx, iv, in, out, 4);
+	for (; len; len--, in += 8, out += 8)
+		gost_cfb_dec_lanes(ctx, iv, in, out, 1);
+}
+
+/*
+ * Gamma (counter) mode, the "output feedback" of gostofb().
+ * gost_cnt_start() encrypts the IV into the counter, (N3, N4) in the
+ * standard's names; each block then steps N3 by C2 modulo 2^32 and
+ * N4 by C1 modulo 2^32-1, and encrypts the pair to get the gamma.
+ * (gostofb() above reduces N3 modulo 2^32-1 as well, following the
+ * draft translation; it is left as it was.)  The counter steps are
+ * cheap and serial, the encryptions independent, so four blocks at
+ * a time go through the rounds together.  ctr is updated in place,
+ * so a long stream may be processed in pieces of whole blocks.
+ */
+void
+gost_cnt_start(gost_ctx const *ctx, unsigned char const iv[8],
+	word32 ctr[2])
+{
+	word32 n1 = GETW(iv), n2 = GETW(iv + 4);
+
+	gost_lanes(ctx->sbox, ctx->ek, 1, &n1, &n2);
+	ctr[0] = n2;
+	ctr[1] = n1;
+}
+
+GOST_INLINE void
+gost_cnt_lanes(gost_ctx const *ctx, word32 ctr[2],
+	unsigned char const *in, unsigned char *out, int const n)
+{
+	word32 n1[GOST_MAX_LANES], n2[GOST_MAX_LANES];
+	word32 x1, x2;
+	int j;
+
+	for (j = 0; j < n; j++) {
+		ctr[0] += C2;
+		ctr[1] += C1;
+		if (ctr[1] < C1)	/* Wrap modulo 2^32? */
+			ctr[1]++;	/* Make it modulo 2^32-1 */
+		n1[j] = ctr[0];
+		n2[j] = ctr[1];
+	}
+	gost_lanes(ctx->sbox, ctx->ek, n, n1, n2);
+	for (j = 0; j < n; j++) {
+		x1 = GETW(in + 8*j) ^ n2[j];
+		x2 = GETW(in + 8*j + 4) ^ n1[j];
+		PUTW(out + 8*j, x1);
+		PUTW(out + 8*j + 4, x2);
+	}
+}
+
+/* Self-inverse; len is in blocks and in may be the same as out */
+void
+gost_cnt_crypt(gost_ctx const *ctx, word32 ctr[2],
+	unsigned char const *in, unsigned char *out, size_t len)
+{
+	for (; len >= 4; len -= 4, in += 32, out += 32)
+		gost_cnt_lanes(ctx, ctr, in, out, 4);
+	for (; len; len--, in += 8, out += 8)
+		gost_cnt_lanes(ctx, ctr, in, out, 1);
+}
+
+/*
+ * The imitovstavka (MAC): each block is XORed into (N1, N2), which then
+ * goes through the first 16 rounds, without the final swap.  The chain
+ * admits no interleaving within one message.
+ *
+ * gost_mac_blocks() runs whole blocks through a state the caller
+ * zeroes before the first call.  gost_mac() does a whole message of
+ * len bytes: the last block is padded with zeros and, as the standard
+ * requires at least two blocks, a one-block message gets a zero block
+ * after it (an empty message has MAC 0).  The MAC is N1; its low byte comes first on the wire.
+ * A shorter MAC is the low bits of that.
+ */
+void
+gost_mac_blocks(gost_ctx const *ctx, word32 mac[2],
+	unsigned char const *in, size_t len)
+{
+	word32 const (*s)[256] = ctx->sbox;
+	word32 const *k = ctx->ek;
+	word32 n1 = mac[0], n2 = mac[1];
+	word32 t;
+	int i;
+
+	while (len--) {
+		n1 ^= GETW(in);
+		n2 ^= GETW(in + 4);
+		in += 8;
+		for (i = 0; i < 16; i += 2) {
+			t = n1 + k[i];
+			n2 ^= GOST_F(s, t);
+			t = n2 + k[i+1];
+			n1 ^= GOST_F(s, t);
+		}
+	}
+	mac[0] = n1;
+	mac[1] = n2;
+}
+
+word32
+gost_mac(gost_ctx const *ctx, unsigned char const *in, size_t len)
+{
+	static unsigned char const zero[8];
+	unsigned char last[8];
+	word32 mac[2] = { 0, 0 };
+	size_t i, r = len & 7;
+
+	gost_mac_blocks(ctx, mac, in, len >> 3);
+	if (r) {
+		for (i = 0; i < 8; i++)
+			last[i] = i < r ? in[len - r + i] : 0;
+		gost_mac_blocks(ctx, mac, last, 1);
+	}
+	if (len && len <= 8)
+		gost_mac_blocks(ctx, mac, zero, 1);
+	return mac[0];
+}
+
 #ifdef TEST
 
 #include <stdio.h>
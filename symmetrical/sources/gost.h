@@ -0,0 +1,92 @@
+/*
+ * The GOST 28147-89 cipher: interface to gost.c.
+ *
+ * This code is placed in the public domain.
+ */
+
+#ifndef GOST_H
+#define GOST_H
+
+#include <limits.h>
+#include <stddef.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/* A 32-bit data type */
+#if ULONG_MAX > 0xffffffffUL	/* LP64: long is 64 bits */
+typedef unsigned int word32;
+#else
+typedef unsigned long word32;
+#endif
+
+void kboxinit(void);
+
+void gostcrypt(word32 const in[2], word32 out[2], word32 const key[8]);
+void gostdecrypt(word32 const in[2], word32 out[2], word32 const key[8]);
+
+void gostcrypt_blocks(unsigned char const *in, unsigned char *out,
+	size_t len, word32 const key[8]);
+void gostdecrypt_blocks(unsigned char const *in, unsigned char *out,
+	size_t len, word32 const key[8]);
+
+void gostofb(word32 const *in, word32 *out, int len,
+	word32 const iv[2], word32 const key[8]);
+void gostcfbencrypt(word32 const *in, word32 *out, int len,
+	word32 iv[2], word32 const key[8]);
+void gostcfbdecrypt(word32 const *in, word32 *out, int len,
+	word32 iv[2], word32 const key[8]);
+void gostmac(word32 const *in, int len, word32 out[2], word32 const key[8]);
+
+/* S-box parameter sets for gost_setkey() */
+enum {
+	GOST_SBOX_DES,		/* the illustrative DES rows of gost.c */
+	GOST_SBOX_TEST,		/* id-Gost28147-89-TestParamSet */
+	GOST_SBOX_CRYPTOPRO_A,	/* id-Gost28147-89-CryptoPro-A-ParamSet */
+	GOST_SBOX_CRYPTOPRO_B,	/* id-Gost28147-89-CryptoPro-B-ParamSet */
+	GOST_SBOX_CRYPTOPRO_C,	/* id-Gost28147-89-CryptoPro-C-ParamSet */
+	GOST_SBOX_CRYPTOPRO_D,	/* id-Gost28147-89-CryptoPro-D-ParamSet */
+	GOST_SBOX_TC26_Z,	/* id-tc26-gost-28147-param-Z */
+	GOST_SBOX_COUNT
+};
+
+/*
+ * A key with its own parameter set.  sbox[i][b] is byte i of f()'s
+ * input equal to b, substituted, shifted into place and rotated.
+ */
+typedef struct {
+	word32 sbox[4][256];
+	word32 ek[32];		/* subkeys in encryption order */
+	word32 dk[32];		/* and in decryption order */
+} gost_ctx;
+
+/* key is eight little-endian words; returns -1 for an unknown sbox */
+int gost_setkey(gost_ctx *ctx, unsigned char const key[32], int sbox);
+
+/* len is in 8-byte blocks throughout; in may be the same as out */
+void gost_encrypt_blocks(gost_ctx const *ctx, unsigned char const *in,
+	unsigned char *out, size_t len);
+void gost_decrypt_blocks(gost_ctx const *ctx, unsigned char const *in,
+	unsigned char *out, size_t len);
+
+void gost_cfb_encrypt(gost_ctx const *ctx, unsigned char iv[8],
+	unsigned char const *in, unsigned char *out, size_t len);
+void gost_cfb_decrypt(gost_ctx const *ctx, unsigned char iv[8],
+	unsigned char const *in, unsigned char *out, size_t len);
+
+void gost_cnt_start(gost_ctx const *ctx, unsigned char const iv[8],
+	word32 ctr[2]);
+void gost_cnt_crypt(gost_ctx const *ctx, word32 ctr[2],
+	unsigned char const *in, unsigned char *out, size_t len);
+
+/* the MAC over whole blocks (mac[] starts zeroed), or over len bytes */
+void gost_mac_blocks(gost_ctx const *ctx, word32 mac[2],
+	unsigned char const *in, size_t len);
+word32 gost_mac(gost_ctx const *ctx, unsigned char const *in, size_t len);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* GOST_H */
@@ -36,23 +36,21 @@ Mean:         1638 cycles =    15.6 mbits/sec
 
 #define	BYTE_SWAP
 
-#include "../std_defs.h"
+#include <string.h>
+#include "hpc.h"
 
 static char *alg_name[] = { "hpc", "hpc0.c" };
 
-char **cipher_name()
+char **hpc_cipher_name(void)
 {
 	return alg_name;
 }
 
-typedef	u4byte	u8byte[2];
+static u8byte	spice[8] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
-u8byte	l_key[286];
-u8byte	spice[8] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-
-u8byte	p119 = { 0xa23249d6, 0x2b992ddf };
-u8byte	e19  = { 0xc0b36173, 0x25b946eb };
-u8byte	r220 = { 0xe9e17158, 0xc442f56b };
+static u8byte	p119 = { 0xa23249d6, 0x2b992ddf };
+static u8byte	e19  = { 0xc0b36173, 0x25b946eb };
+static u8byte	r220 = { 0xe9e17158, 0xc442f56b };
 
 #define	xor_eq(x,y)		(x)[0] ^= (y)[0]; (x)[1] ^= (y)[1]
 #define	and_eq(x,y)		(x)[0] &= (y)[0]; (x)[1] &= (y)[1]
@@ -82,7 +80,7 @@ u8byte	r220 = { 0xe9e17158, 0xc442f56b };
 #define lo(x)	((x) & 0x0000ffff)
 #define hi(x)	((x) >> 16)
 
-void mult_64(u8byte r, const u8byte x, const u8byte y)
+static void mult_64(u8byte r, const u8byte x, const u8byte y)
 {	u4byte	x0, x1, x2, x3, y0, y1, y2, y3, t0, t1, t2, t3, c;
 
 	x0 = lo(x[0]); x1 = hi(x[0]); x2 = lo(x[1]); x3 = hi(x[1]);
@@ -113,12 +111,11 @@ void mult_64(u8byte r, const u8byte x, const u8byte y)
 */
 };
 
-u8byte	l_key[286];	/* storage for the key schedule 		*/
-
 /* initialise the key schedule from the user supplied key	*/
 
-u4byte *set_key(const u4byte in_key[], const u4byte key_len)
-{	u8byte	s[8], t;
+u4byte *hpc_set_key(hpc_ctx *ctx, const u4byte in_key[], const u4byte key_len)
+{	u8byte *l_key = ctx->l_key;
+	u8byte	s[8], t;
 	u4byte	i, j, xs;
 
 	l_key[0][0] = p119[0] + 3; l_key[0][1] = p119[1];
@@ -187,8 +184,9 @@ u4byte *set_key(const u4byte in_key[], const u4byte key_len)
 
 /* encrypt a block of text	*/
 
-void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{	u8byte	s0, s1, k, kk, t;
+void hpc_encrypt(const hpc_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{	const u8byte *l_key = ctx->l_key;
+	u8byte	s0, s1, k, kk, t;
 	u4byte	tt, xs;
 	s4byte	i;
 
@@ -238,8 +236,9 @@ void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
 
 /* decrypt a block of text	*/
 
-void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{	u8byte	s0, s1, k, kk, t;
+void hpc_decrypt(const hpc_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{	const u8byte *l_key = ctx->l_key;
+	u8byte	s0, s1, k, kk, t;
 	u4byte	tt, xs;
 	s4byte	i;
 
@@ -286,3 +285,28 @@ void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
 	out_blk[0] = io_swap(s0[1]); out_blk[1] = io_swap(s0[0]);
 	out_blk[2] = io_swap(s1[1]); out_blk[3] = io_swap(s1[0]);
 };
+
+/* encrypt n_blk consecutive blocks of text held in byte buffers that */
+/* need not be word aligned; in_blk may be the same as out_blk        */
+
+void hpc_encrypt_blocks(const hpc_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{	u4byte	b_in[4], b_out[4];
+
+	for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+	{
+		memcpy(b_in, in_blk, 16); hpc_encrypt(ctx, b_in, b_out);
+		memcpy(out_blk, b_out, 16);
+	}
+};
+
+/* decrypt n_blk consecutive blocks of text                          */
+
+void hpc_decrypt_blocks(const hpc_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{	u4byte	b_in[4], b_out[4];
+
+	for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+	{
+		memcpy(b_in, in_blk, 16); hpc_decrypt(ctx, b_in, b_out);
+		memcpy(out_blk, b_out, 16);
+	}
+};
@@ -0,0 +1,34 @@
+
+/* HPC with the key schedule held in a caller supplied              */
+/* context (see hpc.c). A context may be shared by any number       */
+/* of threads once its key has been set.                            */
+
+#ifndef _HPC_H
+#define _HPC_H
+
+#include "../std_defs.h"
+#include <stddef.h>
+#include "cache_align.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+typedef u4byte  u8byte[2];  /* 64 bit value, low word first */
+
+typedef struct
+{   CACHE_ALIGN u8byte  l_key[286]; /* storage for the key schedule */
+} hpc_ctx;
+
+char    **hpc_cipher_name(void);
+u4byte  *hpc_set_key(hpc_ctx *ctx, const u4byte in_key[], const u4byte key_len);
+void    hpc_encrypt(const hpc_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    hpc_decrypt(const hpc_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    hpc_encrypt_blocks(const hpc_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+void    hpc_decrypt_blocks(const hpc_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
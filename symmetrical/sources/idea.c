@@ -2,48 +2,56 @@
  * 1994 by Risto Paasivirta, paasivir@jyu.fi
  */
 
+#include <string.h>
+#include "idea.h"
+
 typedef unsigned long ulong;
 typedef unsigned short ushort;
 typedef unsigned char uchar;
 
 #define INLINE __inline
 
-/* a * b mod 65537
+/* The batch entry points run 8 (SSE2) or 16 (AVX2) blocks per pass,
+ * one 16-bit lane per block, when the CPU has them.  Define
+ * IDEA_NO_SIMD to build the scalar code only.
+ */
+#if !defined(IDEA_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define IDEA_SIMD
+#include <immintrin.h>
+#endif
+
+/* a * b mod 65537, where 0 stands for 65536.  No branches: the
+ * zero operand case is selected with a mask, so timing does not
+ * depend on key or data.
  */
 static INLINE ushort mul(ushort a, ushort b);
 
 static INLINE ushort mul(ushort a, ushort b)
 {
-  long p;
-  ulong q;
+  ulong q, lo, hi, z;
 
-  if (a==0)
-    return (ushort)(1 - b);
-  if (b==0)
-    return (ushort)(1 - a);
   q = (ulong)a * (ulong)b;
-  if((p = (q & 65535) - (q >> 16)) <= 0)
-    p++;
-  return (ushort)p;
+  lo = q & 65535;
+  hi = q >> 16;
+  lo = lo - hi + (lo < hi);
+  z = (ulong)(q != 0) - 1;	/* all ones when a or b is 0 */
+  return (ushort)((lo & ~z) | ((1 - a - b) & z));
 }
 
-/* a^-1 mod 65537
+/* a^-1 mod 65537, as a^65535 (65537 is prime)
  */
 
 static INLINE ushort inv(ushort a);
 
-static INLINE ushort inv(ushort ain)
+static INLINE ushort inv(ushort a)
 {
-  long a = ain, c = 65537, d, e = 0, f = 1, g;
+  ushort r = a;
+  int i;
 
-  while ( a > 0 ) {
-    d = c % a;
-    g = e - c / a * f;
-    c = a; a = d; e = f; f = g;
-  }
-  if (e < 0)
-    e++;
-  return (ushort)e;
+  for (i = 0; i < 15; i++)	/* r = a^(2^(i+2) - 1) */
+    r = mul(mul(r, r), a);
+  return r;
 }
 
 /* IDEA core function
@@ -126,3 +134,254 @@ InvertIdeaKey(ushort *ks, ushort *ik)
     ik[i] = kb[i];
 }
 
+/* Expand a 16-byte key to both schedules
+ */
+
+void
+IdeaSetKey(IdeaCtx *ctx, const uchar *key)
+{
+  ushort uk[8], i;
+
+  for (i = 0; i < 8; i++)
+    uk[i] = (ushort)(key[2 * i] << 8 | key[2 * i + 1]);
+  ExpandUserKey(uk, ctx->ek);
+  InvertIdeaKey(ctx->ek, ctx->dk);
+  memset(uk, 0, sizeof(uk));
+}
+
+#ifdef IDEA_SIMD
+
+typedef ushort v8hu __attribute__((vector_size(16)));
+typedef ushort v16hu __attribute__((vector_size(32)));
+
+/* mul() on every lane: the low and high halves of the 32-bit product
+ * come from pmullw/pmulhuw, zero operands are patched in by mask.
+ */
+#define IDEA_VMUL(V, mulhi, x, k) \
+  V lo = x * k, hi = (V)mulhi(x, k), z = (V)((x == 0) | (k == 0)); \
+  lo = lo - hi + (V)-(lo < hi); \
+  return (lo & ~z) | ((1 - x - k) & z)
+
+__attribute__((target("sse2")))
+static INLINE v8hu mul8(v8hu x, v8hu k)
+{
+#define MULHI8(a, b) _mm_mulhi_epu16((__m128i)(a), (__m128i)(b))
+  IDEA_VMUL(v8hu, MULHI8, x, k);
+}
+
+__attribute__((target("avx2")))
+static INLINE v16hu mul16(v16hu x, v16hu k)
+{
+#define MULHI16(a, b) _mm256_mulhi_epu16((__m256i)(a), (__m256i)(b))
+  IDEA_VMUL(v16hu, MULHI16, x, k);
+}
+
+/* Same rounds as Idea(), on x0..x3 with broadcast subkeys k[52]
+ */
+#define IDEA_VROUNDS(mul, k) \
+  for (i = 0; i < 48; i += 6) { \
+    x0 = mul(x0, k[i]); \
+    x1 += k[i + 1]; \
+    x2 += k[i + 2]; \
+    x3 = mul(x3, k[i + 3]); \
+    b = mul(x0 ^ x2, k[i + 4]); \
+    a = mul(b + (x1 ^ x3), k[i + 5]); \
+    b += a; \
+    x0 ^= a; \
+    x3 ^= b; \
+    b ^= x1; \
+    x1 = a ^ x2; \
+    x2 = b; \
+  } \
+  x0 = mul(x0, k[48]); \
+  a = x2 + k[49]; \
+  x2 = x1 + k[50]; \
+  x1 = a; \
+  x3 = mul(x3, k[51])
+
+/* Four registers of two blocks each (per 128-bit half) to word
+ * vectors and back; blocks are big-endian words.
+ */
+#define IDEA_SPLIT(P) \
+  u0 = P##_unpacklo_epi16(r0, r1); u1 = P##_unpackhi_epi16(r0, r1); \
+  u2 = P##_unpacklo_epi16(r2, r3); u3 = P##_unpackhi_epi16(r2, r3); \
+  r0 = P##_unpacklo_epi16(u0, u1); r1 = P##_unpackhi_epi16(u0, u1); \
+  r2 = P##_unpacklo_epi16(u2, u3); r3 = P##_unpackhi_epi16(u2, u3); \
+  u0 = P##_unpacklo_epi64(r0, r2); u1 = P##_unpackhi_epi64(r0, r2); \
+  u2 = P##_unpacklo_epi64(r1, r3); u3 = P##_unpackhi_epi64(r1, r3)
+
+#define IDEA_JOIN(P) \
+  u0 = P##_unpacklo_epi16(r0, r1); u1 = P##_unpackhi_epi16(r0, r1); \
+  u2 = P##_unpacklo_epi16(r2, r3); u3 = P##_unpackhi_epi16(r2, r3); \
+  r0 = P##_unpacklo_epi32(u0, u2); r1 = P##_unpackhi_epi32(u0, u2); \
+  r2 = P##_unpacklo_epi32(u1, u3); r3 = P##_unpackhi_epi32(u1, u3)
+
+#define BSWAP16(v) ((v) << 8 | (v) >> 8)
+
+/* 8 blocks per pass; returns the number of blocks done
+ */
+__attribute__((target("sse2")))
+static size_t
+Idea8(const ushort *ks, const uchar *in, uchar *out, size_t n)
+{
+  v8hu k[52], x0, x1, x2, x3, a, b;
+  __m128i r0, r1, r2, r3, u0, u1, u2, u3;
+  size_t d;
+  int i;
+
+  for (i = 0; i < 52; i++)
+    k[i] = (v8hu)_mm_set1_epi16((short)ks[i]);
+  for (d = 0; n - d >= 8; d += 8, in += 64, out += 64) {
+    r0 = _mm_loadu_si128((const __m128i *)in);
+    r1 = _mm_loadu_si128((const __m128i *)in + 1);
+    r2 = _mm_loadu_si128((const __m128i *)in + 2);
+    r3 = _mm_loadu_si128((const __m128i *)in + 3);
+    IDEA_SPLIT(_mm);
+    x0 = BSWAP16((v8hu)u0);
+    x1 = BSWAP16((v8hu)u1);
+    x2 = BSWAP16((v8hu)u2);
+    x3 = BSWAP16((v8hu)u3);
+    IDEA_VROUNDS(mul8, k);
+    r0 = (__m128i)BSWAP16(x0);
+    r1 = (__m128i)BSWAP16(x1);
+    r2 = (__m128i)BSWAP16(x2);
+    r3 = (__m128i)BSWAP16(x3);
+    IDEA_JOIN(_mm);
+    _mm_storeu_si128((__m128i *)out, r0);
+    _mm_storeu_si128((__m128i *)out + 1, r1);
+    _mm_storeu_si128((__m128i *)out + 2, r2);
+    _mm_storeu_si128((__m128i *)out + 3, r3);
+  }
+  return d;
+}
+
+/* 16 blocks per pass; the unpacks stay within 128-bit halves, so
+ * each half carries 8 blocks exactly as in Idea8().
+ */
+__attribute__((target("avx2")))
+static size_t
+Idea16(const ushort *ks, const uchar *in, uchar *out, size_t n)
+{
+  v16hu k[52], x0, x1, x2, x3, a, b;
+  __m256i r0, r1, r2, r3, u0, u1, u2, u3;
+  size_t d;
+  int i;
+
+  for (i = 0; i < 52; i++)
+    k[i] = (v16hu)_mm256_set1_epi16((short)ks[i]);
+  for (d = 0; n - d >= 16; d += 16, in += 128, out += 128) {
+    r0 = _mm256_loadu_si256((const __m256i *)in);
+    r1 = _mm256_loadu_si256((const __m256i *)in + 1);
+    r2 = _mm256_loadu_si256((const __m256i *)in + 2);
+    r3 = _mm256_loadu_si256((const __m256i *)in + 3);
+    IDEA_SPLIT(_mm256);
+    x0 = BSWAP16((v16hu)u0);
+    x1 = BSWAP16((v16hu)u1);
+    x2 = BSWAP16((v16hu)u2);
+    x3 = BSWAP16((v16hu)u3);
+    IDEA_VROUNDS(mul16, k);
+    r0 = (__m256i)BSWAP16(x0);
+    r1 = (__m256i)BSWAP16(x1);
+    r2 = (__m256i)BSWAP16(x2);
+    r3 = (__m256i)BSWAP16(x3);
+    IDEA_JOIN(_mm256);
+    _mm256_storeu_si256((__m256i *)out, r0);
+    _mm256_storeu_si256((__m256i *)out + 1, r1);
+    _mm256_storeu_si256((__m256i *)out + 2, r2);
+    _mm256_storeu_si256((__m256i *)out + 3, r3);
+  }
+  return d;
+}
+
+#endif /* IDEA_SIMD */
+
+/* One block of big-endian words through Idea()
+ */
+
+static void
+IdeaBlock(const ushort *ks, const uchar *in, uchar *out)
+{
+  ushort x[4], i;
+
+  for (i = 0; i < 4; i++)
+    x[i] = (ushort)(in[2 * i] << 8 | in[2 * i + 1]);
+  Idea(x, x, (ushort *)ks);
+  for (i = 0; i < 4; i++) {
+    out[2 * i] = (uchar)(x[i] >> 8);
+    out[2 * i + 1] = (uchar)x[i];
+  }
+}
+
+static void
+IdeaBlocks(const ushort *ks, const uchar *in, uchar *out, size_t n)
+{
+  size_t d;
+
+#ifdef IDEA_SIMD
+  if (n >= 16 && __builtin_cpu_supports("avx2")) {
+    d = Idea16(ks, in, out, n);
+    in += 8 * d; out += 8 * d; n -= d;
+  }
+  if (n >= 8 && __builtin_cpu_supports("sse2")) {
+    d = Idea8(ks, in, out, n);
+    in += 8 * d; out += 8 * d; n -= d;
+  }
+#endif
+  for (d = 0; d < n; d++)
+    IdeaBlock(ks, in + 8 * d, out + 8 * d);
+}
+
+void
+IdeaEncryptBlocks(const IdeaCtx *ctx, const uchar *in, uchar *out, size_t n)
+{
+  IdeaBlocks(ctx->ek, in, out, n);
+}
+
+void
+IdeaDecryptBlocks(const IdeaCtx *ctx, const uchar *in, uchar *out, size_t n)
+{
+  IdeaBlocks(ctx->dk, in, out, n);
+}
+
+/* CFB encryption chains every block through the previous one.
+ */
+
+void
+IdeaCfbEncrypt(const IdeaCtx *ctx, uchar *iv, const uchar *in, uchar *out,
+	       size_t n)
+{
+  uchar t[8];
+  int i;
+
+  for (; n; n--, in += 8, out += 8) {
+    IdeaBlock(ctx->ek, iv, t);
+    for (i = 0; i < 8; i++)
+      iv[i] = out[i] = t[i] ^ in[i];
+  }
+}
+
+/* CFB decryption only encrypts ciphertext that is already known, so
+ * it runs in batches: keystream for up to IDEA_CFB_BATCH blocks at a
+ * time from iv and in[0 .. n-2], then one xor pass.
+ */
+
+#define IDEA_CFB_BATCH 64
+
+void
+IdeaCfbDecrypt(const IdeaCtx *ctx, uchar *iv, const uchar *in, uchar *out,
+	       size_t n)
+{
+  uchar ks[IDEA_CFB_BATCH * 8];
+  size_t m, i;
+
+  while (n) {
+    m = n < IDEA_CFB_BATCH ? n : IDEA_CFB_BATCH;
+    memcpy(ks, iv, 8);
+    memcpy(ks + 8, in, 8 * (m - 1));
+    memcpy(iv, in + 8 * (m - 1), 8);
+    IdeaBlocks(ctx->ek, ks, ks, m);
+    for (i = 0; i < 8 * m; i++)
+      out[i] = ks[i] ^ in[i];
+    in += 8 * m; out += 8 * m; n -= m;
+  }
+}
@@ -0,0 +1,46 @@
+/* idea.h -- interface to idea.c
+ */
+
+#ifndef IDEA_H
+#define IDEA_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Both key schedules, expanded once by IdeaSetKey()
+ */
+typedef struct {
+  unsigned short ek[52];	/* encrypt key */
+  unsigned short dk[52];	/* decrypt key */
+} IdeaCtx;
+
+void Idea(unsigned short *in, unsigned short *out, unsigned short *ks);
+void ExpandUserKey(unsigned short *key, unsigned short *ks);
+void InvertIdeaKey(unsigned short *ks, unsigned short *ik);
+
+/* key is 16 bytes, read as 8 big-endian words
+ */
+void IdeaSetKey(IdeaCtx *ctx, const unsigned char *key);
+
+/* n consecutive 8-byte blocks; in may be the same as out
+ */
+void IdeaEncryptBlocks(const IdeaCtx *ctx, const unsigned char *in,
+		       unsigned char *out, size_t n);
+void IdeaDecryptBlocks(const IdeaCtx *ctx, const unsigned char *in,
+		       unsigned char *out, size_t n);
+
+/* 64-bit CFB over n blocks; iv is updated in place
+ */
+void IdeaCfbEncrypt(const IdeaCtx *ctx, unsigned char *iv,
+		    const unsigned char *in, unsigned char *out, size_t n);
+void IdeaCfbDecrypt(const IdeaCtx *ctx, unsigned char *iv,
+		    const unsigned char *in, unsigned char *out, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IDEA_H */
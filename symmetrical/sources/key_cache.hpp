@@ -0,0 +1,384 @@
+/*
+ *  key_cache.hpp:  a shared cache of expanded key schedules.
+ *
+ *  Some key schedules cost far more than encrypting a short message:
+ *  Blowfish runs 521 encryptions to fill its S-boxes and P-array, and
+ *  Twofish with full keying builds four key-dependent 1 KB tables.  A
+ *  server that sets up many short sessions under a working set of
+ *  recurring keys spends most of its time there.  key_cache<Cipher>
+ *  keeps recently used schedules and hands a copy back on a hit, so a
+ *  repeated key costs a table lookup and a memcpy.
+ *
+ *  Cipher is a BlockCipher<Impl> (block_cipher.hpp) or anything with the
+ *  same set_key/context/set_context face.  One cache serves one
+ *  algorithm and any number of threads.
+ *
+ *  Layout.  The cache is a fixed array of slots, allocated once and
+ *  never grown, so memory use is bounded by the size given to the
+ *  constructor.  Slots are grouped into sets of KEY_CACHE_WAYS; a key
+ *  may only live in the set picked by its hash, and when a set is full
+ *  its least recently used slot is replaced.  Recency is tracked in
+ *  epochs that advance on every miss, so a hit only writes its slot's
+ *  stamp the first time it is seen in a new epoch.
+ *
+ *  Concurrency.  Sets are divided among shards, each with a mutex that
+ *  only writers take.  Readers never lock: every slot carries a sequence
+ *  count that is odd while it is being written, and a reader that sees
+ *  it change while copying the slot out treats the lookup as a miss.
+ *  The slot contents are atomic words, so this is race-free in the C++
+ *  memory model.  On a miss the schedule is expanded outside any lock.
+ *
+ *  Keys.  Slots are found by SipHash-2-4 of the key under a secret drawn
+ *  from std::random_device and bound to the algorithm name, so peers
+ *  choosing keys cannot aim them all at one set.  A hit also compares
+ *  the stored key in full, so a hash collision can never return the
+ *  wrong schedule.  The cache holds raw keys and schedules: a replaced
+ *  slot is overwritten in full, and clear() and the destructor zero
+ *  every slot.
+ */
+
+#ifndef KEY_CACHE_HPP
+#define KEY_CACHE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <random>
+#include "block_cipher.hpp"
+
+/* default memory for slots, and default number of writer locks */
+#define KEY_CACHE_BYTES  (16u << 20)
+#define KEY_CACHE_SHARDS 64
+
+/* slots per set */
+#define KEY_CACHE_WAYS   8
+
+#define KEY_CACHE_ROTL(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+#define KEY_CACHE_SIPROUND(v0, v1, v2, v3)                                  \
+  do {                                                                      \
+    v0 += v1; v1 = KEY_CACHE_ROTL (v1, 13); v1 ^= v0;                       \
+    v0 = KEY_CACHE_ROTL (v0, 32);                                           \
+    v2 += v3; v3 = KEY_CACHE_ROTL (v3, 16); v3 ^= v2;                       \
+    v0 += v3; v3 = KEY_CACHE_ROTL (v3, 21); v3 ^= v0;                       \
+    v2 += v1; v1 = KEY_CACHE_ROTL (v1, 17); v1 ^= v2;                       \
+    v2 = KEY_CACHE_ROTL (v2, 32);                                           \
+  } while (0)
+
+/* SipHash-2-4 of m[0..len) under the key (k0, k1) */
+inline uint64_t key_cache_siphash (uint64_t k0, uint64_t k1,
+                                   const unsigned char *m, size_t len)
+{
+  uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+  uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+  uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+  uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+  uint64_t b = (uint64_t) len << 56;
+
+  for (; len >= 8; len -= 8, m += 8)
+    {
+      uint64_t w = 0;
+      for (int i = 7; i >= 0; i--)
+        w = w << 8 | m[i];
+      v3 ^= w;
+      KEY_CACHE_SIPROUND (v0, v1, v2, v3);
+      KEY_CACHE_SIPROUND (v0, v1, v2, v3);
+      v0 ^= w;
+    }
+  for (size_t i = 0; i < len; i++)
+    b |= (uint64_t) m[i] << (8 * i);
+
+  v3 ^= b;
+  KEY_CACHE_SIPROUND (v0, v1, v2, v3);
+  KEY_CACHE_SIPROUND (v0, v1, v2, v3);
+  v0 ^= b;
+  v2 ^= 0xff;
+  for (int i = 0; i < 4; i++)
+    KEY_CACHE_SIPROUND (v0, v1, v2, v3);
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+template <class Cipher>
+class key_cache
+{
+public:
+  typedef typename Cipher::context_type context_type;
+
+  struct statistics
+  {
+    uint64_t hits, misses, evictions;
+    size_t   entries, capacity;
+
+    double hit_rate () const
+    {
+      return hits + misses ? (double) hits / (double) (hits + misses) : 0.0;
+    }
+  };
+
+  /*
+   * max_bytes bounds the slot array (at least one set is always made);
+   * shards is the number of writer locks, capped at the number of sets.
+   */
+  explicit key_cache (size_t max_bytes = KEY_CACHE_BYTES,
+                      unsigned int shards = KEY_CACHE_SHARDS);
+  ~key_cache ();
+
+  key_cache (const key_cache &) = delete;
+  key_cache &operator= (const key_cache &) = delete;
+
+  /*
+   * Put the schedule for key into out: copied from the cache on a hit,
+   * expanded with out.set_key and cached on a miss.  Returns false,
+   * caching nothing, if out.set_key rejects the key.
+   */
+  bool get (const unsigned char *key, size_t len, Cipher &out);
+
+  /* zero and drop every cached schedule */
+  void clear ();
+
+  /* counters since construction; entries is a snapshot */
+  statistics stats () const;
+
+  size_t capacity () const { return nslots; }
+
+private:
+  /* a slot holds the key length, the key, then the schedule */
+  static constexpr size_t KEY_WORDS = 1 + (Cipher::MAX_KEYLENGTH + 7) / 8;
+  static constexpr size_t CTX_WORDS = (sizeof (context_type) + 7) / 8;
+
+  struct alignas (64) slot
+  {
+    std::atomic<uint32_t> seq;     /* odd while a writer is changing it */
+    std::atomic<uint64_t> stamp;   /* epoch of the last use */
+    std::atomic<uint64_t> tag;     /* keyed hash of the key, 0 if empty */
+    std::atomic<uint64_t> words[KEY_WORDS + CTX_WORDS];
+  };
+
+  struct alignas (64) shard
+  {
+    std::mutex            lock;    /* taken by writers only */
+    std::atomic<uint64_t> hits, misses, evictions;
+  };
+
+  uint64_t hash (const uint64_t *kw) const;
+  bool read (const slot &s, uint64_t tag, const uint64_t *kw,
+             context_type &ctx) const;
+  void write (slot &s, uint64_t tag, const uint64_t *kw,
+              const context_type *ctx);
+  void insert (shard &sh, slot *set, uint64_t tag, const uint64_t *kw,
+               const context_type &ctx);
+
+  std::unique_ptr<slot[]>  slots;
+  std::unique_ptr<shard[]> shards;
+  size_t                   nslots, nsets, nshards;
+  uint64_t                 secret[2];
+  std::atomic<uint64_t>    epoch;
+};
+
+template <class Cipher>
+key_cache<Cipher>::key_cache (size_t max_bytes, unsigned int nshard)
+  : epoch (0)
+{
+  nsets = max_bytes / sizeof (slot) / KEY_CACHE_WAYS;
+  if (nsets == 0)
+    nsets = 1;
+  if (nsets > 0xffffffff)
+    nsets = 0xffffffff;
+  nslots = nsets * KEY_CACHE_WAYS;
+  nshards = nshard == 0 ? 1 : nshard < nsets ? nshard : nsets;
+
+  slots.reset (new slot[nslots] ());
+  shards.reset (new shard[nshards] ());
+
+  std::random_device rd;
+  uint64_t s0 = (uint64_t) rd () << 32 | rd ();
+  uint64_t s1 = (uint64_t) rd () << 32 | rd ();
+  const char *n = Cipher::name ();
+  secret[0] = key_cache_siphash (s0, s1, (const unsigned char *) n, strlen (n));
+  secret[1] = key_cache_siphash (s1, s0, (const unsigned char *) n, strlen (n));
+  block_cipher_wipe (&s0, sizeof (s0));
+  block_cipher_wipe (&s1, sizeof (s1));
+}
+
+template <class Cipher>
+key_cache<Cipher>::~key_cache ()
+{
+  block_cipher_wipe (slots.get (), nslots * sizeof (slot));
+  block_cipher_wipe (secret, sizeof (secret));
+}
+
+template <class Cipher>
+uint64_t key_cache<Cipher>::hash (const uint64_t *kw) const
+{
+  uint64_t h = key_cache_siphash (secret[0], secret[1],
+                                  (const unsigned char *) kw,
+                                  KEY_WORDS * sizeof (uint64_t));
+  return h | 1;                                 /* 0 marks an empty slot */
+}
+
+/* copy s out if it still holds kw; false if it does not or was changing */
+template <class Cipher>
+bool key_cache<Cipher>::read (const slot &s, uint64_t tag,
+                              const uint64_t *kw, context_type &ctx) const
+{
+  uint32_t seq = s.seq.load (std::memory_order_acquire);
+  if (seq & 1)
+    return false;
+
+  uint64_t diff = s.tag.load (std::memory_order_relaxed) ^ tag;
+  for (size_t i = 0; i < KEY_WORDS; i++)
+    diff |= s.words[i].load (std::memory_order_relaxed) ^ kw[i];
+
+  unsigned char *p = reinterpret_cast<unsigned char *> (&ctx);
+  for (size_t i = 0; i < CTX_WORDS; i++)
+    {
+      uint64_t w = s.words[KEY_WORDS + i].load (std::memory_order_relaxed);
+      size_t n = sizeof (ctx) - 8 * i < 8 ? sizeof (ctx) - 8 * i : 8;
+      memcpy (p + 8 * i, &w, n);
+    }
+
+  std::atomic_thread_fence (std::memory_order_acquire);
+  return diff == 0 && s.seq.load (std::memory_order_relaxed) == seq;
+}
+
+/* fill s with (tag, kw, ctx), or zero it if ctx is null; shard lock held */
+template <class Cipher>
+void key_cache<Cipher>::write (slot &s, uint64_t tag, const uint64_t *kw,
+                               const context_type *ctx)
+{
+  const unsigned char *p = reinterpret_cast<const unsigned char *> (ctx);
+  uint32_t seq = s.seq.load (std::memory_order_relaxed);
+
+  s.seq.store (seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence (std::memory_order_release);
+
+  s.tag.store (ctx ? tag : 0, std::memory_order_relaxed);
+  for (size_t i = 0; i < KEY_WORDS; i++)
+    s.words[i].store (ctx ? kw[i] : 0, std::memory_order_relaxed);
+  for (size_t i = 0; i < CTX_WORDS; i++)
+    {
+      uint64_t w = 0;
+      if (ctx)
+        memcpy (&w, p + 8 * i,
+                sizeof (*ctx) - 8 * i < 8 ? sizeof (*ctx) - 8 * i : 8);
+      s.words[KEY_WORDS + i].store (w, std::memory_order_relaxed);
+    }
+  s.stamp.store (epoch.load (std::memory_order_relaxed),
+                 std::memory_order_relaxed);
+
+  s.seq.store (seq + 2, std::memory_order_release);
+}
+
+template <class Cipher>
+void key_cache<Cipher>::insert (shard &sh, slot *set, uint64_t tag,
+                                const uint64_t *kw, const context_type &ctx)
+{
+  std::lock_guard<std::mutex> guard (sh.lock);
+
+  /* another thread may have cached the same key while we expanded it */
+  size_t victim = 0;
+  for (size_t w = 0; w < KEY_CACHE_WAYS; w++)
+    {
+      uint64_t t = set[w].tag.load (std::memory_order_relaxed);
+      if (t == tag)
+        {
+          uint64_t diff = 0;
+          for (size_t i = 0; i < KEY_WORDS; i++)
+            diff |= set[w].words[i].load (std::memory_order_relaxed) ^ kw[i];
+          if (diff == 0)
+            return;
+        }
+      if (t == 0)
+        {
+          victim = w;
+          break;
+        }
+      if (set[w].stamp.load (std::memory_order_relaxed)
+          < set[victim].stamp.load (std::memory_order_relaxed))
+        victim = w;
+    }
+
+  if (set[victim].tag.load (std::memory_order_relaxed) != 0)
+    sh.evictions.fetch_add (1, std::memory_order_relaxed);
+  write (set[victim], tag, kw, &ctx);
+}
+
+template <class Cipher>
+bool key_cache<Cipher>::get (const unsigned char *key, size_t len,
+                             Cipher &out)
+{
+  if (len > Cipher::MAX_KEYLENGTH)
+    return false;
+
+  uint64_t kw[KEY_WORDS] = { len };
+  memcpy (kw + 1, key, len);
+
+  uint64_t tag = hash (kw);
+  size_t n = (size_t) (((tag >> 32) * nsets) >> 32);
+  slot *set = &slots[n * KEY_CACHE_WAYS];
+  shard &sh = shards[n % nshards];
+
+  for (size_t w = 0; w < KEY_CACHE_WAYS; w++)
+    {
+      if (set[w].tag.load (std::memory_order_relaxed) != tag)
+        continue;
+      context_type ctx;
+      bool hit = read (set[w], tag, kw, ctx);
+      if (hit)
+        {
+          out.set_context (ctx);
+          uint64_t e = epoch.load (std::memory_order_relaxed);
+          if (set[w].stamp.load (std::memory_order_relaxed) != e)
+            set[w].stamp.store (e, std::memory_order_relaxed);
+          sh.hits.fetch_add (1, std::memory_order_relaxed);
+        }
+      block_cipher_wipe (&ctx, sizeof (ctx));
+      if (hit)
+        {
+          block_cipher_wipe (kw, sizeof (kw));
+          return true;
+        }
+      break;
+    }
+
+  sh.misses.fetch_add (1, std::memory_order_relaxed);
+  epoch.fetch_add (1, std::memory_order_relaxed);
+
+  bool ok = out.set_key (key, len);
+  if (ok)
+    insert (sh, set, tag, kw, out.context ());
+  block_cipher_wipe (kw, sizeof (kw));
+  return ok;
+}
+
+template <class Cipher>
+void key_cache<Cipher>::clear ()
+{
+  for (size_t i = 0; i < nshards; i++)
+    {
+      std::lock_guard<std::mutex> guard (shards[i].lock);
+      for (size_t n = i; n < nsets; n += nshards)
+        for (size_t w = 0; w < KEY_CACHE_WAYS; w++)
+          write (slots[n * KEY_CACHE_WAYS + w], 0, 0, 0);
+    }
+}
+
+template <class Cipher>
+typename key_cache<Cipher>::statistics key_cache<Cipher>::stats () const
+{
+  statistics st = { 0, 0, 0, 0, nslots };
+  for (size_t i = 0; i < nshards; i++)
+    {
+      st.hits += shards[i].hits.load (std::memory_order_relaxed);
+      st.misses += shards[i].misses.load (std::memory_order_relaxed);
+      st.evictions += shards[i].evictions.load (std::memory_order_relaxed);
+    }
+  for (size_t i = 0; i < nslots; i++)
+    st.entries += slots[i].tag.load (std::memory_order_relaxed) != 0;
+  return st;
+}
+
+#endif /* KEY_CACHE_HPP */
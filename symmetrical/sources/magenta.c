@@ -37,62 +37,72 @@ Mean:         8708 cycles =     2.9 mbits/sec
 
 #define LARGE_TABLES
 
-#include "../std_defs.h"
+#include <string.h>
+#include "magenta.h"
 
 static char *alg_name[] = { "magenta", "magenta.c", "magenta" };
 
-char **cipher_name()
+char **magenta_cipher_name(void)
 {
     return alg_name;
 }
 
 #define GF_POLY 0x0165;
 
-u4byte  k_len;
-u4byte  l_key[16];  /* storage for the key schedule         */
-
-u1byte  f_tab[256];
-u4byte  tab_init = 0;
+/* f_tab[i] is alpha^i in GF(2^8) modulo GF_POLY for i < 255 with  */
+/* f_tab[255] = 0. The table is fixed rather than built on first    */
+/* use so that key setup on several threads at once is safe.        */
+
+#define f_data(w) \
+    w(0x01), w(0x02), w(0x04), w(0x08), w(0x10), w(0x20), w(0x40), w(0x80), \
+    w(0x65), w(0xca), w(0xf1), w(0x87), w(0x6b), w(0xd6), w(0xc9), w(0xf7), \
+    w(0x8b), w(0x73), w(0xe6), w(0xa9), w(0x37), w(0x6e), w(0xdc), w(0xdd), \
+    w(0xdf), w(0xdb), w(0xd3), w(0xc3), w(0xe3), w(0xa3), w(0x23), w(0x46), \
+    w(0x8c), w(0x7d), w(0xfa), w(0x91), w(0x47), w(0x8e), w(0x79), w(0xf2), \
+    w(0x81), w(0x67), w(0xce), w(0xf9), w(0x97), w(0x4b), w(0x96), w(0x49), \
+    w(0x92), w(0x41), w(0x82), w(0x61), w(0xc2), w(0xe1), w(0xa7), w(0x2b), \
+    w(0x56), w(0xac), w(0x3d), w(0x7a), w(0xf4), w(0x8d), w(0x7f), w(0xfe), \
+    w(0x99), w(0x57), w(0xae), w(0x39), w(0x72), w(0xe4), w(0xad), w(0x3f), \
+    w(0x7e), w(0xfc), w(0x9d), w(0x5f), w(0xbe), w(0x19), w(0x32), w(0x64), \
+    w(0xc8), w(0xf5), w(0x8f), w(0x7b), w(0xf6), w(0x89), w(0x77), w(0xee), \
+    w(0xb9), w(0x17), w(0x2e), w(0x5c), w(0xb8), w(0x15), w(0x2a), w(0x54), \
+    w(0xa8), w(0x35), w(0x6a), w(0xd4), w(0xcd), w(0xff), w(0x9b), w(0x53), \
+    w(0xa6), w(0x29), w(0x52), w(0xa4), w(0x2d), w(0x5a), w(0xb4), w(0x0d), \
+    w(0x1a), w(0x34), w(0x68), w(0xd0), w(0xc5), w(0xef), w(0xbb), w(0x13), \
+    w(0x26), w(0x4c), w(0x98), w(0x55), w(0xaa), w(0x31), w(0x62), w(0xc4), \
+    w(0xed), w(0xbf), w(0x1b), w(0x36), w(0x6c), w(0xd8), w(0xd5), w(0xcf), \
+    w(0xfb), w(0x93), w(0x43), w(0x86), w(0x69), w(0xd2), w(0xc1), w(0xe7), \
+    w(0xab), w(0x33), w(0x66), w(0xcc), w(0xfd), w(0x9f), w(0x5b), w(0xb6), \
+    w(0x09), w(0x12), w(0x24), w(0x48), w(0x90), w(0x45), w(0x8a), w(0x71), \
+    w(0xe2), w(0xa1), w(0x27), w(0x4e), w(0x9c), w(0x5d), w(0xba), w(0x11), \
+    w(0x22), w(0x44), w(0x88), w(0x75), w(0xea), w(0xb1), w(0x07), w(0x0e), \
+    w(0x1c), w(0x38), w(0x70), w(0xe0), w(0xa5), w(0x2f), w(0x5e), w(0xbc), \
+    w(0x1d), w(0x3a), w(0x74), w(0xe8), w(0xb5), w(0x0f), w(0x1e), w(0x3c), \
+    w(0x78), w(0xf0), w(0x85), w(0x6f), w(0xde), w(0xd9), w(0xd7), w(0xcb), \
+    w(0xf3), w(0x83), w(0x63), w(0xc6), w(0xe9), w(0xb7), w(0x0b), w(0x16), \
+    w(0x2c), w(0x58), w(0xb0), w(0x05), w(0x0a), w(0x14), w(0x28), w(0x50), \
+    w(0xa0), w(0x25), w(0x4a), w(0x94), w(0x4d), w(0x9a), w(0x51), w(0xa2), \
+    w(0x21), w(0x42), w(0x84), w(0x6d), w(0xda), w(0xd1), w(0xc7), w(0xeb), \
+    w(0xb3), w(0x03), w(0x06), w(0x0c), w(0x18), w(0x30), w(0x60), w(0xc0), \
+    w(0xe5), w(0xaf), w(0x3b), w(0x76), w(0xec), w(0xbd), w(0x1f), w(0x3e), \
+    w(0x7c), w(0xf8), w(0x95), w(0x4f), w(0x9e), w(0x59), w(0xb2), w(0x00)
+
+#define f0(x)   (x)
+#define f1(x)   ((u4byte)(x) <<  8)
+#define f2(x)   ((u4byte)(x) << 16)
+#define f3(x)   ((u4byte)(x) << 24)
+
+static const u1byte f_tab[256] = { f_data(f0) };
 
 #ifdef  LARGE_TABLES
-u4byte  fl_tab[4][256];
-#endif
-
-void init_tab(void)
-{   u4byte  i, f;
-
-    f = 1;
-
-    for(i = 0; i < 255; ++i)
-    {
-        f_tab[i] = (u1byte)f; 
-        
-#ifdef  LARGE_TABLES
-        fl_tab[0][i] = f;
-        fl_tab[1][i] = f <<  8;
-        fl_tab[2][i] = f << 16;
-        fl_tab[3][i] = f << 24;
-#endif
-
-        f <<= 1;
-
-        if(f & 0x100)
-
-            f ^= GF_POLY;
-    }
-
-    f_tab[255] = 0;
-
-#ifdef  LARGE_TABLES
-    fl_tab[0][255] = fl_tab[1][255] = 0;
-    fl_tab[2][255] = fl_tab[3][255] = 0;
-#endif
-
+static const u4byte fl_tab[4][256] =
+{   { f_data(f0) }, { f_data(f1) }, { f_data(f2) }, { f_data(f3) }
 };
+#endif
 
 #ifdef  LARGE_TABLES
 
-void pi_fun(u4byte y[4], const u4byte x[4])
+static void pi_fun(u4byte y[4], const u4byte x[4])
 {
     y[0] = fl_tab[0][byte(x[0],0) ^ f_tab[byte(x[2],0)]]
          | fl_tab[1][byte(x[2],0) ^ f_tab[byte(x[0],0)]]
@@ -117,7 +127,7 @@ void pi_fun(u4byte y[4], const u4byte x[4])
 
 #else
 
-void pi_fun(u4byte y[4], const u4byte x[4])
+static void pi_fun(u4byte y[4], const u4byte x[4])
 {
     y[0] =  f_tab[byte(x[0],0) ^ f_tab[byte(x[2],0)]]
          | (f_tab[byte(x[2],0) ^ f_tab[byte(x[0],0)]] <<  8)
@@ -142,7 +152,7 @@ void pi_fun(u4byte y[4], const u4byte x[4])
 
 #endif
 
-void e3_fun(u4byte x[4])
+static void e3_fun(u4byte x[4])
 {   u4byte  u[4],v[4];
 
     u[0] = x[0]; u[1] = x[1]; u[2] = x[2]; u[3] = x[3];
@@ -177,16 +187,10 @@ void e3_fun(u4byte x[4])
 
 /* initialise the key schedule from the user supplied key   */
 
-u4byte *set_key(const u4byte in_key[], const u4byte key_len)
-{
-    if(!tab_init)
-    {
-        init_tab(); tab_init = 1;
-    }
-
-    k_len = (key_len + 63) / 64;
+u4byte *magenta_set_key(magenta_ctx *ctx, const u4byte in_key[], const u4byte key_len)
+{   u4byte  *l_key = ctx->l_key;
 
-    switch(k_len)
+    switch(ctx->k_len = (key_len + 63) / 64)
     {
         case 2:
             l_key[ 0] = in_key[0]; l_key[ 1] = in_key[1]; 
@@ -226,8 +230,9 @@ u4byte *set_key(const u4byte in_key[], const u4byte key_len)
 
 /* encrypt a block of text  */
 
-void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{   u4byte  blk[4], tt[4];
+void magenta_encrypt(const magenta_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{   const u4byte *l_key = ctx->l_key;
+    u4byte  blk[4], tt[4];
 
     blk[0] = in_blk[0]; blk[1] = in_blk[1];
     blk[2] = in_blk[2]; blk[3] = in_blk[3];
@@ -241,7 +246,7 @@ void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
     r_fun(blk, blk + 2, l_key +  8);
     r_fun(blk + 2, blk, l_key + 10);
 
-    if(k_len == 4)
+    if(ctx->k_len == 4)
     {
         r_fun(blk, blk + 2, l_key + 12);
         r_fun(blk + 2, blk, l_key + 14);
@@ -253,8 +258,9 @@ void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
 
 /* decrypt a block of text  */
 
-void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{   u4byte  blk[4], tt[4];
+void magenta_decrypt(const magenta_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{   const u4byte *l_key = ctx->l_key;
+    u4byte  blk[4], tt[4];
 
     blk[2] = in_blk[0]; blk[3] = in_blk[1];
     blk[0] = in_blk[2]; blk[1] = in_blk[3];
@@ -268,7 +274,7 @@ void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
     r_fun(blk, blk + 2, l_key +  8);
     r_fun(blk + 2, blk, l_key + 10);
 
-    if(k_len == 4)
+    if(ctx->k_len == 4)
     {
         r_fun(blk, blk + 2, l_key + 12);
         r_fun(blk + 2, blk, l_key + 14);
@@ -277,3 +283,28 @@ void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
     out_blk[2] = blk[0]; out_blk[3] = blk[1];
     out_blk[0] = blk[2]; out_blk[1] = blk[3];
 };
+
+/* encrypt n_blk consecutive blocks of text held in byte buffers that */
+/* need not be word aligned; in_blk may be the same as out_blk        */
+
+void magenta_encrypt_blocks(const magenta_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{   u4byte  b_in[4], b_out[4];
+
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+    {
+        memcpy(b_in, in_blk, 16); magenta_encrypt(ctx, b_in, b_out);
+        memcpy(out_blk, b_out, 16);
+    }
+};
+
+/* decrypt n_blk consecutive blocks of text                          */
+
+void magenta_decrypt_blocks(const magenta_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{   u4byte  b_in[4], b_out[4];
+
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+    {
+        memcpy(b_in, in_blk, 16); magenta_decrypt(ctx, b_in, b_out);
+        memcpy(out_blk, b_out, 16);
+    }
+};
@@ -0,0 +1,33 @@
+
+/* Magenta with the key schedule held in a caller supplied          */
+/* context (see magenta.c). A context may be shared by any number   */
+/* of threads once its key has been set.                            */
+
+#ifndef _MAGENTA_H
+#define _MAGENTA_H
+
+#include "../std_defs.h"
+#include <stddef.h>
+#include "cache_align.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{   CACHE_ALIGN u4byte  l_key[16];  /* storage for the key schedule */
+    u4byte  k_len;
+} magenta_ctx;
+
+char    **magenta_cipher_name(void);
+u4byte  *magenta_set_key(magenta_ctx *ctx, const u4byte in_key[], const u4byte key_len);
+void    magenta_encrypt(const magenta_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    magenta_decrypt(const magenta_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    magenta_encrypt_blocks(const magenta_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+void    magenta_decrypt_blocks(const magenta_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
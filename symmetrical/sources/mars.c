@@ -33,11 +33,12 @@ Mean:          377 cycles =    68.0 mbits/sec
 
 */
 
-#include "../std_defs.h"
+#include <string.h>
+#include "mars.h"
 
 static char *alg_name[] = { "mars", "mars6.c" };
 
-char **cipher_name()
+char **mars_cipher_name(void)
 {
 	return alg_name;
 }
@@ -175,14 +176,12 @@ static u4byte s_box[] =
 	0xab561187, 0x14eea0f0, 0xdf0d4164, 0x19af70ee
 };
 
-static u4byte vk[47] =
+static u4byte vk[7] =
 { 
 	0x09d0c479, 0x28c8ffe0, 0x84aa6c39, 0x9dad7287, 0x7dff9be3, 0xd4268361,
 	0xc96da1d4
 };
 
-static u4byte	l_key[40];
-
 #define f_mix(a,b,c,d)					\
 		r = rotr(a, 8); 				\
 		b ^= s_box[a & 255];			\
@@ -242,7 +241,7 @@ static u4byte	l_key[40];
 /* Halevi of IBM for the neat trick (which I missed) of finding */
 /* the '0' and '1' sequences at the same time.					*/
 
-u4byte gen_mask(u4byte x)
+static u4byte gen_mask(u4byte x)
 {	u4byte	m;
 
 	/* if m{bn} stands for bit number bn of m, set m{bn} = 1 if */
@@ -281,14 +280,19 @@ u4byte gen_mask(u4byte x)
 	return m & 0xfffffffc;
 };
 
-u4byte *set_key(const u4byte in_key[], const u4byte key_len)
-{	u4byte	i, j, m, u, w, *t = vk + 7;
+u4byte *mars_set_key(mars_ctx *ctx, const u4byte in_key[], const u4byte key_len)
+{	u4byte *l_key = ctx->l_key;
+	u4byte	i, j, m, u, w, lk[47], *t = lk + 7;
+
+	for(i = 0; i < 7; ++i)
+
+		lk[i] = vk[i];
 
 	m = key_len / 32 - 1;
 
 	for(i = j = 0; i < 39; ++i)
 	{
-	  u = t[i - 7] ^ t[i - 2]; t[i] = rotl(u, 3) ^ in_key[j] ^ i;
+	  u = lk[i] ^ lk[i + 5]; lk[i + 7] = rotl(u, 3) ^ in_key[j] ^ i;
 	  j = (j == m ? 0 : j + 1);
 	}
 
@@ -328,8 +332,9 @@ u4byte *set_key(const u4byte in_key[], const u4byte key_len)
 	return l_key;
 };
 
-void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{	u4byte	a, b, c, d, l, m, r;
+void mars_encrypt(const mars_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{	const u4byte *l_key = ctx->l_key;
+	u4byte	a, b, c, d, l, m, r;
 
 	a = in_blk[0] + l_key[0]; b = in_blk[1] + l_key[1];
 	c = in_blk[2] + l_key[2]; d = in_blk[3] + l_key[3];
@@ -361,8 +366,9 @@ void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
 	out_blk[2] = c - l_key[38]; out_blk[3] = d - l_key[39];
 };
 
-void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{	u4byte	a, b, c, d, l, m, r;
+void mars_decrypt(const mars_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{	const u4byte *l_key = ctx->l_key;
+	u4byte	a, b, c, d, l, m, r;
 	
 	d = in_blk[0] + l_key[36]; c = in_blk[1] + l_key[37];
 	b = in_blk[2] + l_key[38]; a = in_blk[3] + l_key[39];
@@ -394,3 +400,27 @@ void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
 	out_blk[2] = b - l_key[2]; out_blk[3] = a - l_key[3];
 }
 
+/* encrypt n_blk consecutive blocks of text held in byte buffers that */
+/* need not be word aligned; in_blk may be the same as out_blk        */
+
+void mars_encrypt_blocks(const mars_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{	u4byte	b_in[4], b_out[4];
+
+	for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+	{
+		memcpy(b_in, in_blk, 16); mars_encrypt(ctx, b_in, b_out);
+		memcpy(out_blk, b_out, 16);
+	}
+};
+
+/* decrypt n_blk consecutive blocks of text                          */
+
+void mars_decrypt_blocks(const mars_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{	u4byte	b_in[4], b_out[4];
+
+	for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+	{
+		memcpy(b_in, in_blk, 16); mars_decrypt(ctx, b_in, b_out);
+		memcpy(out_blk, b_out, 16);
+	}
+};
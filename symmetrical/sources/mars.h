@@ -0,0 +1,32 @@
+
+/* MARS with the key schedule held in a caller supplied             */
+/* context (see mars.c). A context may be shared by any number      */
+/* of threads once its key has been set.                            */
+
+#ifndef _MARS_H
+#define _MARS_H
+
+#include "../std_defs.h"
+#include <stddef.h>
+#include "cache_align.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{   CACHE_ALIGN u4byte  l_key[40];  /* storage for the key schedule */
+} mars_ctx;
+
+char    **mars_cipher_name(void);
+u4byte  *mars_set_key(mars_ctx *ctx, const u4byte in_key[], const u4byte key_len);
+void    mars_encrypt(const mars_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    mars_decrypt(const mars_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    mars_encrypt_blocks(const mars_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+void    mars_decrypt_blocks(const mars_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
@@ -15,13 +15,183 @@
  *
  */
 
+#include <string.h>
+#include "misty1.h"
 
+/*
+ * FI with its S-boxes folded into lookup tables.  The first half of FI,
+ * before the key is mixed in, is
+ *   d9 = S9[x >> 7] ^ (x & 0x7f);  d7 = S7[x & 0x7f] ^ (d9 & 0x7f);
+ * which, packed as (d7 << 9) | d9, is fi7[x & 0x7f] ^ fi9[x >> 7] with
+ *   fi7[i] = ((S7[i] ^ i) << 9) | i
+ *   fi9[j] = ((S9[j] & 0x7f) << 9) | S9[j].
+ * The key then xors in as a whole 16-bit word t, and the last step,
+ * d9 = S9[t & 0x1ff] ^ (t >> 9) with d7 left in place, is
+ *   t ^ s9x[t & 0x1ff] ^ (t >> 9)   with   s9x[j] = S9[j] ^ j.
+ * All three tables together fit in 2.3KB.
+ */
+static const unsigned short fi7[128] = {
+  0x3600, 0x6601, 0x6202, 0xb203, 0x7e04, 0x2a05, 0x2206, 0xa607,
+  0xa608, 0x2609, 0xf00a, 0xf00b, 0xce0c, 0x420d, 0xd00e, 0x8c0f,
+  0x1e10, 0x6a11, 0x0212, 0xfe13, 0x4614, 0x7615, 0x5216, 0xba17,
+  0x8a18, 0x2c19, 0xb41a, 0x9a1b, 0x721c, 0x981d, 0x041e, 0x361f,
+  0x5620, 0xce21, 0x0422, 0x5c23, 0xbe24, 0x2025, 0xc426, 0xca27,
+  0x0628, 0x6e29, 0xd62a, 0x7e2b, 0xce2c, 0xa82d, 0x762e, 0x802f,
+  0x7c30, 0xc831, 0x7632, 0x0a33, 0x8034, 0x7235, 0xa236, 0xc837,
+  0x2038, 0x6639, 0x883a, 0x063b, 0x7c3c, 0x743d, 0xbc3e, 0x2c3f,
+  0xb240, 0xa641, 0x4e42, 0xd843, 0xe844, 0xf845, 0x9c46, 0x5e47,
+  0x2e48, 0x6249, 0xc04a, 0x0e4b, 0x504c, 0x104d, 0x764e, 0xe44f,
+  0x1250, 0x3251, 0xa252, 0x0853, 0x5054, 0x3455, 0x6856, 0xd657,
+  0x8a58, 0xf059, 0x085a, 0xf85b, 0x6c5c, 0x5a5d, 0x265e, 0xca5f,
+  0xc260, 0x1861, 0x1862, 0x0063, 0xf864, 0x2465, 0x8a66, 0xc467,
+  0x9c68, 0x3e69, 0xd46a, 0xb46b, 0x826c, 0x2e6d, 0x226e, 0x1c6f,
+  0x4070, 0xa671, 0xc672, 0xea73, 0x6674, 0xc675, 0x4876, 0x7277,
+  0x1278, 0x8e79, 0x267a, 0x707b, 0x907c, 0x427d, 0x4c7e, 0x047f
+};
 
+static const unsigned short fi9[512] = {
+  0x87c3, 0x96cb, 0xa753, 0x3f9f, 0xc7e3, 0xd2e9, 0xf6fb, 0x6a35,
+  0x0381, 0x72b9, 0x2f17, 0xd7eb, 0x6733, 0x1209, 0x5a2d, 0xa6d3,
+  0x8ec7, 0x954a, 0x6e37, 0xfc7e, 0xd6eb, 0xc964, 0x2793, 0xb1d8,
+  0x46a3, 0x3d1e, 0xaa55, 0x582c, 0x3a1d, 0x45a2, 0xc763, 0x3118,
+  0x974b, 0xa552, 0xa5d2, 0x1e0f, 0x562b, 0x6030, 0x753a, 0xcae5,
+  0x2311, 0x7138, 0x1d8e, 0xc663, 0xc6e3, 0x90c8, 0xe9f4, 0x361b,
+  0x0201, 0x3a9d, 0xf0f8, 0x41a0, 0xdb6d, 0xe7f3, 0x381c, 0x8d46,
+  0xfa7d, 0xa2d1, 0x0482, 0xd5ea, 0x0783, 0x5b2d, 0xe8f4, 0x3d9e,
+  0xa7d3, 0xbadd, 0xc5e2, 0x5128, 0xc1e0, 0xd8ec, 0xb259, 0x2291,
+  0x2211, 0x5f2f, 0x4c26, 0xb8dc, 0x60b0, 0x198c, 0x1f0f, 0xeff7,
+  0xcee7, 0xd96c, 0x6cb6, 0xf2f9, 0xb0d8, 0xa351, 0x0301, 0x994c,
+  0x0703, 0x70b8, 0xa954, 0x572b, 0x5dae, 0x2e17, 0xe271, 0x180c,
+  0x8e47, 0xb058, 0xfe7f, 0x49a4, 0x6934, 0x5329, 0x0884, 0xbb5d,
+  0x3b9d, 0x65b2, 0x47a3, 0x9048, 0xf87c, 0xa251, 0x95ca, 0x4623,
+  0x7b3d, 0x4fa7, 0xcb65, 0x763b, 0x8442, 0xb4da, 0x2592, 0x9cce,
+  0x82c1, 0xd66b, 0x3e9f, 0xe3f1, 0x592c, 0x0984, 0xf4fa, 0x2d96,
+  0xc3e1, 0xd369, 0xfb7d, 0x6231, 0x0180, 0x150a, 0x2894, 0xb5da,
+  0x0d86, 0x7d3e, 0x391c, 0xc060, 0xeb75, 0x9fcf, 0xce67, 0x3319,
+  0xca65, 0xd068, 0x3299, 0xa150, 0x1008, 0x0e07, 0xf97c, 0x6eb7,
+  0x4824, 0x3219, 0xbcde, 0x4f27, 0xb6db, 0xc8e4, 0x53a9, 0xa452,
+  0x1309, 0x2090, 0x399c, 0x83c1, 0x5028, 0x67b3, 0x6b35, 0xd56a,
+  0xed76, 0xbedf, 0xcbe5, 0x1188, 0x8ac5, 0xdd6e, 0xbdde, 0x63b1,
+  0x86c3, 0xbfdf, 0x6c36, 0xdcee, 0xddee, 0xe0f0, 0x2693, 0x9249,
+  0x349a, 0x6db6, 0xd269, 0x0281, 0x4b25, 0x160b, 0xbc5e, 0x68b4,
+  0x9349, 0x8fc7, 0xe974, 0x7c3e, 0x773b, 0x6fb7, 0x1c8e, 0x8dc6,
+  0x5cae, 0x2010, 0x2a95, 0xdfef, 0x9c4e, 0xe4f2, 0xfbfd, 0x0a85,
+  0xfafd, 0xecf6, 0x40a0, 0xdf6f, 0x0683, 0x148a, 0xad56, 0x369b,
+  0x793c, 0x0f07, 0xcf67, 0x3098, 0xa1d0, 0xd3e9, 0x0603, 0xfdfe,
+  0x7abd, 0x4522, 0x1289, 0xa4d2, 0x1f8f, 0x2412, 0x6633, 0xd46a,
+  0x8542, 0xdaed, 0xe170, 0x371b, 0xc4e2, 0x9f4f, 0xb158, 0x6331,
+  0x8f47, 0xba5d, 0x2713, 0x9bcd, 0xf279, 0xc361, 0x4ba5, 0xf379,
+  0x3c9e, 0x69b4, 0x98cc, 0x4422, 0x6532, 0x341a, 0xd0e8, 0x0804,
+  0x0f87, 0xdbed, 0x2f97, 0x7239, 0x7fbf, 0xafd7, 0x4e27, 0x178b,
+  0x8cc6, 0x389c, 0xa0d0, 0x9d4e, 0xd86c, 0x6834, 0xe5f2, 0xdc6e,
+  0x94ca, 0x4a25, 0x74ba, 0x2391, 0xfcfe, 0x2613, 0x0d06, 0x5e2f,
+  0x5bad, 0xe572, 0xb7db, 0x80c0, 0x170b, 0xadd6, 0xeaf5, 0xd9ec,
+  0x1b0d, 0xec76, 0x2914, 0x57ab, 0xea75, 0x190c, 0xc9e4, 0xb359,
+  0xa854, 0x3f1f, 0x964b, 0x88c4, 0x7dbe, 0xeef7, 0x5229, 0x48a4,
+  0x1c0e, 0xe1f0, 0xee77, 0x9a4d, 0xf57a, 0x0c86, 0x168b, 0x66b3,
+  0xe371, 0x7ebf, 0x1d0e, 0x0904, 0x2e97, 0xb75b, 0xc160, 0xd168,
+  0xaed7, 0x76bb, 0xcc66, 0x9dce, 0xf8fc, 0x2492, 0x8bc5, 0xde6f,
+  0x2c16, 0x944a, 0x42a1, 0x7339, 0x5eaf, 0xe2f1, 0x2190, 0x140a,
+  0x55aa, 0x8743, 0xf77b, 0xac56, 0x1b8d, 0xcd66, 0xa8d4, 0xf7fb,
+  0x9b4d, 0x2994, 0x359a, 0x0e87, 0xf1f8, 0x4723, 0x4ea7, 0x71b8,
+  0x8341, 0x783c, 0xf3f9, 0x8140, 0x542a, 0xab55, 0x351a, 0x43a1,
+  0x3198, 0xaad5, 0x4d26, 0x5faf, 0xc261, 0x5d2e, 0xaf57, 0xb9dc,
+  0xe472, 0x158a, 0x54aa, 0x2c96, 0x2b15, 0xdeef, 0x8a45, 0xf67b,
+  0x1a8d, 0x8b45, 0xa653, 0xbe5f, 0xf178, 0x64b2, 0x5c2e, 0x4020,
+  0xabd5, 0x7e3f, 0x93c9, 0xcfe7, 0x59ac, 0x8844, 0x7038, 0x2814,
+  0x62b1, 0xd76b, 0x56ab, 0x6ab5, 0xb45a, 0x0582, 0x91c8, 0xa9d4,
+  0x3018, 0xef77, 0xc864, 0x9ecf, 0xda6d, 0x0100, 0x3399, 0x6130,
+  0xb55a, 0x0a05, 0x4120, 0x77bb, 0x7bbd, 0xc0e0, 0x9e4f, 0xacd6,
+  0x7f3f, 0x89c4, 0x552a, 0x2a15, 0x0c06, 0xfeff, 0x379b, 0x4ca6,
+  0x8643, 0x1088, 0xa050, 0xbf5f, 0xd1e8, 0x4321, 0xe673, 0xfd7e,
+  0x78bc, 0x84c2, 0x92c9, 0xe773, 0x1389, 0xebf5, 0xe874, 0x99cc,
+  0xcde6, 0x51a8, 0x2b95, 0x3e1f, 0x8241, 0x1a0d, 0x75ba, 0x6432,
+  0x7a3d, 0xa3d1, 0x0080, 0x50a8, 0xae57, 0x73b9, 0xc562, 0x9148,
+  0xb2d9, 0x0b05, 0xc462, 0xf47a, 0x4221, 0xffff, 0x2512, 0x1108,
+  0x81c0, 0x52a9, 0x3b1d, 0x61b0, 0x4da6, 0x9acd, 0xe6f3, 0xb85c,
+  0x0502, 0xb65b, 0xb3d9, 0x8944, 0xedf6, 0x5aad, 0x4aa5, 0x743a,
+  0x97cb, 0x6d36, 0xff7f, 0x8c46, 0xc2e1, 0x3c1e, 0xbbdd, 0xcce6,
+  0x6f37, 0xf5fa, 0x0b85, 0x188c, 0x1e8f, 0x8040, 0x6bb5, 0x7cbe,
+  0xf078, 0x0000, 0x58ac, 0x2110, 0xbd5e, 0x4924, 0x0402, 0x79bc,
+  0x44a2, 0xd4ea, 0xe070, 0xf9fc, 0x2d16, 0xb95c, 0x984c, 0x85c2
+};
 
+static const unsigned short s9x[512] = {
+  0x01c3, 0x00ca, 0x0151, 0x019c, 0x01e7, 0x00ec, 0x00fd, 0x0032,
+  0x0189, 0x00b0, 0x011d, 0x01e0, 0x013f, 0x0004, 0x0023, 0x00dc,
+  0x00d7, 0x015b, 0x0025, 0x006d, 0x00ff, 0x0171, 0x0185, 0x01cf,
+  0x00bb, 0x0107, 0x004f, 0x0037, 0x0001, 0x01bf, 0x017d, 0x0107,
+  0x016b, 0x0173, 0x01f0, 0x002c, 0x000f, 0x0015, 0x011c, 0x00c2,
+  0x0139, 0x0111, 0x01a4, 0x0048, 0x00cf, 0x00e5, 0x01da, 0x0034,
+  0x0031, 0x00ac, 0x00ca, 0x0193, 0x0159, 0x01c6, 0x002a, 0x0171,
+  0x0045, 0x00e8, 0x00b8, 0x01d1, 0x01bf, 0x0110, 0x00ca, 0x01a1,
+  0x0193, 0x009c, 0x01a0, 0x016b, 0x01a4, 0x00a9, 0x001f, 0x00d6,
+  0x0059, 0x0166, 0x006c, 0x0097, 0x00fc, 0x01c1, 0x0141, 0x01b8,
+  0x00b7, 0x013d, 0x00e4, 0x00aa, 0x008c, 0x0104, 0x0157, 0x011b,
+  0x015b, 0x00e1, 0x010e, 0x0170, 0x01f2, 0x004a, 0x002f, 0x0053,
+  0x0027, 0x0039, 0x001d, 0x01c7, 0x0150, 0x014c, 0x00e2, 0x013a,
+  0x01f5, 0x01db, 0x01c9, 0x0023, 0x0010, 0x003c, 0x01a4, 0x004c,
+  0x014d, 0x01d6, 0x0117, 0x0048, 0x0036, 0x00af, 0x01e4, 0x00b9,
+  0x00b9, 0x0012, 0x00e5, 0x018a, 0x0150, 0x01f9, 0x0084, 0x01e9,
+  0x0161, 0x01e8, 0x01ff, 0x00b2, 0x0104, 0x018f, 0x0012, 0x015d,
+  0x010e, 0x01b7, 0x0196, 0x00eb, 0x01f9, 0x0142, 0x00e9, 0x0196,
+  0x00f5, 0x00f9, 0x000b, 0x01c3, 0x009c, 0x0092, 0x01ea, 0x0020,
+  0x00bc, 0x0080, 0x0044, 0x01bc, 0x0047, 0x0079, 0x0137, 0x00cd,
+  0x01a9, 0x0031, 0x013e, 0x0162, 0x008c, 0x0116, 0x0193, 0x01cd,
+  0x01de, 0x0076, 0x014f, 0x0123, 0x0069, 0x01c3, 0x0170, 0x011e,
+  0x0073, 0x016e, 0x0084, 0x005d, 0x015a, 0x0045, 0x0025, 0x00fe,
+  0x0022, 0x010f, 0x00d3, 0x003a, 0x0199, 0x00b6, 0x00e0, 0x000b,
+  0x0189, 0x0106, 0x01b6, 0x00fd, 0x01ff, 0x0172, 0x0048, 0x0101,
+  0x0066, 0x00d9, 0x005f, 0x0124, 0x0082, 0x003f, 0x0133, 0x004a,
+  0x002d, 0x0027, 0x0072, 0x01bc, 0x0057, 0x005f, 0x0180, 0x004c,
+  0x01e4, 0x01de, 0x01bd, 0x0043, 0x010c, 0x0134, 0x00dd, 0x0121,
+  0x005d, 0x01c3, 0x006b, 0x0031, 0x016b, 0x00f7, 0x00d5, 0x008d,
+  0x01aa, 0x0004, 0x019a, 0x01f0, 0x000e, 0x01a2, 0x01b6, 0x01de,
+  0x01b7, 0x00ac, 0x01e1, 0x013e, 0x008d, 0x0194, 0x0153, 0x018e,
+  0x0066, 0x014d, 0x0036, 0x00d9, 0x01ce, 0x00e7, 0x0016, 0x00fb,
+  0x0087, 0x00ec, 0x0095, 0x013a, 0x00bb, 0x00d2, 0x0121, 0x008c,
+  0x01ce, 0x0195, 0x01da, 0x0045, 0x0160, 0x0139, 0x00fc, 0x0161,
+  0x01da, 0x0134, 0x01a8, 0x0082, 0x01ea, 0x0106, 0x0010, 0x0138,
+  0x00b5, 0x006b, 0x00c1, 0x01db, 0x0017, 0x00cb, 0x01eb, 0x00f3,
+  0x002d, 0x0157, 0x0036, 0x0088, 0x0151, 0x0029, 0x00c2, 0x007e,
+  0x017c, 0x0036, 0x0161, 0x01ef, 0x0092, 0x01da, 0x0107, 0x018b,
+  0x013e, 0x00c1, 0x0145, 0x017e, 0x004e, 0x01b3, 0x01bd, 0x0184,
+  0x0049, 0x0186, 0x0034, 0x003f, 0x01ab, 0x0066, 0x005e, 0x0057,
+  0x0197, 0x01fa, 0x0124, 0x008d, 0x01b8, 0x01d7, 0x0083, 0x0128,
+  0x015e, 0x0103, 0x01eb, 0x0072, 0x01e3, 0x01bc, 0x00de, 0x0145,
+  0x00fa, 0x0012, 0x0029, 0x0105, 0x00d9, 0x0033, 0x0182, 0x00ac,
+  0x0015, 0x00cd, 0x00c0, 0x01dc, 0x00a4, 0x007e, 0x01f9, 0x00e7,
+  0x0021, 0x015d, 0x009b, 0x0023, 0x014e, 0x0030, 0x007c, 0x00c6,
+  0x00f0, 0x01bc, 0x004c, 0x00c4, 0x010d, 0x0043, 0x0039, 0x00b3,
+  0x0102, 0x00fb, 0x01d8, 0x01e5, 0x0061, 0x019a, 0x0133, 0x010c,
+  0x01f5, 0x003c, 0x0129, 0x0124, 0x0004, 0x01cf, 0x0150, 0x015f,
+  0x0055, 0x01be, 0x004b, 0x0064, 0x0028, 0x01c1, 0x01be, 0x0193,
+  0x0139, 0x00e2, 0x0121, 0x013e, 0x01d6, 0x000f, 0x0046, 0x005b,
+  0x0188, 0x00e6, 0x01f6, 0x015c, 0x01f9, 0x0095, 0x000f, 0x00a7,
+  0x00c2, 0x019c, 0x00ba, 0x0020, 0x0021, 0x017d, 0x01d1, 0x0149,
+  0x009f, 0x0065, 0x0088, 0x01b6, 0x01a2, 0x015a, 0x003d, 0x0101,
+  0x01eb, 0x0121, 0x01fa, 0x00f4, 0x0044, 0x008c, 0x01dd, 0x00d1,
+  0x010c, 0x0173, 0x017b, 0x00c0, 0x003d, 0x0040, 0x01c2, 0x007b,
+  0x005e, 0x0011, 0x002f, 0x01a4, 0x01fd, 0x01b0, 0x0004, 0x018d,
+  0x01fd, 0x0010, 0x0142, 0x016b, 0x0193, 0x007c, 0x00a4, 0x008f,
+  0x0111, 0x00cc, 0x01a8, 0x01b1, 0x01ed, 0x0032, 0x00dc, 0x00c7,
+  0x0010, 0x0178, 0x00cf, 0x0063, 0x0072, 0x0118, 0x0125, 0x018b,
+  0x00da, 0x0182, 0x0003, 0x009f, 0x002a, 0x0170, 0x017b, 0x01e5,
+  0x002b, 0x00d7, 0x009d, 0x01a5, 0x0105, 0x01fb, 0x003b, 0x0101,
+  0x00df, 0x0013, 0x006f, 0x0167, 0x0163, 0x01ad, 0x005b, 0x0151,
+  0x0188, 0x01f1, 0x015e, 0x00e3, 0x00aa, 0x00d1, 0x01f4, 0x004b,
+  0x015a, 0x0113, 0x018a, 0x0007, 0x00ea, 0x00a1, 0x01b2, 0x003d
+};
 
+#define FI(t, x, k) (t = fi7[(x) & 0x7f] ^ fi9[(x) >> 7] ^ (k), \
+  t ^ s9x[t & 0x1ff] ^ (t >> 9))
 
+static unsigned fi(unsigned x, unsigned k)
+{
+  unsigned t;
 
-
+  return FI(t, x, k);
+}
 
 static void bcopy_u4_byte(u4 k, byte * b) { 
   b[0]=(k>>24)&0xFF;
@@ -39,7 +209,7 @@ void misty1_keyinit(u4  *ek, u4  *k)
   bcopy_u4_byte(k[2],(byte *)(&key[8]));
   bcopy_u4_byte(k[3],(byte *)(&key[12]));
   
-  bzero(ek,MISTY1_KEYSIZE*sizeof(u4));
+  memset(ek,0,MISTY1_KEYSIZE*sizeof(u4));
   for(i=0; i < 8 ; i++) {
     ek[i] = (key[i*2]*256) + (key[(i*2) +1]);
   }
@@ -51,13 +221,214 @@ void misty1_keyinit(u4  *ek, u4  *k)
   }
 }
 
-misty1_key_destroy(u4  *ek)
+void misty1_key_destroy(u4  *ek)
+{
+  memset(ek,0,MISTY1_KEYSIZE*sizeof(u4));
+}
+
+/*
+ * Round keys from the 16 subkeys K1..K8, K'1..K'8 of ek[0..15], as in
+ * the correspondence table of the specification.
+ */
+static void misty1_schedule(misty1_ctx *ctx, const u4 *ek)
+{
+  int r, k;
+
+  for (r = 0; r < 8; r++) {
+    ctx->ko[r][0] = (unsigned short)ek[r];
+    ctx->ko[r][1] = (unsigned short)ek[(r + 2) % 8];
+    ctx->ko[r][2] = (unsigned short)ek[(r + 7) % 8];
+    ctx->ko[r][3] = (unsigned short)ek[(r + 4) % 8];
+    ctx->ki[r][0] = (unsigned short)ek[(r + 5) % 8 + 8];
+    ctx->ki[r][1] = (unsigned short)ek[(r + 1) % 8 + 8];
+    ctx->ki[r][2] = (unsigned short)ek[(r + 3) % 8 + 8];
+  }
+  for (k = 0; k < 10; k += 2) {
+    ctx->kl[k][0] = (unsigned short)ek[k / 2];
+    ctx->kl[k][1] = (unsigned short)ek[(k / 2 + 6) % 8 + 8];
+    ctx->kl[k + 1][0] = (unsigned short)ek[(k / 2 + 2) % 8 + 8];
+    ctx->kl[k + 1][1] = (unsigned short)ek[(k / 2 + 4) % 8];
+  }
+}
+
+/*
+ * Multi-block core.
+ *
+ * FO is three FI steps, each waiting on the one before, so a single
+ * block leaves most of the core idle.  Blocks are independent: up to
+ * four of them go through every FL and FO in lockstep.  More lanes
+ * than that no longer fit in registers and run slower.  n is a
+ * constant at every call, so the lane tests fold away.
+ *
+ * h[0], h[1] are the high and low halves of D0, h[2], h[3] of D1.
+ */
+#if defined(__GNUC__)
+#define M1_INLINE static __inline__ __attribute__((always_inline))
+#else
+#define M1_INLINE static
+#endif
+
+#define M1_MAX_LANES 4
+
+#define M1_LANES(op, x, y, k) do { \
+  op(x, y, k, 0); \
+  if (n > 1) op(x, y, k, 1); \
+  if (n > 2) op(x, y, k, 2); \
+  if (n > 3) op(x, y, k, 3); \
+} while (0)
+
+/* FL k and its inverse on the word at h[x], h[x + 1] */
+#define M1_FL(x, y, k, j) { \
+  h[x + 1][j] ^= h[x][j] & ctx->kl[k][0]; \
+  h[x][j] ^= h[x + 1][j] | ctx->kl[k][1]; \
+}
+#define M1_FLI(x, y, k, j) { \
+  h[x][j] ^= h[x + 1][j] | ctx->kl[k][1]; \
+  h[x + 1][j] ^= h[x][j] & ctx->kl[k][0]; \
+}
+
+/* word y ^= FO round k of word x */
+#define M1_FO(x, y, k, j) { \
+  unsigned t0 = h[x][j], t1 = h[x + 1][j], t; \
+  t0 = FI(t, t0 ^ ctx->ko[k][0], ctx->ki[k][0]) ^ t1; \
+  t1 = FI(t, t1 ^ ctx->ko[k][1], ctx->ki[k][1]) ^ t0; \
+  t0 = FI(t, t0 ^ ctx->ko[k][2], ctx->ki[k][2]) ^ t1; \
+  h[y][j] ^= t1 ^ ctx->ko[k][3]; \
+  h[y + 1][j] ^= t0; \
+}
+
+#define M1_GET(a, b, p) { \
+  for (j = 0; j < n; j++) { \
+    h[a][j] = (p[8*j + 0] << 8) | p[8*j + 1]; \
+    h[a + 1][j] = (p[8*j + 2] << 8) | p[8*j + 3]; \
+    h[b][j] = (p[8*j + 4] << 8) | p[8*j + 5]; \
+    h[b + 1][j] = (p[8*j + 6] << 8) | p[8*j + 7]; \
+  } \
+}
+
+#define M1_PUT(p, a, b) { \
+  for (j = 0; j < n; j++) { \
+    p[8*j + 0] = (byte)(h[a][j] >> 8); p[8*j + 1] = (byte)h[a][j]; \
+    p[8*j + 2] = (byte)(h[a + 1][j] >> 8); p[8*j + 3] = (byte)h[a + 1][j]; \
+    p[8*j + 4] = (byte)(h[b][j] >> 8); p[8*j + 5] = (byte)h[b][j]; \
+    p[8*j + 6] = (byte)(h[b + 1][j] >> 8); p[8*j + 7] = (byte)h[b + 1][j]; \
+  } \
+}
+
+M1_INLINE void encrypt_lanes(const misty1_ctx *ctx, const byte *in,
+  byte *out, const int n)
 {
-  bzero(ek,MISTY1_KEYSIZE*sizeof(u4));
+  unsigned h[4][M1_MAX_LANES];
+  int j;
+
+  M1_GET(0, 2, in);
+  M1_LANES(M1_FL, 0, 0, 0); M1_LANES(M1_FL, 2, 0, 1);
+  M1_LANES(M1_FO, 0, 2, 0);
+  M1_LANES(M1_FO, 2, 0, 1);
+  M1_LANES(M1_FL, 0, 0, 2); M1_LANES(M1_FL, 2, 0, 3);
+  M1_LANES(M1_FO, 0, 2, 2);
+  M1_LANES(M1_FO, 2, 0, 3);
+  M1_LANES(M1_FL, 0, 0, 4); M1_LANES(M1_FL, 2, 0, 5);
+  M1_LANES(M1_FO, 0, 2, 4);
+  M1_LANES(M1_FO, 2, 0, 5);
+  M1_LANES(M1_FL, 0, 0, 6); M1_LANES(M1_FL, 2, 0, 7);
+  M1_LANES(M1_FO, 0, 2, 6);
+  M1_LANES(M1_FO, 2, 0, 7);
+  M1_LANES(M1_FL, 0, 0, 8); M1_LANES(M1_FL, 2, 0, 9);
+  M1_PUT(out, 2, 0);
+}
+
+M1_INLINE void decrypt_lanes(const misty1_ctx *ctx, const byte *in,
+  byte *out, const int n)
+{
+  unsigned h[4][M1_MAX_LANES];
+  int j;
+
+  M1_GET(2, 0, in);
+  M1_LANES(M1_FLI, 0, 0, 8); M1_LANES(M1_FLI, 2, 0, 9);
+  M1_LANES(M1_FO, 2, 0, 7);
+  M1_LANES(M1_FO, 0, 2, 6);
+  M1_LANES(M1_FLI, 0, 0, 6); M1_LANES(M1_FLI, 2, 0, 7);
+  M1_LANES(M1_FO, 2, 0, 5);
+  M1_LANES(M1_FO, 0, 2, 4);
+  M1_LANES(M1_FLI, 0, 0, 4); M1_LANES(M1_FLI, 2, 0, 5);
+  M1_LANES(M1_FO, 2, 0, 3);
+  M1_LANES(M1_FO, 0, 2, 2);
+  M1_LANES(M1_FLI, 0, 0, 2); M1_LANES(M1_FLI, 2, 0, 3);
+  M1_LANES(M1_FO, 2, 0, 1);
+  M1_LANES(M1_FO, 0, 2, 0);
+  M1_LANES(M1_FLI, 0, 0, 0); M1_LANES(M1_FLI, 2, 0, 1);
+  M1_PUT(out, 0, 2);
+}
+
+void misty1_setkey(misty1_ctx *ctx, const byte key[16])
+{
+  u4 ek[16];
+  int i;
+
+  for (i = 0; i < 8; i++)
+    ek[i] = (key[i*2] << 8) | key[i*2 + 1];
+  for (i = 0; i < 8; i++)
+    ek[i+8] = fi(ek[i], ek[(i+1)%8]);
+  misty1_schedule(ctx, ek);
+  memset(ek, 0, sizeof ek);
+}
+
+void misty1_encrypt_blocks(const misty1_ctx *ctx, const byte *in,
+  byte *out, size_t n)
+{
+  for (; n >= 4; n -= 4, in += 32, out += 32)
+    encrypt_lanes(ctx, in, out, 4);
+  for (; n; n--, in += 8, out += 8)
+    encrypt_lanes(ctx, in, out, 1);
+}
+
+void misty1_decrypt_blocks(const misty1_ctx *ctx, const byte *in,
+  byte *out, size_t n)
+{
+  for (; n >= 4; n -= 4, in += 32, out += 32)
+    decrypt_lanes(ctx, in, out, 4);
+  for (; n; n--, in += 8, out += 8)
+    decrypt_lanes(ctx, in, out, 1);
+}
+
+/*
+ * One block as two big-endian words, p[0] on the left, with the key
+ * array from misty1_keyinit().
+ */
+static void misty1_words(u4 *ek, u4 *in, u4 *out, int dir)
+{
+  misty1_ctx ctx;
+  byte b[8];
+
+  misty1_schedule(&ctx, ek);
+  bcopy_u4_byte(in[0], &b[0]);
+  bcopy_u4_byte(in[1], &b[4]);
+  if (dir)
+    encrypt_lanes(&ctx, b, b, 1);
+  else
+    decrypt_lanes(&ctx, b, b, 1);
+  out[0] = ((u4)b[0] << 24) | ((u4)b[1] << 16) | (b[2] << 8) | b[3];
+  out[1] = ((u4)b[4] << 24) | ((u4)b[5] << 16) | (b[6] << 8) | b[7];
+  memset(&ctx, 0, sizeof ctx);
+}
+
+void misty1_encrypt_block(u4 *ek, u4 *p, u4 *c)
+{
+  misty1_words(ek, p, c, 1);
+}
+
+void misty1_decrypt_block(u4 *ek, u4 *c, u4 *p)
+{
+  misty1_words(ek, c, p, 0);
 }
 
 #ifdef TESTMAIN
-main()
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int main()
 {
 /*
    Key:        00 11 22 33 44 55 66 77 88 99 aa bb cc dd ee ff
@@ -108,9 +479,33 @@ main()
 
    misty1_key_destroy(ek_e);
    misty1_key_destroy(ek_d);
-   bzero(Key,4 * sizeof(u4));
+   memset(Key,0,4 * sizeof(u4));
 
-   
+   /* every lane count of the batch path against the reference block */
+   {
+     static const byte key[16] = {
+       0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+       0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+     static const byte chk[8] = {
+       0x8b, 0x1d, 0xa5, 0xf5, 0x6a, 0xb3, 0xd0, 0x7c };
+     byte buf[8*29], enc[8*29], dec[8*29];
+     misty1_ctx ctx;
+     int i;
 
+     misty1_setkey(&ctx, key);
+     for (i = 0; i < 29; i++)
+       memcpy(buf + 8*i, "\x01\x23\x45\x67\x89\xab\xcd\xef", 8);
+     misty1_encrypt_blocks(&ctx, buf, enc, 29);
+     misty1_decrypt_blocks(&ctx, enc, dec, 29);
+     for (i = 0; i < 29; i++) {
+       if (memcmp(enc + 8*i, chk, 8) || memcmp(dec + 8*i, buf + 8*i, 8)) {
+         printf("Batch failed at block %d\n", i);
+         exit(1);
+       }
+     }
+     printf("Batch OK\n");
+     memset(&ctx, 0, sizeof ctx);
+   }
+   return 0;
 }
-#endif TESTMAIN
+#endif /* TESTMAIN */
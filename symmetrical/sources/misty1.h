@@ -0,0 +1,48 @@
+/*
+ *   MISTY1 module -- interface to misty1.c
+ */
+
+#ifndef MISTY1_H
+#define MISTY1_H
+
+#include <stddef.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+typedef unsigned long u4;
+typedef unsigned char byte;
+
+/* words in the caller-held key array of misty1_keyinit() */
+#define MISTY1_KEYSIZE 32
+
+void misty1_keyinit(u4 *ek, u4 *k);
+void misty1_encrypt_block(u4 *ek, u4 *p, u4 *c);
+void misty1_decrypt_block(u4 *ek, u4 *c, u4 *p);
+void misty1_key_destroy(u4 *ek);
+
+/*
+ * The expanded key, laid out per round: ko/ki feed FO round r,
+ * kl[k] is the AND and OR key of FL k.  It is only read once built,
+ * so one context may serve any number of threads.
+ */
+typedef struct {
+  unsigned short ko[8][4];
+  unsigned short ki[8][3];
+  unsigned short kl[10][2];
+} misty1_ctx;
+
+void misty1_setkey(misty1_ctx *ctx, const unsigned char key[16]);
+
+/* n consecutive 8-byte blocks; in may be the same as out */
+void misty1_encrypt_blocks(const misty1_ctx *ctx, const unsigned char *in,
+  unsigned char *out, size_t n);
+void misty1_decrypt_blocks(const misty1_ctx *ctx, const unsigned char *in,
+  unsigned char *out, size_t n);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* MISTY1_H */
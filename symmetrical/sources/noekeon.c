@@ -225,20 +225,14 @@ void NESSIEdecrypt(const struct NESSIEstruct * const structpointer,
                    const unsigned char * const ciphertext,
                    unsigned char * const plaintext)
 /*==================================================================================*/
-{ u32 const *kencrypt=structpointer->k;
-  u32 k[4],state[4];
+{ u32 const *k=structpointer->kd;
+  u32 state[4];
 
   state[0]=U8TO32_BIG(ciphertext   );
   state[1]=U8TO32_BIG(ciphertext+4 );
   state[2]=U8TO32_BIG(ciphertext+8 );
   state[3]=U8TO32_BIG(ciphertext+12);
 
-  k[0]=kencrypt[0];
-  k[1]=kencrypt[1];
-  k[2]=kencrypt[2];
-  k[3]=kencrypt[3];
-  Theta(NullVector,k);
-
   CommonLoop (k,state,0,RC2DECRYPTSTART);
 
   U32TO8_BIG(plaintext   , state[0]);
@@ -259,7 +253,8 @@ void NESSIEkeysetup(const unsigned char * const key,
  *      ----+----+----+----+----+----+----+----+----+----+----+----+----+----+----+----
  *
  * POST:
- * key value written in 32-bit word array k in NESSIEstruct
+ * key value written in 32-bit word array k in NESSIEstruct,
+ * and the decryption working key Theta(0,k) in kd
  *      -------------------+-------------------+-------------------+-------------------
  *              k[0]                k[1]                k[2]                k[3]
 /*==================================================================================*/
@@ -272,12 +267,190 @@ void NESSIEkeysetup(const unsigned char * const key,
 
   CommonLoop (NullVector,k,RC1ENCRYPTSTART,0);
 
+  /* decryption working key, computed once here rather than per block */
+  structpointer->kd[0]=k[0];
+  structpointer->kd[1]=k[1];
+  structpointer->kd[2]=k[2];
+  structpointer->kd[3]=k[3];
+  Theta(NullVector,structpointer->kd);
+
 } /* NESSIEkeysetup */
 
 
+/*==================================================================================*/
+/* Multi-block interface */
+/*----------------------------------------------------------------------------------*/
+/* Every step of the round is a bitwise operation or a fixed rotation, the same for
+ * every block.  Word i of 4 blocks (SSE2) or 8 blocks (AVX2) is kept in one
+ * register and the rounds run on whole registers.  Define NOEKEON_NO_SIMD to build
+ * the scalar loop only. */
+/*==================================================================================*/
+
+#if !defined(NOEKEON_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define NOEKEON_SIMD
+#include <immintrin.h>
+#endif
+
+/* Round constants RC1, RC2 of each round and of the final Theta, as CommonLoop
+ * produces them from RC1ENCRYPTSTART and RC2DECRYPTSTART
+ */
+static const u8 RCEncrypt[NROUND+1] = {
+  0x80,0x1B,0x36,0x6C,0xD8,0xAB,0x4D,0x9A,0x2F,0x5E,0xBC,0x63,0xC6,0x97,0x35,0x6A,0xD4
+};
+static const u8 RCDecrypt[NROUND+1] = {
+  0xD4,0x6A,0x35,0x97,0xC6,0x63,0xBC,0x5E,0x2F,0x9A,0x4D,0xAB,0xD8,0x6C,0x36,0x1B,0x80
+};
+static const u8 RCNull[NROUND+1] = { 0 };
+
+#ifdef NOEKEON_SIMD
+
+typedef unsigned int v4u32 __attribute__((vector_size(16)));
+typedef unsigned int v8u32 __attribute__((vector_size(32)));
+
+#define VROTL(x,n)  ((x) << (n) | (x) >> (32 - (n)))
+#define VBSWAP(x)   ((x) << 24 | (x) >> 24 | ((x) & 0xff00) << 8 | ((x) >> 8 & 0xff00))
+
+/* Theta, Pi1, Gamma and Pi2 on a0..a3, as the scalar functions above */
+#define VTHETA(k) \
+  t  = a0^a2; t ^= VROTL(t,8)^VROTL(t,24); a1 ^= t; a3 ^= t; \
+  a0 ^= k[0]; a1 ^= k[1]; a2 ^= k[2]; a3 ^= k[3]; \
+  t  = a1^a3; t ^= VROTL(t,8)^VROTL(t,24); a0 ^= t; a2 ^= t
+
+#define VROUNDS(k,rc1,rc2) \
+  for (i=0 ; i<NROUND ; i++) { \
+    a0 ^= rc1[i]; \
+    VTHETA(k); \
+    a0 ^= rc2[i]; \
+    a1 = VROTL(a1,1); a2 = VROTL(a2,5); a3 = VROTL(a3,2); \
+    a1 ^= ~(a3|a2); a0 ^= a2&a1; \
+    t = a3; a3 = a0; a0 = t; a2 ^= a0^a1^a3; \
+    a1 ^= ~(a3|a2); a0 ^= a2&a1; \
+    a1 = VROTL(a1,31); a2 = VROTL(a2,27); a3 = VROTL(a3,30); \
+  } \
+  a0 ^= rc1[NROUND]; \
+  VTHETA(k); \
+  a0 ^= rc2[NROUND]
+
+/* Four blocks in r0..r3 to word vectors and back (the transpose is its own
+ * inverse); with 256-bit registers each 128-bit half is done on its own
+ */
+#define VTRANSPOSE(P) \
+  u0 = P##_unpacklo_epi32(r0,r1); u1 = P##_unpackhi_epi32(r0,r1); \
+  u2 = P##_unpacklo_epi32(r2,r3); u3 = P##_unpackhi_epi32(r2,r3); \
+  r0 = P##_unpacklo_epi64(u0,u2); r1 = P##_unpackhi_epi64(u0,u2); \
+  r2 = P##_unpacklo_epi64(u1,u3); r3 = P##_unpackhi_epi64(u1,u3)
+
+/*==================================================================================*/
+__attribute__((target("sse2")))
+static size_t Noekeon4(u32 const * const k, u8 const *rc1, u8 const *rc2,
+                       const unsigned char *in, unsigned char *out, size_t n)
+/*----------------------------------------------------------------------------------*/
+/* 4 blocks per pass; returns the number of blocks done */
+/*==================================================================================*/
+{ v4u32 a0, a1, a2, a3, t;
+  __m128i r0, r1, r2, r3, u0, u1, u2, u3;
+  size_t d;
+  unsigned i;
+
+  for (d=0 ; n-d>=4 ; d+=4, in+=64, out+=64) {
+    r0 = _mm_loadu_si128((const __m128i *)in);
+    r1 = _mm_loadu_si128((const __m128i *)in+1);
+    r2 = _mm_loadu_si128((const __m128i *)in+2);
+    r3 = _mm_loadu_si128((const __m128i *)in+3);
+    VTRANSPOSE(_mm);
+    a0 = VBSWAP((v4u32)r0); a1 = VBSWAP((v4u32)r1);
+    a2 = VBSWAP((v4u32)r2); a3 = VBSWAP((v4u32)r3);
+    VROUNDS(k,rc1,rc2);
+    r0 = (__m128i)VBSWAP(a0); r1 = (__m128i)VBSWAP(a1);
+    r2 = (__m128i)VBSWAP(a2); r3 = (__m128i)VBSWAP(a3);
+    VTRANSPOSE(_mm);
+    _mm_storeu_si128((__m128i *)out, r0);
+    _mm_storeu_si128((__m128i *)out+1, r1);
+    _mm_storeu_si128((__m128i *)out+2, r2);
+    _mm_storeu_si128((__m128i *)out+3, r3);
+  }
+  return d;
+} /* Noekeon4 */
+
+/*==================================================================================*/
+__attribute__((target("avx2")))
+static size_t Noekeon8(u32 const * const k, u8 const *rc1, u8 const *rc2,
+                       const unsigned char *in, unsigned char *out, size_t n)
+/*----------------------------------------------------------------------------------*/
+/* 8 blocks per pass; returns the number of blocks done */
+/*==================================================================================*/
+{ v8u32 a0, a1, a2, a3, t;
+  __m256i r0, r1, r2, r3, u0, u1, u2, u3;
+  size_t d;
+  unsigned i;
 
+  for (d=0 ; n-d>=8 ; d+=8, in+=128, out+=128) {
+    r0 = _mm256_loadu_si256((const __m256i *)in);
+    r1 = _mm256_loadu_si256((const __m256i *)in+1);
+    r2 = _mm256_loadu_si256((const __m256i *)in+2);
+    r3 = _mm256_loadu_si256((const __m256i *)in+3);
+    VTRANSPOSE(_mm256);
+    a0 = VBSWAP((v8u32)r0); a1 = VBSWAP((v8u32)r1);
+    a2 = VBSWAP((v8u32)r2); a3 = VBSWAP((v8u32)r3);
+    VROUNDS(k,rc1,rc2);
+    r0 = (__m256i)VBSWAP(a0); r1 = (__m256i)VBSWAP(a1);
+    r2 = (__m256i)VBSWAP(a2); r3 = (__m256i)VBSWAP(a3);
+    VTRANSPOSE(_mm256);
+    _mm256_storeu_si256((__m256i *)out, r0);
+    _mm256_storeu_si256((__m256i *)out+1, r1);
+    _mm256_storeu_si256((__m256i *)out+2, r2);
+    _mm256_storeu_si256((__m256i *)out+3, r3);
+  }
+  return d;
+} /* Noekeon8 */
 
+#endif /* NOEKEON_SIMD */
 
+/*==================================================================================*/
+static void NoekeonBlocks (u32 const * const k, u8 const *rc1, u8 const *rc2,
+                           const unsigned char *in, unsigned char *out, size_t n)
+/*----------------------------------------------------------------------------------*/
+/* Whole passes through the widest kernel the CPU has, the rest through CommonLoop */
+/*==================================================================================*/
+{ u32 state[4];
+  size_t d;
 
+#ifdef NOEKEON_SIMD
+  if (n>=8 && __builtin_cpu_supports("avx2")) {
+    d = Noekeon8(k,rc1,rc2,in,out,n);
+    in += 16*d; out += 16*d; n -= d;
+  }
+  if (n>=4 && __builtin_cpu_supports("sse2")) {
+    d = Noekeon4(k,rc1,rc2,in,out,n);
+    in += 16*d; out += 16*d; n -= d;
+  }
+#endif
+  for (d=0 ; d<n ; d++, in+=16, out+=16) {
+    state[0]=U8TO32_BIG(in   );
+    state[1]=U8TO32_BIG(in+4 );
+    state[2]=U8TO32_BIG(in+8 );
+    state[3]=U8TO32_BIG(in+12);
+    CommonLoop (k,state,rc1[0],rc2[0]);
+    U32TO8_BIG(out   , state[0]);
+    U32TO8_BIG(out+4 , state[1]);
+    U32TO8_BIG(out+8 , state[2]);
+    U32TO8_BIG(out+12, state[3]);
+  }
+} /* NoekeonBlocks */
 
+/*==================================================================================*/
+void NESSIEencryptblocks(const struct NESSIEstruct * const structpointer,
+                         const unsigned char *in, unsigned char *out, size_t n)
+/*==================================================================================*/
+{
+  NoekeonBlocks (structpointer->k,RCEncrypt,RCNull,in,out,n);
+} /* NESSIEencryptblocks */
 
+/*==================================================================================*/
+void NESSIEdecryptblocks(const struct NESSIEstruct * const structpointer,
+                         const unsigned char *in, unsigned char *out, size_t n)
+/*==================================================================================*/
+{
+  NoekeonBlocks (structpointer->kd,RCNull,RCDecrypt,in,out,n);
+} /* NESSIEdecryptblocks */
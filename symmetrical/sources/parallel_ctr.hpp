@@ -0,0 +1,197 @@
+/*
+ *  parallel_ctr.hpp:  multi-threaded CTR mode for very large buffers.
+ *
+ *  CTR blocks depend only on the key and the counter, so a buffer can be
+ *  cut anywhere on a block boundary and the pieces encrypted in any
+ *  order.  parallel_ctr splits the buffer into counter-aligned chunks and
+ *  runs them on a set of worker threads; the output is byte for byte what
+ *  a single ctr_mode (cipher_modes.hpp) started at the same IV produces.
+ *
+ *  Each worker encrypts with its own copy of the key schedule, on its own
+ *  stack, so the hot tables are never shared between cores.  The chunks
+ *  are first dealt out as one contiguous run per worker; a worker that
+ *  runs dry steals the back half of another worker's remaining run, so
+ *  threads that are slowed down (by other load, page faults, a smaller
+ *  core) do not hold up the whole call.  The calling thread works too.
+ *
+ *  If a worker thread cannot be started the call still completes: its
+ *  share is stolen by the others.
+ */
+
+#ifndef PARALLEL_CTR_HPP
+#define PARALLEL_CTR_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include "cipher_modes.hpp"
+
+/* default amount of data per unit of work */
+#define PARALLEL_CTR_CHUNK_BYTES (1u << 20)
+
+template <class Cipher>
+class parallel_ctr
+{
+public:
+  static constexpr size_t BLOCKSIZE = Cipher::BLOCKSIZE;
+
+  /*
+   * threads == 0 uses one worker per hardware thread.  chunk is rounded
+   * down to whole blocks.  The cipher must outlive this object.
+   */
+  explicit parallel_ctr (const Cipher &cipher, unsigned int threads = 0,
+                         size_t chunk = PARALLEL_CTR_CHUNK_BYTES)
+    : c (&cipher),
+      nthreads (threads ? threads
+                        : std::max (std::thread::hardware_concurrency (), 1u)),
+      chunk_bytes (chunk < BLOCKSIZE ? BLOCKSIZE : chunk - chunk % BLOCKSIZE)
+  {}
+
+  /* in may be the same as out */
+  void process (const unsigned char *iv, const unsigned char *in,
+                unsigned char *out, size_t len) const;
+
+  void encrypt (const unsigned char *iv, const unsigned char *in,
+                unsigned char *out, size_t len) const
+  {
+    process (iv, in, out, len);
+  }
+
+  void decrypt (const unsigned char *iv, const unsigned char *in,
+                unsigned char *out, size_t len) const
+  {
+    process (iv, in, out, len);
+  }
+
+private:
+  /* a worker's remaining chunks [begin, end), packed as begin << 32 | end */
+  struct alignas (64) run
+  {
+    std::atomic<uint64_t> r;
+  };
+
+  static uint64_t pack (uint64_t begin, uint64_t end)
+  {
+    return begin << 32 | end;
+  }
+
+  static bool pop (run &own, size_t &chunk);
+  static bool steal (run &victim, run &own);
+  static bool next (run *runs, size_t nruns, size_t self, size_t &chunk);
+
+  const Cipher *c;
+  unsigned int  nthreads;
+  size_t        chunk_bytes;
+};
+
+template <class Cipher>
+bool parallel_ctr<Cipher>::pop (run &own, size_t &chunk)
+{
+  uint64_t v = own.r.load ();
+  for (;;)
+    {
+      uint64_t begin = v >> 32, end = v & 0xffffffff;
+      if (begin >= end)
+        return false;
+      if (own.r.compare_exchange_weak (v, pack (begin + 1, end)))
+        {
+          chunk = (size_t) begin;
+          return true;
+        }
+    }
+}
+
+/* move the back half (at least one chunk) of victim's run into own */
+template <class Cipher>
+bool parallel_ctr<Cipher>::steal (run &victim, run &own)
+{
+  uint64_t v = victim.r.load ();
+  for (;;)
+    {
+      uint64_t begin = v >> 32, end = v & 0xffffffff;
+      if (begin >= end)
+        return false;
+      uint64_t mid = end - (end - begin + 1) / 2;
+      if (victim.r.compare_exchange_weak (v, pack (begin, mid)))
+        {
+          own.r.store (pack (mid, end));
+          return true;
+        }
+    }
+}
+
+template <class Cipher>
+bool parallel_ctr<Cipher>::next (run *runs, size_t nruns, size_t self,
+                                 size_t &chunk)
+{
+  while (!pop (runs[self], chunk))
+    {
+      bool stolen = false;
+      for (size_t k = 1; k < nruns && !stolen; k++)
+        stolen = steal (runs[(self + k) % nruns], runs[self]);
+      if (!stolen)
+        return false;
+    }
+  return true;
+}
+
+template <class Cipher>
+void parallel_ctr<Cipher>::process (const unsigned char *iv,
+                                    const unsigned char *in,
+                                    unsigned char *out, size_t len) const
+{
+  size_t chunk = chunk_bytes;
+  while (len / chunk >= 0xffffffff)          /* chunk numbers fit in 32 bits */
+    chunk *= 2;
+  size_t nchunks = (len + chunk - 1) / chunk;
+  size_t workers = std::min ((size_t) nthreads, nchunks);
+
+  if (workers <= 1)
+    {
+      ctr_mode<Cipher> m (*c, iv);
+      m.process (in, out, len);
+      return;
+    }
+
+  std::unique_ptr<run[]> runs (new run[workers]);
+  for (size_t w = 0; w < workers; w++)
+    runs[w].r.store (pack (nchunks * w / workers, nchunks * (w + 1) / workers));
+
+  auto work = [&] (size_t self)
+  {
+    Cipher local (*c);                       /* this thread's key schedule */
+    ctr_mode<Cipher> m (local, iv);
+    size_t i;
+    while (next (runs.get (), workers, self, i))
+      {
+        size_t off = i * chunk;
+        m.set_iv (iv);
+        m.seek (off / BLOCKSIZE);
+        m.process (in + off, out + off, std::min (chunk, len - off));
+      }
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve (workers - 1);
+  for (size_t w = 1; w < workers; w++)
+    {
+      try
+        {
+          pool.emplace_back (work, w);
+        }
+      catch (const std::system_error &)
+        {
+          break;                             /* the rest is stolen */
+        }
+    }
+  work (0);
+  for (auto &t : pool)
+    t.join ();
+}
+
+#endif /* PARALLEL_CTR_HPP */
@@ -1,7 +1,11 @@
 /* RC5REF.C -- Reference implementation of RC5-32/12/16 in C.        */
 /* Copyright (C) 1995 RSA Data Security, Inc.                        */
-typedef unsigned long WORD;       /* Should be 32-bit = 4 bytes
-*/
+#include <limits.h>
+#if ULONG_MAX > 0xffffffffUL      /* LP64: long is 64 bits             */
+typedef unsigned int WORD;        /* Should be 32-bit = 4 bytes        */
+#else
+typedef unsigned long WORD;       /* Should be 32-bit = 4 bytes        */
+#endif
 #define w        32             /* word size in bits                 */
 #define r        12             /* number of rounds                  */
 #define b        16             /* number of bytes in key            */
@@ -10,8 +14,9 @@ typedef unsigned long WORD;       /* Should be 32-bit = 4 bytes
 WORD S[t];                      /* expanded key table                */
 WORD P = 0xb7e15163, Q = 0x9e3779b9;  /* magic constants             */
 /* Rotation operators. x must be unsigned, to get logical right shift*/
-#define ROTL(x,y) (((x)<<(y&(w-1))) | ((x)>>(w-(y&(w-1)))))
-#define ROTR(x,y) (((x)>>(y&(w-1))) | ((x)<<(w-(y&(w-1)))))
+/* A count of 0 mod w shifts by 0 both ways, never by w.              */
+#define ROTL(x,y) (((x)<<((y)&(w-1))) | ((x)>>((w-((y)&(w-1)))&(w-1))))
+#define ROTR(x,y) (((x)>>((y)&(w-1))) | ((x)<<((w-((y)&(w-1)))&(w-1))))
 
 void RC5_ENCRYPT(WORD *pt, WORD *ct) /* 2 WORD input pt/output ct    */
 { WORD i, A=pt[0]+S[0], B=pt[1]+S[1];
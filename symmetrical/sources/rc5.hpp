@@ -0,0 +1,379 @@
+/*
+ *  rc5.hpp:  RC5-w/r/b as a C++ template.
+ *
+ *  RC5<Word, Rounds, KeyBytes> is RC5 with w = 8 * sizeof (Word) (16, 32
+ *  or 64), r = Rounds and b = KeyBytes, after Rivest's "The RC5
+ *  Encryption Algorithm" and the reference code in rc5.c.  Each object
+ *  holds its own expanded key, and the rounds are unrolled at compile
+ *  time.  Blocks are two words, each read little-endian as the
+ *  reference specifies, so the result does not depend on the host.
+ *
+ *  The multi-block calls run RC5-32 eight blocks to an AVX2 vector and
+ *  RC5-64 four, with the data-dependent rotates done per lane by
+ *  vpsllv/vpsrlv, when the processor has AVX2.  Two vectors go through
+ *  the rounds together so that their dependency chains overlap.  Other
+ *  blocks run one at a time: x86 takes every variable rotate count in
+ *  CL, so interleaving blocks in scalar code only serializes on it.
+ *  Define RC5_NO_SIMD to leave the vector code out.
+ *
+ *    RC5_32_12_16 c (key);             the interoperable RC5-32/12/16
+ *    c.encrypt_blocks (in, out, n);
+ *
+ *  rc5_cipher<Word, Rounds, KeyBytes> adapts the template to
+ *  BlockCipher (block_cipher.hpp) for 32- and 64-bit words.
+ */
+
+#ifndef RC5_HPP
+#define RC5_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "block_cipher.hpp"
+
+#if !defined(RC5_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define RC5_SIMD
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RC5_INLINE inline __attribute__ ((always_inline))
+#else
+#define RC5_INLINE inline
+#endif
+
+namespace rc5_detail
+{
+
+/* magic constants: P = Odd ((e - 2) 2^w), Q = Odd ((phi - 1) 2^w) */
+template <size_t Size> struct magic;
+template <> struct magic<2>
+{
+  static constexpr uint16_t P = 0xb7e1, Q = 0x9e37;
+};
+template <> struct magic<4>
+{
+  static constexpr uint32_t P = 0xb7e15163, Q = 0x9e3779b9;
+};
+template <> struct magic<8>
+{
+  static constexpr uint64_t P = 0xb7e151628aed2a6bULL;
+  static constexpr uint64_t Q = 0x9e3779b97f4a7c15ULL;
+};
+
+/*
+ * Half rounds on V, a word or a vector of words with one block per lane.
+ * The rotate counts are taken mod w and a zero count shifts by zero, not
+ * by w.  Word arithmetic on 16-bit words is done in int and truncated.
+ */
+template <typename Word, typename V>
+RC5_INLINE void enc_half (V &a, const V &b, Word k)
+{
+  constexpr unsigned W = 8 * sizeof (Word);
+  V x = a ^ b, s = b & (W - 1);
+  x = (x << s) | (x >> ((W - s) & (W - 1)));
+  a = x + k;
+}
+
+template <typename Word, typename V>
+RC5_INLINE void dec_half (V &a, const V &b, Word k)
+{
+  constexpr unsigned W = 8 * sizeof (Word);
+  V x = a - k, s = b & (W - 1);
+  x = (x >> s) | (x << ((W - s) & (W - 1)));
+  a = x ^ b;
+}
+
+/* round i on K independent sets of lanes */
+template <typename Word, size_t K, typename V>
+RC5_INLINE void enc_round (const Word *S, V *A, V *B, size_t i)
+{
+  for (size_t k = 0; k < K; k++)
+    enc_half (A[k], B[k], S[2 * i]);
+  for (size_t k = 0; k < K; k++)
+    enc_half (B[k], A[k], S[2 * i + 1]);
+}
+
+template <typename Word, size_t K, typename V>
+RC5_INLINE void dec_round (const Word *S, V *A, V *B, size_t i)
+{
+  for (size_t k = 0; k < K; k++)
+    dec_half (B[k], A[k], S[2 * i + 1]);
+  for (size_t k = 0; k < K; k++)
+    dec_half (A[k], B[k], S[2 * i]);
+}
+
+/* all the rounds, unrolled by expanding the index pack */
+template <typename Word, size_t K, typename V, size_t... I>
+RC5_INLINE void encrypt (const Word *S, V *A, V *B, std::index_sequence<I...>)
+{
+  for (size_t k = 0; k < K; k++)
+    {
+      A[k] += S[0];
+      B[k] += S[1];
+    }
+  (enc_round<Word, K> (S, A, B, I + 1), ...);
+}
+
+template <typename Word, size_t K, typename V, size_t... I>
+RC5_INLINE void decrypt (const Word *S, V *A, V *B, std::index_sequence<I...>)
+{
+  (dec_round<Word, K> (S, A, B, sizeof... (I) - I), ...);
+  for (size_t k = 0; k < K; k++)
+    {
+      B[k] -= S[1];
+      A[k] -= S[0];
+    }
+}
+
+template <typename Word>
+RC5_INLINE Word load (const unsigned char *p)
+{
+  Word x = 0;
+  for (size_t i = sizeof (Word); i-- > 0; )
+    x = (Word) (x << 8 | p[i]);
+  return x;
+}
+
+template <typename Word>
+RC5_INLINE void store (unsigned char *p, Word x)
+{
+  for (size_t i = 0; i < sizeof (Word); i++, x = (Word) (x >> 8))
+    p[i] = (unsigned char) x;
+}
+
+/* K blocks in scalar code */
+template <typename Word, unsigned Rounds, size_t K>
+RC5_INLINE void crypt_scalar (const Word *S, const unsigned char *in,
+                              unsigned char *out, bool dec)
+{
+  constexpr size_t U = sizeof (Word);
+  Word A[K], B[K];
+  for (size_t k = 0; k < K; k++)
+    {
+      A[k] = load<Word> (in + 2 * U * k);
+      B[k] = load<Word> (in + 2 * U * k + U);
+    }
+  if (dec)
+    decrypt<Word, K> (S, A, B, std::make_index_sequence<Rounds> ());
+  else
+    encrypt<Word, K> (S, A, B, std::make_index_sequence<Rounds> ());
+  for (size_t k = 0; k < K; k++)
+    {
+      store<Word> (out + 2 * U * k, A[k]);
+      store<Word> (out + 2 * U * k + U, B[k]);
+    }
+}
+
+#ifdef RC5_SIMD
+
+#if defined(__clang__) || __GNUC__ >= 12
+#define RC5_SHUFFLE(V, a, b, ...) __builtin_shufflevector (a, b, __VA_ARGS__)
+#else
+#define RC5_SHUFFLE(V, a, b, ...) __builtin_shuffle (a, b, V { __VA_ARGS__ })
+#endif
+
+/*
+ * One AVX2 vector of words per half, 32 bytes of blocks per vector.  A
+ * pair of loaded vectors holds alternating A and B words; split() sorts
+ * them into a vector of A and one of B, join() undoes it.
+ */
+template <size_t Size> struct avx2;
+
+template <> struct avx2<4>
+{
+  typedef uint32_t vec __attribute__ ((vector_size (32)));
+  static constexpr size_t LANES = 8;
+
+  static RC5_INLINE void split (const vec *x, vec &a, vec &b)
+  {
+    a = RC5_SHUFFLE (vec, x[0], x[1], 0, 2, 4, 6, 8, 10, 12, 14);
+    b = RC5_SHUFFLE (vec, x[0], x[1], 1, 3, 5, 7, 9, 11, 13, 15);
+  }
+  static RC5_INLINE void join (vec *x, const vec &a, const vec &b)
+  {
+    x[0] = RC5_SHUFFLE (vec, a, b, 0, 8, 1, 9, 2, 10, 3, 11);
+    x[1] = RC5_SHUFFLE (vec, a, b, 4, 12, 5, 13, 6, 14, 7, 15);
+  }
+};
+
+template <> struct avx2<8>
+{
+  typedef uint64_t vec __attribute__ ((vector_size (32)));
+  static constexpr size_t LANES = 4;
+
+  static RC5_INLINE void split (const vec *x, vec &a, vec &b)
+  {
+    a = RC5_SHUFFLE (vec, x[0], x[1], 0, 2, 4, 6);
+    b = RC5_SHUFFLE (vec, x[0], x[1], 1, 3, 5, 7);
+  }
+  static RC5_INLINE void join (vec *x, const vec &a, const vec &b)
+  {
+    x[0] = RC5_SHUFFLE (vec, a, b, 0, 4, 1, 5);
+    x[1] = RC5_SHUFFLE (vec, a, b, 2, 6, 3, 7);
+  }
+};
+
+/* 2 * LANES blocks; x86 is little-endian, so words load as they are */
+template <typename Word, unsigned Rounds>
+__attribute__ ((target ("avx2")))
+void crypt_avx2 (const Word *S, const unsigned char *in, unsigned char *out,
+                 bool dec)
+{
+  typedef avx2<sizeof (Word)> simd;
+  typename simd::vec x[4], A[2], B[2];
+
+  memcpy (x, in, sizeof (x));
+  simd::split (x, A[0], B[0]);
+  simd::split (x + 2, A[1], B[1]);
+  if (dec)
+    decrypt<Word, 2> (S, A, B, std::make_index_sequence<Rounds> ());
+  else
+    encrypt<Word, 2> (S, A, B, std::make_index_sequence<Rounds> ());
+  simd::join (x, A[0], B[0]);
+  simd::join (x + 2, A[1], B[1]);
+  memcpy (out, x, sizeof (x));
+}
+
+#endif /* RC5_SIMD */
+
+} /* namespace rc5_detail */
+
+template <typename Word, unsigned Rounds, size_t KeyBytes>
+class RC5
+{
+  static_assert (std::is_unsigned<Word>::value
+                 && (sizeof (Word) == 2 || sizeof (Word) == 4
+                     || sizeof (Word) == 8),
+                 "RC5 words are 16, 32 or 64 bits");
+  static_assert (Rounds <= 255 && KeyBytes <= 255,
+                 "RC5 allows at most 255 rounds and 255 key bytes");
+
+public:
+  typedef Word word_type;
+
+  static constexpr unsigned WORDBITS = 8 * sizeof (Word);
+  static constexpr unsigned ROUNDS = Rounds;
+  static constexpr size_t BLOCKSIZE = 2 * sizeof (Word);
+  static constexpr size_t KEYLENGTH = KeyBytes;
+
+  RC5 () : S () {}
+  explicit RC5 (const unsigned char *key) { set_key (key); }
+  RC5 (const RC5 &) = default;
+  RC5 &operator= (const RC5 &) = default;
+  ~RC5 () { block_cipher_wipe (S, sizeof (S)); }
+
+  /* key is KeyBytes long */
+  void set_key (const unsigned char *key)
+  {
+    constexpr size_t U = sizeof (Word);
+    constexpr size_t C = KeyBytes ? (KeyBytes + U - 1) / U : 1;
+    constexpr size_t N = 3 * (T > C ? T : C);
+    Word L[C] = {};
+    Word A = 0, B = 0;
+    size_t i, j, k;
+
+    for (i = KeyBytes; i-- > 0; )
+      L[i / U] = (Word) (L[i / U] << 8 | key[i]);
+    S[0] = rc5_detail::magic<U>::P;
+    for (i = 1; i < T; i++)
+      S[i] = (Word) (S[i - 1] + rc5_detail::magic<U>::Q);
+    for (i = j = k = 0; k < N; k++, i = (i + 1) % T, j = (j + 1) % C)
+      {
+        A = S[i] = rotl ((Word) (S[i] + A + B), 3);
+        B = L[j] = rotl ((Word) (L[j] + A + B), (Word) (A + B));
+      }
+    block_cipher_wipe (L, sizeof (L));
+  }
+
+  /* n consecutive blocks; in may be the same as out */
+  void encrypt_blocks (const unsigned char *in, unsigned char *out,
+                       size_t n) const
+  {
+    crypt (in, out, n, false);
+  }
+
+  void decrypt_blocks (const unsigned char *in, unsigned char *out,
+                       size_t n) const
+  {
+    crypt (in, out, n, true);
+  }
+
+  void encrypt_block (const unsigned char *in, unsigned char *out) const
+  {
+    rc5_detail::crypt_scalar<Word, Rounds, 1> (S, in, out, false);
+  }
+
+  void decrypt_block (const unsigned char *in, unsigned char *out) const
+  {
+    rc5_detail::crypt_scalar<Word, Rounds, 1> (S, in, out, true);
+  }
+
+private:
+  static constexpr size_t T = 2 * (Rounds + 1);
+
+  Word S[T];    /* expanded key table */
+
+  static Word rotl (Word x, Word s)
+  {
+    s &= WORDBITS - 1;
+    return (Word) (x << s | x >> ((WORDBITS - s) & (WORDBITS - 1)));
+  }
+
+  void crypt (const unsigned char *in, unsigned char *out, size_t n,
+              bool dec) const
+  {
+#ifdef RC5_SIMD
+    if constexpr (sizeof (Word) >= 4)
+      {
+        constexpr size_t P = 2 * rc5_detail::avx2<sizeof (Word)>::LANES;
+        if (n >= P && __builtin_cpu_supports ("avx2"))
+          for (; n >= P; n -= P, in += P * BLOCKSIZE, out += P * BLOCKSIZE)
+            rc5_detail::crypt_avx2<Word, Rounds> (S, in, out, dec);
+      }
+#endif
+    for (; n; n--, in += BLOCKSIZE, out += BLOCKSIZE)
+      rc5_detail::crypt_scalar<Word, Rounds, 1> (S, in, out, dec);
+  }
+};
+
+typedef RC5<uint32_t, 12, 16> RC5_32_12_16;
+typedef RC5<uint64_t, 16, 16> RC5_64_16_16;
+
+/* RC5 under BlockCipher, for w = 32 (8-byte blocks) and w = 64 (16) */
+template <typename Word, unsigned Rounds, size_t KeyBytes>
+struct rc5_cipher
+{
+  typedef RC5<Word, Rounds, KeyBytes> context;
+  static constexpr size_t BLOCKSIZE = context::BLOCKSIZE;
+  static constexpr size_t MIN_KEYLENGTH = KeyBytes;
+  static constexpr size_t MAX_KEYLENGTH = KeyBytes;
+  static constexpr size_t KEYLENGTH_MULTIPLE = 1;
+  static const char *name ()
+  {
+    static const std::string n = "RC5-" + std::to_string (context::WORDBITS)
+                                 + "/" + std::to_string (Rounds)
+                                 + "/" + std::to_string (KeyBytes);
+    return n.c_str ();
+  }
+  static bool set_key (context &ctx, const unsigned char *key, size_t)
+  {
+    ctx.set_key (key);
+    return true;
+  }
+  static void encrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    ctx.encrypt_blocks (in, out, nblocks);
+  }
+  static void decrypt_blocks (const context &ctx, const unsigned char *in,
+                              unsigned char *out, size_t nblocks)
+  {
+    ctx.decrypt_blocks (in, out, nblocks);
+  }
+};
+
+#endif /* RC5_HPP */
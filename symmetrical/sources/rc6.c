@@ -33,20 +33,32 @@ Mean:          242 cycles =   105.9 mbits/sec
 
 */
 
-#include "../std_defs.h"
+#include <string.h>
+#include "rc6.h"
+
+/* The multi-block entry points run blocks in batches: 8 or 16 at  */
+/* a time in vectors (GCC/Clang vector extensions with AVX2 or     */
+/* AVX-512 variable rotates) when the processor has them, and four */
+/* at a time interleaved in scalar code otherwise. Define          */
+/* RC6_NO_SIMD to leave the vector code out.                       */
+
+#if !defined(RC6_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define RC6_SIMD
+#endif
 
 static char *alg_name[] = { "rc6", "rc62.c" };
 
-char **cipher_name()
+char **rc6_cipher_name(void)
 {
     return alg_name;
 }
 
 #define f_rnd(i,a,b,c,d)                \
-        t = b * (b + b + 1);            \
-        u = d * (d + d + 1);            \
-        a = rotl(a ^ rotl(t,5), u);     \
-        c = rotl(c ^ rotl(u,5), t);     \
+        t = rotl(b * (b + b + 1), 5);   \
+        u = rotl(d * (d + d + 1), 5);   \
+        a = rotl(a ^ t, u);             \
+        c = rotl(c ^ u, t);             \
         a += l_key[i];                  \
         c += l_key[i + 1]               \
 
@@ -56,12 +68,11 @@ char **cipher_name()
         c = rotr(c - l_key[i + 1], t) ^ u; \
         a = rotr(a - l_key[i], u) ^ t      \
 
-u4byte  l_key[44];  /* storage for the key schedule         */
-
 /* initialise the key schedule from the user supplied key   */
 
-u4byte *set_key(const u4byte in_key[], const u4byte key_len)
-{   u4byte  i, j, k, a, b, l[8], t;
+u4byte *rc6_set_key(rc6_ctx *ctx, const u4byte in_key[], const u4byte key_len)
+{   u4byte *l_key = ctx->l_key;
+    u4byte  i, j, k, a, b, l[8], t;
 
     l_key[0] = 0xb7e15163;
 
@@ -90,8 +101,9 @@ u4byte *set_key(const u4byte in_key[], const u4byte key_len)
 
 /* encrypt a block of text  */
 
-void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{   u4byte  a,b,c,d,t,u;
+void rc6_encrypt(const rc6_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{   const u4byte *l_key = ctx->l_key;
+    u4byte  a,b,c,d,t,u;
 
     a = in_blk[0]; b = in_blk[1] + l_key[0];
     c = in_blk[2]; d = in_blk[3] + l_key[1];
@@ -113,8 +125,9 @@ void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
 
 /* decrypt a block of text  */
 
-void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{   u4byte  a,b,c,d,t,u;
+void rc6_decrypt(const rc6_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{   const u4byte *l_key = ctx->l_key;
+    u4byte  a,b,c,d,t,u;
 
     d = in_blk[3]; c = in_blk[2] - l_key[43]; 
     b = in_blk[1]; a = in_blk[0] - l_key[42];
@@ -133,3 +146,223 @@ void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
     out_blk[3] = d - l_key[1]; out_blk[2] = c; 
     out_blk[1] = b - l_key[0]; out_blk[0] = a; 
 };
+
+/* Batches are held as slices: for n blocks, w[j], w[n + j],        */
+/* w[2 * n + j] and w[3 * n + j] are the words a, b, c and d of      */
+/* block j.                                                          */
+
+static void get_slices(const u1byte *in_blk, u4byte *w, size_t n)
+{   u4byte  b[4];
+    size_t  j;
+
+    for(j = 0; j < n; ++j, in_blk += 16)
+    {
+        memcpy(b, in_blk, 16);
+        w[j] = b[0]; w[n + j] = b[1]; w[2 * n + j] = b[2]; w[3 * n + j] = b[3];
+    }
+};
+
+static void put_slices(u1byte *out_blk, const u4byte *w, size_t n)
+{   u4byte  b[4];
+    size_t  j;
+
+    for(j = 0; j < n; ++j, out_blk += 16)
+    {
+        b[0] = w[j]; b[1] = w[n + j]; b[2] = w[2 * n + j]; b[3] = w[3 * n + j];
+        memcpy(out_blk, b, 16);
+    }
+};
+
+/* four blocks interleaved in scalar code   */
+
+#define f_rnd4(i,a,b,c,d)   for(j = 0; j < 4; ++j) { f_rnd(i,a[j],b[j],c[j],d[j]); }
+#define i_rnd4(i,a,b,c,d)   for(j = 0; j < 4; ++j) { i_rnd(i,a[j],b[j],c[j],d[j]); }
+
+static void rc6_encrypt4(const u4byte *l_key, u4byte w[16])
+{   u4byte  *a = w, *b = w + 4, *c = w + 8, *d = w + 12, t, u;
+    int     i, j;
+
+    for(j = 0; j < 4; ++j)
+    {
+        b[j] += l_key[0]; d[j] += l_key[1];
+    }
+
+    for(i = 2; i < 42; i += 8)
+    {
+        f_rnd4(i,a,b,c,d); f_rnd4(i + 2,b,c,d,a);
+        f_rnd4(i + 4,c,d,a,b); f_rnd4(i + 6,d,a,b,c);
+    }
+
+    for(j = 0; j < 4; ++j)
+    {
+        a[j] += l_key[42]; c[j] += l_key[43];
+    }
+};
+
+static void rc6_decrypt4(const u4byte *l_key, u4byte w[16])
+{   u4byte  *a = w, *b = w + 4, *c = w + 8, *d = w + 12, t, u;
+    int     i, j;
+
+    for(j = 0; j < 4; ++j)
+    {
+        c[j] -= l_key[43]; a[j] -= l_key[42];
+    }
+
+    for(i = 40; i > 0; i -= 8)
+    {
+        i_rnd4(i,d,a,b,c); i_rnd4(i - 2,c,d,a,b);
+        i_rnd4(i - 4,b,c,d,a); i_rnd4(i - 6,a,b,c,d);
+    }
+
+    for(j = 0; j < 4; ++j)
+    {
+        d[j] -= l_key[1]; b[j] -= l_key[0];
+    }
+};
+
+#ifdef  RC6_SIMD
+
+/* The same rounds on vectors of words, one block per lane. The    */
+/* multiplies map to vpmulld and the data dependent rotates to     */
+/* vpsllvd/vpsrlvd (AVX2) or vprolvd/vprorvd (AVX-512).            */
+
+typedef u4byte  v8word  __attribute__((vector_size(32)));
+typedef u4byte  v16word __attribute__((vector_size(64)));
+
+#define vrotl(x,n)  (((x) << (n)) | ((x) >> (32 - (n))))
+#define vrotlv(x,n) (((x) << ((n) & 31)) | ((x) >> (-(n) & 31)))
+#define vrotrv(x,n) (((x) >> ((n) & 31)) | ((x) << (-(n) & 31)))
+
+#define vf_rnd(i,a,b,c,d)               \
+        t = vrotl(b * (b + b + 1), 5);  \
+        u = vrotl(d * (d + d + 1), 5);  \
+        a = vrotlv(a ^ t, u);           \
+        c = vrotlv(c ^ u, t);           \
+        a += l_key[i];                  \
+        c += l_key[i + 1]
+
+#define vi_rnd(i,a,b,c,d)                   \
+        u = vrotl(d * (d + d + 1), 5);      \
+        t = vrotl(b * (b + b + 1), 5);      \
+        c = vrotrv(c - l_key[i + 1], t) ^ u; \
+        a = vrotrv(a - l_key[i], u) ^ t
+
+#define v_encrypt                                               \
+    b += l_key[0]; d += l_key[1];                               \
+    for(i = 2; i < 42; i += 8)                                  \
+    {                                                           \
+        vf_rnd(i,a,b,c,d); vf_rnd(i + 2,b,c,d,a);               \
+        vf_rnd(i + 4,c,d,a,b); vf_rnd(i + 6,d,a,b,c);           \
+    }                                                           \
+    a += l_key[42]; c += l_key[43]
+
+#define v_decrypt                                               \
+    c -= l_key[43]; a -= l_key[42];                             \
+    for(i = 40; i > 0; i -= 8)                                  \
+    {                                                           \
+        vi_rnd(i,d,a,b,c); vi_rnd(i - 2,c,d,a,b);               \
+        vi_rnd(i - 4,b,c,d,a); vi_rnd(i - 6,a,b,c,d);           \
+    }                                                           \
+    d -= l_key[1]; b -= l_key[0]
+
+#define v_load(w,n)                                             \
+    memcpy(&a, w, 4 * n); memcpy(&b, w + n, 4 * n);             \
+    memcpy(&c, w + 2 * n, 4 * n); memcpy(&d, w + 3 * n, 4 * n)
+
+#define v_store(w,n)                                            \
+    memcpy(w, &a, 4 * n); memcpy(w + n, &b, 4 * n);             \
+    memcpy(w + 2 * n, &c, 4 * n); memcpy(w + 3 * n, &d, 4 * n)
+
+__attribute__((target("avx2")))
+static void rc6_encrypt8(const u4byte *l_key, u4byte w[32])
+{   v8word  a,b,c,d,t,u;
+    int     i;
+
+    v_load(w, 8); v_encrypt; v_store(w, 8);
+};
+
+__attribute__((target("avx2")))
+static void rc6_decrypt8(const u4byte *l_key, u4byte w[32])
+{   v8word  a,b,c,d,t,u;
+    int     i;
+
+    v_load(w, 8); v_decrypt; v_store(w, 8);
+};
+
+__attribute__((target("avx512f")))
+static void rc6_encrypt16(const u4byte *l_key, u4byte w[64])
+{   v16word a,b,c,d,t,u;
+    int     i;
+
+    v_load(w, 16); v_encrypt; v_store(w, 16);
+};
+
+__attribute__((target("avx512f")))
+static void rc6_decrypt16(const u4byte *l_key, u4byte w[64])
+{   v16word a,b,c,d,t,u;
+    int     i;
+
+    v_load(w, 16); v_decrypt; v_store(w, 16);
+};
+
+#endif
+
+/* run whole batches, widest first, advancing in_blk, out_blk and  */
+/* n_blk past them; what is left goes to the one block code          */
+
+#define run_batches(dir)                                                \
+{   u4byte  w[64];                                                      \
+    RUN_SIMD(dir)                                                       \
+    for(; n_blk >= 4; n_blk -= 4, in_blk += 64, out_blk += 64)          \
+    {                                                                   \
+        get_slices(in_blk, w, 4); rc6_##dir##4(ctx->l_key, w);          \
+        put_slices(out_blk, w, 4);                                      \
+    }                                                                   \
+}
+
+#ifdef  RC6_SIMD
+#define RUN_SIMD(dir)                                                   \
+    if(n_blk >= 16 && __builtin_cpu_supports("avx512f"))                \
+        for(; n_blk >= 16; n_blk -= 16, in_blk += 256, out_blk += 256)  \
+        {                                                               \
+            get_slices(in_blk, w, 16); rc6_##dir##16(ctx->l_key, w);    \
+            put_slices(out_blk, w, 16);                                 \
+        }                                                               \
+    if(n_blk >= 8 && __builtin_cpu_supports("avx2"))                    \
+        for(; n_blk >= 8; n_blk -= 8, in_blk += 128, out_blk += 128)    \
+        {                                                               \
+            get_slices(in_blk, w, 8); rc6_##dir##8(ctx->l_key, w);      \
+            put_slices(out_blk, w, 8);                                  \
+        }
+#else
+#define RUN_SIMD(dir)
+#endif
+
+/* encrypt n_blk consecutive blocks of text held in byte buffers that */
+/* need not be word aligned; in_blk may be the same as out_blk        */
+
+void rc6_encrypt_blocks(const rc6_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{   u4byte  b_in[4], b_out[4];
+
+    run_batches(encrypt);
+
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+    {
+        memcpy(b_in, in_blk, 16); rc6_encrypt(ctx, b_in, b_out);
+        memcpy(out_blk, b_out, 16);
+    }
+};
+
+/* decrypt n_blk consecutive blocks of text                          */
+
+void rc6_decrypt_blocks(const rc6_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{   u4byte  b_in[4], b_out[4];
+
+    run_batches(decrypt);
+
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+    {
+        memcpy(b_in, in_blk, 16); rc6_decrypt(ctx, b_in, b_out);
+        memcpy(out_blk, b_out, 16);
+    }
+};
@@ -0,0 +1,32 @@
+
+/* RC6 with the key schedule held in a caller supplied              */
+/* context (see rc6.c). A context may be shared by any number       */
+/* of threads once its key has been set.                            */
+
+#ifndef _RC6_H
+#define _RC6_H
+
+#include "../std_defs.h"
+#include <stddef.h>
+#include "cache_align.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{   CACHE_ALIGN u4byte  l_key[44];  /* storage for the key schedule */
+} rc6_ctx;
+
+char    **rc6_cipher_name(void);
+u4byte  *rc6_set_key(rc6_ctx *ctx, const u4byte in_key[], const u4byte key_len);
+void    rc6_encrypt(const rc6_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    rc6_decrypt(const rc6_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    rc6_encrypt_blocks(const rc6_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+void    rc6_decrypt_blocks(const rc6_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
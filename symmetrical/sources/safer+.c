@@ -35,16 +35,17 @@ Mean:         3442 cycles =     7.4 mbits/sec
 #define BYTE_SWAP
 #define	WORD_SWAP
 
-#include "../std_defs.h"
+#include <string.h>
+#include "safer+.h"
 
 static char *alg_name[] = { "safer", "safer3.c" };
 
-char **cipher_name()
+char **saferp_cipher_name(void)
 {
 	return alg_name;
 };
 
-u1byte	expf[256] =
+static u1byte	expf[256] =
 {	  1,  45, 226, 147, 190,  69,  21, 174, 120,   3, 135, 164, 184,  56, 207,	63, 
 	  8, 103,	9, 148, 235,  38, 168, 107, 189,  24,  52,	27, 187, 191, 114, 247, 
 	 64,  53,  72, 156,  81,  47,  59,	85, 227, 192, 159, 216, 211, 243, 141, 177, 
@@ -63,7 +64,7 @@ u1byte	expf[256] =
 	225, 102, 221, 179,  88, 105,  99,	86,  15, 161,  49, 149,  23,   7,  58,	40 
 };
 
-u1byte logf[512] = 
+static u1byte logf[512] = 
 {
 	128,   0, 176,	 9,  96, 239, 185, 253,  16,  18, 159, 228, 105, 186, 173, 248, 
 	192,  56, 194, 101,  79,   6, 148, 252,  25, 222, 106,	27,  93,  78, 168, 130, 
@@ -100,16 +101,14 @@ u1byte logf[512] =
 	184,  64, 120,	45,  58, 233, 100,	31, 146, 144, 125,	57, 111, 224, 137,	48
 };
 
-u1byte	l_key[33 * 16];
-u4byte	k_bytes;
-
-u4byte *set_key(const u4byte in_key[], const u4byte key_len)
-{	u1byte	by, lk[33];
-	u4byte	i, j, k, l, m;
+u4byte *saferp_set_key(saferp_ctx *ctx, const u4byte in_key[], const u4byte key_len)
+{	u1byte *l_key = ctx->l_key;
+	u1byte	by, lk[33];
+	u4byte	i, j, k, l, m, k_bytes;
 
 	get_key(lk, key_len);
 
-	k_bytes = key_len / 8; lk[k_bytes] = 0;
+	k_bytes = ctx->k_bytes = key_len / 8; lk[k_bytes] = 0;
 
 	for(i = 0; i < k_bytes; ++i)
 	{
@@ -147,7 +146,7 @@ u4byte *set_key(const u4byte in_key[], const u4byte key_len)
 	return (u4byte*)l_key;
 };
 
-void do_fr(u1byte x[16], u1byte *kp)
+static void do_fr(u1byte x[16], const u1byte *kp)
 {	u1byte	t;
 
 	x[ 0] = expf[x[ 0] ^ kp[ 0]] + kp[16];
@@ -214,7 +213,7 @@ void do_fr(u1byte x[16], u1byte *kp)
 	t = x[15]; x[15] = x[3]; x[3] = t;
 };
 
-void do_ir(u1byte x[16], u1byte *kp)
+static void do_ir(u1byte x[16], const u1byte *kp)
 {	u1byte	t;
 
 	t = x[3]; x[3] = x[15]; x[15] = t; 
@@ -281,8 +280,10 @@ void do_ir(u1byte x[16], u1byte *kp)
 	x[15] = logf[x[15] - kp[31] + 256] ^ kp[15];
 };
 
-void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{	u1byte	blk[16], *kp;
+void saferp_encrypt(const saferp_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{	const u1byte *l_key = ctx->l_key;
+	u1byte	blk[16];
+	const u1byte	*kp;
 
 	get_block(blk);
 
@@ -291,19 +292,19 @@ void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
 	do_fr(blk, l_key + 128); do_fr(blk, l_key + 160);
 	do_fr(blk, l_key + 192); do_fr(blk, l_key + 224);
 	
-	if(k_bytes > 16)
+	if(ctx->k_bytes > 16)
 	{
 		do_fr(blk, l_key + 256); do_fr(blk, l_key + 288); 
 		do_fr(blk, l_key + 320); do_fr(blk, l_key + 352);
 	}
 
-	if(k_bytes > 24)
+	if(ctx->k_bytes > 24)
 	{
 		do_fr(blk, l_key + 384); do_fr(blk, l_key + 416); 
 		do_fr(blk, l_key + 448); do_fr(blk, l_key + 480);
 	}
 
-	kp = l_key + 16 * k_bytes;
+	kp = l_key + 16 * ctx->k_bytes;
 
 	blk[ 0] ^= kp[ 0]; blk[ 1] += kp[ 1];
 	blk[ 2] += kp[ 2]; blk[ 3] ^= kp[ 3]; 
@@ -317,12 +318,14 @@ void encrypt(const u4byte in_blk[4], u4byte out_blk[4])
 	put_block(blk);
 };
 
-void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{	u1byte	blk[16], *kp;
+void saferp_decrypt(const saferp_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{	const u1byte *l_key = ctx->l_key;
+	u1byte	blk[16];
+	const u1byte	*kp;
 
 	get_block(blk);
 
-	kp = l_key + 16 * k_bytes;
+	kp = l_key + 16 * ctx->k_bytes;
 
 	blk[ 0] ^= kp[ 0]; blk[ 1] -= kp[ 1];
 	blk[ 2] -= kp[ 2]; blk[ 3] ^= kp[ 3];
@@ -333,13 +336,13 @@ void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
 	blk[12] ^= kp[12]; blk[13] -= kp[13];
 	blk[14] -= kp[14]; blk[15] ^= kp[15];
 
-	if(k_bytes > 24)
+	if(ctx->k_bytes > 24)
 	{
 		do_ir(blk, l_key + 480); do_ir(blk, l_key + 448); 
 		do_ir(blk, l_key + 416); do_ir(blk, l_key + 384);
 	}
 
-	if(k_bytes > 16)
+	if(ctx->k_bytes > 16)
 	{
 		do_ir(blk, l_key + 352); do_ir(blk, l_key + 320); 
 		do_ir(blk, l_key + 288); do_ir(blk, l_key + 256);
@@ -352,3 +355,28 @@ void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
 
 	put_block(blk);
 };
+
+/* encrypt n_blk consecutive blocks of text held in byte buffers that */
+/* need not be word aligned; in_blk may be the same as out_blk        */
+
+void saferp_encrypt_blocks(const saferp_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{	u4byte	b_in[4], b_out[4];
+
+	for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+	{
+		memcpy(b_in, in_blk, 16); saferp_encrypt(ctx, b_in, b_out);
+		memcpy(out_blk, b_out, 16);
+	}
+};
+
+/* decrypt n_blk consecutive blocks of text                          */
+
+void saferp_decrypt_blocks(const saferp_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{	u4byte	b_in[4], b_out[4];
+
+	for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+	{
+		memcpy(b_in, in_blk, 16); saferp_decrypt(ctx, b_in, b_out);
+		memcpy(out_blk, b_out, 16);
+	}
+};
@@ -0,0 +1,33 @@
+
+/* SAFER+ with the key schedule held in a caller supplied           */
+/* context (see safer+.c). A context may be shared by any number    */
+/* of threads once its key has been set.                            */
+
+#ifndef _SAFERP_H
+#define _SAFERP_H
+
+#include "../std_defs.h"
+#include <stddef.h>
+#include "cache_align.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{   CACHE_ALIGN u1byte  l_key[33 * 16];    /* storage for the key schedule */
+    u4byte  k_bytes;
+} saferp_ctx;
+
+char    **saferp_cipher_name(void);
+u4byte  *saferp_set_key(saferp_ctx *ctx, const u4byte in_key[], const u4byte key_len);
+void    saferp_encrypt(const saferp_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    saferp_decrypt(const saferp_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    saferp_encrypt_blocks(const saferp_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+void    saferp_decrypt_blocks(const saferp_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
@@ -33,13 +33,24 @@ Mean:         1000 cycles =    25.6 mbits/sec
 
 */
 
-#include "../std_defs.h"
+#include <string.h>
+#include "serpent.h"
 
 #define BLOCK_REVERSE
 
+/* The multi-block entry points run 8 or 16 blocks at once through  */
+/* the same S box and linear transform macros applied to vectors of */
+/* words (GCC/Clang vector extensions), using AVX2 or AVX-512 when  */
+/* the processor has them. Define SERPENT_NO_SIMD to leave out.     */
+
+#if !defined(SERPENT_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define SERPENT_SIMD
+#endif
+
 static char *alg_name[] = { "serpent", "serpent6.c" };
 
-char **cipher_name()
+char **serpent_cipher_name(void)
 {
     return alg_name;
 }
@@ -56,10 +67,15 @@ char **cipher_name()
 /* I hereby give permission for the information in this file to */
 /* be used freely subject only to acknowledgement of its origin */
 
+/* The S box temporaries are of type sb_word, a 32-bit word here    */
+/* and a vector of them in the multi-block code.                    */
+
+#define sb_word u4byte
+
 /* 17 terms */
 
 #define sb0(a,b,c,d,e,f,g,h)                                    \
-{   u4byte  t1,t2,t3,t4,t6,t7,t8,t9,t11,t12,t13,t15,t16;        \
+{   sb_word t1,t2,t3,t4,t6,t7,t8,t9,t11,t12,t13,t15,t16;        \
     t1 = b ^ d;         \
     t2 = ~t1;           \
     t3 = a | d;         \
@@ -82,7 +98,7 @@ char **cipher_name()
 /* 17 terms */
 
 #define ib0(a,b,c,d,e,f,g,h)                                    \
-{   u4byte  t1,t2,t3,t4,t6,t7,t8,t9,t11,t12,t13,t15,t16;        \
+{   sb_word t1,t2,t3,t4,t6,t7,t8,t9,t11,t12,t13,t15,t16;        \
     t1 = a ^ d;         \
     t2 = c ^ d;         \
     t3 = ~t2;           \
@@ -105,7 +121,7 @@ char **cipher_name()
 /* 18 terms */
 
 #define sb1(a,b,c,d,e,f,g,h)                                    \
-{   u4byte  t1,t2,t3,t4,t5,t7,t8,t9,t10,t12,t13,t14,t16,t17;    \
+{   sb_word t1,t2,t3,t4,t5,t7,t8,t9,t10,t12,t13,t14,t16,t17;    \
     t1 = a ^ d;         \
     t2 = b ^ d;         \
     t3 = a & b;         \
@@ -129,7 +145,7 @@ char **cipher_name()
 /* 17 terms */
 
 #define ib1(a,b,c,d,e,f,g,h)                                \
-{   u4byte  t1,t2,t3,t4,t5,t7,t8,t9,t11,t12,t13,t15,t16;    \
+{   sb_word t1,t2,t3,t4,t5,t7,t8,t9,t11,t12,t13,t15,t16;    \
     t1 = a ^ d;         \
     t2 = a & b;         \
     t3 = b ^ c;         \
@@ -152,7 +168,7 @@ char **cipher_name()
 /* 16 terms */
 
 #define sb2(a,b,c,d,e,f,g,h)                            \
-{   u4byte  t1,t2,t3,t5,t6,t7,t9,t10,t11,t13,t14,t15;   \
+{   sb_word t1,t2,t3,t5,t6,t7,t9,t10,t11,t13,t14,t15;   \
     t1 = ~a;            \
     t2 = b ^ d;         \
     t3 = c & t1;        \
@@ -174,7 +190,7 @@ char **cipher_name()
 /* 16 terms */
 
 #define ib2(a,b,c,d,e,f,g,h)                                    \
-{   u4byte  t1,t2,t3,t4,t5,t7,t8,t9,t11,t12,t14,t15;            \
+{   sb_word t1,t2,t3,t4,t5,t7,t8,t9,t11,t12,t14,t15;            \
     t1 = b ^ d;         \
     t2 = ~t1;           \
     t3 = a ^ c;         \
@@ -196,7 +212,7 @@ char **cipher_name()
 /* 18 terms */
 
 #define sb3(a,b,c,d,e,f,g,h)                                    \
-{   u4byte  t1,t2,t3,t4,t5,t6,t8,t9,t10,t12,t13,t15,t16,t17;    \
+{   sb_word t1,t2,t3,t4,t5,t6,t8,t9,t10,t12,t13,t15,t16,t17;    \
     t1 = a ^ c;         \
     t2 = a | d;         \
     t3 = a & b;         \
@@ -220,7 +236,7 @@ char **cipher_name()
 /* 17 terms */
 
 #define ib3(a,b,c,d,e,f,g,h)                                    \
-{   u4byte  t1,t2,t3,t4,t5,t7,t8,t9,t11,t12,t14,t15,t16;        \
+{   sb_word t1,t2,t3,t4,t5,t7,t8,t9,t11,t12,t14,t15,t16;        \
     t1 = b ^ c;         \
     t2 = b | c;         \
     t3 = a ^ c;         \
@@ -243,7 +259,7 @@ char **cipher_name()
 /* 17 terms */
 
 #define sb4(a,b,c,d,e,f,g,h)                                    \
-{   u4byte  t1,t2,t3,t4,t5,t7,t8,t10,t11,t12,t14,t15,t16;       \
+{   sb_word t1,t2,t3,t4,t5,t7,t8,t10,t11,t12,t14,t15,t16;       \
     t1 = ~a;            \
     t2 = a ^ d;         \
     t3 = a ^ b;         \
@@ -266,7 +282,7 @@ char **cipher_name()
 /* 17 terms */
 
 #define ib4(a,b,c,d,e,f,g,h)                                    \
-{   u4byte  t1,t2,t3,t4,t6,t7,t8,t10,t11,t12,t14,t15,t16;       \
+{   sb_word t1,t2,t3,t4,t6,t7,t8,t10,t11,t12,t14,t15,t16;       \
     t1 = c ^ d;         \
     t2 = c | d;         \
     t3 = b ^ t2;        \
@@ -289,7 +305,7 @@ char **cipher_name()
 /* 17 terms */
 
 #define sb5(a,b,c,d,e,f,g,h)                                \
-{   u4byte  t1,t2,t3,t4,t5,t7,t8,t10,t11,t12,t14,t15,t16;   \
+{   sb_word t1,t2,t3,t4,t5,t7,t8,t10,t11,t12,t14,t15,t16;   \
     t1 = ~a;            \
     t2 = a ^ b;         \
     t3 = a ^ d;         \
@@ -312,7 +328,7 @@ char **cipher_name()
 /* 16 terms */
 
 #define ib5(a,b,c,d,e,f,g,h)                                \
-{   u4byte  t1,t2,t3,t4,t5,t7,t8,t10,t11,t13,t14,t15;       \
+{   sb_word t1,t2,t3,t4,t5,t7,t8,t10,t11,t13,t14,t15;       \
     t1 = ~c;            \
     t2 = b & t1;        \
     t3 = d ^ t2;        \
@@ -334,7 +350,7 @@ char **cipher_name()
 /* 17 terms */
 
 #define sb6(a,b,c,d,e,f,g,h)                                \
-{   u4byte  t1,t2,t3,t4,t5,t7,t8,t9,t11,t12,t13,t15,t16;    \
+{   sb_word t1,t2,t3,t4,t5,t7,t8,t9,t11,t12,t13,t15,t16;    \
     t1 = a ^ c;         \
     t2 = b | d;         \
     t3 = b ^ c;         \
@@ -357,7 +373,7 @@ char **cipher_name()
 /* 17 terms */
 
 #define ib6(a,b,c,d,e,f,g,h)                                \
-{   u4byte  t1,t2,t3,t4,t6,t7,t8,t9,t11,t12,t13,t15,t16;    \
+{   sb_word t1,t2,t3,t4,t6,t7,t8,t9,t11,t12,t13,t15,t16;    \
     t1 = ~c;            \
     t2 = a ^ c;         \
     t3 = b ^ d;         \
@@ -380,7 +396,7 @@ char **cipher_name()
 /* 17 terms */
 
 #define sb7(a,b,c,d,e,f,g,h)                                \
-{   u4byte  t1,t2,t3,t4,t5,t7,t8,t9,t11,t12,t13,t15,t16;    \
+{   sb_word t1,t2,t3,t4,t5,t7,t8,t9,t11,t12,t13,t15,t16;    \
     t1 = ~c;            \
     t2 = b ^ c;         \
     t3 = b | t1;        \
@@ -403,7 +419,7 @@ char **cipher_name()
 /* 17 terms */
 
 #define ib7(a,b,c,d,e,f,g,h)                                \
-{   u4byte  t1,t2,t3,t4,t6,t7,t8,t9,t11,t12,t14,t15,t16;    \
+{   sb_word t1,t2,t3,t4,t6,t7,t8,t9,t11,t12,t14,t15,t16;    \
     t1 = a & b;         \
     t2 = a | b;         \
     t3 = c | t1;        \
@@ -472,12 +488,84 @@ char **cipher_name()
     a = rotr(a, 13);    \
 }
 
-u4byte  l_key[140]; /* storage for the key schedule         */
+/* the 32 rounds, parameterised on the linear transformation so    */
+/* that the scalar and vector code share them                      */
+
+#define enc_rounds(lt)                                          \
+{   k_xor( 0,a,b,c,d); sb0(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor( 1,e,f,g,h); sb1(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor( 2,a,b,c,d); sb2(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor( 3,e,f,g,h); sb3(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor( 4,a,b,c,d); sb4(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor( 5,e,f,g,h); sb5(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor( 6,a,b,c,d); sb6(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor( 7,e,f,g,h); sb7(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor( 8,a,b,c,d); sb0(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor( 9,e,f,g,h); sb1(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor(10,a,b,c,d); sb2(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor(11,e,f,g,h); sb3(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor(12,a,b,c,d); sb4(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor(13,e,f,g,h); sb5(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor(14,a,b,c,d); sb6(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor(15,e,f,g,h); sb7(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor(16,a,b,c,d); sb0(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor(17,e,f,g,h); sb1(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor(18,a,b,c,d); sb2(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor(19,e,f,g,h); sb3(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor(20,a,b,c,d); sb4(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor(21,e,f,g,h); sb5(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor(22,a,b,c,d); sb6(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor(23,e,f,g,h); sb7(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor(24,a,b,c,d); sb0(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor(25,e,f,g,h); sb1(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor(26,a,b,c,d); sb2(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor(27,e,f,g,h); sb3(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor(28,a,b,c,d); sb4(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor(29,e,f,g,h); sb5(e,f,g,h,a,b,c,d); lt(a,b,c,d);       \
+    k_xor(30,a,b,c,d); sb6(a,b,c,d,e,f,g,h); lt(e,f,g,h);       \
+    k_xor(31,e,f,g,h); sb7(e,f,g,h,a,b,c,d); k_xor(32,a,b,c,d); \
+}
+
+#define dec_rounds(ilt)                                         \
+{   k_xor(32,a,b,c,d); ib7(a,b,c,d,e,f,g,h); k_xor(31,e,f,g,h); \
+    ilt(e,f,g,h); ib6(e,f,g,h,a,b,c,d); k_xor(30,a,b,c,d);      \
+    ilt(a,b,c,d); ib5(a,b,c,d,e,f,g,h); k_xor(29,e,f,g,h);      \
+    ilt(e,f,g,h); ib4(e,f,g,h,a,b,c,d); k_xor(28,a,b,c,d);      \
+    ilt(a,b,c,d); ib3(a,b,c,d,e,f,g,h); k_xor(27,e,f,g,h);      \
+    ilt(e,f,g,h); ib2(e,f,g,h,a,b,c,d); k_xor(26,a,b,c,d);      \
+    ilt(a,b,c,d); ib1(a,b,c,d,e,f,g,h); k_xor(25,e,f,g,h);      \
+    ilt(e,f,g,h); ib0(e,f,g,h,a,b,c,d); k_xor(24,a,b,c,d);      \
+    ilt(a,b,c,d); ib7(a,b,c,d,e,f,g,h); k_xor(23,e,f,g,h);      \
+    ilt(e,f,g,h); ib6(e,f,g,h,a,b,c,d); k_xor(22,a,b,c,d);      \
+    ilt(a,b,c,d); ib5(a,b,c,d,e,f,g,h); k_xor(21,e,f,g,h);      \
+    ilt(e,f,g,h); ib4(e,f,g,h,a,b,c,d); k_xor(20,a,b,c,d);      \
+    ilt(a,b,c,d); ib3(a,b,c,d,e,f,g,h); k_xor(19,e,f,g,h);      \
+    ilt(e,f,g,h); ib2(e,f,g,h,a,b,c,d); k_xor(18,a,b,c,d);      \
+    ilt(a,b,c,d); ib1(a,b,c,d,e,f,g,h); k_xor(17,e,f,g,h);      \
+    ilt(e,f,g,h); ib0(e,f,g,h,a,b,c,d); k_xor(16,a,b,c,d);      \
+    ilt(a,b,c,d); ib7(a,b,c,d,e,f,g,h); k_xor(15,e,f,g,h);      \
+    ilt(e,f,g,h); ib6(e,f,g,h,a,b,c,d); k_xor(14,a,b,c,d);      \
+    ilt(a,b,c,d); ib5(a,b,c,d,e,f,g,h); k_xor(13,e,f,g,h);      \
+    ilt(e,f,g,h); ib4(e,f,g,h,a,b,c,d); k_xor(12,a,b,c,d);      \
+    ilt(a,b,c,d); ib3(a,b,c,d,e,f,g,h); k_xor(11,e,f,g,h);      \
+    ilt(e,f,g,h); ib2(e,f,g,h,a,b,c,d); k_xor(10,a,b,c,d);      \
+    ilt(a,b,c,d); ib1(a,b,c,d,e,f,g,h); k_xor( 9,e,f,g,h);      \
+    ilt(e,f,g,h); ib0(e,f,g,h,a,b,c,d); k_xor( 8,a,b,c,d);      \
+    ilt(a,b,c,d); ib7(a,b,c,d,e,f,g,h); k_xor( 7,e,f,g,h);      \
+    ilt(e,f,g,h); ib6(e,f,g,h,a,b,c,d); k_xor( 6,a,b,c,d);      \
+    ilt(a,b,c,d); ib5(a,b,c,d,e,f,g,h); k_xor( 5,e,f,g,h);      \
+    ilt(e,f,g,h); ib4(e,f,g,h,a,b,c,d); k_xor( 4,a,b,c,d);      \
+    ilt(a,b,c,d); ib3(a,b,c,d,e,f,g,h); k_xor( 3,e,f,g,h);      \
+    ilt(e,f,g,h); ib2(e,f,g,h,a,b,c,d); k_xor( 2,a,b,c,d);      \
+    ilt(a,b,c,d); ib1(a,b,c,d,e,f,g,h); k_xor( 1,e,f,g,h);      \
+    ilt(e,f,g,h); ib0(e,f,g,h,a,b,c,d); k_xor( 0,a,b,c,d);      \
+}
 
 /* initialise the key schedule from the user supplied key   */
 
-u4byte *set_key(const u4byte in_key[], const u4byte key_len)
-{    u4byte  i,lk,a,b,c,d,e,f,g,h;
+u4byte *serpent_set_key(serpent_ctx *ctx, const u4byte in_key[], const u4byte key_len)
+{    u4byte *l_key = ctx->l_key;
+     u4byte  i,lk,a,b,c,d,e,f,g,h;
 
     if(key_len < 0 || key_len > 256)
 
@@ -553,8 +641,9 @@ u4byte *set_key(const u4byte in_key[], const u4byte key_len)
 
 /* encrypt a block of text  */
 
-void encrypt(const u4byte in_blk[4], u4byte out_blk[])
-{    u4byte  a,b,c,d,e,f,g,h;
+void serpent_encrypt(const serpent_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{    const u4byte *l_key = ctx->l_key;
+     u4byte  a,b,c,d,e,f,g,h;
     
 #ifdef  BLOCK_REVERSE
     a = bswap(in_blk[3]); b = bswap(in_blk[2]); 
@@ -563,38 +652,7 @@ void encrypt(const u4byte in_blk[4], u4byte out_blk[])
     a = in_blk[0]; b = in_blk[1]; c = in_blk[2]; d = in_blk[3];
 #endif
 
-    k_xor( 0,a,b,c,d); sb0(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor( 1,e,f,g,h); sb1(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor( 2,a,b,c,d); sb2(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor( 3,e,f,g,h); sb3(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor( 4,a,b,c,d); sb4(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor( 5,e,f,g,h); sb5(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor( 6,a,b,c,d); sb6(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor( 7,e,f,g,h); sb7(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor( 8,a,b,c,d); sb0(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor( 9,e,f,g,h); sb1(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor(10,a,b,c,d); sb2(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor(11,e,f,g,h); sb3(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor(12,a,b,c,d); sb4(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor(13,e,f,g,h); sb5(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor(14,a,b,c,d); sb6(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor(15,e,f,g,h); sb7(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor(16,a,b,c,d); sb0(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor(17,e,f,g,h); sb1(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor(18,a,b,c,d); sb2(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor(19,e,f,g,h); sb3(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor(20,a,b,c,d); sb4(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor(21,e,f,g,h); sb5(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor(22,a,b,c,d); sb6(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor(23,e,f,g,h); sb7(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor(24,a,b,c,d); sb0(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor(25,e,f,g,h); sb1(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor(26,a,b,c,d); sb2(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor(27,e,f,g,h); sb3(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor(28,a,b,c,d); sb4(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor(29,e,f,g,h); sb5(e,f,g,h,a,b,c,d); rot(a,b,c,d); 
-    k_xor(30,a,b,c,d); sb6(a,b,c,d,e,f,g,h); rot(e,f,g,h); 
-    k_xor(31,e,f,g,h); sb7(e,f,g,h,a,b,c,d); k_xor(32,a,b,c,d); 
+    enc_rounds(rot);
     
 #ifdef  BLOCK_REVERSE
     out_blk[3] = bswap(a); out_blk[2] = bswap(b); 
@@ -606,8 +664,9 @@ void encrypt(const u4byte in_blk[4], u4byte out_blk[])
 
 /* decrypt a block of text  */
 
-void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{   u4byte  a,b,c,d,e,f,g,h;
+void serpent_decrypt(const serpent_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{   const u4byte *l_key = ctx->l_key;
+    u4byte  a,b,c,d,e,f,g,h;
     
 #ifdef  BLOCK_REVERSE
     a = bswap(in_blk[3]); b = bswap(in_blk[2]); 
@@ -616,38 +675,7 @@ void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
     a = in_blk[0]; b = in_blk[1]; c = in_blk[2]; d = in_blk[3];
 #endif
 
-    k_xor(32,a,b,c,d); ib7(a,b,c,d,e,f,g,h); k_xor(31,e,f,g,h);
-    irot(e,f,g,h); ib6(e,f,g,h,a,b,c,d); k_xor(30,a,b,c,d);
-    irot(a,b,c,d); ib5(a,b,c,d,e,f,g,h); k_xor(29,e,f,g,h);
-    irot(e,f,g,h); ib4(e,f,g,h,a,b,c,d); k_xor(28,a,b,c,d);
-    irot(a,b,c,d); ib3(a,b,c,d,e,f,g,h); k_xor(27,e,f,g,h);
-    irot(e,f,g,h); ib2(e,f,g,h,a,b,c,d); k_xor(26,a,b,c,d);
-    irot(a,b,c,d); ib1(a,b,c,d,e,f,g,h); k_xor(25,e,f,g,h);
-    irot(e,f,g,h); ib0(e,f,g,h,a,b,c,d); k_xor(24,a,b,c,d);
-    irot(a,b,c,d); ib7(a,b,c,d,e,f,g,h); k_xor(23,e,f,g,h);
-    irot(e,f,g,h); ib6(e,f,g,h,a,b,c,d); k_xor(22,a,b,c,d);
-    irot(a,b,c,d); ib5(a,b,c,d,e,f,g,h); k_xor(21,e,f,g,h);
-    irot(e,f,g,h); ib4(e,f,g,h,a,b,c,d); k_xor(20,a,b,c,d);
-    irot(a,b,c,d); ib3(a,b,c,d,e,f,g,h); k_xor(19,e,f,g,h);
-    irot(e,f,g,h); ib2(e,f,g,h,a,b,c,d); k_xor(18,a,b,c,d);
-    irot(a,b,c,d); ib1(a,b,c,d,e,f,g,h); k_xor(17,e,f,g,h);
-    irot(e,f,g,h); ib0(e,f,g,h,a,b,c,d); k_xor(16,a,b,c,d);
-    irot(a,b,c,d); ib7(a,b,c,d,e,f,g,h); k_xor(15,e,f,g,h);
-    irot(e,f,g,h); ib6(e,f,g,h,a,b,c,d); k_xor(14,a,b,c,d);
-    irot(a,b,c,d); ib5(a,b,c,d,e,f,g,h); k_xor(13,e,f,g,h);
-    irot(e,f,g,h); ib4(e,f,g,h,a,b,c,d); k_xor(12,a,b,c,d);
-    irot(a,b,c,d); ib3(a,b,c,d,e,f,g,h); k_xor(11,e,f,g,h);
-    irot(e,f,g,h); ib2(e,f,g,h,a,b,c,d); k_xor(10,a,b,c,d);
-    irot(a,b,c,d); ib1(a,b,c,d,e,f,g,h); k_xor( 9,e,f,g,h);
-    irot(e,f,g,h); ib0(e,f,g,h,a,b,c,d); k_xor( 8,a,b,c,d);
-    irot(a,b,c,d); ib7(a,b,c,d,e,f,g,h); k_xor( 7,e,f,g,h);
-    irot(e,f,g,h); ib6(e,f,g,h,a,b,c,d); k_xor( 6,a,b,c,d);
-    irot(a,b,c,d); ib5(a,b,c,d,e,f,g,h); k_xor( 5,e,f,g,h);
-    irot(e,f,g,h); ib4(e,f,g,h,a,b,c,d); k_xor( 4,a,b,c,d);
-    irot(a,b,c,d); ib3(a,b,c,d,e,f,g,h); k_xor( 3,e,f,g,h);
-    irot(e,f,g,h); ib2(e,f,g,h,a,b,c,d); k_xor( 2,a,b,c,d);
-    irot(a,b,c,d); ib1(a,b,c,d,e,f,g,h); k_xor( 1,e,f,g,h);
-    irot(e,f,g,h); ib0(e,f,g,h,a,b,c,d); k_xor( 0,a,b,c,d);
+    dec_rounds(irot);
     
 #ifdef  BLOCK_REVERSE
     out_blk[3] = bswap(a); out_blk[2] = bswap(b); 
@@ -656,3 +684,192 @@ void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
     out_blk[0] = a; out_blk[1] = b; out_blk[2] = c; out_blk[3] = d;
 #endif
 };
+
+#ifdef  SERPENT_SIMD
+
+/* Word-sliced multi-block code. Block i of a batch of n occupies   */
+/* lane i of four vectors a, b, c and d, so each S box and linear   */
+/* transform step below runs on n blocks with one instruction.      */
+
+typedef u4byte  v8word  __attribute__((vector_size(32)));
+typedef u4byte  v16word __attribute__((vector_size(64)));
+
+#define vrotl(x,n)  (((x) << (n)) | ((x) >> (32 - (n))))
+#define vrotr(x,n)  (((x) >> (n)) | ((x) << (32 - (n))))
+
+#define vrot(a,b,c,d)   \
+{   a = vrotl(a, 13);   \
+    c = vrotl(c, 3);    \
+    d ^= c ^ (a << 3);  \
+    b ^= a ^ c;         \
+    d = vrotl(d, 7);    \
+    b = vrotl(b, 1);    \
+    a ^= b ^ d;         \
+    c ^= d ^ (b << 7);  \
+    a = vrotl(a, 5);    \
+    c = vrotl(c, 22);   \
+}
+
+#define virot(a,b,c,d)  \
+{   c = vrotr(c, 22);   \
+    a = vrotr(a, 5);    \
+    c ^= d ^ (b << 7);  \
+    a ^= b ^ d;         \
+    d = vrotr(d, 7);    \
+    b = vrotr(b, 1);    \
+    d ^= c ^ (a << 3);  \
+    b ^= a ^ c;         \
+    c = vrotr(c, 3);    \
+    a = vrotr(a, 13);   \
+}
+
+/* gather n blocks into slices: w[i], w[n + i], w[2 * n + i] and    */
+/* w[3 * n + i] receive the words a, b, c and d of block i          */
+
+static void get_slices(const u1byte *in_blk, u4byte *w, size_t n)
+{   u4byte  b[4];
+    size_t  i;
+
+    for(i = 0; i < n; ++i, in_blk += 16)
+    {
+        memcpy(b, in_blk, 16);
+#ifdef  BLOCK_REVERSE
+        w[i] = bswap(b[3]); w[n + i] = bswap(b[2]);
+        w[2 * n + i] = bswap(b[1]); w[3 * n + i] = bswap(b[0]);
+#else
+        w[i] = b[0]; w[n + i] = b[1]; w[2 * n + i] = b[2]; w[3 * n + i] = b[3];
+#endif
+    }
+};
+
+/* scatter slices back into n blocks                                */
+
+static void put_slices(u1byte *out_blk, const u4byte *w, size_t n)
+{   u4byte  b[4];
+    size_t  i;
+
+    for(i = 0; i < n; ++i, out_blk += 16)
+    {
+#ifdef  BLOCK_REVERSE
+        b[3] = bswap(w[i]); b[2] = bswap(w[n + i]);
+        b[1] = bswap(w[2 * n + i]); b[0] = bswap(w[3 * n + i]);
+#else
+        b[0] = w[i]; b[1] = w[n + i]; b[2] = w[2 * n + i]; b[3] = w[3 * n + i];
+#endif
+        memcpy(out_blk, b, 16);
+    }
+};
+
+#undef  sb_word
+#define sb_word v8word
+
+__attribute__((target("avx2")))
+static void serpent_encrypt8(const u4byte *l_key, u4byte w[32])
+{   v8word  a,b,c,d,e,f,g,h;
+
+    memcpy(&a, w, 32); memcpy(&b, w + 8, 32);
+    memcpy(&c, w + 16, 32); memcpy(&d, w + 24, 32);
+    enc_rounds(vrot);
+    memcpy(w, &a, 32); memcpy(w + 8, &b, 32);
+    memcpy(w + 16, &c, 32); memcpy(w + 24, &d, 32);
+};
+
+__attribute__((target("avx2")))
+static void serpent_decrypt8(const u4byte *l_key, u4byte w[32])
+{   v8word  a,b,c,d,e,f,g,h;
+
+    memcpy(&a, w, 32); memcpy(&b, w + 8, 32);
+    memcpy(&c, w + 16, 32); memcpy(&d, w + 24, 32);
+    dec_rounds(virot);
+    memcpy(w, &a, 32); memcpy(w + 8, &b, 32);
+    memcpy(w + 16, &c, 32); memcpy(w + 24, &d, 32);
+};
+
+#undef  sb_word
+#define sb_word v16word
+
+__attribute__((target("avx512f")))
+static void serpent_encrypt16(const u4byte *l_key, u4byte w[64])
+{   v16word a,b,c,d,e,f,g,h;
+
+    memcpy(&a, w, 64); memcpy(&b, w + 16, 64);
+    memcpy(&c, w + 32, 64); memcpy(&d, w + 48, 64);
+    enc_rounds(vrot);
+    memcpy(w, &a, 64); memcpy(w + 16, &b, 64);
+    memcpy(w + 32, &c, 64); memcpy(w + 48, &d, 64);
+};
+
+__attribute__((target("avx512f")))
+static void serpent_decrypt16(const u4byte *l_key, u4byte w[64])
+{   v16word a,b,c,d,e,f,g,h;
+
+    memcpy(&a, w, 64); memcpy(&b, w + 16, 64);
+    memcpy(&c, w + 32, 64); memcpy(&d, w + 48, 64);
+    dec_rounds(virot);
+    memcpy(w, &a, 64); memcpy(w + 16, &b, 64);
+    memcpy(w + 32, &c, 64); memcpy(w + 48, &d, 64);
+};
+
+#undef  sb_word
+#define sb_word u4byte
+
+#endif
+
+/* encrypt n_blk consecutive blocks of text held in byte buffers that */
+/* need not be word aligned; in_blk may be the same as out_blk        */
+
+void serpent_encrypt_blocks(const serpent_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{   u4byte  b_in[4], b_out[4];
+#ifdef  SERPENT_SIMD
+    u4byte  w[64];
+
+    if(n_blk >= 16 && __builtin_cpu_supports("avx512f"))
+        for(; n_blk >= 16; n_blk -= 16, in_blk += 256, out_blk += 256)
+        {
+            get_slices(in_blk, w, 16); serpent_encrypt16(ctx->l_key, w);
+            put_slices(out_blk, w, 16);
+        }
+
+    if(n_blk >= 8 && __builtin_cpu_supports("avx2"))
+        for(; n_blk >= 8; n_blk -= 8, in_blk += 128, out_blk += 128)
+        {
+            get_slices(in_blk, w, 8); serpent_encrypt8(ctx->l_key, w);
+            put_slices(out_blk, w, 8);
+        }
+#endif
+
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+    {
+        memcpy(b_in, in_blk, 16); serpent_encrypt(ctx, b_in, b_out);
+        memcpy(out_blk, b_out, 16);
+    }
+};
+
+/* decrypt n_blk consecutive blocks of text                          */
+
+void serpent_decrypt_blocks(const serpent_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{   u4byte  b_in[4], b_out[4];
+#ifdef  SERPENT_SIMD
+    u4byte  w[64];
+
+    if(n_blk >= 16 && __builtin_cpu_supports("avx512f"))
+        for(; n_blk >= 16; n_blk -= 16, in_blk += 256, out_blk += 256)
+        {
+            get_slices(in_blk, w, 16); serpent_decrypt16(ctx->l_key, w);
+            put_slices(out_blk, w, 16);
+        }
+
+    if(n_blk >= 8 && __builtin_cpu_supports("avx2"))
+        for(; n_blk >= 8; n_blk -= 8, in_blk += 128, out_blk += 128)
+        {
+            get_slices(in_blk, w, 8); serpent_decrypt8(ctx->l_key, w);
+            put_slices(out_blk, w, 8);
+        }
+#endif
+
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+    {
+        memcpy(b_in, in_blk, 16); serpent_decrypt(ctx, b_in, b_out);
+        memcpy(out_blk, b_out, 16);
+    }
+};
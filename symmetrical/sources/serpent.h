@@ -0,0 +1,32 @@
+
+/* Serpent with the key schedule held in a caller supplied          */
+/* context (see serpent.c). A context may be shared by any number   */
+/* of threads once its key has been set.                            */
+
+#ifndef _SERPENT_H
+#define _SERPENT_H
+
+#include "../std_defs.h"
+#include <stddef.h>
+#include "cache_align.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{   CACHE_ALIGN u4byte  l_key[140]; /* storage for the key schedule */
+} serpent_ctx;
+
+char    **serpent_cipher_name(void);
+u4byte  *serpent_set_key(serpent_ctx *ctx, const u4byte in_key[], const u4byte key_len);
+void    serpent_encrypt(const serpent_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    serpent_decrypt(const serpent_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    serpent_encrypt_blocks(const serpent_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+void    serpent_decrypt_blocks(const serpent_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
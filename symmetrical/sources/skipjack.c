@@ -6,6 +6,9 @@
  *	optimized by Paulo Barreto <pbarreto@nw.com.br> 1998.06.30
  */
 
+#include <string.h>
+#include "skipjack.h"
+
 typedef unsigned char	byte;
 typedef unsigned int	word32;
 
@@ -70,7 +73,7 @@ static const byte fTable[256] = {
 /**
  * Preprocess a user key into a table to save an XOR at each F-table access.
  */
-void makeKey(byte key[10], byte tab[10][256]) {
+static void makeKey(const byte key[10], byte tab[10][256]) {
 	/* tab[i][c] = fTable[c ^ key[i]] */
 	int i;
 	for (i = 0; i < 10; i++) {
@@ -85,7 +88,8 @@ void makeKey(byte key[10], byte tab[10][256]) {
 /**
  * Encrypt a single block of data.
  */
-void encrypt(byte tab[10][256], byte in[8], byte out[8]) {
+void skipjack_encrypt(const skipjack_ctx *ctx, const byte in[8], byte out[8]) {
+	const byte (*tab)[256] = ctx->tab;
 	word32 w1, w2, w3, w4;
 
 	w1 = (in[0] << 8) + in[1];
@@ -143,7 +147,8 @@ void encrypt(byte tab[10][256], byte in[8], byte out[8]) {
 /**
  * Decrypt a single block of data.
  */
-void decrypt(byte tab[10][256], byte in[8], byte out[8]) {
+void skipjack_decrypt(const skipjack_ctx *ctx, const byte in[8], byte out[8]) {
+	const byte (*tab)[256] = ctx->tab;
 	word32 w1, w2, w3, w4;
 
 	w1 = (in[0] << 8) + in[1];
@@ -198,30 +203,253 @@ void decrypt(byte tab[10][256], byte in[8], byte out[8]) {
 
 }
 
+/**
+ * Multi-block interface.
+ *
+ * Each G step is a chain of four dependent table loads, and each step
+ * waits on the one before it.  Blocks are independent, so running up
+ * to eight of them through every step in lockstep lets their chains
+ * overlap; all of them read the same key table.  n is a constant at
+ * every call, so the lane tests fold away.
+ */
+#if defined(__GNUC__)
+#define SJ_INLINE static __inline__ __attribute__((always_inline))
+#else
+#define SJ_INLINE static
+#endif
+
+#define SJ_MAX_LANES 8
+
+#define SJ_LANES(op, G, x, y, c) do { \
+	op(G, x, y, c, 0); \
+	if (n > 1) op(G, x, y, c, 1); \
+	if (n > 2) op(G, x, y, c, 2); \
+	if (n > 3) op(G, x, y, c, 3); \
+	if (n > 4) op(G, x, y, c, 4); \
+	if (n > 5) op(G, x, y, c, 5); \
+	if (n > 6) op(G, x, y, c, 6); \
+	if (n > 7) op(G, x, y, c, 7); \
+} while (0)
+
+/* rule A permutes x and then folds it into y; rule B the other way round */
+#define SJ_A(G, x, y, c, j) { G(tab, x[j]); y[j] ^= x[j] ^ c; }
+#define SJ_B(G, x, y, c, j) { y[j] ^= x[j] ^ c; G(tab, x[j]); }
+
+#define SJ_GET(w1, w2, w3, w4, p) { \
+	for (j = 0; j < n; j++) { \
+		w1[j] = (p[8*j + 0] << 8) + p[8*j + 1]; \
+		w2[j] = (p[8*j + 2] << 8) + p[8*j + 3]; \
+		w3[j] = (p[8*j + 4] << 8) + p[8*j + 5]; \
+		w4[j] = (p[8*j + 6] << 8) + p[8*j + 7]; \
+	} \
+}
+
+#define SJ_PUT(p, w1, w2, w3, w4) { \
+	for (j = 0; j < n; j++) { \
+		p[8*j + 0] = (byte)(w1[j] >> 8); p[8*j + 1] = (byte)w1[j]; \
+		p[8*j + 2] = (byte)(w2[j] >> 8); p[8*j + 3] = (byte)w2[j]; \
+		p[8*j + 4] = (byte)(w3[j] >> 8); p[8*j + 5] = (byte)w3[j]; \
+		p[8*j + 6] = (byte)(w4[j] >> 8); p[8*j + 7] = (byte)w4[j]; \
+	} \
+}
+
+SJ_INLINE void encrypt_lanes(const byte tab[10][256], const byte *in,
+		byte *out, const int n) {
+	word32 w1[SJ_MAX_LANES], w2[SJ_MAX_LANES];
+	word32 w3[SJ_MAX_LANES], w4[SJ_MAX_LANES];
+	int j;
+
+	SJ_GET(w1, w2, w3, w4, in);
+
+	/* stepping rule A: */
+	SJ_LANES(SJ_A, g0, w1, w4,  1);
+	SJ_LANES(SJ_A, g1, w4, w3,  2);
+	SJ_LANES(SJ_A, g2, w3, w2,  3);
+	SJ_LANES(SJ_A, g3, w2, w1,  4);
+	SJ_LANES(SJ_A, g4, w1, w4,  5);
+	SJ_LANES(SJ_A, g0, w4, w3,  6);
+	SJ_LANES(SJ_A, g1, w3, w2,  7);
+	SJ_LANES(SJ_A, g2, w2, w1,  8);
+
+	/* stepping rule B: */
+	SJ_LANES(SJ_B, g3, w1, w2,  9);
+	SJ_LANES(SJ_B, g4, w4, w1, 10);
+	SJ_LANES(SJ_B, g0, w3, w4, 11);
+	SJ_LANES(SJ_B, g1, w2, w3, 12);
+	SJ_LANES(SJ_B, g2, w1, w2, 13);
+	SJ_LANES(SJ_B, g3, w4, w1, 14);
+	SJ_LANES(SJ_B, g4, w3, w4, 15);
+	SJ_LANES(SJ_B, g0, w2, w3, 16);
+
+	/* stepping rule A: */
+	SJ_LANES(SJ_A, g1, w1, w4, 17);
+	SJ_LANES(SJ_A, g2, w4, w3, 18);
+	SJ_LANES(SJ_A, g3, w3, w2, 19);
+	SJ_LANES(SJ_A, g4, w2, w1, 20);
+	SJ_LANES(SJ_A, g0, w1, w4, 21);
+	SJ_LANES(SJ_A, g1, w4, w3, 22);
+	SJ_LANES(SJ_A, g2, w3, w2, 23);
+	SJ_LANES(SJ_A, g3, w2, w1, 24);
+
+	/* stepping rule B: */
+	SJ_LANES(SJ_B, g4, w1, w2, 25);
+	SJ_LANES(SJ_B, g0, w4, w1, 26);
+	SJ_LANES(SJ_B, g1, w3, w4, 27);
+	SJ_LANES(SJ_B, g2, w2, w3, 28);
+	SJ_LANES(SJ_B, g3, w1, w2, 29);
+	SJ_LANES(SJ_B, g4, w4, w1, 30);
+	SJ_LANES(SJ_B, g0, w3, w4, 31);
+	SJ_LANES(SJ_B, g1, w2, w3, 32);
+
+	SJ_PUT(out, w1, w2, w3, w4);
+}
+
+SJ_INLINE void decrypt_lanes(const byte tab[10][256], const byte *in,
+		byte *out, const int n) {
+	word32 w1[SJ_MAX_LANES], w2[SJ_MAX_LANES];
+	word32 w3[SJ_MAX_LANES], w4[SJ_MAX_LANES];
+	int j;
+
+	SJ_GET(w1, w2, w3, w4, in);
+
+	/* stepping rule A: */
+	SJ_LANES(SJ_A, h1, w2, w3, 32);
+	SJ_LANES(SJ_A, h0, w3, w4, 31);
+	SJ_LANES(SJ_A, h4, w4, w1, 30);
+	SJ_LANES(SJ_A, h3, w1, w2, 29);
+	SJ_LANES(SJ_A, h2, w2, w3, 28);
+	SJ_LANES(SJ_A, h1, w3, w4, 27);
+	SJ_LANES(SJ_A, h0, w4, w1, 26);
+	SJ_LANES(SJ_A, h4, w1, w2, 25);
+
+	/* stepping rule B: */
+	SJ_LANES(SJ_B, h3, w2, w1, 24);
+	SJ_LANES(SJ_B, h2, w3, w2, 23);
+	SJ_LANES(SJ_B, h1, w4, w3, 22);
+	SJ_LANES(SJ_B, h0, w1, w4, 21);
+	SJ_LANES(SJ_B, h4, w2, w1, 20);
+	SJ_LANES(SJ_B, h3, w3, w2, 19);
+	SJ_LANES(SJ_B, h2, w4, w3, 18);
+	SJ_LANES(SJ_B, h1, w1, w4, 17);
+
+	/* stepping rule A: */
+	SJ_LANES(SJ_A, h0, w2, w3, 16);
+	SJ_LANES(SJ_A, h4, w3, w4, 15);
+	SJ_LANES(SJ_A, h3, w4, w1, 14);
+	SJ_LANES(SJ_A, h2, w1, w2, 13);
+	SJ_LANES(SJ_A, h1, w2, w3, 12);
+	SJ_LANES(SJ_A, h0, w3, w4, 11);
+	SJ_LANES(SJ_A, h4, w4, w1, 10);
+	SJ_LANES(SJ_A, h3, w1, w2,  9);
+
+	/* stepping rule B: */
+	SJ_LANES(SJ_B, h2, w2, w1,  8);
+	SJ_LANES(SJ_B, h1, w3, w2,  7);
+	SJ_LANES(SJ_B, h0, w4, w3,  6);
+	SJ_LANES(SJ_B, h4, w1, w4,  5);
+	SJ_LANES(SJ_B, h3, w2, w1,  4);
+	SJ_LANES(SJ_B, h2, w3, w2,  3);
+	SJ_LANES(SJ_B, h1, w4, w3,  2);
+	SJ_LANES(SJ_B, h0, w1, w4,  1);
+
+	SJ_PUT(out, w1, w2, w3, w4);
+}
+
+void skipjack_setkey(skipjack_ctx *ctx, const byte key[10]) {
+	makeKey(key, ctx->tab);
+}
+
+void skipjack_encrypt_blocks(const skipjack_ctx *ctx, const byte *in,
+		byte *out, size_t n) {
+	for (; n >= 8; n -= 8, in += 64, out += 64) {
+		encrypt_lanes(ctx->tab, in, out, 8);
+	}
+	if (n >= 4) {
+		encrypt_lanes(ctx->tab, in, out, 4);
+		n -= 4, in += 32, out += 32;
+	}
+	for (; n; n--, in += 8, out += 8) {
+		encrypt_lanes(ctx->tab, in, out, 1);
+	}
+}
+
+void skipjack_decrypt_blocks(const skipjack_ctx *ctx, const byte *in,
+		byte *out, size_t n) {
+	for (; n >= 8; n -= 8, in += 64, out += 64) {
+		decrypt_lanes(ctx->tab, in, out, 8);
+	}
+	if (n >= 4) {
+		decrypt_lanes(ctx->tab, in, out, 4);
+		n -= 4, in += 32, out += 32;
+	}
+	for (; n; n--, in += 8, out += 8) {
+		decrypt_lanes(ctx->tab, in, out, 1);
+	}
+}
+
+/**
+ * Counter mode: eight counter blocks at a time go through the lanes.
+ */
+void skipjack_ctr_crypt(const skipjack_ctx *ctx, byte ctr[8],
+		const byte *in, byte *out, size_t n) {
+	byte buf[8*SJ_MAX_LANES];
+	size_t m, i;
+	int j;
+
+	for (; n; n -= m) {
+		m = n < SJ_MAX_LANES ? n : SJ_MAX_LANES;
+		for (i = 0; i < m; i++) {
+			memcpy(buf + 8*i, ctr, 8);
+			for (j = 7; j >= 0 && !++ctr[j]; j--)
+				;
+		}
+		skipjack_encrypt_blocks(ctx, buf, buf, m);
+		for (i = 0; i < 8*m; i++) {
+			*out++ = *in++ ^ buf[i];
+		}
+	}
+	memset(buf, 0, sizeof buf);
+}
+
+#ifdef TEST
+
 #include <stdio.h>
-#include <string.h>
-#include <time.h>
-
-int main() {
-	byte inp[8]		= { 0x33, 0x22, 0x11, 0x00, 0xdd, 0xcc, 0xbb, 0xaa };
-	byte key[10]	= { 0x00, 0x99, 0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11 };
-	byte enc[8], dec[8];
+
+int main() {
+	byte inp[8]		= { 0x33, 0x22, 0x11, 0x00, 0xdd, 0xcc, 0xbb, 0xaa };
+	byte key[10]	= { 0x00, 0x99, 0x88, 0x77, 0x66, 0x55, 0x44, 0x33, 0x22, 0x11 };
 	byte chk[8]	= { 0x25, 0x87, 0xca, 0xe2, 0x7a, 0x12, 0xd3, 0x00 };
-	byte tab[10][256];
-	int i;
-	clock_t elapsed;
-
-	makeKey(key, tab);
-	encrypt(tab, inp, enc);
-	printf((memcmp(enc, chk, 8) == 0) ? "encryption OK!\n" : "encryption failure!\n");
-	decrypt(tab, enc, dec);
-	printf((memcmp(dec, inp, 8) == 0) ? "decryption OK!\n" : "decryption failure!\n");
-
-	elapsed = -clock();
-	for (i = 0; i < 1000000; i++) {
-		encrypt(tab, inp, enc);
-	}
-	elapsed += clock();
-	printf ("elapsed time: %.1f s.\n", (float)elapsed/CLOCKS_PER_SEC);
-	return 0;
-}
+	byte buf[8*29], enc[8*29], dec[8*29], ctr[8];
+	skipjack_ctx ctx;
+	int i, ok = 1;
+
+	skipjack_setkey(&ctx, key);
+	skipjack_encrypt_blocks(&ctx, inp, enc, 1);
+	ok &= memcmp(enc, chk, 8) == 0;
+	skipjack_decrypt_blocks(&ctx, enc, dec, 1);
+	ok &= memcmp(dec, inp, 8) == 0;
+
+	/* every lane count against the single-block code */
+	for (i = 0; i < (int)sizeof buf; i++) {
+		buf[i] = (byte)(i * 37 + 11);
+	}
+	skipjack_encrypt_blocks(&ctx, buf, enc, 29);
+	for (i = 0; i < 29; i++) {
+		skipjack_encrypt(&ctx, buf + 8*i, dec + 8*i);
+	}
+	ok &= memcmp(enc, dec, sizeof enc) == 0;
+	skipjack_decrypt_blocks(&ctx, enc, dec, 29);
+	ok &= memcmp(dec, buf, sizeof buf) == 0;
+
+	memset(ctr, 0xff, 8);
+	skipjack_ctr_crypt(&ctx, ctr, buf, enc, 29);
+	memset(ctr, 0xff, 8);
+	skipjack_ctr_crypt(&ctx, ctr, enc, dec, 5);
+	skipjack_ctr_crypt(&ctx, ctr, enc + 40, dec + 40, 24);
+	ok &= memcmp(dec, buf, sizeof buf) == 0;
+
+	printf(ok ? "Skipjack OK\n" : "Skipjack failure!\n");
+	return !ok;
+}
+
+#endif /* TEST */
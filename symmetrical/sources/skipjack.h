@@ -0,0 +1,47 @@
+/*
+ *	SKIPJACK: interface to skipjack.c
+ */
+
+#ifndef SKIPJACK_H
+#define SKIPJACK_H
+
+#include <stddef.h>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The expanded key, tab[i][c] = F[c ^ key[i]].  It is only read once
+ * built, so one context may serve any number of threads.
+ */
+typedef struct {
+	unsigned char tab[10][256];
+} skipjack_ctx;
+
+void skipjack_setkey(skipjack_ctx *ctx, const unsigned char key[10]);
+
+/* one block, the plain reference code */
+void skipjack_encrypt(const skipjack_ctx *ctx, const unsigned char in[8],
+	unsigned char out[8]);
+void skipjack_decrypt(const skipjack_ctx *ctx, const unsigned char in[8],
+	unsigned char out[8]);
+
+/* n consecutive 8-byte blocks; in may be the same as out */
+void skipjack_encrypt_blocks(const skipjack_ctx *ctx, const unsigned char *in,
+	unsigned char *out, size_t n);
+void skipjack_decrypt_blocks(const skipjack_ctx *ctx, const unsigned char *in,
+	unsigned char *out, size_t n);
+
+/*
+ * Counter mode over n blocks.  ctr is a 64-bit big-endian counter,
+ * advanced past the blocks used so a stream can be done in pieces.
+ */
+void skipjack_ctr_crypt(const skipjack_ctx *ctx, unsigned char ctr[8],
+	const unsigned char *in, unsigned char *out, size_t n);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* SKIPJACK_H */
@@ -7,7 +7,17 @@
 #define ROUNDS 32
 #define DELTA 0x9e3779b9 /* sqr(5)-1 * 2^31 */
 
-#include "ctypes.h"
+#include <string.h>
+#include "tea.h"
+
+/* The multi-block functions run 16 blocks at a time in AVX2 vectors,
+   or 32 in AVX-512 ones, when the processor has them (GCC or Clang
+   vector extensions, one block per lane).  Define TEA_NO_SIMD to
+   leave the vector code out. */
+#if !defined(TEA_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define TEA_SIMD
+#endif
 
 /**********************************************************
    Input values: 	k[4]	128-bit key
@@ -43,3 +53,108 @@ void cl_enc_block(word32 *k, word32 *v) {
 void cl_dec_block(word32 *k, word32 *v) {
  tean(k,v,-ROUNDS);
 }
+
+/**********************************************************
+   Input values: 	k[4]	128-bit key
+			v[2*n]  n 64-bit blocks, each as tean() takes it
+			N	rounds, negative to decrypt
+   Output values:	v[2*n]  the blocks transformed
+ **********************************************************/
+
+#ifdef TEA_SIMD
+
+typedef word32 v8word  __attribute__((vector_size(32)));
+typedef word32 v16word __attribute__((vector_size(64)));
+
+#if defined(__clang__) || __GNUC__ >= 12
+#define SHUFFLE(V, a, b, ...) __builtin_shufflevector(a, b, __VA_ARGS__)
+#else
+#define SHUFFLE(V, a, b, ...) __builtin_shuffle(a, b, (V){ __VA_ARGS__ })
+#endif
+
+/* the loop of tean() on two sets of lanes at once, so that their
+   dependency chains overlap; sum and the key words are broadcast */
+#define TEAN2(y0,z0,y1,z1) \
+  if(N>0) { \
+    limit=DELTA*N; \
+    while(sum!=limit) { \
+      y0+=((z0<<4)^(z0>>5)) + (z0^sum) + k[sum&3]; \
+      y1+=((z1<<4)^(z1>>5)) + (z1^sum) + k[sum&3]; \
+      sum+=DELTA; \
+      z0+=((y0<<4)^(y0>>5)) + (y0^sum) + k[(sum>>11)&3]; \
+      z1+=((y1<<4)^(y1>>5)) + (y1^sum) + k[(sum>>11)&3]; \
+    } \
+  } else { \
+    sum=DELTA*(-N); \
+    while(sum) { \
+      z0-=((y0<<4)^(y0>>5)) + (y0^sum) + k[(sum>>11)&3]; \
+      z1-=((y1<<4)^(y1>>5)) + (y1^sum) + k[(sum>>11)&3]; \
+      sum-=DELTA; \
+      y0-=((z0<<4)^(z0>>5)) + (z0^sum) + k[sum&3]; \
+      y1-=((z1<<4)^(z1>>5)) + (z1^sum) + k[sum&3]; \
+    } \
+  }
+
+/* Blocks are transposed in registers: each loaded vector holds
+   alternating y and z words, split into a vector of y and one of z. */
+__attribute__((target("avx2")))
+static void tean16(word32 *k, word32 *v, long N) {
+  v8word a[4], y0, z0, y1, z1;
+  word32 limit,sum=0;
+  memcpy(a, v, sizeof(a));
+  y0=SHUFFLE(v8word, a[0], a[1], 0, 2, 4, 6, 8, 10, 12, 14);
+  z0=SHUFFLE(v8word, a[0], a[1], 1, 3, 5, 7, 9, 11, 13, 15);
+  y1=SHUFFLE(v8word, a[2], a[3], 0, 2, 4, 6, 8, 10, 12, 14);
+  z1=SHUFFLE(v8word, a[2], a[3], 1, 3, 5, 7, 9, 11, 13, 15);
+  TEAN2(y0,z0,y1,z1)
+  a[0]=SHUFFLE(v8word, y0, z0, 0, 8, 1, 9, 2, 10, 3, 11);
+  a[1]=SHUFFLE(v8word, y0, z0, 4, 12, 5, 13, 6, 14, 7, 15);
+  a[2]=SHUFFLE(v8word, y1, z1, 0, 8, 1, 9, 2, 10, 3, 11);
+  a[3]=SHUFFLE(v8word, y1, z1, 4, 12, 5, 13, 6, 14, 7, 15);
+  memcpy(v, a, sizeof(a));
+}
+
+__attribute__((target("avx512f")))
+static void tean32(word32 *k, word32 *v, long N) {
+  v16word a[4], y0, z0, y1, z1;
+  word32 limit,sum=0;
+  memcpy(a, v, sizeof(a));
+  y0=SHUFFLE(v16word, a[0], a[1], 0, 2, 4, 6, 8, 10, 12, 14,
+             16, 18, 20, 22, 24, 26, 28, 30);
+  z0=SHUFFLE(v16word, a[0], a[1], 1, 3, 5, 7, 9, 11, 13, 15,
+             17, 19, 21, 23, 25, 27, 29, 31);
+  y1=SHUFFLE(v16word, a[2], a[3], 0, 2, 4, 6, 8, 10, 12, 14,
+             16, 18, 20, 22, 24, 26, 28, 30);
+  z1=SHUFFLE(v16word, a[2], a[3], 1, 3, 5, 7, 9, 11, 13, 15,
+             17, 19, 21, 23, 25, 27, 29, 31);
+  TEAN2(y0,z0,y1,z1)
+  a[0]=SHUFFLE(v16word, y0, z0, 0, 16, 1, 17, 2, 18, 3, 19,
+               4, 20, 5, 21, 6, 22, 7, 23);
+  a[1]=SHUFFLE(v16word, y0, z0, 8, 24, 9, 25, 10, 26, 11, 27,
+               12, 28, 13, 29, 14, 30, 15, 31);
+  a[2]=SHUFFLE(v16word, y1, z1, 0, 16, 1, 17, 2, 18, 3, 19,
+               4, 20, 5, 21, 6, 22, 7, 23);
+  a[3]=SHUFFLE(v16word, y1, z1, 8, 24, 9, 25, 10, 26, 11, 27,
+               12, 28, 13, 29, 14, 30, 15, 31);
+  memcpy(v, a, sizeof(a));
+}
+
+#endif
+
+void tean_blocks(word32 *k, word32 *v, long N, unsigned long n) {
+#ifdef TEA_SIMD
+  if(n>=32 && __builtin_cpu_supports("avx512f"))
+    for(; n>=32; n-=32, v+=64) tean32(k,v,N);
+  if(n>=16 && __builtin_cpu_supports("avx2"))
+    for(; n>=16; n-=16, v+=32) tean16(k,v,N);
+#endif
+  for(; n; n--, v+=2) tean(k,v,N);
+}
+
+void cl_enc_blocks(word32 *k, word32 *v, unsigned long n) {
+ tean_blocks(k,v,ROUNDS,n);
+}
+
+void cl_dec_blocks(word32 *k, word32 *v, unsigned long n) {
+ tean_blocks(k,v,-ROUNDS,n);
+}
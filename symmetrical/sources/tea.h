@@ -0,0 +1,28 @@
+/**********************************************************
+   TEA: interface to tea.c
+ **********************************************************/
+
+#ifndef TEA_H
+#define TEA_H
+
+#include "ctypes.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/* one block; N rounds, negative to decrypt */
+void tean(word32 *k, word32 *v, long N);
+void cl_enc_block(word32 *k, word32 *v);
+void cl_dec_block(word32 *k, word32 *v);
+
+/* n consecutive blocks, v[2*n] */
+void tean_blocks(word32 *k, word32 *v, long N, unsigned long n);
+void cl_enc_blocks(word32 *k, word32 *v, unsigned long n);
+void cl_dec_blocks(word32 *k, word32 *v, unsigned long n);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif /* TEA_H */
@@ -37,60 +37,61 @@ Mean:          378 cycles =    67.8 mbits/sec
 
 */
 
-#include "../std_defs.h"
+#include <string.h>
+#include "twofish.h"
 
 #define Q_TABLES
 #define M_TABLE
-#define MK_TABLE
-#define ONE_STEP
 
 static char *alg_name[] = { "twofish", "twofish.c", "twofish" };
 
-char **cipher_name()
+char **twofish_cipher_name(void)
 {
     return alg_name;
 }
 
-u4byte  k_len;
-u4byte  l_key[40];
-u4byte  s_key[4];
-
 /* finite field arithmetic for GF(2**8) with the modular    */
 /* polynomial x^8 + x^6 + x^5 + x^3 + 1 (0x169)             */
 
 #define G_M 0x0169
 
-u1byte  tab_5b[4] = { 0, G_M >> 2, G_M >> 1, (G_M >> 1) ^ (G_M >> 2) };
-u1byte  tab_ef[4] = { 0, (G_M >> 1) ^ (G_M >> 2), G_M >> 1, G_M >> 2 };
+/* tab_5b(x) and tab_ef(x) are the low two bits of x times 0x5b and */
+/* 0xef, written as expressions so that the multiplications can be  */
+/* used in the initialisers of the tables below                     */
+
+#define tab_5b(x)   (((x) & 1 ? G_M >> 2 : 0) ^ ((x) & 2 ? G_M >> 1 : 0))
+#define tab_ef(x)   (((x) & 1 ? (G_M >> 1) ^ (G_M >> 2) : 0) ^ ((x) & 2 ? G_M >> 1 : 0))
 
 #define ffm_01(x)    (x)
-#define ffm_5b(x)   ((x) ^ ((x) >> 2) ^ tab_5b[(x) & 3])
-#define ffm_ef(x)   ((x) ^ ((x) >> 1) ^ ((x) >> 2) ^ tab_ef[(x) & 3])
+#define ffm_5b(x)   ((x) ^ ((x) >> 2) ^ tab_5b(x))
+#define ffm_ef(x)   ((x) ^ ((x) >> 1) ^ ((x) >> 2) ^ tab_ef(x))
+
+#ifndef Q_TABLES
 
-u1byte ror4[16] = { 0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15 };
-u1byte ashx[16] = { 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12, 5, 14, 7 };
+static const u1byte ror4[16] = { 0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15 };
+static const u1byte ashx[16] = { 0, 9, 2, 11, 4, 13, 6, 15, 8, 1, 10, 3, 12, 5, 14, 7 };
 
-u1byte qt0[2][16] = 
+static const u1byte qt0[2][16] = 
 {   { 8, 1, 7, 13, 6, 15, 3, 2, 0, 11, 5, 9, 14, 12, 10, 4 },
     { 2, 8, 11, 13, 15, 7, 6, 14, 3, 1, 9, 4, 0, 10, 12, 5 }
 };
 
-u1byte qt1[2][16] =
+static const u1byte qt1[2][16] =
 {   { 14, 12, 11, 8, 1, 2, 3, 5, 15, 4, 10, 6, 7, 0, 9, 13 }, 
     { 1, 14, 2, 11, 4, 12, 3, 7, 6, 13, 10, 5, 15, 9, 0, 8 }
 };
 
-u1byte qt2[2][16] = 
+static const u1byte qt2[2][16] = 
 {   { 11, 10, 5, 14, 6, 13, 9, 0, 12, 8, 15, 3, 2, 4, 7, 1 },
     { 4, 12, 7, 5, 1, 6, 9, 10, 0, 14, 13, 8, 2, 11, 3, 15 }
 };
 
-u1byte qt3[2][16] = 
+static const u1byte qt3[2][16] = 
 {   { 13, 7, 15, 4, 1, 2, 6, 14, 9, 11, 3, 0, 8, 5, 12, 10 },
     { 11, 9, 5, 1, 12, 3, 13, 14, 6, 4, 7, 15, 2, 0, 8, 10 }
 };
  
-u1byte qp(const u4byte n, const u1byte x)
+static u1byte qp(const u4byte n, const u1byte x)
 {   u1byte  a0, a1, a2, a3, a4, b0, b1, b2, b3, b4;
 
     a0 = x >> 4; b0 = x & 15;
@@ -101,47 +102,103 @@ u1byte qp(const u4byte n, const u1byte x)
     return (b4 << 4) | a4;
 };
 
-#ifdef  Q_TABLES
+#define q(n,x)  qp(n, x)
 
-u4byte  qt_gen = 0;
-u1byte  q_tab[2][256];
+#endif
 
-#define q(n,x)  q_tab[n][x]
+/* The q0 and q1 permutations as generated by qp(0, x) and qp(1, x). */
+/* The tables are fixed so that they need no run time set up and     */
+/* can be read by any number of threads.                             */
+
+#define q0_data(w) \
+    w(0xa9), w(0x67), w(0xb3), w(0xe8), w(0x04), w(0xfd), w(0xa3), w(0x76), \
+    w(0x9a), w(0x92), w(0x80), w(0x78), w(0xe4), w(0xdd), w(0xd1), w(0x38), \
+    w(0x0d), w(0xc6), w(0x35), w(0x98), w(0x18), w(0xf7), w(0xec), w(0x6c), \
+    w(0x43), w(0x75), w(0x37), w(0x26), w(0xfa), w(0x13), w(0x94), w(0x48), \
+    w(0xf2), w(0xd0), w(0x8b), w(0x30), w(0x84), w(0x54), w(0xdf), w(0x23), \
+    w(0x19), w(0x5b), w(0x3d), w(0x59), w(0xf3), w(0xae), w(0xa2), w(0x82), \
+    w(0x63), w(0x01), w(0x83), w(0x2e), w(0xd9), w(0x51), w(0x9b), w(0x7c), \
+    w(0xa6), w(0xeb), w(0xa5), w(0xbe), w(0x16), w(0x0c), w(0xe3), w(0x61), \
+    w(0xc0), w(0x8c), w(0x3a), w(0xf5), w(0x73), w(0x2c), w(0x25), w(0x0b), \
+    w(0xbb), w(0x4e), w(0x89), w(0x6b), w(0x53), w(0x6a), w(0xb4), w(0xf1), \
+    w(0xe1), w(0xe6), w(0xbd), w(0x45), w(0xe2), w(0xf4), w(0xb6), w(0x66), \
+    w(0xcc), w(0x95), w(0x03), w(0x56), w(0xd4), w(0x1c), w(0x1e), w(0xd7), \
+    w(0xfb), w(0xc3), w(0x8e), w(0xb5), w(0xe9), w(0xcf), w(0xbf), w(0xba), \
+    w(0xea), w(0x77), w(0x39), w(0xaf), w(0x33), w(0xc9), w(0x62), w(0x71), \
+    w(0x81), w(0x79), w(0x09), w(0xad), w(0x24), w(0xcd), w(0xf9), w(0xd8), \
+    w(0xe5), w(0xc5), w(0xb9), w(0x4d), w(0x44), w(0x08), w(0x86), w(0xe7), \
+    w(0xa1), w(0x1d), w(0xaa), w(0xed), w(0x06), w(0x70), w(0xb2), w(0xd2), \
+    w(0x41), w(0x7b), w(0xa0), w(0x11), w(0x31), w(0xc2), w(0x27), w(0x90), \
+    w(0x20), w(0xf6), w(0x60), w(0xff), w(0x96), w(0x5c), w(0xb1), w(0xab), \
+    w(0x9e), w(0x9c), w(0x52), w(0x1b), w(0x5f), w(0x93), w(0x0a), w(0xef), \
+    w(0x91), w(0x85), w(0x49), w(0xee), w(0x2d), w(0x4f), w(0x8f), w(0x3b), \
+    w(0x47), w(0x87), w(0x6d), w(0x46), w(0xd6), w(0x3e), w(0x69), w(0x64), \
+    w(0x2a), w(0xce), w(0xcb), w(0x2f), w(0xfc), w(0x97), w(0x05), w(0x7a), \
+    w(0xac), w(0x7f), w(0xd5), w(0x1a), w(0x4b), w(0x0e), w(0xa7), w(0x5a), \
+    w(0x28), w(0x14), w(0x3f), w(0x29), w(0x88), w(0x3c), w(0x4c), w(0x02), \
+    w(0xb8), w(0xda), w(0xb0), w(0x17), w(0x55), w(0x1f), w(0x8a), w(0x7d), \
+    w(0x57), w(0xc7), w(0x8d), w(0x74), w(0xb7), w(0xc4), w(0x9f), w(0x72), \
+    w(0x7e), w(0x15), w(0x22), w(0x12), w(0x58), w(0x07), w(0x99), w(0x34), \
+    w(0x6e), w(0x50), w(0xde), w(0x68), w(0x65), w(0xbc), w(0xdb), w(0xf8), \
+    w(0xc8), w(0xa8), w(0x2b), w(0x40), w(0xdc), w(0xfe), w(0x32), w(0xa4), \
+    w(0xca), w(0x10), w(0x21), w(0xf0), w(0xd3), w(0x5d), w(0x0f), w(0x00), \
+    w(0x6f), w(0x9d), w(0x36), w(0x42), w(0x4a), w(0x5e), w(0xc1), w(0xe0)
+
+#define q1_data(w) \
+    w(0x75), w(0xf3), w(0xc6), w(0xf4), w(0xdb), w(0x7b), w(0xfb), w(0xc8), \
+    w(0x4a), w(0xd3), w(0xe6), w(0x6b), w(0x45), w(0x7d), w(0xe8), w(0x4b), \
+    w(0xd6), w(0x32), w(0xd8), w(0xfd), w(0x37), w(0x71), w(0xf1), w(0xe1), \
+    w(0x30), w(0x0f), w(0xf8), w(0x1b), w(0x87), w(0xfa), w(0x06), w(0x3f), \
+    w(0x5e), w(0xba), w(0xae), w(0x5b), w(0x8a), w(0x00), w(0xbc), w(0x9d), \
+    w(0x6d), w(0xc1), w(0xb1), w(0x0e), w(0x80), w(0x5d), w(0xd2), w(0xd5), \
+    w(0xa0), w(0x84), w(0x07), w(0x14), w(0xb5), w(0x90), w(0x2c), w(0xa3), \
+    w(0xb2), w(0x73), w(0x4c), w(0x54), w(0x92), w(0x74), w(0x36), w(0x51), \
+    w(0x38), w(0xb0), w(0xbd), w(0x5a), w(0xfc), w(0x60), w(0x62), w(0x96), \
+    w(0x6c), w(0x42), w(0xf7), w(0x10), w(0x7c), w(0x28), w(0x27), w(0x8c), \
+    w(0x13), w(0x95), w(0x9c), w(0xc7), w(0x24), w(0x46), w(0x3b), w(0x70), \
+    w(0xca), w(0xe3), w(0x85), w(0xcb), w(0x11), w(0xd0), w(0x93), w(0xb8), \
+    w(0xa6), w(0x83), w(0x20), w(0xff), w(0x9f), w(0x77), w(0xc3), w(0xcc), \
+    w(0x03), w(0x6f), w(0x08), w(0xbf), w(0x40), w(0xe7), w(0x2b), w(0xe2), \
+    w(0x79), w(0x0c), w(0xaa), w(0x82), w(0x41), w(0x3a), w(0xea), w(0xb9), \
+    w(0xe4), w(0x9a), w(0xa4), w(0x97), w(0x7e), w(0xda), w(0x7a), w(0x17), \
+    w(0x66), w(0x94), w(0xa1), w(0x1d), w(0x3d), w(0xf0), w(0xde), w(0xb3), \
+    w(0x0b), w(0x72), w(0xa7), w(0x1c), w(0xef), w(0xd1), w(0x53), w(0x3e), \
+    w(0x8f), w(0x33), w(0x26), w(0x5f), w(0xec), w(0x76), w(0x2a), w(0x49), \
+    w(0x81), w(0x88), w(0xee), w(0x21), w(0xc4), w(0x1a), w(0xeb), w(0xd9), \
+    w(0xc5), w(0x39), w(0x99), w(0xcd), w(0xad), w(0x31), w(0x8b), w(0x01), \
+    w(0x18), w(0x23), w(0xdd), w(0x1f), w(0x4e), w(0x2d), w(0xf9), w(0x48), \
+    w(0x4f), w(0xf2), w(0x65), w(0x8e), w(0x78), w(0x5c), w(0x58), w(0x19), \
+    w(0x8d), w(0xe5), w(0x98), w(0x57), w(0x67), w(0x7f), w(0x05), w(0x64), \
+    w(0xaf), w(0x63), w(0xb6), w(0xfe), w(0xf5), w(0xb7), w(0x3c), w(0xa5), \
+    w(0xce), w(0xe9), w(0x68), w(0x44), w(0xe0), w(0x4d), w(0x43), w(0x69), \
+    w(0x29), w(0x2e), w(0xac), w(0x15), w(0x59), w(0xa8), w(0x0a), w(0x9e), \
+    w(0x6e), w(0x47), w(0xdf), w(0x34), w(0x35), w(0x6a), w(0xcf), w(0xdc), \
+    w(0x22), w(0xc9), w(0xc0), w(0x9b), w(0x89), w(0xd4), w(0xed), w(0xab), \
+    w(0x12), w(0xa2), w(0x0d), w(0x52), w(0xbb), w(0x02), w(0x2f), w(0xa9), \
+    w(0xd7), w(0x61), w(0x1e), w(0xb4), w(0x50), w(0x04), w(0xf6), w(0xc2), \
+    w(0x16), w(0x25), w(0x86), w(0x56), w(0x55), w(0x09), w(0xbe), w(0x91)
 
-void gen_qtab(void)
-{   u4byte  i;
+#ifdef  Q_TABLES
 
-    for(i = 0; i < 256; ++i)
-    {       
-        q(0,i) = qp(0, (u1byte)i);
-        q(1,i) = qp(1, (u1byte)i);
-    }
-};
+#define h0(x)   (x)
 
-#else
+static const u1byte q_tab[2][256] = { { q0_data(h0) }, { q1_data(h0) } };
 
-#define q(n,x)  qp(n, x)
+#define q(n,x)  q_tab[n][x]
 
 #endif
 
 #ifdef  M_TABLE
 
-u4byte  mt_gen = 0;
-u4byte  m_tab[4][256];
+/* the MDS matrix columns applied to q1, q0, q1 and q0 of each byte  */
 
-void gen_mtab(void)
-{   u4byte  i, f01, f5b, fef;
-    
-    for(i = 0; i < 256; ++i)
-    {
-        f01 = q(1,i); f5b = ffm_5b(f01); fef = ffm_ef(f01);
-        m_tab[0][i] = f01 + (f5b << 8) + (fef << 16) + (fef << 24);
-        m_tab[2][i] = f5b + (fef << 8) + (f01 << 16) + (fef << 24);
+#define m0(x)   ((x) + (ffm_5b(x) << 8) + (ffm_ef(x) << 16) + (ffm_ef(x) << 24))
+#define m1(x)   (ffm_ef(x) + (ffm_ef(x) << 8) + (ffm_5b(x) << 16) + ((x) << 24))
+#define m2(x)   (ffm_5b(x) + (ffm_ef(x) << 8) + ((x) << 16) + (ffm_ef(x) << 24))
+#define m3(x)   (ffm_5b(x) + ((x) << 8) + (ffm_ef(x) << 16) + (ffm_5b(x) << 24))
 
-        f01 = q(0,i); f5b = ffm_5b(f01); fef = ffm_ef(f01);
-        m_tab[1][i] = fef + (fef << 8) + (f5b << 16) + (f01 << 24);
-        m_tab[3][i] = f5b + (f01 << 8) + (fef << 16) + (f5b << 24);
-    }
+static const u4byte m_tab[4][256] =
+{   { q1_data(m0) }, { q0_data(m1) }, { q1_data(m2) }, { q0_data(m3) }
 };
 
 #define mds(n,x)    m_tab[n][x]
@@ -181,7 +238,7 @@ void gen_mtab(void)
 
 #endif
 
-u4byte h_fun(const u4byte x, const u4byte key[])
+static u4byte h_fun(const u4byte x, const u4byte key[], const u4byte k_len)
 {   u4byte  b0, b1, b2, b3;
 
 #ifndef M_TABLE
@@ -223,13 +280,7 @@ u4byte h_fun(const u4byte x, const u4byte key[])
 #endif
 };
 
-#ifdef  MK_TABLE
-
-#ifdef  ONE_STEP
-u4byte  mk_tab[4][256];
-#else
-u1byte  sb[4][256];
-#endif
+/* the key dependent S boxes for 2, 3 and 4 word keys  */
 
 #define q20(x)  q(0,q(0,x) ^ byte(key[1],0)) ^ byte(key[0],0)
 #define q21(x)  q(0,q(1,x) ^ byte(key[1],1)) ^ byte(key[0],1)
@@ -246,70 +297,55 @@ u1byte  sb[4][256];
 #define q42(x)  q(1,q(0,q(0, q(0, x) ^ byte(key[3],2)) ^ byte(key[2],2)) ^ byte(key[1],2)) ^ byte(key[0],2)
 #define q43(x)  q(1,q(1,q(0, q(1, x) ^ byte(key[3],3)) ^ byte(key[2],3)) ^ byte(key[1],3)) ^ byte(key[0],3)
 
-gen_mk_tab(u4byte key[])
+/* fill the S box tables for full or partial keying   */
+
+#define gen_tabs(qa,qb,qc,qd)                                           \
+    if(ctx->keying == TWOFISH_FULL_KEYING)                              \
+        for(i = 0; i < 256; ++i)                                        \
+        {                                                               \
+            by = (u1byte)i;                                             \
+            mk_tab[0][i] = mds(0, qa(by)); mk_tab[1][i] = mds(1, qb(by)); \
+            mk_tab[2][i] = mds(2, qc(by)); mk_tab[3][i] = mds(3, qd(by)); \
+        }                                                               \
+    else                                                                \
+        for(i = 0; i < 256; ++i)                                        \
+        {                                                               \
+            by = (u1byte)i;                                             \
+            sb[0][i] = qa(by); sb[1][i] = qb(by);                       \
+            sb[2][i] = qc(by); sb[3][i] = qd(by);                       \
+        }
+
+static void gen_mk_tab(twofish_ctx *ctx, const u4byte key[])
 {   u4byte  i;
     u1byte  by;
+    u4byte  (*mk_tab)[256] = ctx->tab.mk_tab;
+    u1byte  (*sb)[256] = ctx->tab.sb;
 
-    switch(k_len)
+    switch(ctx->k_len)
     {
-    case 2: for(i = 0; i < 256; ++i)
-            {
-                by = (u1byte)i;
-#ifdef ONE_STEP
-                mk_tab[0][i] = mds(0, q20(by)); mk_tab[1][i] = mds(1, q21(by));
-                mk_tab[2][i] = mds(2, q22(by)); mk_tab[3][i] = mds(3, q23(by));
-#else
-                sb[0][i] = q20(by); sb[1][i] = q21(by); 
-                sb[2][i] = q22(by); sb[3][i] = q23(by);
-#endif
-            }
+    case 2: gen_tabs(q20, q21, q22, q23);
             break;
-    
-    case 3: for(i = 0; i < 256; ++i)
-            {
-                by = (u1byte)i;
-#ifdef ONE_STEP
-                mk_tab[0][i] = mds(0, q30(by)); mk_tab[1][i] = mds(1, q31(by));
-                mk_tab[2][i] = mds(2, q32(by)); mk_tab[3][i] = mds(3, q33(by));
-#else
-                sb[0][i] = q30(by); sb[1][i] = q31(by); 
-                sb[2][i] = q32(by); sb[3][i] = q33(by);
-#endif
-            }
+    case 3: gen_tabs(q30, q31, q32, q33);
             break;
-    
-    case 4: for(i = 0; i < 256; ++i)
-            {
-                by = (u1byte)i;
-#ifdef ONE_STEP
-                mk_tab[0][i] = mds(0, q40(by)); mk_tab[1][i] = mds(1, q41(by));
-                mk_tab[2][i] = mds(2, q42(by)); mk_tab[3][i] = mds(3, q43(by));
-#else
-                sb[0][i] = q40(by); sb[1][i] = q41(by); 
-                sb[2][i] = q42(by); sb[3][i] = q43(by);
-#endif
-            }
+    case 4: gen_tabs(q40, q41, q42, q43);
     }
 };
 
-#  ifdef ONE_STEP
-#    define g0_fun(x) ( mk_tab[0][byte(x,0)] ^ mk_tab[1][byte(x,1)] \
-                      ^ mk_tab[2][byte(x,2)] ^ mk_tab[3][byte(x,3)] )
-#    define g1_fun(x) ( mk_tab[0][byte(x,3)] ^ mk_tab[1][byte(x,0)] \
-                      ^ mk_tab[2][byte(x,1)] ^ mk_tab[3][byte(x,2)] )
-#  else
-#    define g0_fun(x) ( mds(0, sb[0][byte(x,0)]) ^ mds(1, sb[1][byte(x,1)]) \
-                      ^ mds(2, sb[2][byte(x,2)]) ^ mds(3, sb[3][byte(x,3)]) )
-#    define g1_fun(x) ( mds(0, sb[0][byte(x,3)]) ^ mds(1, sb[1][byte(x,0)]) \
-                      ^ mds(2, sb[2][byte(x,1)]) ^ mds(3, sb[3][byte(x,2)]) )
-#  endif
+/* the g function under each keying strategy: gf for full, gp for  */
+/* partial and gz for zero keying                                  */
 
-#else
+#define gf0(x)  ( mk_tab[0][byte(x,0)] ^ mk_tab[1][byte(x,1)] \
+                ^ mk_tab[2][byte(x,2)] ^ mk_tab[3][byte(x,3)] )
+#define gf1(x)  ( mk_tab[0][byte(x,3)] ^ mk_tab[1][byte(x,0)] \
+                ^ mk_tab[2][byte(x,1)] ^ mk_tab[3][byte(x,2)] )
 
-#define g0_fun(x)   h_fun(x,s_key)
-#define g1_fun(x)   h_fun(rotl(x,8),s_key)
+#define gp0(x)  ( mds(0, sb[0][byte(x,0)]) ^ mds(1, sb[1][byte(x,1)]) \
+                ^ mds(2, sb[2][byte(x,2)]) ^ mds(3, sb[3][byte(x,3)]) )
+#define gp1(x)  ( mds(0, sb[0][byte(x,3)]) ^ mds(1, sb[1][byte(x,0)]) \
+                ^ mds(2, sb[2][byte(x,1)]) ^ mds(3, sb[3][byte(x,2)]) )
 
-#endif
+#define gz0(x)  h_fun(x,s_key,k_len)
+#define gz1(x)  h_fun(rotl(x,8),s_key,k_len)
 
 /* The (12,8) Reed Soloman code has the generator polynomial
 
@@ -340,7 +376,7 @@ to implement.
 
 #define G_MOD   0x0000014d
 
-u4byte mds_rem(u4byte p0, u4byte p1)
+static u4byte mds_rem(u4byte p0, u4byte p1)
 {   u4byte  i, t, u;
 
     for(i = 0; i < 8; ++i)
@@ -373,24 +409,12 @@ u4byte mds_rem(u4byte p0, u4byte p1)
 
 /* initialise the key schedule from the user supplied key   */
 
-u4byte *set_key(const u4byte in_key[], const u4byte key_len)
-{   u4byte  i, a, b, me_key[4], mo_key[4];
-
-#ifdef Q_TABLES
-    if(!qt_gen)
-    {
-        gen_qtab(); qt_gen = 1;
-    }
-#endif
-
-#ifdef M_TABLE
-    if(!mt_gen)
-    {
-        gen_mtab(); mt_gen = 1;
-    }
-#endif
+u4byte *twofish_set_key_mode(twofish_ctx *ctx, const u4byte in_key[], const u4byte key_len, const u4byte keying)
+{   u4byte  *l_key = ctx->l_key, *s_key = ctx->s_key;
+    u4byte  i, a, b, k_len, me_key[4], mo_key[4];
 
-    k_len = key_len / 64;   /* 2, 3 or 4 */
+    k_len = ctx->k_len = key_len / 64;   /* 2, 3 or 4 */
+    ctx->keying = keying;
 
     for(i = 0; i < k_len; ++i)
     {
@@ -402,39 +426,66 @@ u4byte *set_key(const u4byte in_key[], const u4byte key_len)
     for(i = 0; i < 40; i += 2)
     {
         a = 0x01010101 * i; b = a + 0x01010101;
-        a = h_fun(a, me_key);
-        b = rotl(h_fun(b, mo_key), 8);
+        a = h_fun(a, me_key, k_len);
+        b = rotl(h_fun(b, mo_key, k_len), 8);
         l_key[i] = a + b;
         l_key[i + 1] = rotl(a + 2 * b, 9);
     }
 
-#ifdef MK_TABLE
-    gen_mk_tab(s_key);
-#endif
+    if(keying != TWOFISH_ZERO_KEYING)
+        gen_mk_tab(ctx, s_key);
 
     return l_key;
 };
 
+/* full keying, for bulk data and long lived keys   */
+
+u4byte *twofish_set_key(twofish_ctx *ctx, const u4byte in_key[], const u4byte key_len)
+{
+    return twofish_set_key_mode(ctx, in_key, key_len, TWOFISH_FULL_KEYING);
+};
+
+/* the keying that costs least for a key used on msg_len bytes  */
+
+u4byte *twofish_set_key_for(twofish_ctx *ctx, const u4byte in_key[], const u4byte key_len, const size_t msg_len)
+{
+    return twofish_set_key_mode(ctx, in_key, key_len,
+        msg_len >= TWOFISH_FULL_BYTES ? TWOFISH_FULL_KEYING :
+        msg_len >= TWOFISH_PARTIAL_BYTES ? TWOFISH_PARTIAL_KEYING : TWOFISH_ZERO_KEYING);
+};
+
 /* encrypt a block of text  */
 
-#define f_rnd(i)                                                    \
-    t1 = g1_fun(blk[1]); t0 = g0_fun(blk[0]);                       \
+#define f_rnd(g0,g1,blk,i)                                          \
+    t1 = g1(blk[1]); t0 = g0(blk[0]);                               \
     blk[2] = rotr(blk[2] ^ (t0 + t1 + l_key[4 * (i) + 8]), 1);      \
     blk[3] = rotl(blk[3], 1) ^ (t0 + 2 * t1 + l_key[4 * (i) + 9]);  \
-    t1 = g1_fun(blk[3]); t0 = g0_fun(blk[2]);                       \
+    t1 = g1(blk[3]); t0 = g0(blk[2]);                               \
     blk[0] = rotr(blk[0] ^ (t0 + t1 + l_key[4 * (i) + 10]), 1);     \
     blk[1] = rotl(blk[1], 1) ^ (t0 + 2 * t1 + l_key[4 * (i) + 11])
 
-void encrypt(const u4byte in_blk[4], u4byte out_blk[])
-{   u4byte  t0, t1, blk[4];
+#define f_rnds(g0,g1,blk)                                           \
+    f_rnd(g0,g1,blk,0); f_rnd(g0,g1,blk,1); f_rnd(g0,g1,blk,2);     \
+    f_rnd(g0,g1,blk,3); f_rnd(g0,g1,blk,4); f_rnd(g0,g1,blk,5);     \
+    f_rnd(g0,g1,blk,6); f_rnd(g0,g1,blk,7)
+
+void twofish_encrypt(const twofish_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{   const u4byte  *l_key = ctx->l_key, *s_key = ctx->s_key, k_len = ctx->k_len;
+    const u4byte  (*mk_tab)[256] = ctx->tab.mk_tab;
+    const u1byte  (*sb)[256] = ctx->tab.sb;
+    u4byte  t0, t1, blk[4];
 
     blk[0] = in_blk[0] ^ l_key[0];
     blk[1] = in_blk[1] ^ l_key[1];
     blk[2] = in_blk[2] ^ l_key[2];
     blk[3] = in_blk[3] ^ l_key[3];
 
-    f_rnd(0); f_rnd(1); f_rnd(2); f_rnd(3);
-    f_rnd(4); f_rnd(5); f_rnd(6); f_rnd(7);
+    switch(ctx->keying)
+    {
+    case TWOFISH_FULL_KEYING:       f_rnds(gf0, gf1, blk); break;
+    case TWOFISH_PARTIAL_KEYING:    f_rnds(gp0, gp1, blk); break;
+    default:                        f_rnds(gz0, gz1, blk);
+    }
 
     out_blk[0] = blk[2] ^ l_key[4];
     out_blk[1] = blk[3] ^ l_key[5];
@@ -444,27 +495,128 @@ void encrypt(const u4byte in_blk[4], u4byte out_blk[])
 
 /* decrypt a block of text  */
 
-#define i_rnd(i)                                                        \
-        t1 = g1_fun(blk[1]); t0 = g0_fun(blk[0]);                       \
+#define i_rnd(g0,g1,blk,i)                                              \
+        t1 = g1(blk[1]); t0 = g0(blk[0]);                               \
         blk[2] = rotl(blk[2], 1) ^ (t0 + t1 + l_key[4 * (i) + 10]);     \
         blk[3] = rotr(blk[3] ^ (t0 + 2 * t1 + l_key[4 * (i) + 11]), 1); \
-        t1 = g1_fun(blk[3]); t0 = g0_fun(blk[2]);                       \
+        t1 = g1(blk[3]); t0 = g0(blk[2]);                               \
         blk[0] = rotl(blk[0], 1) ^ (t0 + t1 + l_key[4 * (i) +  8]);     \
         blk[1] = rotr(blk[1] ^ (t0 + 2 * t1 + l_key[4 * (i) +  9]), 1)
 
-void decrypt(const u4byte in_blk[4], u4byte out_blk[4])
-{   u4byte  t0, t1, blk[4];
+#define i_rnds(g0,g1,blk)                                               \
+        i_rnd(g0,g1,blk,7); i_rnd(g0,g1,blk,6); i_rnd(g0,g1,blk,5);     \
+        i_rnd(g0,g1,blk,4); i_rnd(g0,g1,blk,3); i_rnd(g0,g1,blk,2);     \
+        i_rnd(g0,g1,blk,1); i_rnd(g0,g1,blk,0)
+
+void twofish_decrypt(const twofish_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4])
+{   const u4byte  *l_key = ctx->l_key, *s_key = ctx->s_key, k_len = ctx->k_len;
+    const u4byte  (*mk_tab)[256] = ctx->tab.mk_tab;
+    const u1byte  (*sb)[256] = ctx->tab.sb;
+    u4byte  t0, t1, blk[4];
 
     blk[0] = in_blk[0] ^ l_key[4];
     blk[1] = in_blk[1] ^ l_key[5];
     blk[2] = in_blk[2] ^ l_key[6];
     blk[3] = in_blk[3] ^ l_key[7];
 
-    i_rnd(7); i_rnd(6); i_rnd(5); i_rnd(4);
-    i_rnd(3); i_rnd(2); i_rnd(1); i_rnd(0);
+    switch(ctx->keying)
+    {
+    case TWOFISH_FULL_KEYING:       i_rnds(gf0, gf1, blk); break;
+    case TWOFISH_PARTIAL_KEYING:    i_rnds(gp0, gp1, blk); break;
+    default:                        i_rnds(gz0, gz1, blk);
+    }
 
     out_blk[0] = blk[2] ^ l_key[0];
     out_blk[1] = blk[3] ^ l_key[1];
     out_blk[2] = blk[0] ^ l_key[2];
     out_blk[3] = blk[1] ^ l_key[3]; 
 };
+
+/* With full keying the multi-block calls run two blocks (b0, b1)   */
+/* through the rounds side by side: one block's table lookups then  */
+/* overlap the other's instead of each round waiting on its loads.  */
+
+#define f_rnd_n(i)  \
+    f_rnd(gf0,gf1,b0,i); f_rnd(gf0,gf1,b1,i)
+
+#define i_rnd_n(i)  \
+    i_rnd(gf0,gf1,b0,i); i_rnd(gf0,gf1,b1,i)
+
+static void encrypt_n(const twofish_ctx *ctx, const u1byte *in_blk, u1byte *out_blk)
+{   const u4byte  *l_key = ctx->l_key;
+    const u4byte  (*mk_tab)[256] = ctx->tab.mk_tab;
+    u4byte  t0, t1, b0[4], b1[4], o[4];
+    int     i;
+
+    memcpy(b0, in_blk, 16); memcpy(b1, in_blk + 16, 16);
+    for(i = 0; i < 4; ++i)
+    {
+        b0[i] ^= l_key[i]; b1[i] ^= l_key[i];
+    }
+
+    f_rnd_n(0); f_rnd_n(1); f_rnd_n(2); f_rnd_n(3);
+    f_rnd_n(4); f_rnd_n(5); f_rnd_n(6); f_rnd_n(7);
+
+    o[0] = b0[2] ^ l_key[4]; o[1] = b0[3] ^ l_key[5];
+    o[2] = b0[0] ^ l_key[6]; o[3] = b0[1] ^ l_key[7];
+    memcpy(out_blk, o, 16);
+    o[0] = b1[2] ^ l_key[4]; o[1] = b1[3] ^ l_key[5];
+    o[2] = b1[0] ^ l_key[6]; o[3] = b1[1] ^ l_key[7];
+    memcpy(out_blk + 16, o, 16);
+};
+
+static void decrypt_n(const twofish_ctx *ctx, const u1byte *in_blk, u1byte *out_blk)
+{   const u4byte  *l_key = ctx->l_key;
+    const u4byte  (*mk_tab)[256] = ctx->tab.mk_tab;
+    u4byte  t0, t1, b0[4], b1[4], o[4];
+    int     i;
+
+    memcpy(b0, in_blk, 16); memcpy(b1, in_blk + 16, 16);
+    for(i = 0; i < 4; ++i)
+    {
+        b0[i] ^= l_key[i + 4]; b1[i] ^= l_key[i + 4];
+    }
+
+    i_rnd_n(7); i_rnd_n(6); i_rnd_n(5); i_rnd_n(4);
+    i_rnd_n(3); i_rnd_n(2); i_rnd_n(1); i_rnd_n(0);
+
+    o[0] = b0[2] ^ l_key[0]; o[1] = b0[3] ^ l_key[1];
+    o[2] = b0[0] ^ l_key[2]; o[3] = b0[1] ^ l_key[3];
+    memcpy(out_blk, o, 16);
+    o[0] = b1[2] ^ l_key[0]; o[1] = b1[3] ^ l_key[1];
+    o[2] = b1[0] ^ l_key[2]; o[3] = b1[1] ^ l_key[3];
+    memcpy(out_blk + 16, o, 16);
+};
+
+/* encrypt n_blk consecutive blocks of text held in byte buffers that */
+/* need not be word aligned; in_blk may be the same as out_blk        */
+
+void twofish_encrypt_blocks(const twofish_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{   u4byte  b_in[4], b_out[4];
+
+    if(ctx->keying == TWOFISH_FULL_KEYING)
+        for(; n_blk >= 2; n_blk -= 2, in_blk += 32, out_blk += 32)
+            encrypt_n(ctx, in_blk, out_blk);
+
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+    {
+        memcpy(b_in, in_blk, 16); twofish_encrypt(ctx, b_in, b_out);
+        memcpy(out_blk, b_out, 16);
+    }
+};
+
+/* decrypt n_blk consecutive blocks of text                          */
+
+void twofish_decrypt_blocks(const twofish_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk)
+{   u4byte  b_in[4], b_out[4];
+
+    if(ctx->keying == TWOFISH_FULL_KEYING)
+        for(; n_blk >= 2; n_blk -= 2, in_blk += 32, out_blk += 32)
+            decrypt_n(ctx, in_blk, out_blk);
+
+    for(; n_blk; --n_blk, in_blk += 16, out_blk += 16)
+    {
+        memcpy(b_in, in_blk, 16); twofish_decrypt(ctx, b_in, b_out);
+        memcpy(out_blk, b_out, 16);
+    }
+};
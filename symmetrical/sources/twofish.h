@@ -0,0 +1,57 @@
+
+/* Twofish with the key schedule held in a caller supplied context  */
+/* (see twofish.c). A context may be shared by any number of        */
+/* threads once its key has been set.                               */
+
+#ifndef _TWOFISH_H
+#define _TWOFISH_H
+
+#include "../std_defs.h"
+#include <stddef.h>
+#include "cache_align.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/* Key dependent S box strategies from the Twofish paper. FULL      */
+/* keying merges the S boxes with the MDS matrix into 4 kbytes of   */
+/* tables, PARTIAL keying keeps them as 1 kbyte of bytes and ZERO   */
+/* keying stores nothing, rebuilding them from s_key in every round */
+/* so key setup is cheapest and encryption slowest.                 */
+
+#define TWOFISH_ZERO_KEYING     0
+#define TWOFISH_PARTIAL_KEYING  1
+#define TWOFISH_FULL_KEYING     2
+
+/* message lengths (bytes) at and above which twofish_set_key_for() */
+/* moves to partial and to full keying                              */
+
+#define TWOFISH_PARTIAL_BYTES   64
+#define TWOFISH_FULL_BYTES      256
+
+typedef struct
+{   CACHE_ALIGN u4byte  l_key[40];  /* storage for the key schedule */
+    u4byte  s_key[4];
+    u4byte  k_len;
+    u4byte  keying;                 /* TWOFISH_xxx_KEYING           */
+    union
+    {   u4byte  mk_tab[4][256];     /* full keying                  */
+        u1byte  sb[4][256];         /* partial keying               */
+    }   tab;
+} twofish_ctx;
+
+char    **twofish_cipher_name(void);
+u4byte  *twofish_set_key(twofish_ctx *ctx, const u4byte in_key[], const u4byte key_len);
+u4byte  *twofish_set_key_mode(twofish_ctx *ctx, const u4byte in_key[], const u4byte key_len, const u4byte keying);
+u4byte  *twofish_set_key_for(twofish_ctx *ctx, const u4byte in_key[], const u4byte key_len, const size_t msg_len);
+void    twofish_encrypt(const twofish_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    twofish_decrypt(const twofish_ctx *ctx, const u4byte in_blk[4], u4byte out_blk[4]);
+void    twofish_encrypt_blocks(const twofish_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+void    twofish_decrypt_blocks(const twofish_ctx *ctx, const u1byte *in_blk, u1byte *out_blk, size_t n_blk);
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif